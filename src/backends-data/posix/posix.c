@@ -32,12 +32,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <esdm-stream.h>
 
+#ifdef ESDM_HAS_URING
+  #include <liburing.h>
+#endif
+
 #include "posix.h"
 #define DEBUG_ENTER ESDM_DEBUG_COM_FMT("POSIX", "", "")
 #define DEBUG(fmt, ...) ESDM_DEBUG_COM_FMT("POSIX", fmt, __VA_ARGS__)
@@ -49,6 +55,9 @@
 
 #define sprintfFragmentDir(path, f) (sprintf(path, "%s/%c/%c/%s/%c/%c", tgt, f->dataset->id[0], f->dataset->id[1], f->dataset->id+2, f->id[0], f->id[1]))
 #define sprintfFragmentPath(path, f) (sprintf(path, "%s/%c/%c/%s/%c/%c/%s", tgt, f->dataset->id[0], f->dataset->id[1], f->dataset->id+2, f->id[0], f->id[1], f->id+2))
+#define sprintfExtentDir(path) (sprintf(path, "%s/extents", tgt))
+#define sprintfExtentPath(path, name) (sprintf(path, "%s/extents/%s", tgt, name))
+#define sprintfDeadLogPath(path, name) (sprintf(path, "%s/extents/%s.dead", tgt, name))
 
 ///////////////////////////////////////////////////////////////////////////////
 // Helper and utility /////////////////////////////////////////////////////////
@@ -58,7 +67,7 @@
 // Internal Helpers ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-static int entry_retrieve(const char *path, void *buf, uint64_t size) {
+static int entry_retrieve(const char *path, int64_t offset, void *buf, uint64_t size) {
   DEBUG("entry_retrieve(%s)", path);
 
   // write to non existing file
@@ -68,6 +77,11 @@ static int entry_retrieve(const char *path, void *buf, uint64_t size) {
     WARN("error on opening file \"%s\": %s", path, strerror(errno));
     return ESDM_ERROR;
   }
+  if (offset && lseek(fd, offset, SEEK_SET) != offset) {
+    WARN("error on seeking in file \"%s\": %s", path, strerror(errno));
+    close(fd);
+    return ESDM_ERROR;
+  }
   int ret = ea_read_check(fd, buf, size);
   close(fd);
   return ret;
@@ -95,12 +109,453 @@ static int entry_update(const char *path, void *buf, size_t len, int update_only
   return ret;
 }
 
+// Strided fragments are transferred straight from/to their memory with preadv()/pwritev(), starting at `offset` in the file.
+// The iovecs are consumed in the process.
+static int entry_transferv(int fd, int64_t offset, struct iovec *iov, int64_t count, bool write) {
+  while(count) {
+    int batch = count < IOV_MAX ? count : IOV_MAX;
+    ssize_t bytes = write ? pwritev(fd, iov, batch, offset) : preadv(fd, iov, batch, offset);
+    if(bytes < 0 && errno == EINTR) continue;
+    if(bytes <= 0) {
+      WARN("error on %s: %s", write ? "pwritev()" : "preadv()", bytes ? strerror(errno) : "unexpected end of file");
+      return ESDM_ERROR;
+    }
+    offset += bytes;
+    //skip the chunks that are done, and adjust a partially transferred one
+    for(; count && (size_t)bytes >= iov->iov_len; iov++, count--) bytes -= iov->iov_len;
+    if(bytes) {
+      iov->iov_base = (char*)iov->iov_base + bytes;
+      iov->iov_len -= bytes;
+    }
+  }
+  return ESDM_SUCCESS;
+}
+
+static int entry_retrievev(const char *path, int64_t offset, struct iovec *iov, int64_t count) {
+  DEBUG("entry_retrievev(%s: %ld chunks)", path, (long)count);
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    WARN("error on opening file \"%s\": %s", path, strerror(errno));
+    return ESDM_ERROR;
+  }
+  int ret = entry_transferv(fd, offset, iov, count, false);
+  close(fd);
+  return ret;
+}
+
+static int entry_updatev(const char *path, struct iovec *iov, int64_t count) {
+  DEBUG("entry_updatev(%s: %ld chunks)", path, (long)count);
+  int fd = open(path, O_WRONLY | O_TRUNC);
+  if(fd < 0){
+    WARN("error on opening file: %s", strerror(errno));
+    return ESDM_ERROR;
+  }
+  int ret = entry_transferv(fd, 0, iov, count, true);
+  close(fd);
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Direct I/O /////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Large fragments can be transferred with O_DIRECT to bypass the page cache.
+// O_DIRECT requires file offsets, transfer sizes and memory addresses that are multiples of the alignment.
+// Aligned memory is transferred directly, unaligned memory and the unaligned tail of a fragment are staged in bounce buffers from a pool.
+// The padding of the last block of a write is cut off with ftruncate() afterwards.
+// If the file system refuses O_DIRECT, the fragment is transferred with buffered I/O instead.
+
+#define DIRECT_IO_BOUNCE_SIZE (4*1024*1024)  //the size of the bounce buffers, must be a multiple of the alignment
+#define DIRECT_IO_POOL_LIMIT 16 //the maximum number of unused bounce buffers that are kept for reuse
+#define IO_URING_DEFAULT_DEPTH 64 //the number of fragments per io_uring submission with `"io-uring": true`
+
+static bool direct_use(posix_backend_data_t *data, size_t size) {
+  return data->directIoThreshold && size >= (size_t)data->directIoThreshold;
+}
+
+static void *bounce_get(posix_backend_data_t *data) {
+  void *result = NULL;
+  g_mutex_lock(&data->bounceMutex);
+  if(data->bounceCount) result = data->bouncePool[--data->bounceCount];
+  g_mutex_unlock(&data->bounceMutex);
+  return result ? result : ea_checked_memalign(data->directIoAlignment, DIRECT_IO_BOUNCE_SIZE);
+}
+
+static void bounce_put(posix_backend_data_t *data, void *buf) {
+  g_mutex_lock(&data->bounceMutex);
+  if(data->bounceCount < DIRECT_IO_POOL_LIMIT) {
+    data->bouncePool[data->bounceCount++] = buf;
+    buf = NULL;
+  }
+  g_mutex_unlock(&data->bounceMutex);
+  free(buf);
+}
+
+//returns the number of bytes transferred, which is only less than `size` if the end of the file has been reached, or -1 on error
+static ssize_t direct_pio(int fd, char *buf, size_t size, off_t offset, bool write) {
+  size_t done = 0;
+  while(done < size) {
+    ssize_t bytes = write ? pwrite(fd, buf + done, size - done, offset + done) : pread(fd, buf + done, size - done, offset + done);
+    if(bytes < 0) {
+      if(errno == EINTR) continue;
+      return -1;
+    }
+    if(bytes == 0) break;
+    done += bytes;
+  }
+  return done;
+}
+
+static int direct_transfer(posix_backend_data_t *data, int fd, void *buf, size_t size, bool write) {
+  int flags = fcntl(fd, F_GETFL);
+  if(flags < 0 || fcntl(fd, F_SETFL, flags | O_DIRECT) < 0) {
+    DEBUG("O_DIRECT is not supported, using buffered I/O: %s", strerror(errno));
+    return write ? ea_write_check(fd, buf, size) : ea_read_check(fd, buf, size);
+  }
+
+  const size_t alignment = data->directIoAlignment;
+  const bool alignedBuf = !((uintptr_t)buf % alignment);
+  char *bounce = NULL;
+  int ret = ESDM_SUCCESS;
+  for(size_t done = 0; done < size && ret == ESDM_SUCCESS; ) {
+    size_t remaining = size - done, chunk, transfer;
+    char *mem;
+    if(alignedBuf && remaining >= alignment) {
+      chunk = transfer = remaining - remaining%alignment;
+      mem = (char*)buf + done;
+    } else {
+      if(!bounce) bounce = bounce_get(data);
+      chunk = remaining < DIRECT_IO_BOUNCE_SIZE ? remaining : DIRECT_IO_BOUNCE_SIZE;
+      transfer = (chunk + alignment - 1)/alignment*alignment;
+      mem = bounce;
+      if(write) {
+        memcpy(bounce, (char*)buf + done, chunk);
+        memset(bounce + chunk, 0, transfer - chunk);
+      }
+    }
+    ssize_t bytes = direct_pio(fd, mem, transfer, done, write);
+    if(bytes < (ssize_t)chunk) {
+      WARN("error on %s with O_DIRECT: %s", write ? "writing" : "reading", bytes < 0 ? strerror(errno) : "unexpected end of file");
+      ret = ESDM_ERROR;
+    } else if(!write && mem == bounce) {
+      memcpy((char*)buf + done, bounce, chunk);
+    }
+    done += chunk;
+  }
+  if(bounce) bounce_put(data, bounce);
+
+  if(ret == ESDM_SUCCESS && write && size%alignment && ftruncate(fd, size)) {
+    WARN("error on truncating the padding: %s", strerror(errno));
+    ret = ESDM_ERROR;
+  }
+  return ret;
+}
+
+static int direct_retrieve(posix_backend_data_t *data, const char *path, void *buf, size_t size) {
+  DEBUG("direct_retrieve(%s)", path);
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    WARN("error on opening file \"%s\": %s", path, strerror(errno));
+    return ESDM_ERROR;
+  }
+  int ret = direct_transfer(data, fd, buf, size, false);
+  close(fd);
+  return ret;
+}
+
+static int direct_update(posix_backend_data_t *data, const char *path, void *buf, size_t size) {
+  DEBUG("direct_update(%s: %ld)", path, (long)size);
+  int fd = open(path, O_WRONLY | O_TRUNC);
+  if(fd < 0){
+    WARN("error on opening file: %s", strerror(errno));
+    return ESDM_ERROR;
+  }
+  int ret = direct_transfer(data, fd, buf, size, true);
+  close(fd);
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Packed extent files ////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// In packed mode, fragments are appended to a few large extent files instead of being stored in a file of their own each.
+// Every thread appends to its own extent, and starts a new one once the extent has reached the configured size.
+// The location of a fragment is stored in its backend metadata, fragments without a location are stored in their own file.
+//
+// Deleting a fragment appends its range to the dead log `<extent>.dead` of its extent.
+// The compactor thread reclaims the space of the dead ranges by punching holes into the extent,
+// and removes an extent completely once all of its data is dead and no thread appends to it anymore (the appending thread holds a shared lock on it).
+// Live fragments are only moved when an update outgrows their location, they are appended anew in that case.
+// The committed dataset metadata may still reference the old location, so it is only marked as dead once a snapshot of the metadata with the new location has been committed.
+// A journal entry or a fragment index does not record the new location, so these commits keep the old location alive.
+
+typedef struct {
+  char *extent;
+  int64_t offset;
+  int64_t size;
+  char *oldExtent; //the location the fragment was moved away from since the last snapshot commit, NULL if it has not been moved
+  int64_t oldOffset;
+  int64_t oldSize;
+} posix_fragment_md_t;
+
+typedef struct {
+  char *name;
+  int fd;
+  int64_t size;
+} posix_extentWriter_t;
+
+typedef struct {
+  int64_t offset;
+  int64_t size;
+} posix_deadRange_t;
+
+static void extentWriter_destroy(gpointer data) {
+  posix_extentWriter_t *w = data;
+  if(w->fd >= 0) close(w->fd);
+  free(w->name);
+  free(w);
+}
+
+static void extentWriter_close(posix_extentWriter_t *w) {
+  if(w->fd >= 0) close(w->fd);
+  free(w->name);
+  w->name = NULL;
+  w->fd = -1;
+  w->size = 0;
+}
+
+//Creates a new extent file for the writer, and locks it against removal by the compactor while it's appended to.
+static int extentWriter_open(posix_backend_data_t *data, posix_extentWriter_t *w) {
+  const char *tgt = data->config->target;
+  char path[PATH_MAX];
+  struct stat sb;
+  sprintfExtentDir(path);
+  if (stat(path, &sb) == -1) {
+    if (mkdir_recursive(path) != 0 && errno != EEXIST) {
+      WARN("error on creating directory \"%s\": %s", path, strerror(errno));
+      return ESDM_ERROR;
+    }
+  }
+  while(1){
+    w->name = ea_make_id(ESDM_ID_LENGTH);
+    sprintfExtentPath(path, w->name);
+    w->fd = open(path, O_WRONLY | O_CREAT | O_EXCL, S_IWUSR | S_IRUSR | S_IWGRP | S_IRGRP | S_IROTH);
+    if(w->fd >= 0) break;
+    free(w->name);
+    w->name = NULL;
+    if(errno != EEXIST){
+      WARN("error on creating file \"%s\": %s", path, strerror(errno));
+      return ESDM_ERROR;
+    }
+  }
+  if(flock(w->fd, LOCK_SH)) WARN("error on locking file \"%s\": %s", path, strerror(errno));
+  w->size = 0;
+  return ESDM_SUCCESS;
+}
+
+//Records a range of an extent as dead, and schedules the extent for compaction.
+static int extent_markDead(posix_backend_data_t *data, const char *extent, int64_t offset, int64_t size) {
+  const char *tgt = data->config->target;
+  char path[PATH_MAX];
+  sprintfDeadLogPath(path, extent);
+  int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, S_IWUSR | S_IRUSR | S_IWGRP | S_IRGRP | S_IROTH);
+  if(fd < 0){
+    WARN("error on opening file \"%s\": %s", path, strerror(errno));
+    return ESDM_ERROR;
+  }
+  posix_deadRange_t range = {.offset = offset, .size = size};
+  int ret = ea_write_check(fd, (char*)&range, sizeof(range));
+  close(fd);
+  if(ret) return ESDM_ERROR;
+
+  g_mutex_lock(&data->extentMutex);
+  if(data->compactionQueue) {
+    g_hash_table_add(data->compactionQueue, ea_checked_strdup(extent));
+    g_cond_signal(&data->compactionCond);
+  }
+  g_mutex_unlock(&data->extentMutex);
+  return ESDM_SUCCESS;
+}
+
+//Appends the data of a fragment to the extent of the calling thread, and returns the resulting location.
+static int extent_append(posix_backend_data_t *data, void *buf, int64_t size, posix_fragment_md_t **out_md) {
+  g_mutex_lock(&data->extentMutex);
+  posix_extentWriter_t *w = g_hash_table_lookup(data->extentWriters, g_thread_self());
+  if(!w) {
+    w = ea_checked_calloc(1, sizeof(*w));
+    w->fd = -1;
+    g_hash_table_insert(data->extentWriters, g_thread_self(), w);
+  }
+  g_mutex_unlock(&data->extentMutex);
+
+  if(w->fd >= 0 && w->size && w->size + size > data->extentSize) extentWriter_close(w);
+  if(w->fd < 0) {
+    int ret = extentWriter_open(data, w);
+    if(ret != ESDM_SUCCESS) return ret;
+  }
+  if(ea_write_check(w->fd, buf, size)) {
+    //the file position is unknown now, the partially written range must never be used again
+    extent_markDead(data, w->name, w->size, size);
+    extentWriter_close(w);
+    return ESDM_ERROR;
+  }
+
+  posix_fragment_md_t *md = ea_checked_malloc(sizeof(*md));
+  *md = (posix_fragment_md_t){
+    .extent = ea_checked_strdup(w->name),
+    .offset = w->size,
+    .size = size
+  };
+  w->size += size;
+  *out_md = md;
+  return ESDM_SUCCESS;
+}
+
+//Overwrites the data of a fragment at its existing location.
+static int extent_overwrite(posix_backend_data_t *data, posix_fragment_md_t *md, void *buf, int64_t size) {
+  const char *tgt = data->config->target;
+  char path[PATH_MAX];
+  sprintfExtentPath(path, md->extent);
+  int fd = open(path, O_WRONLY);
+  if(fd < 0){
+    WARN("error on opening file \"%s\": %s", path, strerror(errno));
+    return ESDM_ERROR;
+  }
+  int ret = lseek(fd, md->offset, SEEK_SET) == md->offset ? ea_write_check(fd, buf, size) : ESDM_ERROR;
+  close(fd);
+  return ret ? ESDM_ERROR : ESDM_SUCCESS;
+}
+
+//Reclaims the dead ranges of an extent, removing it if it's completely dead and not appended to anymore.
+static void extent_compact(posix_backend_data_t *data, const char *extent) {
+  const char *tgt = data->config->target;
+  char path[PATH_MAX], deadPath[PATH_MAX];
+  sprintfExtentPath(path, extent);
+  sprintfDeadLogPath(deadPath, extent);
+
+  int fd = open(path, O_RDWR);
+  if(fd < 0) {
+    if(errno == ENOENT) unlink(deadPath); //someone else has already removed the extent
+    return;
+  }
+  int deadFd = open(deadPath, O_RDONLY);
+  if(deadFd < 0) {
+    close(fd);
+    return;
+  }
+
+  int64_t deadBytes = 0;
+  posix_deadRange_t range;
+  while(!ea_read_check(deadFd, (char*)&range, sizeof(range))) {
+    deadBytes += range.size;
+    //file systems that cannot punch holes only get their space back once the whole extent is dead
+    if(fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, range.offset, range.size)) DEBUG("cannot punch hole into \"%s\": %s", path, strerror(errno));
+  }
+  close(deadFd);
+
+  struct stat sb;
+  if(!fstat(fd, &sb) && deadBytes >= sb.st_size && !flock(fd, LOCK_EX | LOCK_NB)) {
+    DEBUG("removing dead extent \"%s\"", path);
+    unlink(path);
+    unlink(deadPath);
+  }
+  close(fd);
+}
+
+static gpointer compactor_thread(gpointer arg) {
+  posix_backend_data_t *data = arg;
+  g_mutex_lock(&data->extentMutex);
+  while(1) {
+    while(!data->shutdown && !g_hash_table_size(data->compactionQueue)) g_cond_wait(&data->compactionCond, &data->extentMutex);
+    if(!g_hash_table_size(data->compactionQueue)) break;  //shutdown, and nothing left to do
+
+    GHashTable *batch = data->compactionQueue;
+    data->compactionQueue = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    g_mutex_unlock(&data->extentMutex);
+
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, batch);
+    while(g_hash_table_iter_next(&iter, &key, NULL)) extent_compact(data, key);
+    g_hash_table_destroy(batch);
+
+    g_mutex_lock(&data->extentMutex);
+  }
+  g_mutex_unlock(&data->extentMutex);
+  return NULL;
+}
+
+static int fragment_metadata_create(esdm_backend_t *backend, esdm_fragment_t *f, smd_string_stream_t *stream) {
+  posix_fragment_md_t *md = f->backend_md;
+  if(md) smd_string_stream_printf(stream, "{\"extent\":\"%s\",\"offset\":%"PRId64",\"size\":%"PRId64"}", md->extent, md->offset, md->size);
+  return ESDM_SUCCESS;
+}
+
+static void *fragment_metadata_load(esdm_backend_t *backend, esdm_fragment_t *f, json_t *metadata) {
+  json_t *extent = jansson_object_get(metadata, "extent");
+  json_t *offset = jansson_object_get(metadata, "offset");
+  json_t *size = jansson_object_get(metadata, "size");
+  if(!extent || !json_is_string(extent) || !json_is_integer(offset) || !json_is_integer(size)) return NULL;  //the fragment is stored in its own file
+
+  posix_fragment_md_t *md = ea_checked_malloc(sizeof(*md));
+  *md = (posix_fragment_md_t){
+    .extent = ea_checked_strdup(json_string_value(extent)),
+    .offset = json_integer_value(offset),
+    .size = json_integer_value(size)
+  };
+  return md;
+}
+
+static int fragment_metadata_free(esdm_backend_t *backend, void *options) {
+  posix_fragment_md_t *md = options;
+  free(md->extent);
+  free(md->oldExtent);
+  free(md);
+  return ESDM_SUCCESS;
+}
+
+//Moves the location of `md` into the old location of `newMd`, which replaces it after the fragment outgrew its location.
+static void fragment_metadata_move(posix_backend_data_t *data, posix_fragment_md_t *md, posix_fragment_md_t *newMd) {
+  if(md->oldExtent) {
+    // the fragment has been moved before, the committed metadata references only its first location, the current one can be reclaimed right away
+    extent_markDead(data, md->extent, md->offset, md->size);
+    newMd->oldExtent = md->oldExtent;
+    newMd->oldOffset = md->oldOffset;
+    newMd->oldSize = md->oldSize;
+    md->oldExtent = NULL;
+  } else {
+    newMd->oldExtent = md->extent;
+    newMd->oldOffset = md->offset;
+    newMd->oldSize = md->size;
+    md->extent = NULL;
+  }
+}
+
+static void fragment_metadata_committed(esdm_backend_t *backend, esdm_fragment_t *f) {
+  posix_backend_data_t *data = (posix_backend_data_t *)backend->data;
+  posix_fragment_md_t *md = f->backend_md;
+  if(!md || !md->oldExtent) return;
+
+  // the committed snapshot references the new location, so nothing references the old one anymore
+  DEBUG("reclaiming the old location of fragment %s", f->id);
+  extent_markDead(data, md->oldExtent, md->oldOffset, md->oldSize);
+  free(md->oldExtent);
+  md->oldExtent = NULL;
+}
+
 static int fragment_delete(esdm_backend_t * backend, esdm_fragment_t *f){
   DEBUG_ENTER;
 
   posix_backend_data_t *data = (posix_backend_data_t *)backend->data;
   const char *tgt = data->config->target;
 
+  posix_fragment_md_t *md = f->backend_md;
+  if(md) {
+    if(md->oldExtent) extent_markDead(data, md->oldExtent, md->oldOffset, md->oldSize);
+    return extent_markDead(data, md->extent, md->offset, md->size);
+  }
+
   char path[PATH_MAX];
   if(f->id == NULL){
     return ESDM_ERROR;
@@ -204,14 +659,33 @@ static int fragment_retrieve(esdm_backend_t *backend, esdm_fragment_t *f) {
 
   // determine path to fragment
   char path[PATH_MAX];
-  sprintfFragmentPath(path, f);
+  posix_fragment_md_t *md = f->backend_md;
+  if(md) {
+    sprintfExtentPath(path, md->extent);
+  } else {
+    sprintfFragmentPath(path, f);
+  }
   DEBUG("path_fragment: %s", path);
 
+  int ret;
+  bool direct = !md && direct_use(data, f->bytes);
+  struct iovec *iov;
+  int64_t iovCount;
+  if(!direct && estream_mem_iovec_fragment(f, ESDM_IOVEC_MIN_CHUNK_BYTES, &iov, &iovCount)) {
+    // scatter the data straight into the strided buffer
+    ret = entry_retrievev(path, md ? md->offset : 0, iov, iovCount);
+    free(iov);
+    return ret;
+  }
+
   void* readBuffer;
   size_t size;
-  int ret;
   bool needUnpack = estream_mem_unpack_fragment_param(f, & readBuffer, & size);
-  ret = entry_retrieve(path, readBuffer, size);
+  if(direct) {
+    ret = direct_retrieve(data, path, readBuffer, size);
+  } else {
+    ret = entry_retrieve(path, md ? md->offset : 0, readBuffer, size);
+  }
   if(ret != ESDM_SUCCESS) return ret;
   if(needUnpack){
     ret = estream_mem_unpack_fragment(f, readBuffer, size);
@@ -220,6 +694,40 @@ static int fragment_retrieve(esdm_backend_t *backend, esdm_fragment_t *f) {
   return ret;
 }
 
+// Reads only the given byte ranges of a fragment, ranges that follow each other in the file are read with a single preadv().
+static int fragment_retrieve_region(esdm_backend_t *backend, esdm_fragment_t *f, int64_t count, esdmI_byteRange_t *ranges) {
+  DEBUG("fragment_retrieve_region(%ld ranges)", (long)count);
+
+  posix_backend_data_t *data = (posix_backend_data_t *)backend->data;
+  const char *tgt = data->config->target;
+  char path[PATH_MAX];
+  posix_fragment_md_t *md = f->backend_md;
+  if(md) {
+    sprintfExtentPath(path, md->extent);
+  } else {
+    sprintfFragmentPath(path, f);
+  }
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    WARN("error on opening file \"%s\": %s", path, strerror(errno));
+    return ESDM_ERROR;
+  }
+
+  int ret = ESDM_SUCCESS;
+  struct iovec iov[IOV_MAX];
+  for(int64_t i = 0; i < count && ret == ESDM_SUCCESS; ) {
+    int64_t offset = ranges[i].offset, end = offset;
+    int n = 0;
+    for(; i < count && n < IOV_MAX && ranges[i].offset == end; i++, n++) {
+      iov[n] = (struct iovec){ .iov_base = ranges[i].dest, .iov_len = ranges[i].size };
+      end += ranges[i].size;
+    }
+    ret = entry_transferv(fd, (md ? md->offset : 0) + offset, iov, n, false);
+  }
+  close(fd);
+  return ret;
+}
+
 static int create_posix_id(esdm_fragment_t * f, const char *tgt, int * out_fd){
   char path[PATH_MAX];
   // ensure that the fragment with the ID doesn't exist, yet
@@ -262,8 +770,19 @@ static int fragment_write_stream_blocksize(esdm_backend_t * b, estream_write_t *
   if(c_off == 0){
     // start stream
     s = ea_checked_malloc(sizeof(posix_stream_t));
-    // lazy assignment of ID
-    if(f->id != NULL){
+    posix_fragment_md_t *md = f->backend_md;
+    if(md && f->bytes <= md->size){
+      // a packed fragment is streamed to its existing location, new fragments are always streamed to a file of their own
+      char path[PATH_MAX];
+      sprintfExtentPath(path, md->extent);
+      s->fd = open(path, O_WRONLY);
+      if(s->fd < 0 || lseek(s->fd, md->offset, SEEK_SET) != md->offset){
+        WARN("error on opening file: %s", strerror(errno));
+        if(s->fd >= 0) close(s->fd);
+        free(s);
+        return ESDM_ERROR;
+      }
+    } else if(f->id != NULL){
       char path[PATH_MAX];
       sprintfFragmentPath(path, f);
       DEBUG("path: %s\n", path);
@@ -273,6 +792,7 @@ static int fragment_write_stream_blocksize(esdm_backend_t * b, estream_write_t *
         return ESDM_ERROR;
       }
     } else {
+      // lazy assignment of ID
       ret = create_posix_id(f, tgt, & s->fd);
       if(ret != ESDM_SUCCESS){
         free(s);
@@ -303,25 +823,70 @@ static int fragment_update(esdm_backend_t *backend, esdm_fragment_t *f) {
   posix_backend_data_t *data = (posix_backend_data_t *)backend->data;
   const char *tgt = data->config->target;
   int ret = ESDM_SUCCESS;
+  posix_fragment_md_t *md = f->backend_md;
+
+  struct iovec *iov;
+  int64_t iovCount;
+  if(!md && !data->extentSize && !direct_use(data, f->bytes) && estream_mem_iovec_fragment(f, ESDM_IOVEC_MIN_CHUNK_BYTES, &iov, &iovCount)) {
+    // gather the data straight from the strided buffer
+    if(f->id != NULL){
+      char path[PATH_MAX];
+      sprintfFragmentPath(path, f);
+      ret = entry_updatev(path, iov, iovCount);
+    } else {
+      // lazy assignment of ID
+      int fd;
+      ret = create_posix_id(f, tgt, & fd);
+      if(ret == ESDM_SUCCESS){
+        ret = entry_transferv(fd, 0, iov, iovCount, true);
+        close(fd);
+      }
+    }
+    free(iov);
+    return ret;
+  }
 
   void * buff = NULL;
   size_t buff_size;
   ret = estream_mem_pack_fragment(f, & buff, & buff_size);
   if(ret != ESDM_SUCCESS) return ret;
 
-  // lazy assignment of ID
-  if(f->id != NULL){
+  if(md && buff_size <= md->size){
+    ret = extent_overwrite(data, md, buff, buff_size);
+  } else if(md || (f->id == NULL && data->extentSize)){
+    // packed mode, a new fragment or one that has outgrown its location is appended to our extent
+    // the old location is only marked as dead by fragment_metadata_committed(), the committed dataset metadata may still reference it
+    posix_fragment_md_t *newMd;
+    ret = extent_append(data, buff, buff_size, &newMd);
+    if(ret == ESDM_SUCCESS){
+      if(md) {
+        fragment_metadata_move(data, md, newMd);
+        fragment_metadata_free(backend, md);
+      }
+      f->backend_md = newMd;
+      if(f->id == NULL) f->id = ea_make_id(ESDM_ID_LENGTH);
+    }
+  } else if(f->id != NULL){
     char path[PATH_MAX];
     sprintfFragmentPath(path, f);
     DEBUG("path: %s\n", path);
     // create data
-    ret = entry_update(path, buff, buff_size, 1);
+    if(direct_use(data, buff_size)){
+      ret = direct_update(data, path, buff, buff_size);
+    }else{
+      ret = entry_update(path, buff, buff_size, 1);
+    }
   } else {
+    // lazy assignment of ID
     int fd;
     ret = create_posix_id(f, tgt, & fd);
     if(ret == ESDM_SUCCESS){
       //write the data
-      ret = ea_write_check(fd, buff, buff_size);
+      if(direct_use(data, buff_size)){
+        ret = direct_transfer(data, fd, buff, buff_size, true);
+      }else{
+        ret = ea_write_check(fd, buff, buff_size);
+      }
       close(fd);
     }
   }
@@ -332,6 +897,296 @@ static int fragment_update(esdm_backend_t *backend, esdm_fragment_t *f) {
   return ret;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Batched I/O via io_uring ///////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef ESDM_HAS_URING
+
+// Each fragment of a batch is transferred by a chain of three linked SQEs: open, read/write, close.
+// The files are opened as direct descriptors into the ring's file table, the i-th fragment of a submission uses slot i, so no file descriptors are returned to user space.
+// Fragments that already have an open file descriptor (newly created fragments) skip the open.
+// The whole submission requires a single syscall, all operations are in flight at once, and the thread only blocks once until all of them have completed.
+//
+// Each thread uses its own ring, so no locking is required while the operations are in flight.
+// Whenever io_uring cannot be used, or a chain does not complete as expected (short transfer, interrupted chain), the affected fragments are transferred with the blocking code path instead.
+
+#define RING_MAX_TRANSFER (1 << 30) //larger fragments are transferred by the blocking code path, the length of an io_uring read/write is limited to 32 bits
+
+typedef struct {
+  struct io_uring ring;
+  bool usable;
+} posix_ring_t;
+
+typedef struct {
+  char path[PATH_MAX];
+  int64_t offset;
+  void *buf;
+  size_t size;
+  struct iovec *iov;  //if set, the fragment is transferred from/to these chunks instead of `buf`
+  int64_t iovCount;
+  int fd; //an already open file descriptor, or -1 if the file is to be opened by the chain
+  bool skip;  //the fragment is not to be transferred at all
+  bool done;  //set if the transfer succeeded via io_uring
+  bool needUnpack;  //only used by reads
+} posix_ringItem_t;
+
+static void ring_destroy(gpointer data) {
+  posix_ring_t *r = data;
+  if(r->usable) io_uring_queue_exit(&r->ring);
+  free(r);
+}
+
+//Returns the ring of the calling thread, creating it on first use, or NULL if io_uring cannot be used by this thread.
+static posix_ring_t *ring_get(posix_backend_data_t *data) {
+  g_mutex_lock(&data->ringMutex);
+  posix_ring_t *r = g_hash_table_lookup(data->rings, g_thread_self());
+  g_mutex_unlock(&data->ringMutex);
+  if(r) return r->usable ? r : NULL;
+
+  r = ea_checked_calloc(1, sizeof(*r));
+  int ret = io_uring_queue_init(3*data->ioUringDepth, &r->ring, 0);
+  if(!ret) {
+    ret = io_uring_register_files_sparse(&r->ring, data->ioUringDepth);
+    if(ret) io_uring_queue_exit(&r->ring);
+  }
+  if(ret) WARN("cannot use io_uring, falling back to blocking I/O: %s", strerror(-ret));
+  r->usable = !ret;
+
+  g_mutex_lock(&data->ringMutex);
+  g_hash_table_insert(data->rings, g_thread_self(), r);
+  g_mutex_unlock(&data->ringMutex);
+  return r->usable ? r : NULL;
+}
+
+//Wait for `count` completions, storing their results in `results` which is indexed by the user data of the SQEs.
+static void ring_reap(posix_ring_t *r, int64_t count, int *results) {
+  for(int64_t i = 0; i < count; i++) {
+    struct io_uring_cqe *cqe;
+    int ret;
+    while((ret = io_uring_wait_cqe(&r->ring, &cqe)) == -EINTR);
+    if(ret) {
+      //cannot happen with a ring that is exclusively used by this thread, but we must not touch the ring again if it does
+      WARN("io_uring_wait_cqe(): %s", strerror(-ret));
+      r->usable = false;
+      return;
+    }
+    results[io_uring_cqe_get_data64(cqe)] = cqe->res;
+    io_uring_cqe_seen(&r->ring, cqe);
+  }
+}
+
+//Submit the chains of at most `ioUringDepth` items, and wait for their completion.
+//Sets the `done` flag of all items that have been transferred successfully, and closes the file descriptors of all the other items.
+static void ring_submit(posix_ring_t *r, int64_t count, posix_ringItem_t **items, bool write) {
+  int *results = ea_checked_malloc(3*count*sizeof(*results)); //open, transfer, and close result of each item
+  int64_t sqeCount = 0;
+  for(int64_t i = 0; i < count; i++) {
+    posix_ringItem_t *item = items[i];
+    struct io_uring_sqe *sqe;
+    bool direct = item->fd < 0;
+    if(direct) {
+      sqe = io_uring_get_sqe(&r->ring);
+      io_uring_prep_openat_direct(sqe, AT_FDCWD, item->path, write ? O_WRONLY | O_TRUNC : O_RDONLY, 0, i);
+      io_uring_sqe_set_data64(sqe, 3*i);
+      sqe->flags |= IOSQE_IO_LINK;
+    }
+    results[3*i] = 0;
+
+    sqe = io_uring_get_sqe(&r->ring);
+    if(item->iov && write) {
+      io_uring_prep_writev(sqe, direct ? i : item->fd, item->iov, item->iovCount, item->offset);
+    } else if(item->iov) {
+      io_uring_prep_readv(sqe, direct ? i : item->fd, item->iov, item->iovCount, item->offset);
+    } else if(write) {
+      io_uring_prep_write(sqe, direct ? i : item->fd, item->buf, item->size, item->offset);
+    } else {
+      io_uring_prep_read(sqe, direct ? i : item->fd, item->buf, item->size, item->offset);
+    }
+    io_uring_sqe_set_data64(sqe, 3*i + 1);
+    sqe->flags |= IOSQE_IO_LINK | (direct ? IOSQE_FIXED_FILE : 0);
+
+    sqe = io_uring_get_sqe(&r->ring);
+    if(direct) {
+      io_uring_prep_close_direct(sqe, i);
+    } else {
+      io_uring_prep_close(sqe, item->fd);
+    }
+    io_uring_sqe_set_data64(sqe, 3*i + 2);
+
+    results[3*i + 1] = results[3*i + 2] = -ECANCELED;
+    sqeCount += direct ? 3 : 2;
+  }
+
+  int ret;
+  while((ret = io_uring_submit(&r->ring)) == -EINTR);
+  if(ret != sqeCount) {
+    //the ring is in an unknown state, stop using it
+    WARN("io_uring_submit(): %s", ret < 0 ? strerror(-ret) : "incomplete submission");
+    r->usable = false;
+  }
+  if(ret > 0) ring_reap(r, ret, results);
+
+  //a chain that was interrupted after the open leaves the file open
+  int64_t closeCount = 0;
+  for(int64_t i = 0; i < count; i++) {
+    posix_ringItem_t *item = items[i];
+    int openRes = results[3*i], transferRes = results[3*i + 1], closeRes = results[3*i + 2];
+    item->done = openRes >= 0 && transferRes >= 0 && (size_t)transferRes == item->size && closeRes == 0;
+    if(closeRes != -ECANCELED) continue;
+    if(item->fd >= 0) {
+      close(item->fd);
+    } else if(openRes >= 0 && r->usable) {
+      struct io_uring_sqe *sqe = io_uring_get_sqe(&r->ring);
+      io_uring_prep_close_direct(sqe, i);
+      io_uring_sqe_set_data64(sqe, 3*i + 2);
+      closeCount++;
+    }
+  }
+  if(closeCount) {
+    while((ret = io_uring_submit(&r->ring)) == -EINTR);
+    if(ret > 0) ring_reap(r, ret, results);
+    if(ret != closeCount) r->usable = false;
+  }
+  for(int64_t i = 0; i < count; i++) items[i]->fd = -1;
+  free(results);
+}
+
+//Transfer all items that are not skipped, in submissions of at most `ioUringDepth` items.
+static void ring_transfer(posix_backend_data_t *data, posix_ring_t *r, int64_t count, posix_ringItem_t *items, bool write) {
+  posix_ringItem_t **submission = ea_checked_malloc(data->ioUringDepth*sizeof(*submission));
+  int64_t submissionCount = 0;
+  for(int64_t i = 0; i < count; i++) {
+    posix_ringItem_t *item = &items[i];
+    if(item->skip) continue;
+    if(item->size > RING_MAX_TRANSFER || item->iovCount > IOV_MAX || !r->usable) {
+      if(item->fd >= 0) close(item->fd);
+      item->fd = -1;
+      continue;
+    }
+    submission[submissionCount++] = item;
+    if(submissionCount == data->ioUringDepth) {
+      ring_submit(r, submissionCount, submission, write);
+      submissionCount = 0;
+    }
+  }
+  if(submissionCount) ring_submit(r, submissionCount, submission, write);
+  free(submission);
+}
+
+static void fragments_retrieve(esdm_backend_t *backend, int64_t count, esdm_fragment_t **fragments, int *out_rets) {
+  DEBUG("fragments_retrieve(%ld)", (long)count);
+
+  posix_backend_data_t *data = (posix_backend_data_t *)backend->data;
+  const char *tgt = data->config->target;
+  posix_ring_t *r = ring_get(data);
+  if(!r) {
+    for(int64_t i = 0; i < count; i++) out_rets[i] = fragment_retrieve(backend, fragments[i]);
+    return;
+  }
+
+  posix_ringItem_t *items = ea_checked_calloc(count, sizeof(*items));
+  for(int64_t i = 0; i < count; i++) {
+    esdm_fragment_t *f = fragments[i];
+    posix_fragment_md_t *md = f->backend_md;
+    if(!md && direct_use(data, f->bytes)) {
+      // large fragments bypass the page cache via the blocking code path
+      out_rets[i] = fragment_retrieve(backend, f);
+      items[i].skip = true;
+      continue;
+    }
+    if(md) {
+      sprintfExtentPath(items[i].path, md->extent);
+      items[i].offset = md->offset;
+    } else {
+      sprintfFragmentPath(items[i].path, f);
+    }
+    if(estream_mem_iovec_fragment(f, ESDM_IOVEC_MIN_CHUNK_BYTES, &items[i].iov, &items[i].iovCount)) {
+      items[i].size = f->bytes;
+    } else {
+      items[i].needUnpack = estream_mem_unpack_fragment_param(f, &items[i].buf, &items[i].size);
+    }
+    items[i].fd = -1;
+  }
+  ring_transfer(data, r, count, items, false);
+
+  for(int64_t i = 0; i < count; i++) {
+    posix_ringItem_t *item = &items[i];
+    if(item->skip) continue;
+    int ret = item->done ? ESDM_SUCCESS :
+              item->iov ? entry_retrievev(item->path, item->offset, item->iov, item->iovCount) :
+              entry_retrieve(item->path, item->offset, item->buf, item->size);
+    free(item->iov);
+    if(item->needUnpack) {
+      if(ret == ESDM_SUCCESS) {
+        ret = estream_mem_unpack_fragment(fragments[i], item->buf, item->size);
+      } else {
+        free(item->buf);
+      }
+    }
+    out_rets[i] = ret;
+  }
+  free(items);
+}
+
+static void fragments_update(esdm_backend_t *backend, int64_t count, esdm_fragment_t **fragments, int *out_rets) {
+  DEBUG("fragments_update(%ld)", (long)count);
+
+  posix_backend_data_t *data = (posix_backend_data_t *)backend->data;
+  const char *tgt = data->config->target;
+  posix_ring_t *r = ring_get(data);
+  if(!r) {
+    for(int64_t i = 0; i < count; i++) out_rets[i] = fragment_update(backend, fragments[i]);
+    return;
+  }
+
+  posix_ringItem_t *items = ea_checked_calloc(count, sizeof(*items));
+  for(int64_t i = 0; i < count; i++) {
+    esdm_fragment_t *f = fragments[i];
+    posix_ringItem_t *item = &items[i];
+    item->fd = -1;
+    if(f->backend_md || data->extentSize || direct_use(data, f->bytes)) {
+      // packed fragments are appended by the blocking code path, large fragments bypass the page cache there
+      out_rets[i] = fragment_update(backend, f);
+      item->skip = true;
+      continue;
+    }
+    if(estream_mem_iovec_fragment(f, ESDM_IOVEC_MIN_CHUNK_BYTES, &item->iov, &item->iovCount)) {
+      item->size = f->bytes;
+      out_rets[i] = ESDM_SUCCESS;
+    } else {
+      out_rets[i] = estream_mem_pack_fragment(f, &item->buf, &item->size);
+    }
+    // lazy assignment of ID, the file is created right away to reserve the ID
+    if(out_rets[i] == ESDM_SUCCESS && f->id == NULL) out_rets[i] = create_posix_id(f, tgt, &item->fd);
+    if(out_rets[i] == ESDM_SUCCESS) {
+      sprintfFragmentPath(item->path, f);
+    } else {
+      item->skip = true;
+    }
+  }
+  ring_transfer(data, r, count, items, true);
+
+  for(int64_t i = 0; i < count; i++) {
+    posix_ringItem_t *item = &items[i];
+    if(item->skip) {
+      free(item->iov);
+      continue;
+    }
+    out_rets[i] = item->done ? ESDM_SUCCESS :
+                  item->iov ? entry_updatev(item->path, item->iov, item->iovCount) :
+                  entry_update(item->path, item->buf, item->size, 1);
+    if(item->iov) {
+      free(item->iov);
+    } else if(item->buf != fragments[i]->buf) {
+      free(item->buf);
+    }
+  }
+  free(items);
+}
+
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // ESDM Callbacks /////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -357,6 +1212,35 @@ int posix_finalize(esdm_backend_t *backend) {
   DEBUG_ENTER;
 
   posix_backend_data_t* data = backend->data;
+
+  //closing our extents releases their locks, so that the final compaction can remove them if they are dead
+  g_hash_table_destroy(data->extentWriters);
+  if(data->compactor) {
+    g_mutex_lock(&data->extentMutex);
+    data->shutdown = true;
+    g_cond_broadcast(&data->compactionCond);
+    g_mutex_unlock(&data->extentMutex);
+    g_thread_join(data->compactor);
+  } else {
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, data->compactionQueue);
+    while(g_hash_table_iter_next(&iter, &key, NULL)) extent_compact(data, key);
+  }
+  g_hash_table_destroy(data->compactionQueue);
+  g_cond_clear(&data->compactionCond);
+  g_mutex_clear(&data->extentMutex);
+  if(data->directIoThreshold) {
+    while(data->bounceCount) free(data->bouncePool[--data->bounceCount]);
+    free(data->bouncePool);
+    g_mutex_clear(&data->bounceMutex);
+  }
+#ifdef ESDM_HAS_URING
+  if(data->ioUringDepth) {
+    g_hash_table_destroy(data->rings);
+    g_mutex_clear(&data->ringMutex);
+  }
+#endif
   free(data->config);  //TODO: Do we need to destruct this?
   free(data);
   free(backend);
@@ -384,9 +1268,11 @@ static esdm_backend_t backend_template = {
     .fragment_retrieve = fragment_retrieve,
     .fragment_update = fragment_update,
     .fragment_delete = fragment_delete,
-    .fragment_metadata_create = NULL,
-    .fragment_metadata_load = NULL,
-    .fragment_metadata_free = NULL,
+    .fragment_retrieve_region = fragment_retrieve_region,
+    .fragment_metadata_create = fragment_metadata_create,
+    .fragment_metadata_load = fragment_metadata_load,
+    .fragment_metadata_free = fragment_metadata_free,
+    .fragment_metadata_committed = fragment_metadata_committed,
     .mkfs = mkfs,
     .fsck = fsck,
     .fragment_write_stream_blocksize = fragment_write_stream_blocksize
@@ -409,7 +1295,7 @@ esdm_backend_t *posix_backend_init(esdm_config_backend_t *config) {
   memcpy(backend, &backend_template, sizeof(esdm_backend_t));
 
   // allocate memory for backend instance
-  posix_backend_data_t *data = ea_checked_malloc(sizeof(*data));
+  posix_backend_data_t *data = ea_checked_calloc(1, sizeof(*data));
   backend->data = data;
 
   if (data && config->performance_model)
@@ -421,5 +1307,63 @@ esdm_backend_t *posix_backend_init(esdm_config_backend_t *config) {
   data->config = config;
   DEBUG("Backend config: target=%s\n", config->target);
 
+  // fragments that were written in packed mode must be readable and deletable in any case
+  g_mutex_init(&data->extentMutex);
+  g_cond_init(&data->compactionCond);
+  data->extentWriters = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, extentWriter_destroy);
+  data->compactionQueue = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+  json_t *elem = jansson_object_get(config->backend, "packed");
+  if(elem && json_is_true(elem)) {
+    data->extentSize = 1024*1024*1024;
+    elem = jansson_object_get(config->backend, "extent-size");
+    if(elem && json_integer_value(elem) > 0) data->extentSize = json_integer_value(elem);
+    data->compactor = g_thread_new("esdm-posix-compact", compactor_thread, data);
+  }
+
+  elem = jansson_object_get(config->backend, "direct-io");
+  if(elem && json_is_true(elem)) {
+    data->directIoThreshold = 64*1024*1024;
+    elem = jansson_object_get(config->backend, "direct-io-threshold");
+    if(elem && json_integer_value(elem) > 0) data->directIoThreshold = json_integer_value(elem);
+    data->directIoAlignment = 4096;
+    elem = jansson_object_get(config->backend, "direct-io-alignment");
+    if(elem) {
+      int64_t alignment = json_integer_value(elem);
+      if(alignment > 0 && !(alignment & (alignment - 1)) && alignment <= DIRECT_IO_BOUNCE_SIZE) {
+        data->directIoAlignment = alignment;
+      } else {
+        WARN("direct-io-alignment must be a power of two of at most %d, using %"PRId64, DIRECT_IO_BOUNCE_SIZE, data->directIoAlignment);
+      }
+    }
+    g_mutex_init(&data->bounceMutex);
+    data->bouncePool = ea_checked_malloc(DIRECT_IO_POOL_LIMIT*sizeof(*data->bouncePool));
+    backend->alignment = data->directIoAlignment;
+  }
+
+  // like the other flags, "io-uring" may be a boolean, an integer sets the queue depth explicitly
+  elem = jansson_object_get(config->backend, "io-uring");
+  int64_t ioUringDepth = 0;
+  if(elem) {
+    if(json_is_boolean(elem)) {
+      ioUringDepth = json_is_true(elem) ? IO_URING_DEFAULT_DEPTH : 0;
+    } else if(json_is_integer(elem) && json_integer_value(elem) >= 0) {
+      ioUringDepth = json_integer_value(elem);
+    } else {
+      ESDM_ERROR_FMT("Configuration: \"io-uring\" of backend %s must be a boolean or a non-negative integer", config->id);
+    }
+  }
+  if(ioUringDepth) {
+#ifdef ESDM_HAS_URING
+    data->ioUringDepth = ioUringDepth;
+    g_mutex_init(&data->ringMutex);
+    data->rings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, ring_destroy);
+    backend->callbacks.fragments_retrieve = fragments_retrieve;
+    backend->callbacks.fragments_update = fragments_update;
+    backend->batchSize = data->ioUringDepth;
+#else
+    WARNS("io-uring is configured, but ESDM has been compiled without liburing, using blocking I/O");
+#endif
+  }
+
   return backend;
 }
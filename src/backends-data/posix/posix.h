@@ -24,6 +24,27 @@
 typedef struct {
   esdm_config_backend_t *config;
   esdm_perf_model_lat_thp_t perf_model;
+  int ioUringDepth; //the maximum number of fragments that are submitted together via io_uring, 0 if io_uring is not used
+
+  //packed mode
+  int64_t extentSize; //the size after which a thread starts a new extent file, 0 if each fragment is stored in its own file
+  GMutex extentMutex; //protects the members below
+  GHashTable *extentWriters;  //the extent that each thread currently appends to, keyed by its `GThread*`
+  GHashTable *compactionQueue;  //the names of the extents that have dead ranges which have not been reclaimed yet
+  GCond compactionCond;
+  GThread *compactor;
+  bool shutdown;
+
+  //direct I/O
+  int64_t directIoThreshold; //fragments of at least this size are transferred with O_DIRECT, 0 if direct I/O is not used
+  int64_t directIoAlignment; //the alignment of file offsets, transfer sizes and memory buffers that O_DIRECT requires
+  GMutex bounceMutex; //protects the members below
+  void **bouncePool;  //unused aligned bounce buffers, kept for reuse
+  int bounceCount;
+#ifdef ESDM_HAS_URING
+  GMutex ringMutex;
+  GHashTable *rings;  //the io_uring instance of each thread that has performed batched I/O, keyed by its `GThread*`
+#endif
 } posix_backend_data_t;
 
 // static int mkfs(esdm_backend_t* backend, int enforce_format);
@@ -26,6 +26,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,6 +43,7 @@
 
 #define sprintfDatasetDir(path, d) (sprintf(path, "%s/datasets/%c%c", tgt, d->id[0], d->id[1]))
 #define sprintfDatasetMd(path, d) (sprintf(path, "%s/datasets/%c%c/%s.md", tgt, d->id[0], d->id[1], d->id + 2))
+#define sprintfDatasetJournal(path, d) (sprintf(path, "%s/datasets/%c%c/%s.journal", tgt, d->id[0], d->id[1], d->id + 2))
 
 ///////////////////////////////////////////////////////////////////////////////
 // Helper and utility /////////////////////////////////////////////////////////
@@ -52,6 +54,24 @@
 // Internal Helpers  //////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+//Mixes the modification time, size, and inode of the file into `*version`, a missing file contributes a fixed value.
+static int file_version(const char *path, uint64_t *version) {
+  struct stat statbuf;
+  uint64_t fields[4] = {0};
+  if (stat(path, &statbuf) == 0) {
+    fields[0] = statbuf.st_mtim.tv_sec;
+    fields[1] = statbuf.st_mtim.tv_nsec;
+    fields[2] = statbuf.st_size;
+    fields[3] = statbuf.st_ino;
+  } else if (errno != ENOENT) {
+    return ESDM_ERROR;
+  }
+  for (int i = 0; i < 4; i++) {
+    *version = (*version ^ fields[i]) * 0x100000001b3ull;
+  }
+  return ESDM_SUCCESS;
+}
+
 static int entry_create(const char *path, char * const json, int size) {
   DEBUG_ENTER;
 
@@ -94,6 +114,390 @@ static int entry_update(const char *path, void *buf, size_t len) {
   return 0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Durable updates and group commit ///////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// With the durability modes "fsync" and "group", metadata files are never modified in place:
+// The new content is written to a temporary file that is synced and renamed over the old file, then the directory is synced.
+// Thus, a crash leaves either the old or the new version of each file.
+// With "group", the updates are queued instead, and a background thread applies all queued updates in one batch,
+// syncing each affected directory only once per batch.
+// Each caller blocks until the batch that contains its update is durable, and receives the status of that batch.
+// This process sees its queued updates immediately, other processes see them when the batch has been flushed.
+
+typedef enum {
+  PENDING_REPLACE,  //the file gets the content of `data`
+  PENDING_APPEND,   //`data` is appended to the file
+  PENDING_REMOVE    //the file is removed
+} md_pending_kind_t;
+
+struct md_pending_write_t {
+  md_pending_kind_t kind;
+  char *data;
+  size_t size;
+  char *tmp;  //the temporary file of a PENDING_REPLACE while its batch is being flushed, NULL otherwise
+};
+
+//The outcome of flushing one batch, shared by the callers that wait for it.
+struct md_batch_t {
+  int status;
+  bool done;
+  int refcount; //one for the backend until the batch is flushed, plus one per waiting caller
+};
+
+static const guint kMaxPendingWrites = 1024; //a batch is flushed early when this many files are pending
+
+static md_batch_t *batch_create() {
+  md_batch_t *batch = ea_checked_malloc(sizeof(*batch));
+  *batch = (md_batch_t){ .status = ESDM_SUCCESS, .done = false, .refcount = 1 };
+  return batch;
+}
+
+//Must be called with the mutex held.
+static void batch_release(md_batch_t *batch) {
+  if (!--batch->refcount) free(batch);
+}
+
+static void pending_destroy(gpointer value) {
+  md_pending_write_t *entry = value;
+  free(entry->data);
+  free(entry->tmp);
+  free(entry);
+}
+
+static GHashTable *pending_table_create() {
+  return g_hash_table_new_full(g_str_hash, g_str_equal, free, pending_destroy);
+}
+
+static void parent_dir(const char *path, char *out_dir) {
+  strcpy(out_dir, path);
+  char *slash = strrchr(out_dir, '/');
+  if (slash) *slash = 0; else strcpy(out_dir, ".");
+}
+
+static int sync_dir(const char *dir) {
+  int fd = open(dir, O_RDONLY | O_DIRECTORY);
+  if (fd < 0) return ESDM_ERROR;
+  int ret = fsync(fd);
+  close(fd);
+  return ret == 0 ? ESDM_SUCCESS : ESDM_ERROR;
+}
+
+static int sync_parent_dir(const char *path) {
+  char dir[PATH_MAX];
+  parent_dir(path, dir);
+  return sync_dir(dir);
+}
+
+//The name is unique to the process and the call, so concurrent updates of the same file by several threads or processes never share a temporary file.
+static void temp_path(const char *path, char *out_tmp) {
+  static atomic_int counter = 0;
+  sprintf(out_tmp, "%s.%d.%d.tmp", path, (int)getpid(), atomic_fetch_add(&counter, 1));
+}
+
+//Writes the data to a new temporary file next to `path` and syncs it, `rename_temp()` makes it visible.
+//`out_tmp` receives the name of the temporary file and must have room for PATH_MAX characters.
+static int write_temp(const char *path, char *data, size_t size, char *out_tmp) {
+  temp_path(path, out_tmp);
+  int fd = open(out_tmp, O_WRONLY | O_CREAT | O_TRUNC, S_IWUSR | S_IRUSR | S_IWGRP | S_IRGRP | S_IROTH);
+  if (fd < 0) return ESDM_ERROR;
+  int ret = size ? ea_write_check(fd, data, size) : 0;
+  if (ret == 0) ret = fsync(fd);
+  close(fd);
+  if (ret != 0) {
+    unlink(out_tmp);
+    return ESDM_ERROR;
+  }
+  return ESDM_SUCCESS;
+}
+
+static int rename_temp(const char *tmp, const char *path) {
+  if (rename(tmp, path) == 0) return ESDM_SUCCESS;
+  unlink(tmp);
+  return ESDM_ERROR;
+}
+
+//`out_created` is set if the file did not exist or was empty before.
+static int append_file(const char *path, char *data, size_t size, bool sync, bool *out_created) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, S_IWUSR | S_IRUSR | S_IWGRP | S_IRGRP | S_IROTH);
+  if (fd < 0) return ESDM_ERROR;
+  *out_created = lseek(fd, 0, SEEK_END) == 0;
+  int ret = ea_write_check(fd, data, size);
+  if (ret == 0 && sync) ret = fdatasync(fd);
+  close(fd);
+  return ret == 0 ? ESDM_SUCCESS : ESDM_ERROR;
+}
+
+//Reads the complete file, `*out_exists` is cleared if there is no such file.
+static int read_file(const char *path, char **out_data, size_t *out_size, bool *out_exists) {
+  *out_data = NULL;
+  *out_size = 0;
+  *out_exists = false;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return errno == ENOENT ? ESDM_SUCCESS : ESDM_ERROR;
+  struct stat statbuf;
+  if (fstat(fd, &statbuf) != 0) {
+    close(fd);
+    return ESDM_ERROR;
+  }
+  char *data = ea_checked_malloc(statbuf.st_size + 1);
+  int ret = ea_read_check(fd, data, statbuf.st_size);
+  close(fd);
+  if (ret != 0) {
+    free(data);
+    return ESDM_ERROR;
+  }
+  data[statbuf.st_size] = 0;
+  *out_data = data;
+  *out_size = statbuf.st_size;
+  *out_exists = true;
+  return ESDM_SUCCESS;
+}
+
+//Applies a queued update to the content of a file, the result is NUL terminated.
+static void pending_apply(md_pending_write_t *entry, char **inout_data, size_t *inout_size, bool *inout_exists) {
+  if (!entry) return;
+  if (entry->kind != PENDING_APPEND || !*inout_exists) {
+    free(*inout_data);
+    *inout_data = NULL;
+    *inout_size = 0;
+  }
+  *inout_exists = entry->kind != PENDING_REMOVE;
+  if (!*inout_exists) return;
+  *inout_data = ea_checked_realloc(*inout_data, *inout_size + entry->size + 1);
+  if (entry->size) memcpy(*inout_data + *inout_size, entry->data, entry->size);
+  *inout_size += entry->size;
+  (*inout_data)[*inout_size] = 0;
+}
+
+//Must be called with the mutex held.
+static md_pending_write_t *pending_lookup(GHashTable *table, const char *path) {
+  return table ? g_hash_table_lookup(table, path) : NULL;
+}
+
+//Merges an update into the queue, must be called with the mutex held.
+static void pending_queue(metadummy_backend_options_t *options, const char *path, md_pending_kind_t kind, char *data, size_t size) {
+  md_pending_write_t *entry = g_hash_table_lookup(options->pending, path);
+  if (entry && kind == PENDING_APPEND) {
+    if (entry->kind == PENDING_REMOVE) entry->kind = PENDING_REPLACE;
+    entry->data = ea_checked_realloc(entry->data, entry->size + size);
+    memcpy(entry->data + entry->size, data, size);
+    entry->size += size;
+  } else {
+    entry = ea_checked_malloc(sizeof(*entry));
+    *entry = (md_pending_write_t){
+      .kind = kind,
+      .data = size ? ea_memdup(data, size) : NULL,
+      .size = size
+    };
+    g_hash_table_insert(options->pending, ea_checked_strdup(path), entry);
+  }
+  g_cond_broadcast(&options->changed);
+}
+
+//Applies the pending updates to the file system and returns the status of this batch,
+//must be called with the mutex held, which is released while the files are written.
+static int flush_locked(metadummy_backend_options_t *options) {
+  while (options->flushing) g_cond_wait(&options->changed, &options->mutex);
+  if (!g_hash_table_size(options->pending)) return ESDM_SUCCESS;
+
+  GHashTable *batch = options->pending;
+  md_batch_t *outcome = options->pending_batch;
+  options->pending = pending_table_create();
+  options->pending_batch = batch_create();
+  options->flushing = batch;
+  g_mutex_unlock(&options->mutex);
+  DEBUG("flushing %u metadata updates", g_hash_table_size(batch));
+
+  // write and sync the new file contents without making them visible
+  int ret = ESDM_SUCCESS;
+  GHashTable *failed = g_hash_table_new(g_str_hash, g_str_equal);  //the updates that are dropped because their temporary file could not be written
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init(&iter, batch);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    md_pending_write_t *entry = value;
+    if (entry->kind != PENDING_REPLACE) continue;
+    char tmp[PATH_MAX];
+    if (write_temp(key, entry->data, entry->size, tmp) != ESDM_SUCCESS) {
+      ESDM_LOG_FMT(ESDM_LOGLEVEL_WARNING, "failed to write the metadata file \"%s\"", (char*)key);
+      g_hash_table_add(failed, key);
+      ret = ESDM_ERROR;
+    } else {
+      entry->tmp = ea_checked_strdup(tmp);
+    }
+  }
+
+  // make the whole batch visible at once, readers of this process see either the old files and the batch, or the new files
+  GHashTable *dirs = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+  g_mutex_lock(&options->mutex);
+  g_hash_table_iter_init(&iter, batch);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    md_pending_write_t *entry = value;
+    if (g_hash_table_contains(failed, key)) continue;
+    bool changedDir = true;
+    int status = ESDM_SUCCESS;
+    switch (entry->kind) {
+      case PENDING_REPLACE: status = rename_temp(entry->tmp, key); break;
+      case PENDING_APPEND: status = append_file(key, entry->data, entry->size, false, &changedDir); break;
+      case PENDING_REMOVE: status = unlink(key) == 0 || errno == ENOENT ? ESDM_SUCCESS : ESDM_ERROR; break;
+    }
+    if (status != ESDM_SUCCESS) {
+      ESDM_LOG_FMT(ESDM_LOGLEVEL_WARNING, "failed to update the metadata file \"%s\"", (char*)key);
+      ret = ESDM_ERROR;
+    }
+    if (changedDir) {
+      char dir[PATH_MAX];
+      parent_dir(key, dir);
+      g_hash_table_add(dirs, ea_checked_strdup(dir));
+    }
+  }
+  options->flushing = NULL;
+  options->generation++;
+  g_cond_broadcast(&options->changed);
+  g_mutex_unlock(&options->mutex);
+
+  // make the batch durable
+  g_hash_table_iter_init(&iter, batch);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    if (((md_pending_write_t*)value)->kind != PENDING_APPEND) continue;
+    int fd = open(key, O_WRONLY);
+    if (fd < 0 || fdatasync(fd) != 0) ret = ESDM_ERROR;
+    if (fd >= 0) close(fd);
+  }
+  g_hash_table_iter_init(&iter, dirs);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    if (sync_dir(key) != ESDM_SUCCESS) ret = ESDM_ERROR;
+  }
+  g_hash_table_destroy(dirs);
+  g_hash_table_destroy(failed);
+  g_hash_table_destroy(batch);
+
+  g_mutex_lock(&options->mutex);
+  outcome->status = ret;
+  outcome->done = true;
+  batch_release(outcome);
+  g_cond_broadcast(&options->changed);
+  return ret;
+}
+
+static gpointer flusher_thread(gpointer data) {
+  metadummy_backend_options_t *options = data;
+  g_mutex_lock(&options->mutex);
+  while (1) {
+    while (!options->shutdown && !g_hash_table_size(options->pending)) g_cond_wait(&options->changed, &options->mutex);
+    if (options->shutdown) break;
+
+    // give other commits the chance to join the batch
+    gint64 deadline = g_get_monotonic_time() + options->group_commit_delay * G_TIME_SPAN_MILLISECOND;
+    while (!options->shutdown && g_hash_table_size(options->pending) < kMaxPendingWrites) {
+      if (!g_cond_wait_until(&options->changed, &options->mutex, deadline)) break;
+    }
+    if (options->shutdown) break;
+    flush_locked(options);
+  }
+  g_mutex_unlock(&options->mutex);
+  return NULL;
+}
+
+//Flushes all pending updates, errors of earlier batches have already been returned to the callers that queued them.
+static int flush_pending(metadummy_backend_options_t *options) {
+  if (!options->flusher) return ESDM_SUCCESS;
+  g_mutex_lock(&options->mutex);
+  int ret = flush_locked(options);
+  g_mutex_unlock(&options->mutex);
+  return ret;
+}
+
+//Queues an update and waits until the batch that contains it is durable, returns the status of that batch.
+static int queue_update(metadummy_backend_options_t *options, const char *path, md_pending_kind_t kind, char *data, size_t size) {
+  g_mutex_lock(&options->mutex);
+  pending_queue(options, path, kind, data, size);
+  md_batch_t *batch = options->pending_batch;
+  batch->refcount++;
+  while (!batch->done) g_cond_wait(&options->changed, &options->mutex);
+  int ret = batch->status;
+  batch_release(batch);
+  g_mutex_unlock(&options->mutex);
+  return ret;
+}
+
+//Reads a metadata file including the updates that have not been flushed yet.
+static int entry_read(metadummy_backend_options_t *options, const char *path, char **out_data, size_t *out_size, bool *out_exists) {
+  if (!options->flusher) return read_file(path, out_data, out_size, out_exists);
+  while (1) {
+    g_mutex_lock(&options->mutex);
+    uint64_t generation = options->generation;
+    g_mutex_unlock(&options->mutex);
+
+    int ret = read_file(path, out_data, out_size, out_exists);
+    if (ret != ESDM_SUCCESS) return ret;
+
+    g_mutex_lock(&options->mutex);
+    if (options->generation == generation) {
+      // the file is older than the batch that is being flushed, if any
+      pending_apply(pending_lookup(options->flushing, path), out_data, out_size, out_exists);
+      pending_apply(pending_lookup(options->pending, path), out_data, out_size, out_exists);
+      g_mutex_unlock(&options->mutex);
+      return ESDM_SUCCESS;
+    }
+    // a batch has been made visible while the file was read
+    g_mutex_unlock(&options->mutex);
+    free(*out_data);
+  }
+}
+
+static bool entry_exists(metadummy_backend_options_t *options, const char *path) {
+  g_mutex_lock(&options->mutex);
+  md_pending_write_t *entry = pending_lookup(options->pending, path);
+  if (!entry) entry = pending_lookup(options->flushing, path);
+  g_mutex_unlock(&options->mutex);
+  if (entry) return entry->kind != PENDING_REMOVE;
+  struct stat statbuf;
+  return stat(path, &statbuf) == 0;
+}
+
+//Replaces the content of a metadata file according to the durability mode.
+static int entry_commit(metadummy_backend_options_t *options, const char *path, char *data, size_t size) {
+  switch (options->durability) {
+    case ESDMI_METADATA_DURABILITY_NONE:
+      return entry_create(path, data, size);
+    case ESDMI_METADATA_DURABILITY_FSYNC: {
+      char tmp[PATH_MAX];
+      int ret = write_temp(path, data, size, tmp);
+      if (ret == ESDM_SUCCESS) ret = rename_temp(tmp, path);
+      if (ret == ESDM_SUCCESS) ret = sync_parent_dir(path);
+      return ret;
+    }
+    case ESDMI_METADATA_DURABILITY_GROUP:
+      return queue_update(options, path, PENDING_REPLACE, data, size);
+  }
+  return ESDM_ERROR;
+}
+
+static int entry_append(metadummy_backend_options_t *options, const char *path, char *data, size_t size) {
+  if (options->durability == ESDMI_METADATA_DURABILITY_GROUP) return queue_update(options, path, PENDING_APPEND, data, size);
+
+  bool created;
+  bool sync = options->durability == ESDMI_METADATA_DURABILITY_FSYNC;
+  int ret = append_file(path, data, size, sync, &created);
+  if (ret == ESDM_SUCCESS && sync && created) ret = sync_parent_dir(path);
+  return ret;
+}
+
+//Removes a metadata file, a missing file is only an error if `must_exist` is set.
+static int entry_remove(metadummy_backend_options_t *options, const char *path, bool must_exist) {
+  if (options->durability == ESDMI_METADATA_DURABILITY_GROUP) {
+    if (must_exist && !entry_exists(options, path)) return ESDM_ERROR;
+    return queue_update(options, path, PENDING_REMOVE, NULL, 0);
+  }
+
+  if (unlink(path) != 0) return errno == ENOENT && !must_exist ? ESDM_SUCCESS : ESDM_ERROR;
+  if (options->durability == ESDMI_METADATA_DURABILITY_FSYNC) return sync_parent_dir(path);
+  return ESDM_SUCCESS;
+}
+
 
 static int mkfs(esdm_md_backend_t *backend, int format_flags) {
   DEBUG_ENTER;
@@ -106,6 +510,7 @@ static int mkfs(esdm_md_backend_t *backend, int format_flags) {
     printf("[mkfs] error, the target name is to short (< 6 characters)!\n");
     return ESDM_ERROR;
   }
+  flush_pending(options); //queued updates must not recreate files after the directory has been removed
 
   struct stat sb;
   char path[PATH_MAX];
@@ -205,6 +610,12 @@ static int container_create(esdm_md_backend_t *backend, esdm_container_t *contai
 
   sprintf(path, "%s/containers/%s.md", tgt, container->name);
 
+  if (options->durability == ESDMI_METADATA_DURABILITY_GROUP) {
+    // the existence check can only be atomic with respect to this process, as the file may only be created by a later flush
+    if (!allow_overwrite && entry_exists(options, path)) return ESDM_ERROR;
+    return queue_update(options, path, PENDING_REPLACE, NULL, 0);
+  }
+
   int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, S_IWUSR | S_IRUSR | S_IWGRP | S_IRGRP | S_IROTH);
   if(fd < 0){
     if( allow_overwrite && errno == EEXIST ){
@@ -221,6 +632,7 @@ static int container_create(esdm_md_backend_t *backend, esdm_container_t *contai
   }
   close(fd);
 
+  if (options->durability == ESDMI_METADATA_DURABILITY_FSYNC) return sync_parent_dir(path);
   return ESDM_SUCCESS;
 }
 
@@ -232,10 +644,7 @@ static int container_remove(esdm_md_backend_t *backend, esdm_container_t *c){
   DEBUG("tgt: %p\n", tgt);
   sprintf(path_metadata, "%s/containers/%s.md", tgt, c->name);
 
-  if(unlink(path_metadata) == 0){
-    return ESDM_SUCCESS;
-  }
-  return ESDM_ERROR;
+  return entry_remove(options, path_metadata, true);
 }
 
 static int dataset_remove(esdm_md_backend_t * backend, esdm_dataset_t *d){
@@ -245,11 +654,11 @@ static int dataset_remove(esdm_md_backend_t * backend, esdm_dataset_t *d){
 
   DEBUG("tgt: %p\n", tgt);
 
+  sprintfDatasetJournal(path_metadata, d);
+  entry_remove(options, path_metadata, false); //there is only a journal if it has been written to since the last snapshot
+
   sprintfDatasetMd(path_metadata, d);
-  if(unlink(path_metadata) == 0){
-    return ESDM_SUCCESS;
-  }
-  return ESDM_ERROR;
+  return entry_remove(options, path_metadata, true);
 }
 
 static int container_commit(esdm_md_backend_t *backend, esdm_container_t *container, char * json, int md_size) {
@@ -265,7 +674,7 @@ static int container_commit(esdm_md_backend_t *backend, esdm_container_t *contai
   sprintf(path_metadata, "%s/containers/%s.md", tgt, container->name);
 
   // create metadata entry
-  esdm_status ret = entry_create(path_metadata, json, md_size);
+  esdm_status ret = entry_commit(options, path_metadata, json, md_size);
   return ret;
 }
 
@@ -279,26 +688,29 @@ static int container_retrieve(esdm_md_backend_t *backend, esdm_container_t *cont
 
   sprintf(path_metadata, "%s/containers/%s.md", tgt, container->name);
 
-  struct stat statbuf;
-  ret = stat(path_metadata, &statbuf);
-  if (ret != 0) return ESDM_ERROR;
-  off_t len = statbuf.st_size + 1;
-
-  int fd = open(path_metadata, O_RDONLY);
-  if (fd < 0) return ESDM_ERROR;
-  char * json = ea_checked_malloc(len);
-  ret = ea_read_check(fd, json, statbuf.st_size);
-  close(fd);
-  json[statbuf.st_size] = 0;
-  if (ret != 0){
-    return ESDM_ERROR;
-  }
+  char * json;
+  size_t size;
+  bool exists;
+  ret = entry_read(options, path_metadata, &json, &size, &exists);
+  if (ret != ESDM_SUCCESS || !exists) return ESDM_ERROR;
   *out_json = json;
-  *out_size = statbuf.st_size;
+  *out_size = size;
 
   return 0;
 }
 
+static int container_version(esdm_md_backend_t *backend, esdm_container_t *container, uint64_t * out_version) {
+  DEBUG_ENTER;
+  char path_metadata[PATH_MAX];
+
+  metadummy_backend_options_t *options = (metadummy_backend_options_t *)backend->data;
+  const char *tgt = options->target;
+
+  sprintf(path_metadata, "%s/containers/%s.md", tgt, container->name);
+  *out_version = 0xcbf29ce484222325ull;
+  return file_version(path_metadata, out_version);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Dataset Helpers ////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -306,6 +718,7 @@ static int container_retrieve(esdm_md_backend_t *backend, esdm_container_t *cont
 static int dataset_create(esdm_md_backend_t * backend, esdm_dataset_t *d){
   DEBUG_ENTER;
   char path_dataset[PATH_MAX];
+  char path_parent[PATH_MAX];
   eassert(backend);
   eassert(d);
 
@@ -324,6 +737,9 @@ static int dataset_create(esdm_md_backend_t * backend, esdm_dataset_t *d){
       if (stat(path_dataset, &sb) == -1) {
         int ret = mkdir_recursive(path_dataset);
         if (ret != 0 && errno != EEXIST) return ESDM_ERROR;
+        // the metadata file is synced along with its directory, but the directory itself needs to be durable as well
+        parent_dir(path_dataset, path_parent);
+        if (options->durability != ESDMI_METADATA_DURABILITY_NONE && sync_dir(path_parent) != ESDM_SUCCESS) return ESDM_ERROR;
       }
       return ESDM_SUCCESS;
     }
@@ -353,8 +769,51 @@ static int dataset_commit(esdm_md_backend_t *backend, esdm_dataset_t *dataset, c
   }
 
   // create metadata entry
-  esdm_status ret = entry_create(path_metadata, json, md_size);
-  return ret;
+  esdm_status ret = entry_commit(options, path_metadata, json, md_size);
+  if(ret != ESDM_SUCCESS) return ret;
+
+  // the new snapshot contains everything that was in the journal,
+  // if the journal survives a crash at this point, its entries are skipped because they refer to the old snapshot
+  sprintfDatasetJournal(path_metadata, dataset);
+  return entry_remove(options, path_metadata, false);
+}
+
+static int dataset_journal_append(esdm_md_backend_t *backend, esdm_dataset_t *dataset, char * record, int record_size) {
+  DEBUG_ENTER;
+
+  char path_journal[PATH_MAX];
+
+  metadummy_backend_options_t *options = (metadummy_backend_options_t *)backend->data;
+  const char *tgt = options->target;
+
+  sprintfDatasetJournal(path_journal, dataset);
+  return entry_append(options, path_journal, record, record_size);
+}
+
+static int dataset_journal_retrieve(esdm_md_backend_t *backend, esdm_dataset_t *d, char ** out_journal, int * out_size) {
+  DEBUG_ENTER;
+  char path_journal[PATH_MAX];
+
+  metadummy_backend_options_t *options = (metadummy_backend_options_t *)backend->data;
+  const char *tgt = options->target;
+
+  *out_journal = NULL;
+  *out_size = 0;
+
+  sprintfDatasetJournal(path_journal, d);
+  char * journal;
+  size_t size;
+  bool exists;
+  int ret = entry_read(options, path_journal, &journal, &size, &exists);
+  if (ret != ESDM_SUCCESS) return ret;
+  if (!size) {
+    free(journal);
+    return ESDM_SUCCESS;
+  }
+  *out_journal = journal;
+  *out_size = size;
+
+  return ESDM_SUCCESS;
 }
 
 static int dataset_retrieve(esdm_md_backend_t *backend, esdm_dataset_t *d, char ** out_json, int * out_size) {
@@ -366,26 +825,33 @@ static int dataset_retrieve(esdm_md_backend_t *backend, esdm_dataset_t *d, char
   const char *tgt = options->target;
 
   sprintfDatasetMd(path_metadata, d);
-  struct stat statbuf;
-  ret = stat(path_metadata, &statbuf);
-  if (ret != 0) return ESDM_ERROR;
-  off_t len = statbuf.st_size + 1;
-
-  int fd = open(path_metadata, O_RDONLY);
-  if (fd < 0) return ESDM_ERROR;
-  char * json = ea_checked_malloc(len);
-  ret = ea_read_check(fd, json, statbuf.st_size);
-  close(fd);
-  json[statbuf.st_size] = 0;
-  if (ret != 0){
-    return ESDM_ERROR;
-  }
+  char * json;
+  size_t size;
+  bool exists;
+  ret = entry_read(options, path_metadata, &json, &size, &exists);
+  if (ret != ESDM_SUCCESS || !exists) return ESDM_ERROR;
   *out_json = json;
-  *out_size = statbuf.st_size;
+  *out_size = size;
 
   return ESDM_SUCCESS;
 }
 
+static int dataset_version(esdm_md_backend_t *backend, esdm_dataset_t *d, uint64_t * out_version) {
+  DEBUG_ENTER;
+  char path[PATH_MAX];
+
+  metadummy_backend_options_t *options = (metadummy_backend_options_t *)backend->data;
+  const char *tgt = options->target;
+
+  //a commit either rewrites the snapshot or appends to the journal, so both files are part of the version
+  *out_version = 0xcbf29ce484222325ull;
+  sprintfDatasetMd(path, d);
+  int ret = file_version(path, out_version);
+  if (ret != ESDM_SUCCESS) return ret;
+  sprintfDatasetJournal(path, d);
+  return file_version(path, out_version);
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ESDM Callbacks /////////////////////////////////////////////////////////////
@@ -401,11 +867,26 @@ static int metadummy_backend_performance_estimate(esdm_md_backend_t *backend, es
 static int metadummy_finalize(esdm_md_backend_t *me) {
   DEBUG_ENTER;
 
+  metadummy_backend_options_t *options = (metadummy_backend_options_t *)me->data;
+  int ret = ESDM_SUCCESS;
+  if (options->flusher) {
+    g_mutex_lock(&options->mutex);
+    options->shutdown = true;
+    g_cond_broadcast(&options->changed);
+    g_mutex_unlock(&options->mutex);
+    g_thread_join(options->flusher);
+    ret = flush_pending(options);
+    g_hash_table_destroy(options->pending);
+    batch_release(options->pending_batch);
+    g_cond_clear(&options->changed);
+    g_mutex_clear(&options->mutex);
+  }
+
   free(me->data);
   free(me->config);
   free(me);
 
-  return 0;
+  return ret;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -425,11 +906,15 @@ static esdm_md_backend_t backend_template = {
     .container_commit = container_commit,
     .container_retrieve = container_retrieve,
     .container_remove = container_remove,
+    .container_version = container_version,
 
     .dataset_create = dataset_create,
     .dataset_commit = dataset_commit,
     .dataset_retrieve = dataset_retrieve,
     .dataset_remove = dataset_remove,
+    .dataset_journal_append = dataset_journal_append,
+    .dataset_journal_retrieve = dataset_journal_retrieve,
+    .dataset_version = dataset_version,
 
     .mkfs = mkfs,
     .fsck = fsck,
@@ -442,9 +927,18 @@ esdm_md_backend_t *metadummy_backend_init(esdm_config_backend_t *config) {
   esdm_md_backend_t *backend = ea_checked_malloc(sizeof(esdm_md_backend_t));
   memcpy(backend, &backend_template, sizeof(esdm_md_backend_t));
 
-  metadummy_backend_options_t *data = ea_checked_malloc(sizeof(metadummy_backend_options_t));
+  metadummy_backend_options_t *data = ea_checked_calloc(1, sizeof(metadummy_backend_options_t));
 
   data->target = config->target;
+  data->durability = config->metadata_durability;
+  data->group_commit_delay = config->group_commit_delay;
+  if (data->durability == ESDMI_METADATA_DURABILITY_GROUP) {
+    g_mutex_init(&data->mutex);
+    g_cond_init(&data->changed);
+    data->pending = pending_table_create();
+    data->pending_batch = batch_create();
+    data->flusher = g_thread_new("esdm-md-flush", flusher_thread, data);
+  }
   backend->data = data;
   backend->config = config;
   //metadummy_test();
@@ -18,11 +18,27 @@
 
 #include <esdm-internal.h>
 
+typedef struct md_pending_write_t md_pending_write_t; //defined in md-posix.c
+typedef struct md_batch_t md_batch_t; //defined in md-posix.c
+
 // Internal functions used by this backend.
 typedef struct {
   const char *type;
   const char *name;
   const char *target;
+
+  esdmI_metadata_durability_t durability;
+  int64_t group_commit_delay; //milliseconds
+
+  // group commit state, only used with ESDMI_METADATA_DURABILITY_GROUP
+  GMutex mutex;
+  GCond changed;  //signaled when updates are queued, when a flush completes, and on shutdown
+  GThread *flusher;
+  GHashTable *pending;  //path -> md_pending_write_t*, the updates that have not been flushed yet
+  md_batch_t *pending_batch;  //receives the outcome of the flush of `pending`
+  GHashTable *flushing; //path -> md_pending_write_t*, the batch that is currently being flushed, NULL if there is none
+  uint64_t generation;  //incremented whenever a batch has been made visible in the file system
+  bool shutdown;
 } metadummy_backend_options_t;
 
 // Internal functions used by this backend.
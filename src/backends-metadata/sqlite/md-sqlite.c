@@ -0,0 +1,686 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * @brief A metadata backend that stores the metadata in an embedded SQLite database.
+ *
+ * The database lives in a single file in the target directory and is used in WAL mode,
+ * so that several processes on one node can read consistent snapshots while another one commits.
+ *
+ * Instead of one metadata blob per dataset, this backend implements the fragment index callbacks:
+ * The dataset level metadata is stored without the fragments, each fragment is a row of its own,
+ * and the fragment bounds are indexed by an R*Tree, so that a read only retrieves the fragments that intersect the region it accesses.
+ *
+ * Every change of a container or dataset stores the next value of a database wide counter in its row,
+ * so that the metadata cache can detect changes made by other processes without retrieving the metadata.
+ * The counter never repeats a value, even if a container or dataset is removed and created again.
+ *
+ * All threads of a process share one connection. A transaction belongs to the connection, not to the thread that began it,
+ * so every callback holds the mutex of the backend from its first to its last statement, including the BEGIN and COMMIT.
+ */
+
+#define _GNU_SOURCE /* See feature_test_macros(7) */
+
+#include <errno.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "md-sqlite.h"
+#include <esdm-internal.h>
+
+#define DEBUG_ENTER ESDM_DEBUG_COM_FMT("MDSQLITE", "", "")
+#define DEBUG(fmt, ...) ESDM_DEBUG_COM_FMT("MDSQLITE", fmt, __VA_ARGS__)
+
+#define sprintfDatabase(path, tgt) (sprintf(path, "%s/esdm.sqlite", tgt))
+
+// An R*Tree has at most five dimensions. The first one holds the key of the dataset, so that a single tree serves all datasets,
+// the others hold the bounds of the first four dimensions of the fragments. Higher dimensions are not indexed.
+#define INDEXED_DIMS 4
+
+static const int kBusyTimeoutMs = 60000;  //how long to wait for another process that holds the write lock
+
+static const char kSchema[] =
+  "PRAGMA journal_mode=WAL;"
+  "PRAGMA synchronous=NORMAL;"
+  "CREATE TABLE IF NOT EXISTS version(id INTEGER PRIMARY KEY CHECK(id = 0), value INTEGER NOT NULL);"  //a single row with the last version that has been handed out
+  "INSERT OR IGNORE INTO version VALUES(0, 0);"
+  "CREATE TABLE IF NOT EXISTS containers(name TEXT PRIMARY KEY, md BLOB NOT NULL, version INTEGER NOT NULL);"
+  "CREATE TABLE IF NOT EXISTS datasets(key INTEGER PRIMARY KEY, id TEXT UNIQUE NOT NULL, md BLOB, version INTEGER NOT NULL DEFAULT 0);"  //`md` is NULL until the first commit
+  "CREATE TABLE IF NOT EXISTS fragments(id INTEGER PRIMARY KEY, dataset INTEGER NOT NULL, md BLOB NOT NULL);"
+  "CREATE INDEX IF NOT EXISTS fragments_by_dataset ON fragments(dataset);"
+  "CREATE VIRTUAL TABLE IF NOT EXISTS fragment_bounds USING rtree(id, minKey, maxKey, min0, max0, min1, max1, min2, max2, min3, max3);";
+
+typedef struct {
+  const char *target;
+  GMutex mutex; //protects `db`, held for the duration of each callback
+  sqlite3 *db;  //NULL until the first use
+} md_sqlite_backend_data_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal Helpers  //////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void logError(sqlite3 *db, const char *operation) {
+  ESDM_LOG_FMT(ESDM_LOGLEVEL_WARNING, "SQLite error in \"%s\": %s", operation, sqlite3_errmsg(db));
+}
+
+//Opens the database on first use, i.e. after `mkfs()` had a chance to create the target directory.
+//The caller must hold the mutex.
+static sqlite3 *database(esdm_md_backend_t *backend) {
+  md_sqlite_backend_data_t *data = (md_sqlite_backend_data_t *)backend->data;
+  if(data->db) return data->db;
+
+  char path[PATH_MAX];
+  sprintfDatabase(path, data->target);
+  sqlite3 *db;
+  if(sqlite3_open_v2(path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK) {
+    logError(db, path);
+    sqlite3_close(db);
+    return NULL;
+  }
+  sqlite3_busy_timeout(db, kBusyTimeoutMs);
+  if(sqlite3_exec(db, kSchema, NULL, NULL, NULL) != SQLITE_OK) {
+    logError(db, "schema creation");
+    sqlite3_close(db);
+    return NULL;
+  }
+  DEBUG("opened %s", path);
+  data->db = db;
+  return db;
+}
+
+//Locks the connection for the calling thread, returns NULL without holding the lock if the database cannot be opened.
+static sqlite3 *lockDatabase(esdm_md_backend_t *backend) {
+  md_sqlite_backend_data_t *data = (md_sqlite_backend_data_t *)backend->data;
+  g_mutex_lock(&data->mutex);
+  sqlite3 *db = database(backend);
+  if(!db) g_mutex_unlock(&data->mutex);
+  return db;
+}
+
+//Releases the connection and passes `ret` through.
+static int unlockDatabase(esdm_md_backend_t *backend, int ret) {
+  g_mutex_unlock(&((md_sqlite_backend_data_t *)backend->data)->mutex);
+  return ret;
+}
+
+static void closeDatabase(md_sqlite_backend_data_t *data) {
+  sqlite3_close_v2(data->db); //accepts NULL
+  data->db = NULL;
+}
+
+static int exec(sqlite3 *db, const char *sql) {
+  if(sqlite3_exec(db, sql, NULL, NULL, NULL) == SQLITE_OK) return ESDM_SUCCESS;
+  logError(db, sql);
+  return ESDM_ERROR;
+}
+
+static sqlite3_stmt *prepare(sqlite3 *db, const char *sql) {
+  sqlite3_stmt *stmt;
+  if(sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) return stmt;
+  logError(db, sql);
+  return NULL;
+}
+
+//Executes a statement that does not return rows, and resets it for reuse.
+static int step(sqlite3 *db, sqlite3_stmt *stmt) {
+  int rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  if(rc == SQLITE_DONE) return ESDM_SUCCESS;
+  logError(db, sqlite3_sql(stmt));
+  return ESDM_ERROR;
+}
+
+//Commits the transaction if `ret` signals success, otherwise rolls it back, returns the resulting status.
+static int endTransaction(sqlite3 *db, int ret) {
+  if(ret == ESDM_SUCCESS) {
+    ret = exec(db, "COMMIT");
+    if(ret == ESDM_SUCCESS) return ret;
+  }
+  exec(db, "ROLLBACK");
+  return ret;
+}
+
+//Returns the first column of the single result row as a `malloc()`ed, NUL terminated buffer, fails if there is no row.
+static int retrieveBlob(sqlite3 *db, sqlite3_stmt *stmt, char **out_md, int *out_size) {
+  int rc = sqlite3_step(stmt);
+  if(rc != SQLITE_ROW) {
+    if(rc != SQLITE_DONE) logError(db, sqlite3_sql(stmt));
+    return ESDM_ERROR;
+  }
+  const void *blob = sqlite3_column_blob(stmt, 0);
+  int size = sqlite3_column_bytes(stmt, 0);
+  char *md = ea_checked_malloc(size + 1);
+  if(size) memcpy(md, blob, size);
+  md[size] = 0;
+  *out_md = md;
+  *out_size = size;
+  return ESDM_SUCCESS;
+}
+
+//Advances the version counter and returns its new value, the caller must be inside a write transaction.
+static int nextVersion(sqlite3 *db, sqlite3_int64 *out_version) {
+  if(exec(db, "UPDATE version SET value = value + 1") != ESDM_SUCCESS) return ESDM_ERROR;
+  sqlite3_stmt *query = prepare(db, "SELECT value FROM version");
+  if(!query) return ESDM_ERROR;
+  int rc = sqlite3_step(query);
+  if(rc == SQLITE_ROW) *out_version = sqlite3_column_int64(query, 0);
+  else logError(db, sqlite3_sql(query));
+  sqlite3_finalize(query);
+  return rc == SQLITE_ROW ? ESDM_SUCCESS : ESDM_ERROR;
+}
+
+//Returns the version of the single result row, fails if there is no row.
+static int retrieveVersion(sqlite3 *db, sqlite3_stmt *stmt, uint64_t *out_version) {
+  int rc = sqlite3_step(stmt);
+  if(rc != SQLITE_ROW) {
+    if(rc != SQLITE_DONE) logError(db, sqlite3_sql(stmt));
+    return ESDM_ERROR;
+  }
+  *out_version = (uint64_t)sqlite3_column_int64(stmt, 0);
+  return ESDM_SUCCESS;
+}
+
+static int datasetKey(sqlite3 *db, esdm_dataset_t *d, sqlite3_int64 *out_key) {
+  sqlite3_stmt *query = prepare(db, "SELECT key FROM datasets WHERE id = ?1");
+  if(!query) return ESDM_ERROR;
+  sqlite3_bind_text(query, 1, d->id, -1, SQLITE_STATIC);
+  int rc = sqlite3_step(query);
+  if(rc == SQLITE_ROW) *out_key = sqlite3_column_int64(query, 0);
+  sqlite3_finalize(query);
+  return rc == SQLITE_ROW ? ESDM_SUCCESS : ESDM_ERROR;
+}
+
+//Replaces the dataset level metadata and advances the version of the dataset, the caller must be inside a write transaction.
+static int storeDataset(sqlite3 *db, esdm_dataset_t *d, char *json, int md_size, sqlite3_int64 *out_key) {
+  sqlite3_int64 version;
+  if(nextVersion(db, &version) != ESDM_SUCCESS) return ESDM_ERROR;
+  sqlite3_stmt *upsert = prepare(db, "INSERT INTO datasets(id, md, version) VALUES(?1, ?2, ?3) ON CONFLICT(id) DO UPDATE SET md = excluded.md, version = excluded.version");
+  if(!upsert) return ESDM_ERROR;
+  sqlite3_bind_text(upsert, 1, d->id, -1, SQLITE_STATIC);
+  sqlite3_bind_blob(upsert, 2, json, md_size, SQLITE_STATIC);
+  sqlite3_bind_int64(upsert, 3, version);
+  int ret = step(db, upsert);
+  sqlite3_finalize(upsert);
+  if(ret != ESDM_SUCCESS) return ret;
+  return datasetKey(db, d, out_key);
+}
+
+static int deleteFragments(sqlite3 *db, sqlite3_int64 key) {
+  sqlite3_stmt *deleteBounds = prepare(db, "DELETE FROM fragment_bounds WHERE id IN (SELECT id FROM fragments WHERE dataset = ?1)");
+  sqlite3_stmt *deleteRows = prepare(db, "DELETE FROM fragments WHERE dataset = ?1");
+  int ret = deleteBounds && deleteRows ? ESDM_SUCCESS : ESDM_ERROR;
+  if(ret == ESDM_SUCCESS) {
+    sqlite3_bind_int64(deleteBounds, 1, key);
+    sqlite3_bind_int64(deleteRows, 1, key);
+    ret = step(db, deleteBounds);
+    if(ret == ESDM_SUCCESS) ret = step(db, deleteRows);
+  }
+  sqlite3_finalize(deleteBounds); //accepts NULL
+  sqlite3_finalize(deleteRows);
+  return ret;
+}
+
+static int insertFragments(sqlite3 *db, sqlite3_int64 key, int64_t count, esdm_fragment_t **fragments) {
+  sqlite3_stmt *insertRow = prepare(db, "INSERT INTO fragments(dataset, md) VALUES(?1, ?2)");
+  sqlite3_stmt *insertBounds = prepare(db, "INSERT INTO fragment_bounds VALUES(?1, ?2, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)");
+  int ret = insertRow && insertBounds ? ESDM_SUCCESS : ESDM_ERROR;
+  for(int64_t i = 0; i < count && ret == ESDM_SUCCESS; i++) {
+    esdm_fragment_t *f = fragments[i];
+    smd_string_stream_t *s = smd_string_stream_create();
+    esdm_fragment_metadata_create(f, s);
+    size_t size;
+    char *md = smd_string_stream_close(s, &size);
+    sqlite3_bind_int64(insertRow, 1, key);
+    sqlite3_bind_blob(insertRow, 2, md, size, SQLITE_STATIC);
+    ret = step(db, insertRow);
+    free(md);
+    if(ret != ESDM_SUCCESS || !f->dataspace->dims) continue;  //without dimensions, there is nothing to index
+
+    // The R*Tree stores 32 bit floats, rounding the bounds outwards, so queries may return some false positives, but never miss a fragment.
+    // Unused dimensions are set to zero, queries never constrain them.
+    sqlite3_bind_int64(insertBounds, 1, sqlite3_last_insert_rowid(db));
+    sqlite3_bind_int64(insertBounds, 2, key);
+    for(int64_t dim = 0; dim < INDEXED_DIMS; dim++) {
+      int64_t start = dim < f->dataspace->dims ? f->dataspace->offset[dim] : 0;
+      int64_t end = dim < f->dataspace->dims ? start + f->dataspace->size[dim] : 0;
+      sqlite3_bind_double(insertBounds, 3 + 2*dim, (double)start);
+      sqlite3_bind_double(insertBounds, 4 + 2*dim, (double)end);
+    }
+    ret = step(db, insertBounds);
+  }
+  sqlite3_finalize(insertRow);  //accepts NULL
+  sqlite3_finalize(insertBounds);
+  return ret;
+}
+
+//Prepares the query for the fragments of the dataset that may intersect `region`.
+static sqlite3_stmt *prepareFragmentQuery(sqlite3 *db, sqlite3_int64 key, esdmI_hypercube_t *region) {
+  int64_t dims = region ? esdmI_hypercube_dimensions(region) : 0;
+  int64_t indexedDims = dims < INDEXED_DIMS ? dims : INDEXED_DIMS;
+  if(!indexedDims) {
+    sqlite3_stmt *query = prepare(db, "SELECT md FROM fragments WHERE dataset = ?1");
+    if(query) sqlite3_bind_int64(query, 1, key);
+    return query;
+  }
+
+  // The CROSS JOIN makes the R*Tree the outer loop, the dataset column of the fragments only filters out false positives caused by the rounding of the keys.
+  smd_string_stream_t *s = smd_string_stream_create();
+  smd_string_stream_printf(s, "SELECT f.md FROM fragment_bounds AS b CROSS JOIN fragments AS f ON f.id = b.id WHERE b.minKey <= ?1 AND b.maxKey >= ?1 AND f.dataset = ?1");
+  for(int64_t dim = 0; dim < indexedDims; dim++) {
+    smd_string_stream_printf(s, " AND b.max%" PRId64 " > ?%" PRId64 " AND b.min%" PRId64 " < ?%" PRId64, dim, 2 + 2*dim, dim, 3 + 2*dim);
+  }
+  size_t size;
+  char *sql = smd_string_stream_close(s, &size);
+  sqlite3_stmt *query = prepare(db, sql);
+  free(sql);
+  if(!query) return NULL;
+
+  int64_t offset[dims], count[dims];
+  esdmI_hypercube_getOffsetAndSize(region, offset, count);
+  sqlite3_bind_int64(query, 1, key);
+  for(int64_t dim = 0; dim < indexedDims; dim++) {
+    sqlite3_bind_double(query, 2 + 2*dim, (double)offset[dim]);
+    sqlite3_bind_double(query, 3 + 2*dim, (double)(offset[dim] + count[dim]));
+  }
+  return query;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper and utility /////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static int mkfs(esdm_md_backend_t *backend, int format_flags) {
+  DEBUG_ENTER;
+  md_sqlite_backend_data_t *data = (md_sqlite_backend_data_t *)backend->data;
+
+  // Enforce min target length?
+  const char *tgt = data->target;
+  if (strlen(tgt) < 6) {
+    printf("[mkfs] error, the target name is to short (< 6 characters)!\n");
+    return ESDM_ERROR;
+  }
+
+  struct stat sb;
+  char path[PATH_MAX];
+  int const ignore_err = format_flags & ESDM_FORMAT_IGNORE_ERRORS;
+
+  if (format_flags & ESDM_FORMAT_DELETE) {
+    printf("[mkfs] Removing %s\n", tgt);
+    g_mutex_lock(&data->mutex);
+    closeDatabase(data);
+    g_mutex_unlock(&data->mutex);
+
+    sprintf(path, "%s/README-ESDM.TXT", tgt);
+    if (stat(path, &sb) == 0) {
+      if(posix_recursive_remove(tgt)) {
+        fprintf(stderr, "[mkfs] Error removing ESDM directory at \"%s\"\n", tgt);
+        return ESDM_ERROR;
+      }
+    }else if(! ignore_err){
+      printf("[mkfs] Error %s is not an ESDM directory\n", tgt);
+      return ESDM_ERROR;
+    }
+  }
+
+  if(! (format_flags & ESDM_FORMAT_CREATE)){
+    return ESDM_SUCCESS;
+  }
+  if (stat(tgt, &sb) == 0) {
+    if(! ignore_err){
+      printf("[mkfs] Error %s exists already\n", tgt);
+      return ESDM_ERROR;
+    }
+    printf("[mkfs] WARNING %s exists already\n", tgt);
+  }
+
+  printf("[mkfs] Creating %s\n", tgt);
+
+  if (mkdir(tgt, 0700) != 0) {
+    if(ignore_err){
+      printf("[mkfs] WARNING couldn't create dir %s\n", tgt);
+    }else{
+      return ESDM_ERROR;
+    }
+  }
+
+  sprintf(path, "%s/README-ESDM.TXT", tgt);
+  FILE *readme = fopen(path, "w");
+  if (! readme) {
+    return ESDM_ERROR;
+  }
+  fprintf(readme, "This directory belongs to ESDM and contains the SQLite database with the metadata. Do not delete it until you know what you are doing.");
+  fclose(readme);
+
+  if(!lockDatabase(backend)) return ESDM_ERROR;
+  return unlockDatabase(backend, ESDM_SUCCESS);
+}
+
+static int fsck(esdm_md_backend_t* backend) {
+  DEBUG_ENTER;
+
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Container Helpers //////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+//Inserts or replaces the row of the container with the next version, `sql` takes the name, the metadata, and the version.
+static int storeContainer(esdm_md_backend_t *backend, esdm_container_t *container, const char *sql, char *json, int md_size) {
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  if(exec(db, "BEGIN IMMEDIATE") != ESDM_SUCCESS) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_int64 version;
+  int ret = nextVersion(db, &version);
+  if(ret == ESDM_SUCCESS) {
+    sqlite3_stmt *insert = prepare(db, sql);
+    if(insert) {
+      sqlite3_bind_text(insert, 1, container->name, -1, SQLITE_STATIC);
+      sqlite3_bind_blob(insert, 2, json, md_size, SQLITE_STATIC);
+      sqlite3_bind_int64(insert, 3, version);
+      ret = step(db, insert);
+      sqlite3_finalize(insert);
+    } else {
+      ret = ESDM_ERROR;
+    }
+  }
+  return unlockDatabase(backend, endTransaction(db, ret));
+}
+
+static int container_create(esdm_md_backend_t *backend, esdm_container_t *container, int allow_overwrite) {
+  DEBUG_ENTER;
+  const char *sql = allow_overwrite ? "INSERT OR REPLACE INTO containers(name, md, version) VALUES(?1, ?2, ?3)" : "INSERT INTO containers(name, md, version) VALUES(?1, ?2, ?3)";
+  return storeContainer(backend, container, sql, "", 0);
+}
+
+static int container_commit(esdm_md_backend_t *backend, esdm_container_t *container, char * json, int md_size) {
+  DEBUG_ENTER;
+  return storeContainer(backend, container, "INSERT OR REPLACE INTO containers(name, md, version) VALUES(?1, ?2, ?3)", json, md_size);
+}
+
+static int container_retrieve(esdm_md_backend_t *backend, esdm_container_t *container, char ** out_json, int * out_size) {
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  sqlite3_stmt *query = prepare(db, "SELECT md FROM containers WHERE name = ?1");
+  if(!query) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_bind_text(query, 1, container->name, -1, SQLITE_STATIC);
+  int ret = retrieveBlob(db, query, out_json, out_size);
+  sqlite3_finalize(query);
+  return unlockDatabase(backend, ret);
+}
+
+static int container_version(esdm_md_backend_t *backend, esdm_container_t *container, uint64_t * out_version) {
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  sqlite3_stmt *query = prepare(db, "SELECT version FROM containers WHERE name = ?1");
+  if(!query) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_bind_text(query, 1, container->name, -1, SQLITE_STATIC);
+  int ret = retrieveVersion(db, query, out_version);
+  sqlite3_finalize(query);
+  return unlockDatabase(backend, ret);
+}
+
+static int container_remove(esdm_md_backend_t *backend, esdm_container_t *c){
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  sqlite3_stmt *remove = prepare(db, "DELETE FROM containers WHERE name = ?1");
+  if(!remove) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_bind_text(remove, 1, c->name, -1, SQLITE_STATIC);
+  int ret = step(db, remove);
+  sqlite3_finalize(remove);
+  if(ret == ESDM_SUCCESS && !sqlite3_changes(db)) ret = ESDM_ERROR;  //there was no such container
+  return unlockDatabase(backend, ret);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Dataset Helpers ////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static int dataset_create(esdm_md_backend_t * backend, esdm_dataset_t *d){
+  DEBUG_ENTER;
+  eassert(backend);
+  eassert(d);
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  // reserving the row makes the choice of the ID atomic, even with other processes creating datasets concurrently
+  sqlite3_stmt *insert = prepare(db, "INSERT INTO datasets(id) VALUES(?1)");
+  if(!insert) return unlockDatabase(backend, ESDM_ERROR);
+  while(1){
+    d->id = ea_make_id(ESDM_ID_LENGTH);
+    sqlite3_bind_text(insert, 1, d->id, -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(insert);
+    sqlite3_reset(insert);
+    if(rc == SQLITE_DONE) break;
+
+    free(d->id);  //we'll make a new ID
+    d->id = NULL;
+    if(rc != SQLITE_CONSTRAINT) {
+      logError(db, sqlite3_sql(insert));
+      sqlite3_finalize(insert);
+      return unlockDatabase(backend, ESDM_ERROR);
+    }
+  }
+  sqlite3_finalize(insert);
+  return unlockDatabase(backend, ESDM_SUCCESS);
+}
+
+static int dataset_commit(esdm_md_backend_t *backend, esdm_dataset_t *d, char * json, int md_size) {
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  // a complete snapshot lists all fragments itself, so it replaces the indexed ones
+  if(exec(db, "BEGIN IMMEDIATE") != ESDM_SUCCESS) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_int64 key;
+  int ret = storeDataset(db, d, json, md_size, &key);
+  if(ret == ESDM_SUCCESS) ret = deleteFragments(db, key);
+  return unlockDatabase(backend, endTransaction(db, ret));
+}
+
+static int dataset_commit_fragments(esdm_md_backend_t *backend, esdm_dataset_t *d, char * json, int md_size, int64_t fragment_count, esdm_fragment_t ** fragments) {
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  // one transaction for the whole commit instead of one implicit transaction per row
+  if(exec(db, "BEGIN IMMEDIATE") != ESDM_SUCCESS) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_int64 key;
+  int ret = storeDataset(db, d, json, md_size, &key);
+  if(ret == ESDM_SUCCESS) ret = insertFragments(db, key, fragment_count, fragments);
+  DEBUG("committed dataset %s with %"PRId64" new fragments", d->id, fragment_count);
+  return unlockDatabase(backend, endTransaction(db, ret));
+}
+
+static int dataset_retrieve(esdm_md_backend_t *backend, esdm_dataset_t *d, char ** out_json, int * out_size) {
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  sqlite3_stmt *query = prepare(db, "SELECT md FROM datasets WHERE id = ?1 AND md IS NOT NULL");
+  if(!query) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_bind_text(query, 1, d->id, -1, SQLITE_STATIC);
+  int ret = retrieveBlob(db, query, out_json, out_size);
+  sqlite3_finalize(query);
+  return unlockDatabase(backend, ret);
+}
+
+//`dataset_commit()` and `dataset_commit_fragments()` both store the dataset level metadata, so the version also covers the indexed fragments.
+static int dataset_version(esdm_md_backend_t *backend, esdm_dataset_t *d, uint64_t * out_version) {
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  sqlite3_stmt *query = prepare(db, "SELECT version FROM datasets WHERE id = ?1 AND md IS NOT NULL");
+  if(!query) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_bind_text(query, 1, d->id, -1, SQLITE_STATIC);
+  int ret = retrieveVersion(db, query, out_version);
+  sqlite3_finalize(query);
+  return unlockDatabase(backend, ret);
+}
+
+static int dataset_fragments_retrieve(esdm_md_backend_t *backend, esdm_dataset_t *d, esdmI_hypercube_t *region, char ** out_json, int * out_size) {
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  // a read transaction, so that the key and the fragments come from the same snapshot
+  if(exec(db, "BEGIN") != ESDM_SUCCESS) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_int64 key;
+  int ret = datasetKey(db, d, &key);
+  sqlite3_stmt *query = NULL;
+  if(ret == ESDM_SUCCESS) {
+    query = prepareFragmentQuery(db, key, region);
+    if(!query) ret = ESDM_ERROR;
+  }
+  if(ret != ESDM_SUCCESS) return unlockDatabase(backend, endTransaction(db, ret));
+
+  smd_string_stream_t *s = smd_string_stream_create();
+  smd_string_stream_printf(s, "[");
+  int64_t count = 0;
+  int rc;
+  while((rc = sqlite3_step(query)) == SQLITE_ROW) {
+    smd_string_stream_printf(s, "%s%.*s", count++ ? "," : "", sqlite3_column_bytes(query, 0), (const char *)sqlite3_column_blob(query, 0));
+  }
+  smd_string_stream_printf(s, "]");
+  if(rc != SQLITE_DONE) {
+    logError(db, sqlite3_sql(query));
+    ret = ESDM_ERROR;
+  }
+  sqlite3_finalize(query);
+  size_t size;
+  char *json = smd_string_stream_close(s, &size);
+  ret = unlockDatabase(backend, endTransaction(db, ret));
+  if(ret != ESDM_SUCCESS) {
+    free(json);
+    return ret;
+  }
+
+  DEBUG("retrieved %"PRId64" fragments of dataset %s", count, d->id);
+  *out_json = json;
+  *out_size = size;
+  return ESDM_SUCCESS;
+}
+
+static int dataset_remove(esdm_md_backend_t * backend, esdm_dataset_t *d){
+  DEBUG_ENTER;
+  sqlite3 *db = lockDatabase(backend);
+  if(!db) return ESDM_ERROR;
+
+  if(exec(db, "BEGIN IMMEDIATE") != ESDM_SUCCESS) return unlockDatabase(backend, ESDM_ERROR);
+  sqlite3_int64 key;
+  int ret = datasetKey(db, d, &key);
+  if(ret == ESDM_SUCCESS) ret = deleteFragments(db, key);
+  if(ret == ESDM_SUCCESS) {
+    sqlite3_stmt *remove = prepare(db, "DELETE FROM datasets WHERE key = ?1");
+    if(remove) {
+      sqlite3_bind_int64(remove, 1, key);
+      ret = step(db, remove);
+      sqlite3_finalize(remove);
+    } else {
+      ret = ESDM_ERROR;
+    }
+  }
+  return unlockDatabase(backend, endTransaction(db, ret));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ESDM Callbacks /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static int md_sqlite_backend_performance_estimate(esdm_md_backend_t *backend, esdm_fragment_t *fragment, float *out_time) {
+  DEBUG_ENTER;
+  *out_time = 0;
+
+  return 0;
+}
+
+static int md_sqlite_finalize(esdm_md_backend_t *me) {
+  DEBUG_ENTER;
+
+  md_sqlite_backend_data_t *data = (md_sqlite_backend_data_t *)me->data;
+  closeDatabase(data);
+  g_mutex_clear(&data->mutex);
+  free(data);
+  free(me->config);
+  free(me);
+
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ESDM Module Registration ///////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static esdm_md_backend_t backend_template = {
+  .name = "sqlite",
+  .version = "0.0.1",
+  .data = NULL,
+  .callbacks = {
+    // General for ESDM
+    .finalize = md_sqlite_finalize,
+    .performance_estimate = md_sqlite_backend_performance_estimate,
+
+    .container_create = container_create,
+    .container_commit = container_commit,
+    .container_retrieve = container_retrieve,
+    .container_remove = container_remove,
+    .container_version = container_version,
+
+    .dataset_create = dataset_create,
+    .dataset_commit = dataset_commit,
+    .dataset_retrieve = dataset_retrieve,
+    .dataset_remove = dataset_remove,
+    .dataset_commit_fragments = dataset_commit_fragments,
+    .dataset_fragments_retrieve = dataset_fragments_retrieve,
+    .dataset_version = dataset_version,
+
+    .mkfs = mkfs,
+    .fsck = fsck,
+  },
+};
+
+esdm_md_backend_t *md_sqlite_backend_init(esdm_config_backend_t *config) {
+  DEBUG_ENTER;
+
+  esdm_md_backend_t *backend = ea_checked_malloc(sizeof(esdm_md_backend_t));
+  memcpy(backend, &backend_template, sizeof(esdm_md_backend_t));
+
+  md_sqlite_backend_data_t *data = ea_checked_malloc(sizeof(md_sqlite_backend_data_t));
+  *data = (md_sqlite_backend_data_t){
+    .target = config->target,
+    .db = NULL
+  };
+  g_mutex_init(&data->mutex);
+  backend->data = data;
+  backend->config = config;
+
+  return backend;
+}
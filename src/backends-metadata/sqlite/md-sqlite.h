@@ -0,0 +1,40 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * @brief A metadata backend that stores the metadata in an embedded SQLite database.
+ */
+#ifndef MD_SQLITE_H
+#define MD_SQLITE_H
+
+#include <esdm-internal.h>
+
+/**
+* Initializes the SQLite plugin.
+*
+* The database is kept in the target directory of the configuration, it is opened on first use.
+* Containers and datasets are stored as rows, the fragments of a dataset are stored as rows as well,
+* indexed by an R*Tree over their hyperslab bounds, so that a read only needs to load the fragments of the region it accesses.
+*
+* Takes possession of the config argument. Pass a `malloc()`ed object.
+*
+* @return pointer to backend struct
+*/
+
+esdm_md_backend_t *md_sqlite_backend_init(esdm_config_backend_t *config);
+
+#endif
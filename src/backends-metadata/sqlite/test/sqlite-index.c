@@ -0,0 +1,143 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test writes a dataset with an unlimited dimension to the SQLite metadata backend in several commits,
+ * and checks after a restart that a read only retrieves the fragments of the region it accesses.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 16
+#define WIDTH  100
+#define COUNT  10
+
+static void init() {
+  esdm_status ret = esdm_load_config_str("{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\" } ], \"metadata\": { \"type\": \"sqlite\", \"id\": \"md\", \"target\": \"./_mdsqlite\" } } }");
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void finalize(esdm_container_t *container, esdm_dataset_t *dataset) {
+  esdm_status ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void readRows(esdm_dataset_t *dataset, int64_t firstRow, int64_t rowCount, uint64_t *expected) {
+  uint64_t *buf = ea_checked_malloc(rowCount * WIDTH * sizeof(uint64_t));
+  memset(buf, 0, rowCount * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t subspace = esdm_dataspace_2do(firstRow, rowCount, 0, WIDTH, SMD_DTYPE_UINT64);
+  esdm_status ret = esdm_read(dataset, buf, subspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(!memcmp(buf, expected + firstRow * WIDTH, rowCount * WIDTH * sizeof(uint64_t)));
+  free(buf);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < COUNT * HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  init();
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_dataspace_t *dataspace;
+  ret = esdm_dataspace_create(2, (int64_t[]){0, WIDTH}, SMD_DTYPE_UINT64, &dataspace);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataspace_destroy(dataspace);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+
+  // every commit changes the version that the metadata cache checks
+  esdm_md_backend_t *backend = esdm_get_modules()->metadata_backend;
+  uint64_t containerVersion, version, lastVersion = 0;
+  ret = backend->callbacks.container_version(backend, container, &containerVersion);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = backend->callbacks.container_version(backend, container, &version);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(version != containerVersion);
+
+  // write one fragment per slice, committing twice, each commit only adds its own fragments to the index
+  for (int n = 0; n < COUNT; n++) {
+    esdm_simple_dspace_t subspace = esdm_dataspace_2do(n * HEIGHT, HEIGHT, 0, WIDTH, SMD_DTYPE_UINT64);
+    ret = esdm_write(dataset, buf_w + n * HEIGHT * WIDTH, subspace.ptr);
+    eassert(ret == ESDM_SUCCESS);
+    if(n == COUNT/2 - 1 || n == COUNT - 1) {
+      ret = esdm_dataset_commit(dataset);
+      eassert(ret == ESDM_SUCCESS);
+      eassert(dataset->fragments.uncommittedCount == 0);
+      ret = backend->callbacks.dataset_version(backend, dataset, &version);
+      eassert(ret == ESDM_SUCCESS);
+      eassert(version != lastVersion);
+      lastVersion = version;
+    }
+  }
+  finalize(container, dataset);
+
+  // restart and read the data back piece by piece
+  init();
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  // the actual size is known before any fragment is retrieved
+  eassert(dataset->indexedRegions);
+  eassert(g_hash_table_size(dataset->fragments.table) == 0);
+  eassert(esdm_dataset_get_actual_size(dataset)[0] == COUNT * HEIGHT);
+
+  readRows(dataset, 2 * HEIGHT, 2 * HEIGHT, buf_w);
+  printf("fragments retrieved for two slices = %u (expected 2)\n", g_hash_table_size(dataset->fragments.table));
+  eassert(g_hash_table_size(dataset->fragments.table) == 2);
+
+  readRows(dataset, 0, COUNT * HEIGHT, buf_w);
+  eassert(g_hash_table_size(dataset->fragments.table) == COUNT);
+  finalize(container, dataset);
+
+  // deleting the dataset removes the indexed fragments as well
+  init();
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ | ESDM_MODE_FLAG_WRITE, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_delete(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
@@ -61,6 +61,24 @@ esdm_config_t *esdm_config_init_from_str(const char *config_str) {
     }
   }
 
+  config->copyThreads = ESDMI_COPY_THREADS_DEFAULT;
+  json_t* elem = jansson_object_get(esdm_e, "copy-threads");
+  if(elem) {
+    if(!json_is_integer(elem) || json_integer_value(elem) < 0) {
+      ESDM_ERROR("Configuration: copy-threads must be a non-negative integer");
+    }
+    config->copyThreads = json_integer_value(elem);
+  }
+
+  config->copyMinBytesPerThread = ESDMI_COPY_MIN_BYTES_PER_THREAD_DEFAULT;
+  elem = jansson_object_get(esdm_e, "copy-min-bytes-per-thread");
+  if(elem) {
+    if(!json_is_integer(elem) || json_integer_value(elem) < 0) {
+      ESDM_ERROR("Configuration: copy-min-bytes-per-thread must be a non-negative integer");
+    }
+    config->copyMinBytesPerThread = json_integer_value(elem);
+  }
+
   return config;
 }
 
@@ -164,6 +182,88 @@ esdm_config_backend_t *esdm_config_get_metadata_coordinator(esdm_instance_t *esd
   } else {
     config_backend->data_accessibility = ESDM_ACCESSIBILITY_GLOBAL;
   }
+
+  elem = jansson_object_get(config_backend->backend, "format");
+  if (elem != NULL) {
+    const char *str = json_string_value(elem);
+    if (!str) {
+      ESDM_ERROR("Configuration: \"format\" tag is not a string");
+    } else if (strcasecmp(str, "json") == 0) {
+      config_backend->metadata_format = ESDMI_METADATA_FORMAT_JSON;
+    } else if (strcasecmp(str, "binary") == 0) {
+      config_backend->metadata_format = ESDMI_METADATA_FORMAT_BINARY;
+    } else {
+      ESDM_ERROR_FMT("Configuration: unrecognized value of \"format\" tag: \"%s\"", str);
+    }
+  } else {
+    config_backend->metadata_format = ESDMI_METADATA_FORMAT_JSON;
+  }
+
+  elem = jansson_object_get(config_backend->backend, "journal");
+  if (elem != NULL) {
+    if (!json_is_integer(elem) || json_integer_value(elem) < 0) {
+      ESDM_ERROR("Configuration: journal must be a non-negative integer");
+    }
+    config_backend->journal_max_entries = json_integer_value(elem);
+  } else {
+    config_backend->journal_max_entries = 0;
+  }
+
+  elem = jansson_object_get(config_backend->backend, "durability");
+  if (elem != NULL) {
+    const char *str = json_string_value(elem);
+    if (str && strcasecmp(str, "none") == 0) {
+      config_backend->metadata_durability = ESDMI_METADATA_DURABILITY_NONE;
+    } else if (str && strcasecmp(str, "fsync") == 0) {
+      config_backend->metadata_durability = ESDMI_METADATA_DURABILITY_FSYNC;
+    } else if (str && strcasecmp(str, "group") == 0) {
+      config_backend->metadata_durability = ESDMI_METADATA_DURABILITY_GROUP;
+    } else {
+      ESDM_ERROR("Unknown metadata durability!");
+    }
+  } else {
+    config_backend->metadata_durability = ESDMI_METADATA_DURABILITY_NONE;
+  }
+
+  elem = jansson_object_get(config_backend->backend, "group-commit-delay");
+  if (elem != NULL) {
+    if (!json_is_integer(elem) || json_integer_value(elem) < 0) {
+      ESDM_ERROR("Configuration: group-commit-delay must be a non-negative integer");
+    }
+    config_backend->group_commit_delay = json_integer_value(elem);
+  } else {
+    config_backend->group_commit_delay = 100;
+  }
+
+  elem = jansson_object_get(config_backend->backend, "cache-size");
+  if (elem != NULL) {
+    if (!json_is_integer(elem) || json_integer_value(elem) < 0) {
+      ESDM_ERROR("Configuration: cache-size must be a non-negative integer");
+    }
+    config_backend->metadata_cache_size = json_integer_value(elem);
+  } else {
+    config_backend->metadata_cache_size = 0;
+  }
+
+  elem = jansson_object_get(config_backend->backend, "cache-validate");
+  if (elem != NULL) {
+    if (!json_is_boolean(elem)) {
+      ESDM_ERROR("Configuration: cache-validate must be a boolean");
+    }
+    config_backend->metadata_cache_validate = json_is_true(elem);
+  } else {
+    config_backend->metadata_cache_validate = true;
+  }
+
+  elem = jansson_object_get(config_backend->backend, "mpi-shared");
+  if (elem != NULL) {
+    if (!json_is_boolean(elem)) {
+      ESDM_ERROR("Configuration: mpi-shared must be a boolean");
+    }
+    config_backend->metadata_mpi_shared = json_is_true(elem);
+  } else {
+    config_backend->metadata_mpi_shared = false;
+  }
   return config_backend;
 }
 
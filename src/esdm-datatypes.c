@@ -188,11 +188,21 @@ esdm_status esdm_container_open_md_parse(esdm_container_t *c, char * md, int siz
   return ESDM_SUCCESS;
 }
 
-esdm_status esdm_container_open_md_load(esdm_container_t *c, char ** out_md, int * out_size){
+//The metadata cache, or NULL if it is disabled or ESDM is not initialized.
+static esdmI_metadataCache_t* esdmI_metadataCache(){
+  esdm_modules_t* modules = esdmI_esdm()->modules;
+  return modules ? modules->metadata_cache : NULL;
+}
+
+static esdm_status esdmI_container_retrieveMetadata(esdm_container_t *c, char ** out_md, int * out_size){
   esdm_modules_t* modules = esdm_get_modules();
   return modules->metadata_backend->callbacks.container_retrieve(modules->metadata_backend, c, out_md, out_size);
 }
 
+esdm_status esdm_container_open_md_load(esdm_container_t *c, char ** out_md, int * out_size){
+  return esdmI_metadataCache_loadContainer(esdmI_metadataCache(), c, esdmI_container_retrieveMetadata, out_md, out_size);
+}
+
 esdm_status esdm_container_open(char const *name, int esdm_mode_flags, esdm_container_t **out_container) {
   ESDM_DEBUG(__func__);
   eassert(out_container);
@@ -224,16 +234,15 @@ esdm_status esdm_container_open(char const *name, int esdm_mode_flags, esdm_cont
   return ESDM_SUCCESS;
 }
 
-static void esdmI_dataset_update_actual_size(esdm_dataset_t *d, esdm_fragment_t *frag){
+void esdmI_dataset_extendActualSize(esdm_dataset_t *d, const int64_t *offset, const int64_t *size){
   eassert(d);
-  eassert(frag);
   if(! d->actual_size){
     return;
   }
   // update the actual dimension size
   for (int i = 0; i < d->dataspace->dims; i++) {
     if(d->dataspace->size[i] == 0){
-      int64_t fend = frag->dataspace->size[i] + frag->dataspace->offset[i];
+      int64_t fend = size[i] + offset[i];
       if(fend > d->actual_size[i]){
         d->actual_size[i] = fend;
       }
@@ -241,6 +250,11 @@ static void esdmI_dataset_update_actual_size(esdm_dataset_t *d, esdm_fragment_t
   }
 }
 
+static void esdmI_dataset_update_actual_size(esdm_dataset_t *d, esdm_fragment_t *frag){
+  eassert(frag);
+  esdmI_dataset_extendActualSize(d, frag->dataspace->offset, frag->dataspace->size);
+}
+
 void esdmI_datasets_reference_metadata_create(esdm_container_t *c, smd_string_stream_t * s){
   smd_string_stream_printf(s, "[");
   esdm_datasets_t * d = & c->dsets;
@@ -279,6 +293,7 @@ esdm_status esdm_container_commit(esdm_container_t *c) {
 
   esdm_modules_t* modules = esdm_get_modules();
   esdm_status ret =  modules->metadata_backend->callbacks.container_commit(modules->metadata_backend, c, buff, md_size);
+  esdmI_metadataCache_invalidateContainer(modules->metadata_cache, c);
 
   // Also commit uncommited datasets of this container: cannot do this as it depends on how we are called
   esdm_datasets_t * dsets = & c->dsets;
@@ -460,24 +475,32 @@ esdm_status esdmI_fragment_create(esdm_dataset_t *d, esdm_dataspace_t *sspace, v
   return ESDM_SUCCESS;
 }
 
+//Ensure that a fragment that is to be retrieved has a buffer to write to.
+static esdm_status fragment_allocateBuffer(esdm_fragment_t *fragment) {
+  if(fragment->buf) return ESDM_SUCCESS;
+  if(fragment->dataspace->stride) { //since we need to allocate memory anyways, ensure that we work with a contiguous dataspace
+    esdm_dataspace_t* contiguousSpace;
+    esdm_status ret = esdm_dataspace_makeContiguous(fragment->dataspace, &contiguousSpace);
+    if(ret != ESDM_SUCCESS) return ret;
+    esdm_dataspace_destroy(fragment->dataspace);
+    fragment->dataspace = contiguousSpace;
+  }
+  eassert(!fragment->dataspace->stride);
+
+  int64_t bytes = esdm_dataspace_total_bytes(fragment->dataspace);
+  esdm_backend_t *backend = fragment->backend;
+  fragment->buf = backend && backend->alignment ? ea_checked_memalign(backend->alignment, bytes) : ea_checked_malloc(bytes);  //lets the backend read directly into the buffer
+  fragment->ownsBuf = true;
+  return ESDM_SUCCESS;
+}
+
 esdm_status esdm_fragment_retrieve(esdm_fragment_t *fragment) {
   ESDM_DEBUG(__func__);
   // Call backend
   switch(fragment->status) {
     case ESDM_DATA_NOT_LOADED: {
-      if(!fragment->buf) {
-        if(fragment->dataspace->stride) { //since we need to allocate memory anyways, ensure that we work with a contiguous dataspace
-          esdm_dataspace_t* contiguousSpace;
-          esdm_status ret = esdm_dataspace_makeContiguous(fragment->dataspace, &contiguousSpace);
-          if(ret != ESDM_SUCCESS) return ret;
-          esdm_dataspace_destroy(fragment->dataspace);
-          fragment->dataspace = contiguousSpace;
-        }
-        eassert(!fragment->dataspace->stride);
-
-        fragment->buf = ea_checked_malloc(esdm_dataspace_total_bytes(fragment->dataspace));  //ensure that we have a buffer to write to
-        fragment->ownsBuf = true;
-      }
+      esdm_status allocRet = fragment_allocateBuffer(fragment);
+      if(allocRet != ESDM_SUCCESS) return allocRet;
       esdm_backend_t *backend = fragment->backend;
       int ret = esdmI_backend_fragment_retrieve(backend, fragment);
       if(ret == ESDM_SUCCESS){
@@ -533,8 +556,13 @@ void esdm_fragment_metadata_create(esdm_fragment_t *f, smd_string_stream_t * str
   smd_string_stream_printf(stream, "{\"id\":\"%s\",\"pid\":\"%s\",\"act-size\":%ld,\"space\":", f->id, pid, f->actual_bytes);
   esdm_dataspace_serialize(f->dataspace, stream);
   if(f->backend->callbacks.fragment_metadata_create){
-    smd_string_stream_printf(stream, ",\"backend\":");
-    esdmI_backend_fragment_metadata_create(f->backend, f, stream);
+    //the backend may decide that this fragment does not need any metadata of its own
+    smd_string_stream_t* backendStream = smd_string_stream_create();
+    esdmI_backend_fragment_metadata_create(f->backend, f, backendStream);
+    size_t backendJsonSize;
+    char* backendJson = smd_string_stream_close(backendStream, &backendJsonSize);
+    if(backendJsonSize) smd_string_stream_printf(stream, ",\"backend\":%s", backendJson);
+    free(backendJson);
   }
   smd_string_stream_printf(stream, "}");
 }
@@ -551,6 +579,60 @@ esdm_status esdm_fragment_commit(esdm_fragment_t *f) {
   return ret;
 }
 
+void esdmI_fragment_loadBatch(int64_t count, esdm_fragment_t **fragments, esdm_status *out_rets) {
+  ESDM_DEBUG(__func__);
+  if(!count) return;
+  esdm_backend_t *backend = fragments[0]->backend;
+  if(!backend->callbacks.fragments_retrieve) {
+    for(int64_t i = 0; i < count; i++) out_rets[i] = esdm_fragment_load(fragments[i]);
+    return;
+  }
+
+  //only the fragments that are not loaded, yet, need to go to the backend, the others are handled like `esdm_fragment_load()` does
+  esdm_fragment_t **todo = ea_checked_malloc(count*sizeof(*todo));
+  int64_t *todoIndices = ea_checked_malloc(count*sizeof(*todoIndices));
+  int64_t todoCount = 0;
+  for(int64_t i = 0; i < count; i++) {
+    esdm_fragment_t *f = fragments[i];
+    eassert(f->backend == backend);
+    if(f->status != ESDM_DATA_NOT_LOADED) {
+      out_rets[i] = esdm_fragment_load(f);
+    } else if((out_rets[i] = fragment_allocateBuffer(f)) == ESDM_SUCCESS) {
+      todo[todoCount] = f;
+      todoIndices[todoCount++] = i;
+    }
+  }
+
+  int *rets = ea_checked_malloc(count*sizeof(*rets));
+  if(todoCount) esdmI_backend_fragments_retrieve(backend, todoCount, todo, rets);
+  for(int64_t i = 0; i < todoCount; i++) {
+    if(rets[i] == ESDM_SUCCESS) todo[i]->status = ESDM_DATA_PERSISTENT;
+    out_rets[todoIndices[i]] = rets[i];
+  }
+  free(rets);
+  free(todoIndices);
+  free(todo);
+}
+
+void esdmI_fragment_commitBatch(int64_t count, esdm_fragment_t **fragments, esdm_status *out_rets) {
+  ESDM_DEBUG(__func__);
+  if(!count) return;
+  esdm_backend_t *backend = fragments[0]->backend;
+  if(!backend->callbacks.fragments_update) {
+    for(int64_t i = 0; i < count; i++) out_rets[i] = esdm_fragment_commit(fragments[i]);
+    return;
+  }
+
+  int *rets = ea_checked_malloc(count*sizeof(*rets));
+  esdmI_backend_fragments_update(backend, count, fragments, rets);
+  for(int64_t i = 0; i < count; i++) {
+    eassert(fragments[i]->backend == backend);
+    if(rets[i] == ESDM_SUCCESS) fragments[i]->status = ESDM_DATA_PERSISTENT;
+    out_rets[i] = rets[i];
+  }
+  free(rets);
+}
+
 esdm_status esdm_container_delete(esdm_container_t *c){
   ESDM_DEBUG(__func__);
   eassert(c);
@@ -572,6 +654,7 @@ esdm_status esdm_container_delete(esdm_container_t *c){
 
   esdm_modules_t* modules = esdm_get_modules();
   status = modules->metadata_backend->callbacks.container_remove(modules->metadata_backend, c);
+  esdmI_metadataCache_invalidateContainer(modules->metadata_cache, c);
   if(status != ESDM_SUCCESS){
     ret = status;
   }
@@ -586,13 +669,15 @@ esdm_status esdm_dataset_delete(esdm_dataset_t *d){
   int ret = ESDM_SUCCESS;
   int status;
 
-  if(d->status == ESDM_DATA_NOT_LOADED){
+  if(!d->refcount){  //also takes the dataset out of the metadata cache
     ret = esdm_dataset_ref(d);
     if(ret != ESDM_SUCCESS){
       return ret;
     }
   }
   // TODO check usage of dataset
+  status = esdmI_dataset_loadFragments(d, NULL);
+  if(status != ESDM_SUCCESS) return status;
   status = esdmI_fragments_deleteAll(&d->fragments);
   if(status != ESDM_SUCCESS) return status;
   status = esdmI_fragments_destruct(&d->fragments);
@@ -601,6 +686,7 @@ esdm_status esdm_dataset_delete(esdm_dataset_t *d){
   d->status = ESDM_DATA_DELETED;
   esdm_modules_t* modules = esdm_get_modules();
   status = modules->metadata_backend->callbacks.dataset_remove(modules->metadata_backend, d);
+  esdmI_metadataCache_invalidateDataset(modules->metadata_cache, d);
   if(ret == ESDM_SUCCESS) ret = status;
   esdm_dataset_close(d);
   return ret;
@@ -642,7 +728,9 @@ void esdm_dataset_init(esdm_container_t *c, const char *name, esdm_dataspace_t *
     .gridCount = 0,
     .incompleteGridCount = 0,
     .gridSlotCount = kInitialGridSlotCount,
-    .grids = ea_checked_malloc(kInitialGridSlotCount*sizeof*d->grids)
+    .grids = ea_checked_malloc(kInitialGridSlotCount*sizeof*d->grids),
+    .committedGridCount = 0,
+    .journalEntries = -1
   };
 
   if(dspace){
@@ -657,6 +745,7 @@ void esdm_dataset_init(esdm_container_t *c, const char *name, esdm_dataspace_t *
     }
   }
   esdmI_fragments_construct(&d->fragments);
+  g_rec_mutex_init(&d->loadMutex);
 
   *out_dataset = d;
 }
@@ -711,13 +800,37 @@ esdm_status esdm_dataset_set_compression_hint(esdm_dataset_t * dset, scil_user_h
 #endif
 }
 
-esdm_status esdm_dataset_open_md_load(esdm_dataset_t *dset, char ** out_md, int * out_size){
+static esdm_status esdmI_dataset_retrieveMetadata(esdm_dataset_t *dset, char ** out_md, int * out_size){
   eassert(dset != NULL);
   eassert(out_md != NULL);
   eassert(out_size != NULL);
 
   esdm_modules_t* modules = esdm_get_modules();
-  return modules->metadata_backend->callbacks.dataset_retrieve(modules->metadata_backend, dset, out_md, out_size);
+  esdm_md_backend_t* backend = modules->metadata_backend;
+  esdm_status ret = backend->callbacks.dataset_retrieve(backend, dset, out_md, out_size);
+  if(ret != ESDM_SUCCESS || !backend->callbacks.dataset_journal_retrieve) return ret;
+
+  //if there is a journal, the snapshot and the journal are returned together, so that they can be passed on to esdm_dataset_open_md_parse() as a single buffer
+  char* journal = NULL;
+  int journalSize = 0;
+  ret = backend->callbacks.dataset_journal_retrieve(backend, dset, &journal, &journalSize);
+  if(ret != ESDM_SUCCESS) {
+    free(*out_md);
+    return ret;
+  }
+  if(journal) {
+    size_t size;
+    char* bundle = esdmI_metadata_journal_bundle(*out_md, *out_size, journal, journalSize, &size);
+    free(*out_md);
+    free(journal);
+    *out_md = bundle;
+    *out_size = size;
+  }
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdm_dataset_open_md_load(esdm_dataset_t *dset, char ** out_md, int * out_size){
+  return esdmI_metadataCache_loadDataset(esdmI_metadataCache(), dset, esdmI_dataset_retrieveMetadata, out_md, out_size);
 }
 
 esdm_backend_t * esdmI_get_backend(char const * plugin_id){
@@ -740,63 +853,71 @@ esdm_backend_t * esdmI_get_backend(char const * plugin_id){
   return backend_to_use;
 }
 
-esdm_status esdmI_create_fragment_from_metadata(esdm_dataset_t *dset, json_t * json, esdm_fragment_t ** out_fragment) {
+esdm_status esdmI_fragment_createFromParts(esdm_dataset_t *dset, const char* id, esdm_backend_t* backend, int64_t actualBytes, esdm_dataspace_t* space, json_t* backendMetadata, esdm_fragment_t ** out_fragment) {
   eassert(dset);
+  eassert(id);
+  eassert(space);
   eassert(out_fragment);
 
-  esdm_status status = ESDM_INVALID_DATA_ERROR;
-  esdm_fragment_t *result = NULL;
-  json_t* spaceJson, *backendJson, *idJson, *actualSizeJson;
-
-  //fetch the parts and check their presence and type
-  if(!json || !json_is_object(json)) goto fail;
-  spaceJson = jansson_object_get(json, "space");
-  backendJson = jansson_object_get(json, "pid");
-  idJson = jansson_object_get(json, "id");
-  actualSizeJson = jansson_object_get(json, "act-size"); // if it is compressed the actual size may differ
-  if(!backendJson || !json_is_string(backendJson)) goto fail;
-  if(!idJson || !json_is_string(idJson)) goto fail;
-  if(!actualSizeJson || !json_is_integer(actualSizeJson)) goto fail;
-
-  //decode the dataspace and check for an already existing fragment
-  esdm_dataspace_t* space;
-  esdm_status dataspaceStatus = esdmI_dataspace_createFromJson(spaceJson, dset, &space);
-  if(dataspaceStatus != ESDM_SUCCESS) goto fail;
-  result = esdmI_dataset_lookupFragmentForShape(dset, space);
-  if(result) goto success;  //fast return in case we already have a fragment that matches the given shape
+  //check for an already existing fragment
+  esdm_fragment_t *result = esdmI_dataset_lookupFragmentForShape(dset, space);
+  if(result) {  //fast return in case we already have a fragment that matches the given shape
+    esdm_dataspace_destroy(space);
+    *out_fragment = result;
+    return ESDM_SUCCESS;
+  }
+  if(!backend) {
+    esdm_dataspace_destroy(space);
+    *out_fragment = NULL;
+    return ESDM_INVALID_DATA_ERROR;
+  }
 
   result = ea_checked_malloc(sizeof(esdm_fragment_t));
   *result = (esdm_fragment_t){
-    .id = ea_checked_strdup(json_string_value(idJson)),
+    .id = ea_checked_strdup(id),
     .dataset = dset,
     .dataspace = space,
     .elements = esdm_dataspace_element_count(space),
     .bytes = esdm_dataspace_total_bytes(space),
     .buf = NULL,
     .ownsBuf = false,
-    .backend = esdmI_get_backend(json_string_value(backendJson)),
-    .actual_bytes = json_integer_value(actualSizeJson),
+    .backend = backend,
+    .actual_bytes = actualBytes,
     .status = ESDM_DATA_NOT_LOADED
   };
 
   // deserialize module specific options
-  if(!result->backend) goto fail;
   if(result->backend->callbacks.fragment_metadata_load) {
-    result->backend_md = esdmI_backend_fragment_metadata_load(result->backend, result, jansson_object_get(json, "backend"));
-  }
-
-success:
-  status = ESDM_SUCCESS;
-fail:
-  if(status != ESDM_SUCCESS && result) {
-    free(result->id);
-    if(result->dataspace) esdm_dataspace_destroy(result->dataspace);
-    free(result);
-    result = NULL;
+    result->backend_md = esdmI_backend_fragment_metadata_load(result->backend, result, backendMetadata);
   }
 
   *out_fragment = result;
-  return status;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdmI_create_fragment_from_metadata(esdm_dataset_t *dset, json_t * json, esdm_fragment_t ** out_fragment) {
+  eassert(dset);
+  eassert(out_fragment);
+
+  json_t* spaceJson, *backendJson, *idJson, *actualSizeJson;
+  *out_fragment = NULL;
+
+  //fetch the parts and check their presence and type
+  if(!json || !json_is_object(json)) return ESDM_INVALID_DATA_ERROR;
+  spaceJson = jansson_object_get(json, "space");
+  backendJson = jansson_object_get(json, "pid");
+  idJson = jansson_object_get(json, "id");
+  actualSizeJson = jansson_object_get(json, "act-size"); // if it is compressed the actual size may differ
+  if(!backendJson || !json_is_string(backendJson)) return ESDM_INVALID_DATA_ERROR;
+  if(!idJson || !json_is_string(idJson)) return ESDM_INVALID_DATA_ERROR;
+  if(!actualSizeJson || !json_is_integer(actualSizeJson)) return ESDM_INVALID_DATA_ERROR;
+
+  //decode the dataspace
+  esdm_dataspace_t* space;
+  esdm_status status = esdmI_dataspace_createFromJson(spaceJson, dset, &space);
+  if(status != ESDM_SUCCESS) return status;
+
+  return esdmI_fragment_createFromParts(dset, json_string_value(idJson), esdmI_get_backend(json_string_value(backendJson)), json_integer_value(actualSizeJson), space, jansson_object_get(json, "backend"), out_fragment);
 }
 
 static void ensureStrideBuffer(esdm_dataspace_t* space) {
@@ -859,9 +980,10 @@ esdm_status esdm_dataspace_copyDatalayout(esdm_dataspace_t* space, esdm_dataspac
 }
 
 //FIXME: Error handling in this method leaks memory.
-esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size){
+esdm_status esdmI_dataset_metadata_parseHeader(esdm_dataset_t *d, char * md, int size, json_t** out_root){
   esdm_status ret;
   char * js = md;
+  *out_root = NULL;
 
   // first strip the attributes
   if(d->attr) smd_attr_destroy(d->attr);
@@ -875,12 +997,14 @@ esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size){
   js[0] = '{';
   // for the rest we use JANSSON
   json_t *root = load_json(js);
+  if(!root) return ESDM_ERROR;
   json_t *elem;
   elem = jansson_object_get(root, "typ");
   char *str = (char *)json_string_value(elem);
   smd_dtype_t *type = smd_type_from_ser(str);
   if (type == NULL) {
     DEBUG("Cannot parse type: %s", str);
+    json_decref(root);
     return ESDM_ERROR;
   }
   if(d->id) free(d->id);
@@ -911,14 +1035,28 @@ esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size){
     json_decref(root);
     return ret;
   }
-  if(has_ulim_dim){
+  if(has_ulim_dim && !d->actual_size){  //when replaying a journal, the actual size is already known from the previous entries
     d->actual_size = ea_checked_malloc(sizeof(*d->actual_size) * dims);
     memcpy(d->actual_size, sizes, sizeof(*d->actual_size) * dims);
   }
+  elem = jansson_object_get(root, "actual_size");
+  if(elem && d->actual_size){
+    if (dims != json_array_size(elem)) {
+      json_decref(root);
+      return ESDM_ERROR;
+    }
+    int64_t offset[dims];
+    for (int i = 0; i < dims; i++) {
+      offset[i] = 0;
+      sizes[i] = json_integer_value(json_array_get(elem, i));
+    }
+    esdmI_dataset_extendActualSize(d, offset, sizes);
+  }
   elem = jansson_object_get(root, "dims_dset_id");
   if (elem){
     arrsize = json_array_size(elem);
     if (dims != arrsize) {
+      json_decref(root);
       return ESDM_ERROR;
     }
     char *strs[dims];
@@ -928,12 +1066,102 @@ esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size){
     esdm_dataset_name_dims(d, strs);
   }
 
-  elem = jansson_object_get(root, "fragments");
+  *out_root = root;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdmI_dataset_addLoadedFragment(esdm_dataset_t *d, esdm_fragment_t *frag){
+  if(esdmI_dataset_lookupFragmentForShape(d, frag->dataspace) == frag) return ESDM_SUCCESS;  //the fragment was already known to the dataset
+
+  esdm_status status = esdmI_fragments_addLoaded(&d->fragments, frag);
+  if(status == ESDM_INVALID_STATE_ERROR) {
+    esdm_fragment_destroy(frag);  //we already have a fragment with this shape
+    status = ESDM_SUCCESS;
+  } else if(status == ESDM_SUCCESS) {
+    esdmI_dataset_update_actual_size(d, frag);
+  }
+  return status;
+}
+
+esdm_status esdmI_dataset_addFragment(esdm_dataset_t *d, esdm_fragment_t *frag){
+  if(esdmI_dataset_lookupFragmentForShape(d, frag->dataspace) == frag) return ESDM_SUCCESS;  //the fragment was already known to the dataset
+
+  esdm_status status = esdmI_fragments_add(&d->fragments, frag);
+  if(status == ESDM_INVALID_STATE_ERROR) {
+    esdm_fragment_destroy(frag);  //we already have a fragment with this shape
+    status = ESDM_SUCCESS;
+  } else if(status == ESDM_SUCCESS) {
+    esdmI_dataset_update_actual_size(d, frag);
+  }
+  return status;
+}
+
+esdm_status esdmI_dataset_metadata_parseGrids(esdm_dataset_t *d, json_t *root, bool append){
+  json_t *elem = jansson_object_get(root, "grids");
+  if(!elem || !json_is_array(elem)) return ESDM_ERROR;
+  size_t arrsize = json_array_size(elem);
+  if(!append) {
+    free(d->grids);
+    d->gridSlotCount = kInitialGridSlotCount > arrsize ? kInitialGridSlotCount : arrsize;
+    d->gridCount = d->incompleteGridCount = 0;
+    d->grids = ea_checked_malloc(d->gridSlotCount*sizeof*d->grids);
+  }
+  for(int64_t i = 0; i < arrsize; i++) {
+    json_t* gridDescription = json_array_get(elem, i);
+    if(!gridDescription) return ESDM_ERROR;
+    esdm_grid_t* grid;
+    esdm_status ret = esdmI_grid_createFromJson(gridDescription, d, NULL, &grid);  //registers the grid with the dataset
+    if(ret != ESDM_SUCCESS) return ret;
+  }
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size){
+  if(esdmI_metadata_isJournal(md, size)) return esdmI_dataset_metadata_replayJournal(d, md, size);
+
+  uint64_t snapshotId = esdmI_metadata_journal_snapshotId(md, size);  //before the parser modifies `md`
+  esdm_status ret = esdmI_dataset_metadata_parse(d, md, size, false);
+  if(ret == ESDM_SUCCESS) {
+    d->journalEntries = 0;
+    d->snapshotId = snapshotId;
+  }
+  return ret;
+}
+
+//Everything that has been loaded from the metadata backend is, by definition, committed.
+static void esdmI_dataset_markCommitted(esdm_dataset_t *d){
+  esdmI_fragments_markCommitted(&d->fragments);
+  d->committedGridCount = d->gridCount;
+  d->status = ESDM_DATA_PERSISTENT;
+}
+
+esdm_status esdmI_dataset_metadata_parse(esdm_dataset_t *d, char * md, int size, bool journalEntry){
+  if(!journalEntry) {
+    //a snapshot replaces any fragment pages that are still pending from an earlier one
+    esdmI_fragmentPages_destroy(d->fragmentPages);
+    d->fragmentPages = NULL;
+
+    //with a fragment index, the snapshot lists none of the indexed fragments, they are retrieved on demand
+    if(d->indexedRegions) esdmI_hypercubeSet_destroy(d->indexedRegions);
+    d->indexedRegions = NULL;
+    if(esdm_get_modules()->metadata_backend->callbacks.dataset_fragments_retrieve) d->indexedRegions = esdmI_hypercubeSet_make();
+  }
+  if(esdmI_metadata_isBinary(md, size)) {
+    esdm_status ret = esdmI_dataset_metadata_parseBinary(d, md, size, journalEntry);
+    if(ret == ESDM_SUCCESS) esdmI_dataset_markCommitted(d);
+    return ret;
+  }
+
+  json_t *root;
+  esdm_status ret = esdmI_dataset_metadata_parseHeader(d, md, size, &root);
+  if(ret != ESDM_SUCCESS) return ret;
+
+  json_t *elem = jansson_object_get(root, "fragments");
   if(! elem) {
     json_decref(root);
     return ESDM_ERROR;
   }
-  arrsize = json_array_size(elem);
+  size_t arrsize = json_array_size(elem);
   for (int i = 0; i < arrsize; i++) {
     json_t * fjson = json_array_get(elem, i);
     esdm_fragment_t * frag;
@@ -941,49 +1169,27 @@ esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size){
     if (status != ESDM_SUCCESS) {
       ret = status;
     } else {
-      status = esdmI_fragments_add(&d->fragments, frag);
-      if(status == ESDM_INVALID_STATE_ERROR) {
-        esdm_fragment_destroy(frag);  //we already have a fragment with this shape
-      } else if(status == ESDM_SUCCESS) {
-        esdmI_dataset_update_actual_size(d, frag);
-      } else {
+      status = esdmI_dataset_addLoadedFragment(d, frag);
+      if(status != ESDM_SUCCESS) {
         json_decref(root);
         return status;
       }
     }
   }
 
-  elem = jansson_object_get(root, "grids");
-  if(!elem || !json_is_array(elem)) {
-    json_decref(root);
-    return ESDM_ERROR;
-  }
-  arrsize = json_array_size(elem);
-  d->gridSlotCount = kInitialGridSlotCount > arrsize ? kInitialGridSlotCount : arrsize;
-  d->gridCount = d->incompleteGridCount = 0;  //esdmI_grid_createFromJson() will register the grids
-  d->grids = ea_checked_malloc(d->gridSlotCount*sizeof*d->grids);
-  for(int64_t i = 0; i < arrsize; i++) {
-    json_t* gridDescription = json_array_get(elem, i);
-    if(!gridDescription) {
-      json_decref(root);
-      return ESDM_ERROR;
-    }
-    esdm_status ret = esdmI_grid_createFromJson(gridDescription, d, NULL, &d->grids[i]);
-    if(ret != ESDM_SUCCESS) {
-      json_decref(root);
-      return ret;
-    }
-  }
-
+  esdm_status gridStatus = esdmI_dataset_metadata_parseGrids(d, root, journalEntry);
   json_decref(root);
+  if(gridStatus != ESDM_SUCCESS) return gridStatus;
 
-  d->status = ESDM_DATA_PERSISTENT;
+  esdmI_dataset_markCommitted(d);
 
   return ESDM_SUCCESS;
 }
 
 esdm_status esdm_dataset_ref(esdm_dataset_t * d){
   ESDM_DEBUG(__func__);
+  //a closed dataset may still be loaded because the metadata cache retained it, the cache unloads it if it is outdated
+  if(d->status != ESDM_DATA_NOT_LOADED && !d->refcount) esdmI_metadataCache_releaseDataset(esdmI_metadataCache(), d, false);
   if(d->status != ESDM_DATA_NOT_LOADED){
     d->refcount++;
     return ESDM_SUCCESS;
@@ -1046,7 +1252,7 @@ esdm_status esdm_dataset_open(esdm_container_t *c, const char *name, int esdm_mo
   return ret;
 }
 
-void esdmI_dataset_metadata_create(esdm_dataset_t *d, smd_string_stream_t*s){
+void esdmI_dataset_metadata_createHeader(esdm_dataset_t *d, smd_string_stream_t*s){
   eassert(d->dataspace != NULL);
 
   smd_string_stream_printf(s, "{");
@@ -1067,6 +1273,14 @@ void esdmI_dataset_metadata_create(esdm_dataset_t *d, smd_string_stream_t*s){
   }else{
     smd_string_stream_printf(s,"\",\"dims\":0");
   }
+  if(d->actual_size){
+    //needed when the fragments are not all loaded at once, otherwise the actual size is reconstructed from the fragments anyway
+    smd_string_stream_printf(s, ",\"actual_size\":[%" PRId64, d->actual_size[0]);
+    for (int i = 1; i < d->dataspace->dims; i++) {
+      smd_string_stream_printf(s, ",%" PRId64, d->actual_size[i]);
+    }
+    smd_string_stream_printf(s, "]");
+  }
   if (d->dims_dset_id != NULL) {
     smd_string_stream_printf(s, ",\"dims_dset_id\":[");
     if(d->dataspace->dims > 0){
@@ -1077,16 +1291,109 @@ void esdmI_dataset_metadata_create(esdm_dataset_t *d, smd_string_stream_t*s){
     }
     smd_string_stream_printf(s, "]");
   }
-  smd_string_stream_printf(s, ",\"fragments\":");
-  esdmI_fragments_metadata_create(&d->fragments, s);
+}
+
+void esdmI_dataset_metadata_createGrids(esdm_dataset_t *d, int64_t firstGrid, smd_string_stream_t*s){
   smd_string_stream_printf(s, ",\"grids\":[");
-  for(int64_t i = 0; i < d->gridCount; i++) {
-    if(i) smd_string_stream_printf(s, ",");
+  for(int64_t i = firstGrid; i < d->gridCount; i++) {
+    if(i > firstGrid) smd_string_stream_printf(s, ",");
     esdmI_grid_serialize(s, d->grids[i]);
   }
   smd_string_stream_printf(s, "]}");
 }
 
+void esdmI_dataset_metadata_create(esdm_dataset_t *d, smd_string_stream_t*s){
+  esdmI_dataset_metadata_createHeader(d, s);
+  smd_string_stream_printf(s, ",\"fragments\":");
+  esdmI_fragments_metadata_create(&d->fragments, s);
+  esdmI_dataset_metadata_createGrids(d, 0, s);
+}
+
+void esdmI_dataset_metadata_createJournalEntry(esdm_dataset_t *d, smd_string_stream_t*s){
+  esdmI_dataset_metadata_createHeader(d, s);
+  smd_string_stream_printf(s, ",\"fragments\":");
+  esdmI_fragments_metadata_createUncommitted(&d->fragments, s);
+  esdmI_dataset_metadata_createGrids(d, d->committedGridCount, s);
+}
+
+//Writes the complete metadata of the dataset, replacing the previous snapshot and discarding the journal.
+static esdm_status esdmI_dataset_commitSnapshot(esdm_dataset_t *d) {
+  esdm_status ret = esdmI_dataset_loadFragments(d, NULL);  //the snapshot must include all fragments
+  if(ret != ESDM_SUCCESS) return ret;
+
+  esdm_md_backend_t* backend = esdm_get_modules()->metadata_backend;
+  size_t md_size;
+  char* buff;
+  if(backend->config->metadata_format == ESDMI_METADATA_FORMAT_BINARY) {
+    buff = esdmI_dataset_metadata_createBinary(d, false, &md_size);
+  } else {
+    smd_string_stream_t* stream = smd_string_stream_create();
+    esdmI_dataset_metadata_create(d, stream);
+    buff = smd_string_stream_close(stream, & md_size);
+  }
+
+  // md callback create/update container
+  uint64_t snapshotId = esdmI_metadata_journal_snapshotId(buff, md_size);
+  ret = backend->callbacks.dataset_commit(backend, d, buff, md_size);
+  free(buff);
+  if(ret != ESDM_SUCCESS) return ret;
+
+  esdmI_fragments_markCommitted(&d->fragments);
+  esdmI_fragments_snapshotCommitted(&d->fragments);
+  d->committedGridCount = d->gridCount;
+  d->journalEntries = 0;
+  d->snapshotId = snapshotId;
+  return ESDM_SUCCESS;
+}
+
+//Appends only the changes since the last commit to the journal of the dataset.
+static esdm_status esdmI_dataset_commitJournalEntry(esdm_dataset_t *d) {
+  esdm_md_backend_t* backend = esdm_get_modules()->metadata_backend;
+  size_t md_size;
+  char* buff;
+  if(backend->config->metadata_format == ESDMI_METADATA_FORMAT_BINARY) {
+    buff = esdmI_dataset_metadata_createBinary(d, true, &md_size);
+  } else {
+    smd_string_stream_t* stream = smd_string_stream_create();
+    esdmI_dataset_metadata_createJournalEntry(d, stream);
+    buff = smd_string_stream_close(stream, & md_size);
+  }
+  size_t recordSize;
+  char* record = esdmI_metadata_journal_createRecord(buff, md_size, d->snapshotId, &recordSize);
+  free(buff);
+
+  esdm_status ret = backend->callbacks.dataset_journal_append(backend, d, record, recordSize);
+  free(record);
+  if(ret != ESDM_SUCCESS) return ret;
+
+  DEBUG("appended journal entry %"PRId64" of dataset %s: %"PRId64" fragments, %"PRId64" grids", d->journalEntries + 1, d->id, d->fragments.uncommittedCount, d->gridCount - d->committedGridCount);
+  esdmI_fragments_markCommitted(&d->fragments);
+  d->committedGridCount = d->gridCount;
+  d->journalEntries++;
+  return ESDM_SUCCESS;
+}
+
+//Writes the dataset level metadata and adds the fragments since the last commit to the fragment index of the metadata backend.
+static esdm_status esdmI_dataset_commitToIndex(esdm_dataset_t *d) {
+  esdm_md_backend_t* backend = esdm_get_modules()->metadata_backend;
+  smd_string_stream_t* stream = smd_string_stream_create();
+  esdmI_dataset_metadata_createHeader(d, stream);
+  smd_string_stream_printf(stream, ",\"fragments\":[]");
+  esdmI_dataset_metadata_createGrids(d, 0, stream);
+  size_t md_size;
+  char* buff = smd_string_stream_close(stream, & md_size);
+
+  esdm_status ret = backend->callbacks.dataset_commit_fragments(backend, d, buff, md_size, d->fragments.uncommittedCount, d->fragments.uncommitted);
+  free(buff);
+  if(ret != ESDM_SUCCESS) return ret;
+
+  DEBUG("indexed %"PRId64" fragments of dataset %s", d->fragments.uncommittedCount, d->id);
+  esdmI_fragments_markCommitted(&d->fragments);
+  d->committedGridCount = d->gridCount;
+  d->journalEntries = 0;
+  return ESDM_SUCCESS;
+}
+
 esdm_status esdm_dataset_commit(esdm_dataset_t *d) {
   ESDM_DEBUG(__func__);
   eassert(d);
@@ -1097,18 +1404,30 @@ esdm_status esdm_dataset_commit(esdm_dataset_t *d) {
   }
   d->status = ESDM_DATA_PERSISTENT;
 
-  size_t md_size;
-  smd_string_stream_t* stream = smd_string_stream_create();
-  esdmI_dataset_metadata_create(d, stream);
-  char* buff = smd_string_stream_close(stream, & md_size);
-  // TODO commit each uncommited fragment
-
-  // md callback create/update container
   esdm_modules_t* modules = esdm_get_modules();
-  esdm_status ret = modules->metadata_backend->callbacks.dataset_commit(modules->metadata_backend, d, buff, md_size);
-  free(buff);
+  esdmI_metadataCache_invalidateDataset(modules->metadata_cache, d);
+  esdm_md_backend_t* backend = modules->metadata_backend;
+  if(backend->callbacks.dataset_commit_fragments) return esdmI_dataset_commitToIndex(d);
 
-  return ret;
+  // use the journal if the backend supports it, there is a snapshot to append to, and it's not yet time for compaction
+  int64_t maxEntries = backend->config->journal_max_entries;
+  if(maxEntries > 0 && backend->callbacks.dataset_journal_append && d->journalEntries >= 0 && d->journalEntries < maxEntries) {
+    return esdmI_dataset_commitJournalEntry(d);
+  }
+  return esdmI_dataset_commitSnapshot(d);
+}
+
+esdm_status esdm_dataset_compact(esdm_dataset_t *d) {
+  ESDM_DEBUG(__func__);
+  eassert(d);
+  eassert(d->status != ESDM_DATA_NOT_LOADED);
+  eassert(d->status != ESDM_DATA_DELETED);
+
+  if(esdm_get_modules()->metadata_backend->callbacks.dataset_commit_fragments) return esdm_dataset_commit(d);  //a fragment index has no journal to compact
+  if(d->status != ESDM_DATA_DIRTY && !d->journalEntries) return ESDM_SUCCESS; //the snapshot is already up to date
+  d->status = ESDM_DATA_PERSISTENT;
+  esdmI_metadataCache_invalidateDataset(esdm_get_modules()->metadata_cache, d);
+  return esdmI_dataset_commitSnapshot(d);
 }
 
 esdm_status esdm_dataset_update(esdm_dataset_t *dataset) {
@@ -1116,6 +1435,64 @@ esdm_status esdm_dataset_update(esdm_dataset_t *dataset) {
   return ESDM_SUCCESS;
 }
 
+//Retrieves the fragments that may intersect `region` (all fragments if `region` is NULL) from the fragment index of the metadata backend.
+//Regions that are covered by earlier queries are not queried again.
+static esdm_status esdmI_dataset_retrieveIndexedFragments(esdm_dataset_t *d, esdmI_hypercube_t *region) {
+  if(!d->indexedRegions) return ESDM_SUCCESS;
+
+  if(region) {
+    esdmI_hypercubeSet_t* missing = esdmI_hypercubeSet_make();
+    esdmI_hypercubeSet_add(missing, region);
+    esdmI_hypercubeSet_subtractList(missing, esdmI_hypercubeSet_list(d->indexedRegions));
+    bool retrieved = esdmI_hypercubeSet_isEmpty(missing);
+    esdmI_hypercubeSet_destroy(missing);
+    if(retrieved) return ESDM_SUCCESS;
+  }
+
+  esdm_md_backend_t* backend = esdm_get_modules()->metadata_backend;
+  char* json;
+  int size;
+  esdm_status ret = backend->callbacks.dataset_fragments_retrieve(backend, d, region, &json, &size);
+  if(ret != ESDM_SUCCESS) return ret;
+  json_t* root = load_json(json);
+  free(json);
+  if(!root || !json_is_array(root)) {
+    if(root) json_decref(root);
+    return ESDM_INVALID_DATA_ERROR;
+  }
+
+  //adding the fragments looks up their shapes, which must not trigger further queries
+  esdmI_hypercubeSet_t* indexedRegions = d->indexedRegions;
+  d->indexedRegions = NULL;
+  size_t count = json_array_size(root);
+  for(size_t i = 0; i < count && ret == ESDM_SUCCESS; i++) {
+    esdm_fragment_t* frag;
+    ret = esdmI_create_fragment_from_metadata(d, json_array_get(root, i), &frag);
+    if(ret == ESDM_SUCCESS) ret = esdmI_dataset_addLoadedFragment(d, frag);
+  }
+  json_decref(root);
+  DEBUG("retrieved %zu indexed fragments of dataset %s", count, d->id);
+
+  if(ret != ESDM_SUCCESS || !region) {
+    //on error, the region will simply be queried again
+    if(region) d->indexedRegions = indexedRegions;
+    else esdmI_hypercubeSet_destroy(indexedRegions);
+    return ret;
+  }
+  esdmI_hypercubeSet_add(indexedRegions, region);
+  d->indexedRegions = indexedRegions;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdmI_dataset_loadFragments(esdm_dataset_t *d, esdmI_hypercube_t *region) {
+  //concurrent callers wait until the fragments are loaded, they must not proceed with an incomplete set of fragments
+  g_rec_mutex_lock(&d->loadMutex);
+  esdm_status ret = esdmI_dataset_loadFragmentPages(d, region);
+  if(ret == ESDM_SUCCESS) ret = esdmI_dataset_retrieveIndexedFragments(d, region);
+  g_rec_mutex_unlock(&d->loadMutex);
+  return ret;
+}
+
 static bool fragmentsCoverRegion(esdmI_hypercube_t* region, int64_t fragmentCount, esdm_fragment_t** fragments, esdmI_hypercubeSet_t** out_uncoveredRegion) {
   eassert(region);
   eassert(out_uncoveredRegion);
@@ -1127,12 +1504,11 @@ static bool fragmentsCoverRegion(esdmI_hypercube_t* region, int64_t fragmentCoun
     return false;
   }
 
-  for(int64_t i = 0; i < fragmentCount; i++) {
-    esdmI_hypercube_t* curCube;
-    esdmI_dataspace_getExtends(fragments[i]->dataspace, &curCube);
-    esdmI_hypercubeSet_subtract(*out_uncoveredRegion, curCube);
-    esdmI_hypercube_destroy(curCube);
-  }
+  esdmI_hypercubeList_t extends = { .cubes = ea_checked_malloc(fragmentCount*sizeof(*extends.cubes)), .count = fragmentCount };
+  for(int64_t i = 0; i < fragmentCount; i++) esdmI_dataspace_getExtends(fragments[i]->dataspace, &extends.cubes[i]);
+  esdmI_hypercubeSet_subtractList(*out_uncoveredRegion, &extends);
+  for(int64_t i = 0; i < fragmentCount; i++) esdmI_hypercube_destroy(extends.cubes[i]);
+  free(extends.cubes);
 
   return esdmI_hypercubeSet_isEmpty(*out_uncoveredRegion);
 }
@@ -1155,16 +1531,30 @@ static esdm_grid_t* esdmI_dataset_gridCoveringRegion(esdm_dataset_t* dataset, es
 }
 
 esdm_status esdmI_dataset_fragmentsCoveringRegion(esdm_dataset_t* dataset, esdmI_hypercube_t* region, int64_t* out_count, esdm_fragment_t*** out_fragments, esdmI_hypercubeSet_t** out_uncovered, bool* out_fullyCovered) {
+  //the out parameters are valid even on error, so that the caller can clean up unconditionally
+  *out_count = 0;
+  *out_fragments = NULL;
+  *out_uncovered = NULL;
+  *out_fullyCovered = false;
+
+  esdm_status result;
   esdm_grid_t* grid = esdmI_dataset_gridCoveringRegion(dataset, region);
   if(grid) {
-    esdm_status result = esdmI_grid_fragmentsInRegion(grid, region, out_count, out_fragments);
+    result = esdmI_grid_fragmentsInRegion(grid, region, out_count, out_fragments);
+    if(result != ESDM_SUCCESS) return result;
     *out_uncovered = esdmI_hypercubeSet_make();
     *out_fullyCovered = true;
   } else {
-    *out_fragments = esdmI_fragments_makeSetCoveringRegion(&dataset->fragments, region, out_count);
-    *out_fullyCovered = fragmentsCoverRegion(region, *out_count, *out_fragments, out_uncovered);
+    //the lock is held until the selection is made, so that it does not see fragments that another thread is still decoding
+    g_rec_mutex_lock(&dataset->loadMutex);
+    result = esdmI_dataset_loadFragments(dataset, region);
+    if(result == ESDM_SUCCESS) {
+      *out_fragments = esdmI_fragments_makeSetCoveringRegion(&dataset->fragments, region, out_count);
+      *out_fullyCovered = fragmentsCoverRegion(region, *out_count, *out_fragments, out_uncovered);
+    }
+    g_rec_mutex_unlock(&dataset->loadMutex);
   }
-  return ESDM_SUCCESS;
+  return result;
 }
 
 esdm_fragment_t* esdmI_dataset_createFragment(esdm_dataset_t* dataset, esdm_dataspace_t* memspace, void *buf, bool* out_newFragment) {
@@ -1186,6 +1576,8 @@ esdm_fragment_t* esdmI_dataset_lookupFragmentForShape(esdm_dataset_t* dataset, e
   esdmI_hypercube_t* extends;
   esdm_status status = esdmI_dataspace_getExtends(shape, &extends);
   eassert(status == ESDM_SUCCESS);
+  status = esdmI_dataset_loadFragments(dataset, extends);
+  if(status != ESDM_SUCCESS) ESDM_LOG_FMT(ESDM_LOGLEVEL_WARNING, "failed to load the fragment metadata of dataset %s", dataset->id);
   esdm_fragment_t* result = esdmI_fragments_lookupForShape(&dataset->fragments, extends);
   esdmI_hypercube_destroy(extends);
   return result;
@@ -1208,18 +1600,30 @@ esdm_status esdm_dataset_close(esdm_dataset_t *dset) {
     return ESDM_SUCCESS;
   }
 
+  if(!esdmI_metadataCache_retainDataset(esdmI_metadataCache(), dset)) esdmI_dataset_unload(dset);
+  return ESDM_SUCCESS;
+}
+
+void esdmI_dataset_unload(esdm_dataset_t *dset) {
+  eassert(dset);
+  eassert(!dset->refcount);
+
   dset->status = ESDM_DATA_NOT_LOADED;
 
   smd_attr_destroy(dset->attr);
   dset->attr = NULL;
 
   esdmI_fragments_purge(&dset->fragments);
-  return ESDM_SUCCESS;
+  esdmI_fragmentPages_destroy(dset->fragmentPages);
+  dset->fragmentPages = NULL;
+  if(dset->indexedRegions) esdmI_hypercubeSet_destroy(dset->indexedRegions);
+  dset->indexedRegions = NULL;
 }
 
 esdm_status esdmI_dataset_destroy(esdm_dataset_t *dset) {
   ESDM_DEBUG(__func__);
   eassert(dset);
+  esdmI_metadataCache_forgetDataset(esdmI_metadataCache(), dset);
 
   esdm_status ret = esdmI_fragments_destruct(&dset->fragments);
   if (ret != ESDM_SUCCESS) return ret;  // free dataset only if all fragments can be destroyed/are not longer in use
@@ -1228,6 +1632,9 @@ esdm_status esdmI_dataset_destroy(esdm_dataset_t *dset) {
     esdmI_grid_destroy(dset->grids[i]);
   }
   free(dset->grids);
+  esdmI_fragmentPages_destroy(dset->fragmentPages);
+  if(dset->indexedRegions) esdmI_hypercubeSet_destroy(dset->indexedRegions);
+  g_rec_mutex_clear(&dset->loadMutex);
 
   if(dset->attr) smd_attr_destroy(dset->attr); // maybe unref?
   if(dset->fill_value) smd_attr_destroy(dset->fill_value);
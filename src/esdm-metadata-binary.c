@@ -0,0 +1,579 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * @brief A compact binary encoding of the dataset metadata.
+ *
+ * The JSON metadata of a dataset is dominated by the fragment list, which is expensive to print, to parse, and to store.
+ * The binary format stores the fragments as a table of fixed width records instead:
+ *
+ *     header | backend table | page table | fragment records | string pool | JSON
+ *
+ *   - The header identifies the format and version, and holds the offsets of all the other parts.
+ *   - The backend table interns the backend IDs, each entry is the pool offset of an ID string.
+ *   - The page table partitions the fragment records into pages of spatially close fragments, each entry holds the range of records of the page and their bounding box.
+ *     The records are sorted along the partition dimension (the first unlimited dimension, or the first dimension), which is usually time.
+ *   - Each fragment record holds the fragment's shape as fixed width arrays, the index of its backend, and pool offsets for the variable length data.
+ *     Since the records have a fixed size, the table doubles as an offset table that allows random access to any fragment.
+ *   - The string pool holds the NUL terminated fragment IDs, backend specific JSON, and explicit strides.
+ *   - The JSON part is the dataset metadata without the fragment list (attributes, type, shape, and grids), which is small and rarely performance critical.
+ *
+ * All offsets are relative to the start of the buffer, and all parts are 8 byte aligned, so the buffer can be used directly from a memory mapped file.
+ * Numbers are stored in the native byte order, a byte order mark in the header rejects files from machines with a different endianness.
+ *
+ * When a snapshot is opened, only the header, the backends, and the page table are decoded, the fragment records are decoded one page at a time when a region query touches the page.
+ * So, the time to open a dataset and the memory it occupies depend on the part of the dataset that is actually accessed, not on the total number of fragments.
+ *
+ * A fragment list is the same encoding without pages and with an empty JSON part.
+ * It carries the uncommitted fragments of one process to the process that commits the dataset in `esdm_mpi_dataset_commit()`.
+ */
+
+#define _GNU_SOURCE
+
+#include <esdm-internal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEBUG(fmt, ...) ESDM_DEBUG_COM_FMT("METADATA", fmt, __VA_ARGS__)
+
+static const char kMagic[8] = "ESDMBMD";  //includes the terminating NUL
+enum {
+  kVersion = 2,
+  kByteOrderMark = 0x01020304,
+  kRecordsPerPage = 256
+};
+#define NO_OFFSET UINT64_MAX
+
+typedef struct binaryHeader_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  int64_t dims;
+  int64_t fragmentCount;
+  int64_t backendCount;
+  uint64_t recordSize;  //size of a single fragment record in bytes, depends on `dims`
+  int64_t pageCount;  //0 if there are no fragments
+  uint64_t backendTableOffset;
+  uint64_t pageTableOffset;
+  uint64_t recordTableOffset;
+  uint64_t poolOffset, poolSize;
+  uint64_t jsonOffset, jsonSize;  //the size includes the terminating NUL
+} binaryHeader_t;
+
+typedef struct binaryFragmentRecord_t {
+  uint64_t id;  //pool offset of the fragment ID
+  uint64_t backendMetadata; //pool offset of the backend specific JSON, NO_OFFSET if there is none
+  uint64_t stride;  //pool offset of `dims` int64_t strides, NO_OFFSET if the fragment uses the default C order layout
+  int64_t actualBytes;
+  uint32_t backend; //index into the backend table
+  uint32_t reserved;
+  int64_t coords[];  //`dims` offsets followed by `dims` sizes
+} binaryFragmentRecord_t;
+
+typedef struct binaryPage_t {
+  int64_t firstRecord, recordCount;
+  int64_t bounds[];  //`dims` offsets followed by `dims` sizes of the bounding box of the page's fragments
+} binaryPage_t;
+
+static uint64_t recordSize(int64_t dims) { return sizeof(binaryFragmentRecord_t) + 2*dims*sizeof(int64_t); }
+static uint64_t pageSize(int64_t dims) { return sizeof(binaryPage_t) + 2*dims*sizeof(int64_t); }
+
+//The dimension along which the fragments are partitioned into pages.
+static int64_t partitionDimension(esdm_dataspace_t* space) {
+  for(int64_t i = 0; i < space->dims; i++) if(!space->size[i]) return i;
+  return 0;
+}
+
+struct esdmI_fragmentPages_t {
+  char* md; //private copy of the binary metadata, or a pointer into memory that is shared with other processes if `sharedUsers` is set
+  int64_t* sharedUsers; //counts the fragment pages that reference the shared memory
+  binaryHeader_t header;
+  esdm_backend_t** backends;
+  esdmI_hypercube_t** bounds; //NULL for pages that have been loaded already
+  int64_t unloadedCount;
+  bool loading; //decoding a fragment looks up its shape, which must not recurse into loading, only accessed with the dataset's `loadMutex` held
+};
+
+//Set while `esdmI_dataset_metadata_parseShared()` runs: fragment pages that are created from the private copy at `privateBase` reference the same bytes at `sharedBase` instead of copying them.
+static __thread struct {
+  const char* privateBase;
+  const char* sharedBase;
+  int64_t* users;
+} tShared;
+
+// Encoding ///////////////////////////////////////////////////////////////////
+
+typedef struct byteBuffer_t {
+  char* data;
+  uint64_t size, allocatedSize;
+} byteBuffer_t;
+
+//Appends the data padded to a multiple of 8 bytes, returns the offset at which the data was placed.
+static uint64_t byteBuffer_append(byteBuffer_t* me, const void* data, uint64_t size) {
+  uint64_t offset = me->size, paddedSize = (size + 7) & ~(uint64_t)7;
+  if(offset + paddedSize > me->allocatedSize) {
+    me->allocatedSize = 2*(offset + paddedSize) + 64;
+    me->data = ea_checked_realloc(me->data, me->allocatedSize);
+  }
+  if(size) memcpy(me->data + offset, data, size);
+  memset(me->data + offset + size, 0, paddedSize - size);
+  me->size += paddedSize;
+  return offset;
+}
+
+static uint64_t byteBuffer_appendString(byteBuffer_t* me, const char* string) {
+  return byteBuffer_append(me, string, strlen(string) + 1);
+}
+
+static gint compareFragmentOffsets(gconstpointer aArg, gconstpointer bArg, gpointer dimArg) {
+  const esdm_fragment_t* a = *(esdm_fragment_t* const*)aArg;
+  const esdm_fragment_t* b = *(esdm_fragment_t* const*)bArg;
+  int64_t dim = *(int64_t*)dimArg;
+  int64_t offsetA = a->dataspace->offset[dim], offsetB = b->dataspace->offset[dim];
+  return offsetA < offsetB ? -1 : offsetA > offsetB ? 1 : 0;
+}
+
+//Computes the bounding boxes of consecutive runs of `kRecordsPerPage` fragments, returns the number of pages.
+static int64_t createPageTable(int64_t dims, int64_t fragmentCount, esdm_fragment_t** fragments, binaryPage_t** out_pages) {
+  int64_t pageCount = (fragmentCount + kRecordsPerPage - 1)/kRecordsPerPage;
+  uint64_t curPageSize = pageSize(dims);
+  binaryPage_t* pages = ea_checked_malloc(pageCount ? pageCount*curPageSize : 1);
+  for(int64_t i = 0; i < pageCount; i++) {
+    binaryPage_t* page = (binaryPage_t*)((char*)pages + i*curPageSize);
+    page->firstRecord = i*kRecordsPerPage;
+    page->recordCount = fragmentCount - page->firstRecord < kRecordsPerPage ? fragmentCount - page->firstRecord : kRecordsPerPage;
+    int64_t* start = page->bounds, *end = page->bounds + dims;  //the second half holds the end coordinates until they are converted to sizes below
+    for(int64_t j = 0; j < page->recordCount; j++) {
+      esdm_dataspace_t* space = fragments[page->firstRecord + j]->dataspace;
+      for(int64_t d = 0; d < dims; d++) {
+        if(!j || space->offset[d] < start[d]) start[d] = space->offset[d];
+        if(!j || space->offset[d] + space->size[d] > end[d]) end[d] = space->offset[d] + space->size[d];
+      }
+    }
+    for(int64_t d = 0; d < dims; d++) end[d] -= start[d];
+  }
+  *out_pages = pages;
+  return pageCount;
+}
+
+//Assembles the complete buffer from the fragments, which must already be in the order of the page table, and the dataset level JSON.
+static char* encode(int64_t dims, int64_t fragmentCount, esdm_fragment_t** fragments, int64_t pageCount, binaryPage_t* pages, const char* json, size_t jsonSize, size_t* out_size) {
+  uint64_t curRecordSize = recordSize(dims);
+  binaryFragmentRecord_t* records = ea_checked_malloc(fragmentCount ? fragmentCount*curRecordSize : 1);
+  byteBuffer_t pool = {0};
+
+  //encode the fragments, interning the backends as we go
+  int64_t backendCount = 0;
+  esdm_backend_t** backends = NULL;
+  for(int64_t i = 0; i < fragmentCount; i++) {
+    esdm_fragment_t* fragment = fragments[i];
+    eassert(fragment->id);
+    eassert(fragment->dataspace->dims == dims);
+
+    int64_t backendIndex = 0;
+    while(backendIndex < backendCount && backends[backendIndex] != fragment->backend) backendIndex++;
+    if(backendIndex == backendCount) {
+      backends = ea_checked_realloc(backends, ++backendCount*sizeof(*backends));
+      backends[backendIndex] = fragment->backend;
+    }
+
+    binaryFragmentRecord_t* record = (binaryFragmentRecord_t*)((char*)records + i*curRecordSize);
+    *record = (binaryFragmentRecord_t){
+      .id = byteBuffer_appendString(&pool, fragment->id),
+      .backendMetadata = NO_OFFSET,
+      .stride = NO_OFFSET,
+      .actualBytes = fragment->actual_bytes,
+      .backend = backendIndex
+    };
+    memcpy(record->coords, fragment->dataspace->offset, dims*sizeof(int64_t));
+    memcpy(record->coords + dims, fragment->dataspace->size, dims*sizeof(int64_t));
+    if(fragment->dataspace->stride) record->stride = byteBuffer_append(&pool, fragment->dataspace->stride, dims*sizeof(int64_t));
+    if(fragment->backend->callbacks.fragment_metadata_create) {
+      smd_string_stream_t* stream = smd_string_stream_create();
+      esdmI_backend_fragment_metadata_create(fragment->backend, fragment, stream);
+      size_t backendJsonSize;
+      char* backendJson = smd_string_stream_close(stream, &backendJsonSize);
+      if(backendJsonSize) record->backendMetadata = byteBuffer_append(&pool, backendJson, backendJsonSize + 1);
+      free(backendJson);
+    }
+  }
+
+  //the backend table references the pool as well
+  uint64_t* backendTable = ea_checked_malloc((backendCount ? backendCount : 1)*sizeof(*backendTable));
+  for(int64_t j = 0; j < backendCount; j++) backendTable[j] = byteBuffer_appendString(&pool, backends[j]->config->id);
+
+  //assemble the parts, the pool offsets are made absolute once the position of the pool is known
+  byteBuffer_t result = {0};
+  binaryHeader_t header = {
+    .version = kVersion,
+    .byteOrder = kByteOrderMark,
+    .dims = dims,
+    .fragmentCount = fragmentCount,
+    .backendCount = backendCount,
+    .recordSize = curRecordSize,
+    .pageCount = pageCount
+  };
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  byteBuffer_append(&result, &header, sizeof(header));
+  header.backendTableOffset = byteBuffer_append(&result, backendTable, backendCount*sizeof(*backendTable));
+  header.pageTableOffset = byteBuffer_append(&result, pages, pageCount*pageSize(dims));
+  header.recordTableOffset = byteBuffer_append(&result, records, fragmentCount*curRecordSize);
+  header.poolOffset = byteBuffer_append(&result, pool.data, pool.size);
+  header.poolSize = pool.size;
+  header.jsonOffset = byteBuffer_append(&result, json, jsonSize + 1);
+  header.jsonSize = jsonSize + 1;
+
+  uint64_t* resultBackendTable = (uint64_t*)(result.data + header.backendTableOffset);
+  for(int64_t j = 0; j < backendCount; j++) resultBackendTable[j] += header.poolOffset;
+  for(int64_t j = 0; j < fragmentCount; j++) {
+    binaryFragmentRecord_t* record = (binaryFragmentRecord_t*)(result.data + header.recordTableOffset + j*curRecordSize);
+    record->id += header.poolOffset;
+    if(record->backendMetadata != NO_OFFSET) record->backendMetadata += header.poolOffset;
+    if(record->stride != NO_OFFSET) record->stride += header.poolOffset;
+  }
+  memcpy(result.data, &header, sizeof(header));
+
+  //cleanup
+  free(backendTable);
+  free(backends);
+  free(pool.data);
+  free(records);
+
+  *out_size = result.size;
+  return result.data;
+}
+
+char* esdmI_dataset_metadata_createBinary(esdm_dataset_t *d, bool journalEntry, size_t *out_size) {
+  eassert(d);
+  eassert(d->dataspace);
+  eassert(out_size);
+
+  //a journal entry only contains the fragments and grids that have been added since the last commit
+  int64_t fragmentCount = journalEntry ? d->fragments.uncommittedCount : g_hash_table_size(d->fragments.table);
+  esdm_fragment_t** fragments = ea_checked_malloc((fragmentCount ? fragmentCount : 1)*sizeof(*fragments));
+  if(journalEntry) {
+    if(fragmentCount) memcpy(fragments, d->fragments.uncommitted, fragmentCount*sizeof(*fragments));
+  } else {
+    GHashTableIter iter;
+    gpointer key, value;
+    int64_t i = 0;
+    g_hash_table_iter_init(&iter, d->fragments.table);
+    while(g_hash_table_iter_next(&iter, &key, &value)) fragments[i++] = value;
+    eassert(i == fragmentCount);
+  }
+
+  //sort the fragments into pages
+  int64_t dims = d->dataspace->dims;
+  binaryPage_t* pages = NULL;
+  int64_t pageCount = 0;
+  if(dims) {
+    int64_t partitionDim = partitionDimension(d->dataspace);
+    g_qsort_with_data(fragments, fragmentCount, sizeof(*fragments), compareFragmentOffsets, &partitionDim);
+    pageCount = createPageTable(dims, fragmentCount, fragments, &pages);
+  }
+
+  //the dataset level metadata remains JSON
+  smd_string_stream_t* stream = smd_string_stream_create();
+  esdmI_dataset_metadata_createHeader(d, stream);
+  esdmI_dataset_metadata_createGrids(d, journalEntry ? d->committedGridCount : 0, stream);
+  size_t jsonSize;
+  char* json = smd_string_stream_close(stream, &jsonSize);
+
+  char* result = encode(dims, fragmentCount, fragments, pageCount, pages, json, jsonSize, out_size);
+  free(json);
+  free(fragments);
+  free(pages);
+
+  DEBUG("binary metadata of dataset %s: %"PRId64" fragments in %"PRId64" pages, %"PRIu64" bytes", d->id, fragmentCount, pageCount, (uint64_t)*out_size);
+  return result;
+}
+
+char* esdmI_dataset_metadata_createBinaryFragmentList(esdm_dataset_t *d, size_t *out_size) {
+  eassert(d);
+  eassert(d->dataspace);
+  eassert(out_size);
+
+  //neither pages nor JSON, the list is decoded in one go and only ever appended to an existing dataset
+  return encode(d->dataspace->dims, d->fragments.uncommittedCount, d->fragments.uncommitted, 0, NULL, "", 0, out_size);
+}
+
+// Decoding ///////////////////////////////////////////////////////////////////
+
+bool esdmI_metadata_isBinary(const char *md, size_t size) {
+  return md && size >= sizeof(binaryHeader_t) && !memcmp(md, kMagic, sizeof(kMagic));
+}
+
+static bool rangeIsValid(size_t size, uint64_t offset, uint64_t length) {
+  return offset <= size && length <= size - offset;
+}
+
+//Checks that `offset` references a NUL terminated string within the pool.
+static bool stringIsValid(const binaryHeader_t* header, const char* md, uint64_t offset) {
+  if(offset < header->poolOffset || offset >= header->poolOffset + header->poolSize) return false;
+  return memchr(md + offset, 0, header->poolOffset + header->poolSize - offset) != NULL;
+}
+
+//Sanity check all the offsets in the header, so that the decoding can access the parts without further checks.
+static bool headerIsValid(const binaryHeader_t* header, const char* md, size_t size) {
+  if(header->version != kVersion) {
+    DEBUG("unsupported binary metadata version %"PRIu32, header->version);
+    return false;
+  }
+  if(header->byteOrder != kByteOrderMark) {
+    DEBUG("binary metadata was written on a machine with a different byte order%s", "");
+    return false;
+  }
+  if(header->dims < 0 || header->fragmentCount < 0 || header->backendCount < 0 || header->backendCount > UINT32_MAX) return false;
+  if(header->recordSize != recordSize(header->dims)) return false;
+  if((uint64_t)header->backendCount > size/sizeof(uint64_t)) return false;
+  if(!rangeIsValid(size, header->backendTableOffset, header->backendCount*sizeof(uint64_t))) return false;
+  if(header->fragmentCount && (uint64_t)header->fragmentCount > size/header->recordSize) return false;
+  if(!rangeIsValid(size, header->recordTableOffset, header->fragmentCount*header->recordSize)) return false;
+  if(header->pageCount < 0 || (uint64_t)header->pageCount > size/pageSize(header->dims)) return false;
+  if(!rangeIsValid(size, header->pageTableOffset, header->pageCount*pageSize(header->dims))) return false;
+  if(!rangeIsValid(size, header->poolOffset, header->poolSize)) return false;
+  if(!rangeIsValid(size, header->jsonOffset, header->jsonSize) || !header->jsonSize) return false;
+  if(md[header->jsonOffset + header->jsonSize - 1]) return false;
+  if((header->backendTableOffset | header->pageTableOffset | header->recordTableOffset) & 7) return false;
+  return true;
+}
+
+//Resolves the interned backend IDs, unknown backends are represented by NULL.
+static esdm_backend_t** decodeBackends(const binaryHeader_t* header, const char* md) {
+  const uint64_t* backendTable = (const uint64_t*)(md + header->backendTableOffset);
+  esdm_backend_t** backends = ea_checked_malloc((header->backendCount ? header->backendCount : 1)*sizeof(*backends));
+  for(int64_t i = 0; i < header->backendCount; i++) {
+    backends[i] = stringIsValid(header, md, backendTable[i]) ? esdmI_get_backend(md + backendTable[i]) : NULL;
+  }
+  return backends;
+}
+
+//Creates the fragments for the records in the range [first, first + count) and adds them to the dataset.
+//`loaded` tells whether the fragments are already part of the persistent metadata, or still need to be committed.
+static esdm_status decodeRecords(esdm_dataset_t *d, const binaryHeader_t* header, const char* md, esdm_backend_t** backends, int64_t first, int64_t count, bool loaded) {
+  esdm_status ret = ESDM_SUCCESS;
+  int64_t dims = header->dims;
+  for(int64_t i = first; i < first + count && ret == ESDM_SUCCESS; i++) {
+    const binaryFragmentRecord_t* record = (const binaryFragmentRecord_t*)(md + header->recordTableOffset + i*header->recordSize);
+    if(!stringIsValid(header, md, record->id) || record->backend >= header->backendCount || !backends[record->backend]) {
+      ret = ESDM_INVALID_DATA_ERROR;
+      break;
+    }
+    esdm_backend_t* backend = backends[record->backend];
+
+    esdm_dataspace_t* space;
+    ret = esdm_dataspace_create_full(dims, (int64_t*)record->coords + dims, (int64_t*)record->coords, d->dataspace->type, &space);
+    if(ret != ESDM_SUCCESS) break;
+    if(record->stride != NO_OFFSET) {
+      if(record->stride < header->poolOffset || !rangeIsValid(header->poolOffset + header->poolSize, record->stride, dims*sizeof(int64_t))) {
+        esdm_dataspace_destroy(space);
+        ret = ESDM_INVALID_DATA_ERROR;
+        break;
+      }
+      int64_t stride[dims ? dims : 1];
+      memcpy(stride, md + record->stride, dims*sizeof(int64_t));
+      esdm_dataspace_set_stride(space, stride);
+    }
+
+    //the backend specific JSON is only parsed if the backend actually wants to see it
+    json_t* backendMetadata = NULL;
+    if(record->backendMetadata != NO_OFFSET && backend->callbacks.fragment_metadata_load) {
+      if(!stringIsValid(header, md, record->backendMetadata)) {
+        esdm_dataspace_destroy(space);
+        ret = ESDM_INVALID_DATA_ERROR;
+        break;
+      }
+      json_error_t error;
+      backendMetadata = json_loads(md + record->backendMetadata, JSON_DECODE_ANY, &error);
+    }
+
+    esdm_fragment_t* fragment;
+    ret = esdmI_fragment_createFromParts(d, md + record->id, backend, record->actualBytes, space, backendMetadata, &fragment);
+    if(backendMetadata) json_decref(backendMetadata);
+    if(ret == ESDM_SUCCESS) ret = loaded ? esdmI_dataset_addLoadedFragment(d, fragment) : esdmI_dataset_addFragment(d, fragment);
+  }
+  return ret;
+}
+
+// Lazy loading ///////////////////////////////////////////////////////////////
+
+//Sets up the pages of a snapshot for lazy loading, the unlimited dimensions of the dataset are extended to cover all pages.
+static esdm_status createFragmentPages(esdm_dataset_t *d, const binaryHeader_t* header, const char* md, size_t size, esdmI_fragmentPages_t** out_pages) {
+  int64_t dims = header->dims;
+  esdmI_fragmentPages_t* result = ea_checked_malloc(sizeof(*result));
+  *result = (esdmI_fragmentPages_t){
+    .md = tShared.users ? (char*)tShared.sharedBase + (md - tShared.privateBase) : ea_memdup((void*)md, size),
+    .sharedUsers = tShared.users,
+    .header = *header,
+    .bounds = ea_checked_calloc(header->pageCount, sizeof(*result->bounds)),
+    .unloadedCount = 0
+  };
+  if(result->sharedUsers) (*result->sharedUsers)++;
+  for(int64_t i = 0; i < header->pageCount; i++) {
+    const binaryPage_t* page = (const binaryPage_t*)(md + header->pageTableOffset + i*pageSize(dims));
+    bool valid = page->firstRecord >= 0 && page->firstRecord <= header->fragmentCount && page->recordCount >= 0 && page->recordCount <= header->fragmentCount - page->firstRecord;
+    for(int64_t j = 0; j < dims; j++) valid = valid && page->bounds[dims + j] >= 0;
+    if(!valid) {
+      esdmI_fragmentPages_destroy(result);
+      return ESDM_INVALID_DATA_ERROR;
+    }
+    result->bounds[result->unloadedCount++] = esdmI_hypercube_make(dims, (int64_t*)page->bounds, (int64_t*)page->bounds + dims);
+    esdmI_dataset_extendActualSize(d, page->bounds, page->bounds + dims);
+  }
+  result->backends = decodeBackends(header, result->md);
+  *out_pages = result;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdmI_dataset_loadFragmentPages(esdm_dataset_t *d, esdmI_hypercube_t* region) {
+  eassert(d);
+  //Other threads wait here until the pages are decoded. Only a recursive call from the decoding thread itself sees `loading` set.
+  g_rec_mutex_lock(&d->loadMutex);
+  esdmI_fragmentPages_t* pages = d->fragmentPages;
+  if(!pages || pages->loading) {
+    g_rec_mutex_unlock(&d->loadMutex);
+    return ESDM_SUCCESS;
+  }
+
+  pages->loading = true;
+  esdm_status ret = ESDM_SUCCESS;
+  int64_t dims = pages->header.dims;
+  for(int64_t i = 0; i < pages->header.pageCount && ret == ESDM_SUCCESS; i++) {
+    if(!pages->bounds[i]) continue;
+    if(region && !esdmI_hypercube_doesIntersect(region, pages->bounds[i])) continue;
+
+    const binaryPage_t* page = (const binaryPage_t*)(pages->md + pages->header.pageTableOffset + i*pageSize(dims));
+    DEBUG("loading page %"PRId64" of dataset %s with %"PRId64" fragments", i, d->id, page->recordCount);
+    esdmI_hypercube_destroy(pages->bounds[i]);
+    pages->bounds[i] = NULL;
+    pages->unloadedCount--;
+    ret = decodeRecords(d, &pages->header, pages->md, pages->backends, page->firstRecord, page->recordCount, true);
+  }
+  pages->loading = false;
+
+  //once everything is loaded, the binary metadata is not needed anymore
+  if(!pages->unloadedCount) {
+    esdmI_fragmentPages_destroy(pages);
+    d->fragmentPages = NULL;
+  }
+  g_rec_mutex_unlock(&d->loadMutex);
+  return ret;
+}
+
+void esdmI_fragmentPages_destroy(esdmI_fragmentPages_t* pages) {
+  if(!pages) return;
+  for(int64_t i = 0; i < pages->header.pageCount; i++) {
+    if(pages->bounds[i]) esdmI_hypercube_destroy(pages->bounds[i]);
+  }
+  free(pages->bounds);
+  free(pages->backends);
+  if(pages->sharedUsers) {
+    (*pages->sharedUsers)--;
+  } else {
+    free(pages->md);
+  }
+  free(pages);
+}
+
+int64_t esdmI_fragmentPages_memorySize(esdmI_fragmentPages_t* pages) {
+  if(!pages) return 0;
+  const binaryHeader_t* header = &pages->header;
+  uint64_t mdSize = header->jsonOffset + header->jsonSize;
+  if(header->poolOffset + header->poolSize > mdSize) mdSize = header->poolOffset + header->poolSize;
+  if(pages->sharedUsers) mdSize = 0;  //shared memory is not held by this process alone
+  int64_t boundsSize = pages->unloadedCount*(sizeof(esdmI_hypercube_t*) + sizeof(esdmI_hypercube_t) + 2*header->dims*sizeof(int64_t));
+  return sizeof(*pages) + mdSize + boundsSize + header->backendCount*sizeof(*pages->backends);
+}
+
+// Parsing ////////////////////////////////////////////////////////////////////
+
+esdm_status esdmI_dataset_metadata_parseBinary(esdm_dataset_t *d, const char *md, size_t size, bool journalEntry) {
+  eassert(d);
+  eassert(esdmI_metadata_isBinary(md, size));
+
+  binaryHeader_t header;
+  memcpy(&header, md, sizeof(header));
+  if(!headerIsValid(&header, md, size)) return ESDM_INVALID_DATA_ERROR;
+
+  //the dataset level metadata, this also sets up the dataspace of the dataset
+  //parsing modifies the JSON, so it works on a copy of this small part, and `md` may be shared with other processes
+  json_t* root;
+  char* json = ea_memdup((void*)(md + header.jsonOffset), header.jsonSize);
+  esdm_status ret = esdmI_dataset_metadata_parseHeader(d, json, header.jsonSize - 1, &root);
+  free(json);
+  if(ret != ESDM_SUCCESS) return ret;
+  if(d->dataspace->dims != header.dims) {
+    json_decref(root);
+    return ESDM_INVALID_DATA_ERROR;
+  }
+
+  if(!journalEntry && header.pageCount) {
+    //the fragments of a snapshot are only decoded when they are needed
+    eassert(!d->fragmentPages);
+    ret = createFragmentPages(d, &header, md, size, &d->fragmentPages);
+  } else {
+    //journal entries are small, decode them right away
+    esdm_backend_t** backends = decodeBackends(&header, md);
+    ret = decodeRecords(d, &header, md, backends, 0, header.fragmentCount, true);
+    free(backends);
+  }
+
+  if(ret == ESDM_SUCCESS) ret = esdmI_dataset_metadata_parseGrids(d, root, journalEntry);
+  json_decref(root);
+  if(ret != ESDM_SUCCESS) return ret;
+
+  d->status = ESDM_DATA_PERSISTENT;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdmI_dataset_metadata_parseBinaryFragmentList(esdm_dataset_t *d, const char *md, size_t size) {
+  eassert(d);
+  eassert(d->dataspace);
+
+  if(!esdmI_metadata_isBinary(md, size)) return ESDM_INVALID_DATA_ERROR;
+  binaryHeader_t header;
+  memcpy(&header, md, sizeof(header));
+  if(!headerIsValid(&header, md, size) || header.pageCount || header.dims != d->dataspace->dims) return ESDM_INVALID_DATA_ERROR;
+
+  esdm_backend_t** backends = decodeBackends(&header, md);
+  esdm_status ret = decodeRecords(d, &header, md, backends, 0, header.fragmentCount, false);
+  free(backends);
+  return ret;
+}
+
+esdm_status esdmI_dataset_metadata_parseShared(esdm_dataset_t *d, const char *md, int size, int64_t *users) {
+  eassert(d);
+  eassert(md);
+  eassert(users);
+
+  //A binary snapshot is parsed in place. Other metadata is parsed from a private, NUL terminated copy,
+  //since parsing JSON modifies it, which must not happen in memory that other processes read concurrently.
+  char* privateCopy = NULL;
+  if(!esdmI_metadata_isBinary(md, size)) {
+    privateCopy = ea_checked_malloc(size + 1);
+    memcpy(privateCopy, md, size);
+    privateCopy[size] = 0;
+  }
+  tShared.privateBase = privateCopy ? privateCopy : md;
+  tShared.sharedBase = md;
+  tShared.users = users;
+  esdm_status ret = esdm_dataset_open_md_parse(d, privateCopy ? privateCopy : (char*)md, size);
+  tShared.privateBase = tShared.sharedBase = NULL;
+  tShared.users = NULL;
+  free(privateCopy);
+  return ret;
+}
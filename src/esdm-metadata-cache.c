@@ -0,0 +1,311 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * @brief A process wide LRU cache for container and dataset metadata.
+ *
+ * Opening a container or dataset normally fetches its metadata from the metadata backend and parses it.
+ * The cache holds two kinds of entries within a common memory budget:
+ *
+ *   * The metadata buffers as they were returned by the backend, keyed by container name or dataset ID.
+ *     These outlive the container objects, so reopening a container or dataset after it was closed completely does not touch the backend.
+ *
+ *   * Datasets that have been closed, but are kept parsed as long as their container is alive.
+ *     Reopening such a dataset needs neither the backend nor the parser, evicting it unloads it like a regular close.
+ *
+ * Entries are dropped when this process commits or removes the corresponding metadata.
+ * If the backend can report versions of its metadata, and validation is enabled, entries that were changed by other processes are detected when they are reused.
+ */
+
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEBUG(fmt, ...) ESDM_DEBUG_COM_FMT("MDCACHE", fmt, __VA_ARGS__)
+
+typedef struct cacheEntry_t cacheEntry_t;
+struct cacheEntry_t {
+  cacheEntry_t *prev, *next; //the LRU list, most recently used first
+
+  //buffer entries
+  char* key;  //"c:<container name>" or "d:<dataset ID>", NULL for dataset entries
+  char* md;
+  int size;
+
+  //dataset entries
+  esdm_dataset_t* dataset;
+
+  bool hasVersion;
+  uint64_t version;
+  int64_t cost;  //bytes accounted against the budget
+};
+
+struct esdmI_metadataCache_t {
+  esdm_md_backend_t* backend;
+  int64_t budget, used;
+  bool validate;
+
+  GMutex mutex;
+  GHashTable* buffers;  //key -> cacheEntry_t*
+  GHashTable* datasets; //esdm_dataset_t* -> cacheEntry_t*
+  cacheEntry_t *head, *tail;
+};
+
+static const int64_t kFragmentCost = sizeof(esdm_fragment_t) + sizeof(esdm_dataspace_t) + 128; //rough estimate for the fragment, its shape, and the hash table entries
+
+// LRU list ///////////////////////////////////////////////////////////////////
+
+static void unlinkEntry(esdmI_metadataCache_t* cache, cacheEntry_t* entry) {
+  if(entry->prev) entry->prev->next = entry->next; else cache->head = entry->next;
+  if(entry->next) entry->next->prev = entry->prev; else cache->tail = entry->prev;
+  entry->prev = entry->next = NULL;
+}
+
+static void pushEntry(esdmI_metadataCache_t* cache, cacheEntry_t* entry) {
+  entry->prev = NULL;
+  entry->next = cache->head;
+  if(cache->head) cache->head->prev = entry; else cache->tail = entry;
+  cache->head = entry;
+}
+
+//Removes the entry from the cache and frees it, a dataset is only unloaded if `unload` is set.
+static void dropEntry(esdmI_metadataCache_t* cache, cacheEntry_t* entry, bool unload) {
+  unlinkEntry(cache, entry);
+  cache->used -= entry->cost;
+  if(entry->key) {
+    g_hash_table_remove(cache->buffers, entry->key);
+    free(entry->key);
+    free(entry->md);
+  } else {
+    g_hash_table_remove(cache->datasets, entry->dataset);
+    //a dataset that has been referenced again behind the cache's back is in use and must stay loaded
+    if(unload && !entry->dataset->refcount) esdmI_dataset_unload(entry->dataset);
+  }
+  free(entry);
+}
+
+static void evict(esdmI_metadataCache_t* cache) {
+  while(cache->used > cache->budget && cache->tail) {
+    DEBUG("evicting %s", cache->tail->key ? cache->tail->key : cache->tail->dataset->id);
+    dropEntry(cache, cache->tail, true);
+  }
+}
+
+// Versions ///////////////////////////////////////////////////////////////////
+
+//Exactly one of `container` and `dataset` must be set.
+static bool queryVersion(esdmI_metadataCache_t* cache, esdm_container_t* container, esdm_dataset_t* dataset, uint64_t* out_version) {
+  if(!cache->validate) return false;
+  esdm_md_backend_callbacks_t* callbacks = &cache->backend->callbacks;
+  if(container) return callbacks->container_version && callbacks->container_version(cache->backend, container, out_version) == ESDM_SUCCESS;
+  return callbacks->dataset_version && callbacks->dataset_version(cache->backend, dataset, out_version) == ESDM_SUCCESS;
+}
+
+//Checks whether the entry still matches the metadata in the backend, entries without version are trusted.
+static bool isCurrent(esdmI_metadataCache_t* cache, cacheEntry_t* entry, esdm_container_t* container, esdm_dataset_t* dataset) {
+  if(!entry->hasVersion) return true;
+  uint64_t version;
+  return queryVersion(cache, container, dataset, &version) && version == entry->version;
+}
+
+// Buffer entries /////////////////////////////////////////////////////////////
+
+static char* makeKey(esdm_container_t* container, esdm_dataset_t* dataset) {
+  const char* name = container ? container->name : dataset->id;
+  size_t length = strlen(name) + 3;
+  char* result = ea_checked_malloc(length);
+  snprintf(result, length, "%c:%s", container ? 'c' : 'd', name);
+  return result;
+}
+
+static bool lookupBuffer(esdmI_metadataCache_t* cache, esdm_container_t* container, esdm_dataset_t* dataset, char** out_md, int* out_size) {
+  if(!cache) return false;
+  char* key = makeKey(container, dataset);
+  g_mutex_lock(&cache->mutex);
+  cacheEntry_t* entry = g_hash_table_lookup(cache->buffers, key);
+  bool hit = entry && isCurrent(cache, entry, container, dataset);
+  if(hit) {
+    unlinkEntry(cache, entry);
+    pushEntry(cache, entry);
+    *out_md = ea_checked_malloc(entry->size + 1);
+    memcpy(*out_md, entry->md, entry->size + 1);  //the parsers modify the buffer, so the caller gets a copy
+    *out_size = entry->size;
+  } else if(entry) {
+    DEBUG("%s has been changed by another process", key);
+    dropEntry(cache, entry, false);
+  }
+  g_mutex_unlock(&cache->mutex);
+  free(key);
+  return hit;
+}
+
+//Exactly one of `container` and `dataset` must be set, and the corresponding load function.
+static esdm_status loadBuffer(esdmI_metadataCache_t* cache, esdm_container_t* container, esdmI_metadataCache_loadContainer_func_t loadContainer, esdm_dataset_t* dataset, esdmI_metadataCache_loadDataset_func_t loadDataset, char** out_md, int* out_size) {
+  if(!cache) return container ? loadContainer(container, out_md, out_size) : loadDataset(dataset, out_md, out_size);
+  if(lookupBuffer(cache, container, dataset, out_md, out_size)) return ESDM_SUCCESS;
+
+  //the version is taken before the metadata, so that a concurrent change results in a version mismatch on the next lookup, not in a stale hit
+  uint64_t version;
+  bool hasVersion = queryVersion(cache, container, dataset, &version);
+  esdm_status ret = container ? loadContainer(container, out_md, out_size) : loadDataset(dataset, out_md, out_size);
+  if(ret != ESDM_SUCCESS || *out_size < 0) return ret;
+
+  int64_t cost = sizeof(cacheEntry_t) + *out_size + 1;
+  if(cost > cache->budget) return ESDM_SUCCESS;
+  cacheEntry_t* entry = ea_checked_malloc(sizeof(*entry));
+  *entry = (cacheEntry_t){
+    .key = makeKey(container, dataset),
+    .md = ea_checked_malloc(*out_size + 1),
+    .size = *out_size,
+    .hasVersion = hasVersion,
+    .version = version,
+    .cost = cost
+  };
+  memcpy(entry->md, *out_md, *out_size);
+  entry->md[*out_size] = 0;
+
+  g_mutex_lock(&cache->mutex);
+  cacheEntry_t* old = g_hash_table_lookup(cache->buffers, entry->key);
+  if(old) dropEntry(cache, old, false);
+  g_hash_table_insert(cache->buffers, entry->key, entry);
+  pushEntry(cache, entry);
+  cache->used += cost;
+  evict(cache);
+  g_mutex_unlock(&cache->mutex);
+  return ESDM_SUCCESS;
+}
+
+static void invalidateBuffer(esdmI_metadataCache_t* cache, esdm_container_t* container, esdm_dataset_t* dataset) {
+  if(!cache) return;
+  char* key = makeKey(container, dataset);
+  g_mutex_lock(&cache->mutex);
+  cacheEntry_t* entry = g_hash_table_lookup(cache->buffers, key);
+  if(entry) dropEntry(cache, entry, false);
+  g_mutex_unlock(&cache->mutex);
+  free(key);
+}
+
+// Public interface ///////////////////////////////////////////////////////////
+
+esdmI_metadataCache_t* esdmI_metadataCache_create(esdm_md_backend_t* backend) {
+  eassert(backend);
+  if(backend->config->metadata_cache_size <= 0) return NULL;
+
+  esdmI_metadataCache_t* cache = ea_checked_malloc(sizeof(*cache));
+  *cache = (esdmI_metadataCache_t){
+    .backend = backend,
+    .budget = backend->config->metadata_cache_size,
+    .used = 0,
+    .validate = backend->config->metadata_cache_validate,
+    .buffers = g_hash_table_new(g_str_hash, g_str_equal),
+    .datasets = g_hash_table_new(g_direct_hash, g_direct_equal),
+    .head = NULL,
+    .tail = NULL
+  };
+  g_mutex_init(&cache->mutex);
+  DEBUG("created metadata cache with a budget of %"PRId64" bytes", cache->budget);
+  return cache;
+}
+
+void esdmI_metadataCache_destroy(esdmI_metadataCache_t* cache) {
+  if(!cache) return;
+  //the datasets belong to their containers, they are only forgotten, not unloaded
+  while(cache->head) dropEntry(cache, cache->head, false);
+  g_hash_table_destroy(cache->buffers);
+  g_hash_table_destroy(cache->datasets);
+  g_mutex_clear(&cache->mutex);
+  free(cache);
+}
+
+esdm_status esdmI_metadataCache_loadContainer(esdmI_metadataCache_t* cache, esdm_container_t* container, esdmI_metadataCache_loadContainer_func_t load, char** out_md, int* out_size) {
+  eassert(container);
+  eassert(load);
+  return loadBuffer(cache, container, load, NULL, NULL, out_md, out_size);
+}
+
+esdm_status esdmI_metadataCache_loadDataset(esdmI_metadataCache_t* cache, esdm_dataset_t* dataset, esdmI_metadataCache_loadDataset_func_t load, char** out_md, int* out_size) {
+  eassert(dataset);
+  eassert(load);
+  return loadBuffer(cache, NULL, NULL, dataset, load, out_md, out_size);
+}
+
+void esdmI_metadataCache_invalidateContainer(esdmI_metadataCache_t* cache, esdm_container_t* container) {
+  eassert(container);
+  invalidateBuffer(cache, container, NULL);
+}
+
+void esdmI_metadataCache_invalidateDataset(esdmI_metadataCache_t* cache, esdm_dataset_t* dataset) {
+  eassert(dataset);
+  invalidateBuffer(cache, NULL, dataset);
+}
+
+bool esdmI_metadataCache_retainDataset(esdmI_metadataCache_t* cache, esdm_dataset_t* dataset) {
+  eassert(dataset);
+  eassert(!dataset->refcount);
+  if(!cache) return false;
+
+  int64_t cost = sizeof(cacheEntry_t) + sizeof(*dataset) + g_hash_table_size(dataset->fragments.table)*kFragmentCost + esdmI_fragmentPages_memorySize(dataset->fragmentPages);
+  if(cost > cache->budget) return false;
+  cacheEntry_t* entry = ea_checked_malloc(sizeof(*entry));
+  *entry = (cacheEntry_t){
+    .dataset = dataset,
+    .cost = cost
+  };
+  entry->hasVersion = queryVersion(cache, NULL, dataset, &entry->version);
+
+  g_mutex_lock(&cache->mutex);
+  eassert(!g_hash_table_contains(cache->datasets, dataset));
+  g_hash_table_insert(cache->datasets, dataset, entry);
+  pushEntry(cache, entry);
+  cache->used += cost;
+  evict(cache);  //may evict the new entry right away, which unloads the dataset just like a cache miss would
+  g_mutex_unlock(&cache->mutex);
+  return true;
+}
+
+void esdmI_metadataCache_releaseDataset(esdmI_metadataCache_t* cache, esdm_dataset_t* dataset, bool unload) {
+  eassert(dataset);
+  if(!cache) return;
+  g_mutex_lock(&cache->mutex);
+  cacheEntry_t* entry = g_hash_table_lookup(cache->datasets, dataset);
+  if(entry) {
+    if(!unload && !isCurrent(cache, entry, NULL, dataset)) {
+      DEBUG("dataset %s has been changed by another process", dataset->id);
+      unload = true;
+    }
+    dropEntry(cache, entry, unload);
+  }
+  g_mutex_unlock(&cache->mutex);
+}
+
+void esdmI_metadataCache_forgetDataset(esdmI_metadataCache_t* cache, esdm_dataset_t* dataset) {
+  eassert(dataset);
+  if(!cache) return;
+  g_mutex_lock(&cache->mutex);
+  cacheEntry_t* entry = g_hash_table_lookup(cache->datasets, dataset);
+  if(entry) dropEntry(cache, entry, false);
+  g_mutex_unlock(&cache->mutex);
+}
+
+int64_t esdmI_metadataCache_usedBytes(esdmI_metadataCache_t* cache) {
+  if(!cache) return 0;
+  g_mutex_lock(&cache->mutex);
+  int64_t result = cache->used;
+  g_mutex_unlock(&cache->mutex);
+  return result;
+}
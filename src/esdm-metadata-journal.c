@@ -0,0 +1,145 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * @brief An append only journal of the dataset metadata.
+ *
+ * Rewriting the entire metadata of a dataset on every commit makes the commit cost proportional to the size of the dataset, not to the size of the change.
+ * With the journal enabled, a commit only appends a journal entry with the fragments and grids that were added since the last commit,
+ * every `journal_max_entries` commits (or on an explicit `esdm_dataset_compact()`) a new snapshot replaces the old one and the journal is discarded.
+ *
+ * The journal is a sequence of records:
+ *
+ *     magic | payload size | snapshot ID | payload | padding to 8 bytes
+ *
+ * The payload is a journal entry in either metadata format, followed by a terminating NUL, so that JSON entries can be parsed in place.
+ * A journal entry has the same structure as a snapshot, replaying it adds its fragments and grids to the dataset and replaces the dataset level metadata.
+ * A record that is cut short (e.g. by a crash during the append) ends the replay, the entries before it remain valid.
+ *
+ * The snapshot ID is a hash of the snapshot that the entry was appended to.
+ * The backend publishes a new snapshot before it discards the journal, so a crash in between leaves a journal whose entries are already contained in the snapshot.
+ * These entries carry the ID of the old snapshot, and the replay skips them.
+ */
+
+#define _GNU_SOURCE
+
+#include <esdm-internal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEBUG(fmt, ...) ESDM_DEBUG_COM_FMT("JOURNAL", fmt, __VA_ARGS__)
+
+static const char kMagic[8] = "ESDMJNL";  //includes the terminating NUL
+
+typedef struct journalRecordHeader_t {
+  char magic[8];
+  uint64_t size;  //size of the payload in bytes, including the terminating NUL, excluding the padding
+  uint64_t snapshotId;  //the ID of the snapshot that the entry belongs to, the ID of the snapshot itself in its own record
+} journalRecordHeader_t;
+
+static uint64_t paddedSize(uint64_t size) { return (size + 7) & ~(uint64_t)7; }
+
+//Writes the record for the given payload to `out`, which must have room for `sizeof(journalRecordHeader_t) + paddedSize(size + 1)` bytes.
+static void writeRecord(char* out, const char* md, size_t size, uint64_t snapshotId) {
+  journalRecordHeader_t header = { .size = size + 1, .snapshotId = snapshotId };
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  memcpy(out, &header, sizeof(header));
+  memcpy(out + sizeof(header), md, size);
+  memset(out + sizeof(header) + size, 0, paddedSize(size + 1) - size);
+}
+
+uint64_t esdmI_metadata_journal_snapshotId(const char *snapshot, size_t size) {
+  eassert(snapshot || !size);
+
+  uint64_t hash = 0xcbf29ce484222325ull;  //FNV-1a
+  for(size_t i = 0; i < size; i++) hash = (hash ^ (uint8_t)snapshot[i])*0x100000001b3ull;
+  return hash;
+}
+
+char* esdmI_metadata_journal_createRecord(const char *md, size_t size, uint64_t snapshotId, size_t *out_size) {
+  eassert(md);
+  eassert(out_size);
+
+  *out_size = sizeof(journalRecordHeader_t) + paddedSize(size + 1);
+  char* result = ea_checked_malloc(*out_size);
+  writeRecord(result, md, size, snapshotId);
+  return result;
+}
+
+char* esdmI_metadata_journal_bundle(const char *snapshot, size_t snapshotSize, const char *journal, size_t journalSize, size_t *out_size) {
+  eassert(snapshot);
+  eassert(journal || !journalSize);
+  eassert(out_size);
+
+  size_t snapshotRecordSize = sizeof(journalRecordHeader_t) + paddedSize(snapshotSize + 1);
+  *out_size = snapshotRecordSize + journalSize;
+  char* result = ea_checked_malloc(*out_size + 1);
+  writeRecord(result, snapshot, snapshotSize, esdmI_metadata_journal_snapshotId(snapshot, snapshotSize));
+  if(journalSize) memcpy(result + snapshotRecordSize, journal, journalSize);
+  result[*out_size] = 0;  //like the plain metadata, the buffer is NUL terminated
+  return result;
+}
+
+bool esdmI_metadata_isJournal(const char *md, size_t size) {
+  return md && size >= sizeof(journalRecordHeader_t) && !memcmp(md, kMagic, sizeof(kMagic));
+}
+
+esdm_status esdmI_dataset_metadata_replayJournal(esdm_dataset_t *d, char *md, size_t size) {
+  eassert(d);
+  eassert(esdmI_metadata_isJournal(md, size));
+
+  //the first record is the snapshot, all following records are journal entries
+  int64_t recordCount = 0, staleCount = 0;
+  size_t offset = 0;
+  bool truncated = false;
+  while(offset < size) {
+    journalRecordHeader_t header;
+    if(size - offset < sizeof(header)) {
+      truncated = true;
+      break;
+    }
+    memcpy(&header, md + offset, sizeof(header));
+    char* payload = md + offset + sizeof(header);
+    if(memcmp(header.magic, kMagic, sizeof(kMagic)) || !header.size || header.size > size - offset - sizeof(header) || payload[header.size - 1]) {
+      truncated = true;
+      break;
+    }
+
+    if(!recordCount) d->snapshotId = header.snapshotId;
+    if(header.snapshotId == d->snapshotId) {
+      esdm_status ret = esdmI_dataset_metadata_parse(d, payload, header.size - 1, recordCount > 0);
+      if(ret != ESDM_SUCCESS) return ret;
+      recordCount++;
+    } else {
+      staleCount++;  //left behind by a crash after the snapshot that includes it was written
+    }
+
+    uint64_t recordSize = sizeof(header) + paddedSize(header.size);
+    offset = recordSize < size - offset ? offset + recordSize : size;
+  }
+  if(!recordCount) return ESDM_INVALID_DATA_ERROR;
+
+  if(truncated) {
+    //Appending behind the damaged record would make all further entries unreachable, so the next commit must write a snapshot.
+    ESDM_LOG_FMT(ESDM_LOGLEVEL_WARNING, "ignoring truncated journal record of dataset %s after %"PRId64" entries", d->id, recordCount - 1);
+    d->journalEntries = -1;
+  } else {
+    d->journalEntries = recordCount - 1;
+  }
+  DEBUG("replayed %"PRId64" journal entries of dataset %s, skipped %"PRId64" stale entries", recordCount - 1, d->id, staleCount);
+  return ESDM_SUCCESS;
+}
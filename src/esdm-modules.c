@@ -43,6 +43,11 @@
 #  pragma message("Building ESDM with MongoDB support.")
 #endif
 
+#ifdef ESDM_HAS_SQLITE
+#  include "backends-metadata/sqlite/md-sqlite.h"
+#  pragma message("Building ESDM with SQLite metadata support.")
+#endif
+
 esdm_modules_t *esdm_modules_init(esdm_instance_t *esdm) {
   ESDM_DEBUG(__func__);
 
@@ -66,10 +71,16 @@ esdm_modules_t *esdm_modules_init(esdm_instance_t *esdm) {
   else if (strncmp(metadata_coordinator->type, "mongodb", 7) == 0) {
     modules->metadata_backend = mongodb_backend_init(metadata_coordinator);
   }
+#endif
+#ifdef ESDM_HAS_SQLITE
+  else if (strncmp(metadata_coordinator->type, "sqlite", 6) == 0) {
+    modules->metadata_backend = md_sqlite_backend_init(metadata_coordinator);
+  }
 #endif
   else {
     ESDM_ERROR("Unknown metadata backend type. Please check your ESDM configuration.");
   }
+  modules->metadata_cache = esdmI_metadataCache_create(modules->metadata_backend);
 
   // Register data backends
   modules->data_backend_count = config_backends->count;
@@ -109,6 +120,7 @@ esdm_status esdm_modules_finalize(esdm_instance_t *esdm) {
     }
     free(esdm->modules->data_backends);
 
+    esdmI_metadataCache_destroy(esdm->modules->metadata_cache);
     if(esdm->modules->metadata_backend->callbacks.finalize) {
       esdm->modules->metadata_backend->callbacks.finalize(esdm->modules->metadata_backend);
     }
@@ -27,30 +27,355 @@
 #include <esdm-internal.h>
 #include <esdm.h>
 #include <glib.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __linux__
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #define ESDM_HAVE_FUTEX 1
+#endif
+
 #define DEBUG_ENTER ESDM_DEBUG_COM_FMT("SCHEDULER", "", "")
 #define DEBUG(fmt, ...) ESDM_DEBUG_COM_FMT("SCHEDULER", fmt, __VA_ARGS__)
 
-static void backend_thread(io_work_t *data_p, esdm_backend_t *backend_id);
+static void io_stage(io_work_t *work);
+static void io_stage_batch(io_work_t *works);
+static void cpu_stage(io_work_t *work);
+
+// Statistics ////////////////////////////////////////////////////////////////
+
+//The timing statistics are accumulated per thread, so that the hot paths do not need any synchronization,
+//and merged only when they are requested.
+//Each accumulator is only ever written by its own thread, a concurrent query may thus see values that are a few updates behind, but never inconsistent ones.
+typedef struct threadStats_t threadStats_t;
+struct threadStats_t {
+  esdm_readTimes_t read;
+  esdm_writeTimes_t write;
+  esdm_copyTimes_t copy;
+  double inputTime, outputTime;
+  threadStats_t *next;
+};
+
+static GMutex gStatsMutex;  //protects the list of accumulators, and the retired stats
+static threadStats_t *gStatsList = NULL;  //the accumulators of all living threads
+static threadStats_t gRetiredStats = {0}; //the sum of the accumulators of all threads that have terminated
+
+static void add_stats(threadStats_t *sum, const threadStats_t *summand) {
+  sum->read = esdmI_performance_read_add(&sum->read, &summand->read);
+  sum->write = esdmI_performance_write_add(&sum->write, &summand->write);
+  sum->copy = esdmI_performance_copy_add(&sum->copy, &summand->copy);
+  sum->inputTime += summand->inputTime;
+  sum->outputTime += summand->outputTime;
+}
+
+//called on thread termination, folds the accumulator into the retired stats
+static void retire_stats(gpointer data) {
+  threadStats_t *stats = data;
+  g_mutex_lock(&gStatsMutex);
+  add_stats(&gRetiredStats, stats);
+  for(threadStats_t **link = &gStatsList; *link; link = &(*link)->next) {
+    if(*link == stats) {
+      *link = stats->next;
+      break;
+    }
+  }
+  g_mutex_unlock(&gStatsMutex);
+  free(stats);
+}
+
+static GPrivate gThreadStatsKey = G_PRIVATE_INIT(retire_stats);
+static __thread threadStats_t *tThreadStats = NULL;  //fast access path to the same object that is registered with gThreadStatsKey
+
+static threadStats_t *thread_stats() {
+  if(!tThreadStats) {
+    threadStats_t *stats = ea_checked_calloc(1, sizeof(*stats));
+    g_mutex_lock(&gStatsMutex);
+    stats->next = gStatsList;
+    gStatsList = stats;
+    g_mutex_unlock(&gStatsMutex);
+    g_private_set(&gThreadStatsKey, stats);
+    tThreadStats = stats;
+  }
+  return tThreadStats;
+}
+
+static threadStats_t collect_stats() {
+  g_mutex_lock(&gStatsMutex);
+  threadStats_t result = gRetiredStats;
+  for(threadStats_t *cur = gStatsList; cur; cur = cur->next) add_stats(&result, cur);
+  g_mutex_unlock(&gStatsMutex);
+  result.next = NULL;
+  return result;
+}
+
+esdm_readTimes_t esdmI_performance_read() { return collect_stats().read; }
+esdm_writeTimes_t esdmI_performance_write() { return collect_stats().write; }
+esdm_copyTimes_t esdmI_performance_copy() { return collect_stats().copy; }
+
+//The accumulators are only ever written by their own threads, so a reset just remembers the totals at that time, which are subtracted from later totals.
+static double gInputTimeBase = 0, gOutputTimeBase = 0;  //protected by gStatsMutex
+
+double esdmI_backendOutputTime() {
+  threadStats_t stats = collect_stats();
+  g_mutex_lock(&gStatsMutex);
+  double result = stats.outputTime - gOutputTimeBase;
+  g_mutex_unlock(&gStatsMutex);
+  return result;
+}
+
+double esdmI_backendInputTime() {
+  threadStats_t stats = collect_stats();
+  g_mutex_lock(&gStatsMutex);
+  double result = stats.inputTime - gInputTimeBase;
+  g_mutex_unlock(&gStatsMutex);
+  return result;
+}
+
+void esdmI_resetBackendIoTimes() {
+  threadStats_t stats = collect_stats();
+  g_mutex_lock(&gStatsMutex);
+  gInputTimeBase = stats.inputTime;
+  gOutputTimeBase = stats.outputTime;
+  g_mutex_unlock(&gStatsMutex);
+}
+
+// Completion tracking ///////////////////////////////////////////////////////
+
+//Account for one finished operation of a request.
+//Only the last finisher wakes the waiting thread, all others get away with a single atomic operation.
+static void status_complete_one(io_request_status_t *status, esdm_status ret) {
+  //must be published before the decrement, the waiter may return as soon as it sees `pending_ops == 0`
+  if (ret != ESDM_SUCCESS) atomic_store(&status->return_code, ret);
+
+#ifdef ESDM_HAVE_FUTEX
+  // Please note the return value from atomic_fetch_sub() is the original
+  // value stored in atomic object. Here, it's the value before subtraction.
+  int pendings = atomic_fetch_sub(&status->pending_ops, 1);
+  eassert(pendings >= 1);
+  if (pendings == 1) {
+    //The waiter may already have seen the zero and destroyed the status object.
+    //That is fine, a wake on a stale futex address is harmless, it can at most produce a spurious wakeup that any futex waiter must tolerate anyway.
+    syscall(SYS_futex, &status->pending_ops, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+  }
+#else
+  //without futexes we need the mutex to avoid lost wakeups, and to keep the waiter from destroying the status object before we are done with it
+  g_mutex_lock(&status->mutex);
+  int pendings = atomic_fetch_sub(&status->pending_ops, 1);
+  eassert(pendings >= 1);
+  if (pendings == 1) {
+    g_cond_signal(&status->done_condition);
+  }
+  g_mutex_unlock(&status->mutex);
+#endif
+}
+
+
+struct esdmI_worker_t {
+  esdm_scheduler_t *scheduler;
+  int64_t index;
+  GThread *thread;
+  esdmI_workDeque_t deque;
+};
+
+static void deque_init(esdmI_workDeque_t *deque) {
+  g_mutex_init(&deque->mutex);
+  deque->items = NULL;
+  deque->first = deque->count = deque->allocatedCount = 0;
+}
+
+static void deque_destroy(esdmI_workDeque_t *deque) {
+  eassert(!deque->count);
+  g_mutex_clear(&deque->mutex);
+  free(deque->items);
+}
+
+static void deque_pushBack(esdmI_workDeque_t *deque, io_work_t *work) {
+  g_mutex_lock(&deque->mutex);
+  if(deque->count == deque->allocatedCount) {
+    //grow the ring buffer, unwrapping its contents in the process
+    int64_t newSize = deque->allocatedCount ? 2*deque->allocatedCount : 16;
+    io_work_t **newItems = ea_checked_malloc(newSize*sizeof(*newItems));
+    for(int64_t i = 0; i < deque->count; i++) newItems[i] = deque->items[(deque->first + i)%deque->allocatedCount];
+    free(deque->items);
+    deque->items = newItems;
+    deque->first = 0;
+    deque->allocatedCount = newSize;
+  }
+  deque->items[(deque->first + deque->count++)%deque->allocatedCount] = work;
+  g_mutex_unlock(&deque->mutex);
+}
+
+//Used by the owning worker, LIFO order keeps the data that was just read hot in the cache.
+static io_work_t *deque_popBack(esdmI_workDeque_t *deque) {
+  io_work_t *result = NULL;
+  g_mutex_lock(&deque->mutex);
+  if(deque->count) result = deque->items[(deque->first + --deque->count)%deque->allocatedCount];
+  g_mutex_unlock(&deque->mutex);
+  return result;
+}
+
+//Used by the other workers to steal the oldest work item.
+static io_work_t *deque_popFront(esdmI_workDeque_t *deque) {
+  io_work_t *result = NULL;
+  g_mutex_lock(&deque->mutex);
+  if(deque->count) {
+    result = deque->items[deque->first];
+    deque->first = (deque->first + 1)%deque->allocatedCount;
+    deque->count--;
+  }
+  g_mutex_unlock(&deque->mutex);
+  return result;
+}
+
+//Get a CPU stage from our own deque, or steal one from another worker.
+static io_work_t *take_cpu_work(esdmI_worker_t *me) {
+  esdm_scheduler_t *scheduler = me->scheduler;
+  if(!atomic_load(&scheduler->pendingCpuTasks)) return NULL;
+
+  io_work_t *result = deque_popBack(&me->deque);
+  for(int64_t i = 1; !result && i < scheduler->workerCount; i++) {
+    result = deque_popFront(&scheduler->workers[(me->index + i)%scheduler->workerCount].deque);
+  }
+  if(result) atomic_fetch_sub(&scheduler->pendingCpuTasks, 1);
+  return result;
+}
+
+//Whether the backend handles several I/O operations of the given kind with a single call.
+static bool backend_batches(esdm_backend_t *backend, io_operation_t op) {
+  if(backend->batchSize < 2) return false;
+  switch(op) {
+    case ESDM_OP_READ: return backend->callbacks.fragments_retrieve;
+    case ESDM_OP_WRITE: return backend->callbacks.fragments_update;
+    case ESDM_OP_READ_REGION: return false;  //each region read has its own ranges
+  }
+  return false;
+}
+
+//Get an I/O stage from one of the backends that still has a free slot, round-robin over the backends to avoid starvation.
+//If the backend batches I/O operations, this takes up to `batchSize` consecutive work items of the same kind, which are returned as a list linked via their `next` members.
+//All of them occupy a single slot of the backend.
+//Must be called with the scheduler's mutex held.
+static io_work_t *take_io_work(esdm_scheduler_t *scheduler) {
+  for(int64_t i = 0; i < scheduler->backendCount; i++) {
+    esdm_backend_t *backend = scheduler->backends[(scheduler->nextBackend + i)%scheduler->backendCount];
+    if(backend->pendingHead && backend->activeThreads < backend->threads) {
+      io_work_t *result = backend->pendingHead, *last = result;
+      if(backend_batches(backend, result->op)) {
+        for(int64_t count = 1; count < backend->batchSize && last->next && last->next->op == result->op; count++) last = last->next;
+      }
+      backend->pendingHead = last->next;
+      if(!backend->pendingHead) backend->pendingTail = NULL;
+      last->next = NULL;
+      backend->activeThreads++;
+      scheduler->nextBackend = (scheduler->nextBackend + i + 1)%scheduler->backendCount;
+      return result;
+    }
+  }
+  return NULL;
+}
+
+static gpointer worker_thread(gpointer data) {
+  esdmI_worker_t *me = data;
+  esdm_scheduler_t *scheduler = me->scheduler;
 
-static esdm_readTimes_t gReadTimes = {0};
-static esdm_writeTimes_t gWriteTimes = {0};
+  while(true) {
+    //CPU stages take precedence, they complete requests and release memory
+    io_work_t *work = take_cpu_work(me);
+    if(work) {
+      cpu_stage(work);
+      continue;
+    }
+
+    g_mutex_lock(&scheduler->mutex);
+    work = take_io_work(scheduler);
+    if(work) {
+      g_mutex_unlock(&scheduler->mutex);
+      esdm_backend_t *backend = work->fragment->backend;  //`work` may be stolen and freed as soon as it's in our deque
+      if(work->next) {
+        io_stage_batch(work);
+      } else {
+        io_stage(work);
+      }
+
+      //hand the CPU stages to our own deque, so that the backend slot becomes free for the next I/O operation right away
+      int64_t count = 0;
+      for(io_work_t *next; work; work = next, count++) {
+        next = work->next;
+        work->next = NULL;
+        deque_pushBack(&me->deque, work);
+      }
+      atomic_fetch_add(&scheduler->pendingCpuTasks, count);
+      g_mutex_lock(&scheduler->mutex);
+      backend->activeThreads--;
+      if(count > 1) {
+        if(scheduler->idleWorkers) g_cond_broadcast(&scheduler->workAvailable); //the others can help with the CPU stages of the batch
+      } else {
+        if(scheduler->idleWorkers) g_cond_signal(&scheduler->workAvailable);  //someone else can either take the freed I/O slot or steal our CPU stage
+      }
+      g_mutex_unlock(&scheduler->mutex);
+      continue;
+    }
+
+    if(scheduler->shutdown) {
+      g_mutex_unlock(&scheduler->mutex);
+      break;
+    }
+    //`pendingCpuTasks` is incremented before the mutex is taken to signal us, so checking it under the mutex avoids lost wakeups
+    if(!atomic_load(&scheduler->pendingCpuTasks)) {
+      scheduler->idleWorkers++;
+      g_cond_wait(&scheduler->workAvailable, &scheduler->mutex);
+      scheduler->idleWorkers--;
+    }
+    g_mutex_unlock(&scheduler->mutex);
+  }
+  return NULL;
+}
+
+//Hand a work item to the executor.
+//Backends without any threads are served synchronously by the calling thread.
+static void submit_work(esdm_scheduler_t *scheduler, io_work_t *work) {
+  esdm_backend_t *backend = work->fragment->backend;
+  if (backend->threads == 0 || !scheduler || !scheduler->workerCount) {
+    io_stage(work);
+    cpu_stage(work);
+    return;
+  }
+
+  work->next = NULL;
+  g_mutex_lock(&scheduler->mutex);
+  if(backend->pendingTail) {
+    backend->pendingTail->next = work;
+  } else {
+    backend->pendingHead = work;
+  }
+  backend->pendingTail = work;
+  if(scheduler->idleWorkers) g_cond_signal(&scheduler->workAvailable);
+  g_mutex_unlock(&scheduler->mutex);
+}
 
 esdm_scheduler_t *esdm_scheduler_init(esdm_instance_t *esdm) {
   ESDM_DEBUG(__func__);
 
   esdm_scheduler_t *scheduler = NULL;
   scheduler = ea_checked_malloc(sizeof(esdm_scheduler_t));
+  *scheduler = (esdm_scheduler_t){
+    .backendCount = esdm->modules->data_backend_count,
+    .backends = esdm->modules->data_backends
+  };
+  g_mutex_init(&scheduler->mutex);
+  g_cond_init(&scheduler->workAvailable);
+  atomic_init(&scheduler->pendingCpuTasks, 0);
+  esdmI_dataspace_setCopyParallelism(esdm->config->copyThreads, esdm->config->copyMinBytesPerThread);
 
-  // create thread pools per device
-  // decide how many threads should be used per backend.
+  // decide how many concurrent I/O operations should be allowed per backend.
   const int ppn = esdm->procs_per_node;
   const int gt = esdm->total_procs;
-  GError *error;
+  int64_t ioSlots = 0;
   for (int i = 0; i < esdm->modules->data_backend_count; i++) {
     esdm_backend_t *b = esdm->modules->data_backends[i];
     // in total we should not use more than max_global total threads
@@ -62,12 +387,27 @@ esdm_scheduler_t *esdm_scheduler_init(esdm_instance_t *esdm) {
     } else {
       b->threads = max_local;
     }
+    b->activeThreads = 0;
+    b->pendingHead = b->pendingTail = NULL;
+    ioSlots += b->threads;
     DEBUG("Using %d threads for backend %s", b->threads, b->config->id);
+  }
 
-    if (b->threads == 0) {
-      b->threadPool = NULL;
-    } else {
-      b->threadPool = g_thread_pool_new((GFunc)(backend_thread), b, b->threads, 1, &error);
+  // create the shared workers:
+  // enough workers to fill all I/O slots at once, plus our share of the node's cores to run the CPU stages while the others are blocked in I/O
+  if (ioSlots) {
+    int64_t cpuWorkers = g_get_num_processors() / (ppn > 0 ? ppn : 1);
+    if (cpuWorkers < 1) cpuWorkers = 1;
+    scheduler->workerCount = ioSlots + cpuWorkers;
+    DEBUG("Using %ld workers for %ld I/O slots", (long)scheduler->workerCount, (long)ioSlots);
+    scheduler->workers = ea_checked_calloc(scheduler->workerCount, sizeof(*scheduler->workers));
+    for (int64_t i = 0; i < scheduler->workerCount; i++) {
+      scheduler->workers[i].scheduler = scheduler;
+      scheduler->workers[i].index = i;
+      deque_init(&scheduler->workers[i].deque);
+    }
+    for (int64_t i = 0; i < scheduler->workerCount; i++) {
+      scheduler->workers[i].thread = g_thread_new("esdm-worker", worker_thread, &scheduler->workers[i]);
     }
   }
 
@@ -78,16 +418,22 @@ esdm_scheduler_t *esdm_scheduler_init(esdm_instance_t *esdm) {
 esdm_status esdm_scheduler_finalize(esdm_instance_t *esdm) {
   ESDM_DEBUG(__func__);
 
-  if(esdm->modules){
-    for (int i = 0; i < esdm->modules->data_backend_count; i++) {
-      esdm_backend_t *b = esdm->modules->data_backends[i];
-      if (b->threadPool) {
-        g_thread_pool_free(b->threadPool, 0, 1);
-      }
+  esdm_scheduler_t *scheduler = esdm->scheduler;
+  if (scheduler) {
+    g_mutex_lock(&scheduler->mutex);
+    scheduler->shutdown = true;
+    g_cond_broadcast(&scheduler->workAvailable);
+    g_mutex_unlock(&scheduler->mutex);
+    for (int64_t i = 0; i < scheduler->workerCount; i++) {
+      g_thread_join(scheduler->workers[i].thread);
     }
-  }
+    for (int64_t i = 0; i < scheduler->workerCount; i++) {
+      deque_destroy(&scheduler->workers[i].deque);
+    }
+    free(scheduler->workers);
+    g_mutex_clear(&scheduler->mutex);
+    g_cond_clear(&scheduler->workAvailable);
 
-  if (esdm->scheduler) {
     free(esdm->scheduler);
     esdm->scheduler = NULL;
   }
@@ -95,17 +441,14 @@ esdm_status esdm_scheduler_finalize(esdm_instance_t *esdm) {
   return ESDM_SUCCESS;
 }
 
-static double gOutputTime = 0, gInputTime = 0;
-
-static void backend_thread(io_work_t *work, esdm_backend_t *backend) {
-  io_request_status_t *status = work->parent;
+//The I/O bound part of a work item, only executed while holding one of the backend's slots.
+static void io_stage(io_work_t *work) {
+  esdm_backend_t *backend = work->fragment->backend;
 
   timer myTimer;
   ea_start_timer(&myTimer);
   DEBUG("Backend thread operates on %s via %s", backend->name, backend->config->target);
 
-  eassert(backend == work->fragment->backend);
-
   esdm_status ret;
   switch (work->op) {
     case (ESDM_OP_READ): {
@@ -116,43 +459,80 @@ static void backend_thread(io_work_t *work, esdm_backend_t *backend) {
       ret = esdm_fragment_commit(work->fragment);
       break;
     }
+    case (ESDM_OP_READ_REGION): {
+      ret = esdmI_backend_fragment_retrieve_region(backend, work->fragment, work->rangeCount, work->ranges);
+      break;
+    }
     default:
       ret = ESDM_ERROR;
   }
 
   work->return_code = ret;
+  work->ioTime = ea_stop_timer(myTimer);
+}
 
-  if (work->callback) {
-    work->callback(work);
-  }
+//The I/O stages of a list of work items of the same kind on the same backend, passed to the backend with a single call.
+static void io_stage_batch(io_work_t *works) {
+  esdm_backend_t *backend = works->fragment->backend;
+
+  timer myTimer;
+  ea_start_timer(&myTimer);
 
-  double localTime = ea_stop_timer(myTimer);
+  int64_t count = 0;
+  for(io_work_t *work = works; work; work = work->next) count++;
+  DEBUG("Backend thread operates on %ld fragments of %s via %s", (long)count, backend->name, backend->config->target);
+  esdm_fragment_t **fragments = ea_checked_malloc(count*sizeof(*fragments));
+  esdm_status *rets = ea_checked_malloc(count*sizeof(*rets));
+  int64_t i = 0;
+  for(io_work_t *work = works; work; work = work->next) fragments[i++] = work->fragment;
 
-  g_mutex_lock(&status->mutex);
-  // Please note the return value from atomic_fetch_sub() is the original
-  // value stored in atomic object. Here, it's the value before subtraction.
-  size_t pendings = atomic_fetch_sub(&status->pending_ops, 1);
-  if (ret != ESDM_SUCCESS){
-    status->return_code = ret;
+  switch (works->op) {
+    case (ESDM_OP_READ): {
+      esdmI_fragment_loadBatch(count, fragments, rets);
+      break;
+    }
+    case (ESDM_OP_WRITE): {
+      esdmI_fragment_commitBatch(count, fragments, rets);
+      break;
+    }
+    default:
+      for(i = 0; i < count; i++) rets[i] = ESDM_ERROR;
   }
-  eassert(pendings >= 1);
-  if (pendings == 1) {
-    g_cond_signal(&status->done_condition);
+
+  //the operations were in flight together, so each of them is accounted an equal share of the time
+  double ioTime = ea_stop_timer(myTimer)/count;
+  i = 0;
+  for(io_work_t *work = works; work; work = work->next) {
+    work->return_code = rets[i++];
+    work->ioTime = ioTime;
+  }
+  free(rets);
+  free(fragments);
+}
+
+//The CPU bound part of a work item (copying/converting the data into the user buffer, releasing buffers), followed by the completion signalling.
+static void cpu_stage(io_work_t *work) {
+  io_request_status_t *status = work->parent;
+
+  timer myTimer;
+  ea_start_timer(&myTimer);
+
+  if (work->callback) {
+    work->callback(work);
   }
 
+  double localTime = work->ioTime + ea_stop_timer(myTimer);
   switch (work->op) {
-    case (ESDM_OP_READ): gInputTime += localTime; break;
-    case (ESDM_OP_WRITE): gOutputTime += localTime; break;
+    case (ESDM_OP_READ):
+    case (ESDM_OP_READ_REGION): thread_stats()->inputTime += localTime; break;
+    case (ESDM_OP_WRITE): thread_stats()->outputTime += localTime; break;
   }
-  g_mutex_unlock(&status->mutex);
-  //esdm_dataspace_destroy(work->fragment->dataspace);
 
+  esdm_status ret = work->return_code;
   free(work);
+  status_complete_one(status, ret); //must be the last access to the request, the waiter may destroy it right away
 }
 
-double esdmI_backendOutputTime() { return gOutputTime; }
-double esdmI_backendInputTime() { return gInputTime; }
-void esdmI_resetBackendIoTimes() { gOutputTime = gInputTime = 0; }
 
 static int64_t min_int64(int64_t a, int64_t b) {
   return a < b ? a : b;
@@ -205,6 +585,7 @@ static void esdmI_dataspace_copy_instructions(
   eassert(out_sourceOffset);
   eassert(out_destOffset);
 
+  *out_instructionDims = -1;  //until we know that there's an overlap
   uint64_t dimensions = sourceSpace->dims;
   int64_t overlapOffset[dimensions];
   int64_t overlapSize[dimensions];
@@ -301,10 +682,546 @@ static void esdmI_dataspace_copy_instructions(
   *out_destOffset = (destIndex - dataPointerOffset)*destElementSize;
 }
 
-static esdm_copyTimes_t gCopyTimes = {0};
-esdm_copyTimes_t esdmI_performance_copy() { return gCopyTimes; }
+// Copy plans /////////////////////////////////////////////////////////////////
+//
+// A copy plan bundles the instructions of esdmI_dataspace_copy_instructions() with the converter and a kernel that executes them.
+// The kernel is selected when the plan is made: There are fixed depth loops for one to three instruction dimensions,
+// each in a variant that calls the converter, one that calls memcpy() directly, and some that move small chunks with a fixed size memcpy(),
+// which the compiler turns into plain loads and stores.
+// Everything else is handled by the generic odometer loop.
+//
+// Plans are cached per thread. The key consists of the converter, the element sizes, the sizes and strides of the two dataspaces, and of their offsets relative to each other,
+// so repeated copies between dataspaces of the same layout (timesteps, slices of a grid) skip the planning entirely.
+// The key does not contain the type objects themselves: a type may be destroyed and another one allocated at the same address,
+// while a plan only depends on the element sizes and on the converter, which is a static function.
 
-esdm_status esdm_dataspace_copy_data(esdm_dataspace_t* sourceSpace, void *voidPtrSource, esdm_dataspace_t* destSpace, void *voidPtrDest) {
+#define COPY_PLAN_CACHE_SIZE 32 //entries per thread, must be a power of two
+#define COPY_PLAN_MAX_DIMS 8  //copies with more dimensions are planned without the cache
+#define COPY_PLAN_KEY_SIZE(dims) (4 + 5*(dims))
+
+typedef struct copyPlan_t copyPlan_t;
+typedef void (*copyKernel_t)(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t outerSize);
+
+struct copyPlan_t {
+  ea_datatype_converter converter;
+  copyKernel_t kernel;
+  int64_t instructionDims, chunkSize, sourceOffset, destOffset;
+  int64_t sourceElementSize, destElementSize;
+  int64_t transposeSourceDim, transposeDestDim;  //only used by copy_transpose(), the instruction dimensions that are contiguous in the source/destination
+  int64_t* size; //these three arrays have `instructionDims` entries each, their storage is provided by the user of the plan
+  int64_t* relSourceStride;
+  int64_t* relDestStride;
+};
+
+typedef struct copyPlanCacheEntry_t {
+  int64_t keySize;  //0 == unused entry
+  int64_t key[COPY_PLAN_KEY_SIZE(COPY_PLAN_MAX_DIMS)];
+  copyPlan_t plan;  //the array pointers of the cached plan are not used
+  int64_t size[COPY_PLAN_MAX_DIMS], relSourceStride[COPY_PLAN_MAX_DIMS], relDestStride[COPY_PLAN_MAX_DIMS];
+} copyPlanCacheEntry_t;
+
+static GPrivate gCopyPlanCacheKey = G_PRIVATE_INIT(free);
+static __thread copyPlanCacheEntry_t *tCopyPlanCache = NULL;  //fast access path to the same object that is registered with gCopyPlanCacheKey
+
+typedef enum {
+  kCopyConvert,
+  kCopyMemcpy,
+  kCopy1,
+  kCopy2,
+  kCopy4,
+  kCopy8,
+  kCopy16,
+  kCopyOpCount
+} copyOp_t;
+
+//Always inlined with a constant `op`, so that each kernel only contains the code for its own way of moving a chunk.
+static inline __attribute__((always_inline)) void copy_chunk(copyOp_t op, const copyPlan_t* plan, char* destData, const char* sourceData) {
+  switch(op) {
+    case kCopyConvert: plan->converter(destData, sourceData, plan->chunkSize); break;
+    case kCopyMemcpy: memcpy(destData, sourceData, plan->chunkSize); break;
+    case kCopy1: memcpy(destData, sourceData, 1); break;
+    case kCopy2: memcpy(destData, sourceData, 2); break;
+    case kCopy4: memcpy(destData, sourceData, 4); break;
+    case kCopy8: memcpy(destData, sourceData, 8); break;
+    case kCopy16: memcpy(destData, sourceData, 16); break;
+    case kCopyOpCount: eassert(0);
+  }
+}
+
+//The loops add the relative strides in exactly the same way as the generic odometer loop below.
+#define defineCopyKernels(opName, op) \
+  static void copy_1d_##opName(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t outerSize) { \
+    const int64_t sourceStride0 = plan->relSourceStride[0], destStride0 = plan->relDestStride[0]; \
+    for(int64_t i = 0; i < outerSize; i++, sourceData += sourceStride0, destData += destStride0) { \
+      copy_chunk(op, plan, destData, sourceData); \
+    } \
+  } \
+  static void copy_2d_##opName(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t outerSize) { \
+    const int64_t size1 = plan->size[1]; \
+    const int64_t sourceStride0 = plan->relSourceStride[0], destStride0 = plan->relDestStride[0]; \
+    const int64_t sourceStride1 = plan->relSourceStride[1], destStride1 = plan->relDestStride[1]; \
+    for(int64_t i = 0; i < outerSize; i++, sourceData += sourceStride0, destData += destStride0) { \
+      for(int64_t j = 0; j < size1; j++, sourceData += sourceStride1, destData += destStride1) { \
+        copy_chunk(op, plan, destData, sourceData); \
+      } \
+    } \
+  } \
+  static void copy_3d_##opName(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t outerSize) { \
+    const int64_t size1 = plan->size[1], size2 = plan->size[2]; \
+    const int64_t sourceStride0 = plan->relSourceStride[0], destStride0 = plan->relDestStride[0]; \
+    const int64_t sourceStride1 = plan->relSourceStride[1], destStride1 = plan->relDestStride[1]; \
+    const int64_t sourceStride2 = plan->relSourceStride[2], destStride2 = plan->relDestStride[2]; \
+    for(int64_t i = 0; i < outerSize; i++, sourceData += sourceStride0, destData += destStride0) { \
+      for(int64_t j = 0; j < size1; j++, sourceData += sourceStride1, destData += destStride1) { \
+        for(int64_t k = 0; k < size2; k++, sourceData += sourceStride2, destData += destStride2) { \
+          copy_chunk(op, plan, destData, sourceData); \
+        } \
+      } \
+    } \
+  }
+
+defineCopyKernels(convert, kCopyConvert)
+defineCopyKernels(memcpy, kCopyMemcpy)
+defineCopyKernels(1, kCopy1)
+defineCopyKernels(2, kCopy2)
+defineCopyKernels(4, kCopy4)
+defineCopyKernels(8, kCopy8)
+defineCopyKernels(16, kCopy16)
+
+//The generic kernel for any number of instruction dimensions, including zero.
+static void copy_nd(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t outerSize) {
+  const int64_t instructionDims = plan->instructionDims;
+  int64_t counters[instructionDims > 0 ? instructionDims : 1];
+  memset(counters, 0, sizeof(counters));
+  while(true) {
+    plan->converter(destData, sourceData, plan->chunkSize);
+
+    int64_t i;
+    for(i = instructionDims; i--; ) {
+      sourceData += plan->relSourceStride[i];
+      destData += plan->relDestStride[i];
+      if(++(counters[i]) < (i ? plan->size[i] : outerSize)) break;
+      counters[i] = 0;
+    }
+    if(i == -1) break;
+  }
+}
+
+// Transposing copies
+//
+// When the two dataspaces have their contiguous dimensions in different places (e.g. C order vs. FORTRAN order),
+// the instructions degrade to copying single elements, and either the reads or the writes jump through memory with a large stride.
+// The transpose kernel works on square blocks of the plane spanned by the source's contiguous dimension (p) and the destination's contiguous dimension (q) instead:
+// The rows of a source block are converted into a small buffer with one converter call each, and the buffer is then written to the destination row by row,
+// so both sides are accessed in contiguous runs, and a block fits into the L1 cache.
+// The destination's contiguous dimension may run backwards. If p == q, the copy is a reversal along that dimension, which is handled in the same way.
+
+#define COPY_TRANSPOSE_BLOCK 16 //edge length of the blocks in elements
+#define COPY_TRANSPOSE_MIN_SIZE 4 //smaller extends in p or q are not worth the blocking
+
+#define defineTransposeBlock(type) \
+  static void copy_transpose_block_##type(char* destRow, int64_t destStrideP, int64_t destStrideQ, const char* buffer, int64_t countP, int64_t countQ) { \
+    for(int64_t i = 0; i < countP; i++, destRow += destStrideP) { \
+      type row[COPY_TRANSPOSE_BLOCK]; \
+      for(int64_t j = 0; j < countQ; j++) { \
+        int64_t rowIndex = destStrideQ > 0 ? j : countQ - 1 - j; \
+        memcpy(&row[rowIndex], buffer + (j*COPY_TRANSPOSE_BLOCK + i)*sizeof(type), sizeof(type)); \
+      } \
+      memcpy(destStrideQ > 0 ? destRow : destRow + (countQ - 1)*destStrideQ, row, countQ*sizeof(type)); \
+    } \
+  }
+
+defineTransposeBlock(uint8_t)
+defineTransposeBlock(uint16_t)
+defineTransposeBlock(uint32_t)
+defineTransposeBlock(uint64_t)
+
+//Copy a 2D plane, element (i, j) lives at `sourceData + i*sourceElementSize + j*sourceStrideQ` and `destData + i*destStrideP + j*destStrideQ`.
+static void copy_transpose_2d(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t sizeP, int64_t sizeQ, int64_t sourceStrideQ, int64_t destStrideP, int64_t destStrideQ) {
+  const int64_t sourceElementSize = plan->sourceElementSize;
+  uint64_t buffer[COPY_TRANSPOSE_BLOCK*COPY_TRANSPOSE_BLOCK];  //element (i, j) of a block is at index j*COPY_TRANSPOSE_BLOCK + i, only the first bytes of the buffer are used for smaller types
+
+  for(int64_t blockQ = 0; blockQ < sizeQ; blockQ += COPY_TRANSPOSE_BLOCK) {
+    int64_t countQ = min_int64(COPY_TRANSPOSE_BLOCK, sizeQ - blockQ);
+    for(int64_t blockP = 0; blockP < sizeP; blockP += COPY_TRANSPOSE_BLOCK) {
+      int64_t countP = min_int64(COPY_TRANSPOSE_BLOCK, sizeP - blockP);
+
+      //convert the rows of the source block, which are contiguous, into the buffer
+      const char* sourceRow = sourceData + blockP*sourceElementSize + blockQ*sourceStrideQ;
+      for(int64_t j = 0; j < countQ; j++, sourceRow += sourceStrideQ) {
+        plan->converter((char*)buffer + j*COPY_TRANSPOSE_BLOCK*plan->destElementSize, sourceRow, countP*sourceElementSize);
+      }
+
+      //write the block out in rows that are contiguous in the destination
+      char* destRow = destData + blockP*destStrideP + blockQ*destStrideQ;
+      switch(plan->destElementSize) {
+        case 1: copy_transpose_block_uint8_t(destRow, destStrideP, destStrideQ, (char*)buffer, countP, countQ); break;
+        case 2: copy_transpose_block_uint16_t(destRow, destStrideP, destStrideQ, (char*)buffer, countP, countQ); break;
+        case 4: copy_transpose_block_uint32_t(destRow, destStrideP, destStrideQ, (char*)buffer, countP, countQ); break;
+        case 8: copy_transpose_block_uint64_t(destRow, destStrideP, destStrideQ, (char*)buffer, countP, countQ); break;
+        default: eassert(0 && "copy_select_kernel() must not select the transpose kernel for this element size");
+      }
+    }
+  }
+}
+
+//Copy a reversed row, element i lives at `sourceData + i*sourceElementSize` and `destData + i*destStride` with a negative destStride.
+static void copy_reverse_1d(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t size, int64_t destStride) {
+  const int64_t sourceElementSize = plan->sourceElementSize, destElementSize = plan->destElementSize;
+  uint64_t buffer[COPY_TRANSPOSE_BLOCK*COPY_TRANSPOSE_BLOCK];
+  const int64_t blockSize = sizeof(buffer)/destElementSize;
+
+  for(int64_t block = 0; block < size; block += blockSize) {
+    int64_t count = min_int64(blockSize, size - block);
+    plan->converter(buffer, sourceData + block*sourceElementSize, count*sourceElementSize);
+    const char* bufferData = (const char*)buffer;
+    char* destElement = destData + block*destStride;
+    for(int64_t i = 0; i < count; i++, destElement += destStride) memcpy(destElement, bufferData + i*destElementSize, destElementSize);
+  }
+}
+
+static void copy_transpose(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t outerSize) {
+  const int64_t dims = plan->instructionDims, p = plan->transposeSourceDim, q = plan->transposeDestDim;
+
+  //convert the relative strides into absolute ones
+  int64_t size[dims], sourceStride[dims], destStride[dims];
+  memcpy(size, plan->size, sizeof(size));
+  size[0] = outerSize;
+  sourceStride[dims - 1] = plan->relSourceStride[dims - 1];
+  destStride[dims - 1] = plan->relDestStride[dims - 1];
+  for(int64_t i = dims - 1; i--; ) {
+    sourceStride[i] = plan->relSourceStride[i] + size[i + 1]*sourceStride[i + 1];
+    destStride[i] = plan->relDestStride[i] + size[i + 1]*destStride[i + 1];
+  }
+
+  //iterate over all the other dimensions, and copy one plane/row for each combination of their indices
+  int64_t counters[dims];
+  memset(counters, 0, sizeof(counters));
+  while(true) {
+    int64_t sourceOffset = 0, destOffset = 0;
+    for(int64_t i = 0; i < dims; i++) {
+      sourceOffset += counters[i]*sourceStride[i];
+      destOffset += counters[i]*destStride[i];
+    }
+    if(p == q) {
+      copy_reverse_1d(plan, destData + destOffset, sourceData + sourceOffset, size[p], destStride[p]);
+    } else {
+      copy_transpose_2d(plan, destData + destOffset, sourceData + sourceOffset, size[p], size[q], sourceStride[q], destStride[p], destStride[q]);
+    }
+
+    int64_t i;
+    for(i = dims; i--; ) {
+      if(i == p || i == q) continue;
+      if(++(counters[i]) < size[i]) break;
+      counters[i] = 0;
+    }
+    if(i == -1) break;
+  }
+}
+
+//Check whether the plan describes a transposition or reversal that copy_transpose() can handle, and set the transpose dimensions of the plan accordingly.
+static bool copy_detect_transpose(copyPlan_t* plan) {
+  const int64_t dims = plan->instructionDims;
+  if(dims < 1 || plan->chunkSize != plan->sourceElementSize) return false;  //transposing is only needed when the copy degraded to single elements
+  switch(plan->destElementSize) {
+    case 1: case 2: case 4: case 8: break;
+    default: return false;
+  }
+
+  int64_t sourceStride = plan->relSourceStride[dims - 1], destStride = plan->relDestStride[dims - 1], destStrideQ = 0;
+  plan->transposeSourceDim = plan->transposeDestDim = -1;
+  for(int64_t i = dims; i--; ) {
+    if(i < dims - 1) {
+      sourceStride = plan->relSourceStride[i] + plan->size[i + 1]*sourceStride;
+      destStride = plan->relDestStride[i] + plan->size[i + 1]*destStride;
+    }
+    if(plan->size[i] < 2) continue;  //the stride of a dimension with a single slice is meaningless
+    if(sourceStride == plan->sourceElementSize) plan->transposeSourceDim = i;
+    if(destStride == plan->destElementSize || destStride == -plan->destElementSize) plan->transposeDestDim = i, destStrideQ = destStride;
+  }
+  int64_t p = plan->transposeSourceDim, q = plan->transposeDestDim;
+  if(p < 0 || q < 0) return false;
+  if(p == q) return destStrideQ < 0 && plan->size[p] >= COPY_TRANSPOSE_MIN_SIZE;  //a reversal, forward copies of the same dimension would have been fused into the chunk
+  return plan->size[p] >= COPY_TRANSPOSE_MIN_SIZE && plan->size[q] >= COPY_TRANSPOSE_MIN_SIZE;
+}
+
+static copyKernel_t copy_select_kernel(copyPlan_t* plan) {
+  static const copyKernel_t kernels[3][kCopyOpCount] = {
+    { copy_1d_convert, copy_1d_memcpy, copy_1d_1, copy_1d_2, copy_1d_4, copy_1d_8, copy_1d_16 },
+    { copy_2d_convert, copy_2d_memcpy, copy_2d_1, copy_2d_2, copy_2d_4, copy_2d_8, copy_2d_16 },
+    { copy_3d_convert, copy_3d_memcpy, copy_3d_1, copy_3d_2, copy_3d_4, copy_3d_8, copy_3d_16 }
+  };
+  if(copy_detect_transpose(plan)) return copy_transpose;
+  if(plan->instructionDims < 1 || plan->instructionDims > 3) return copy_nd;
+
+  copyOp_t op = kCopyConvert;
+  if(plan->converter == memcpy) {
+    switch(plan->chunkSize) {
+      case 1: op = kCopy1; break;
+      case 2: op = kCopy2; break;
+      case 4: op = kCopy4; break;
+      case 8: op = kCopy8; break;
+      case 16: op = kCopy16; break;
+      default: op = kCopyMemcpy;
+    }
+  }
+  return kernels[plan->instructionDims - 1][op];
+}
+
+static copyPlanCacheEntry_t* copy_plan_cache() {
+  if(!tCopyPlanCache) {
+    tCopyPlanCache = ea_checked_calloc(COPY_PLAN_CACHE_SIZE, sizeof(*tCopyPlanCache));
+    g_private_set(&gCopyPlanCacheKey, tCopyPlanCache);
+  }
+  return tCopyPlanCache;
+}
+
+//Fill in the plan to copy from sourceSpace to destSpace.
+//The `size`, `relSourceStride`, and `relDestStride` members of `out_plan` must point to arrays with at least `sourceSpace->dims` entries.
+static void copy_plan_make(esdm_dataspace_t* sourceSpace, esdm_dataspace_t* destSpace, ea_datatype_converter converter, copyPlan_t* out_plan) {
+  eassert(sourceSpace->dims == destSpace->dims);
+  int64_t dimensions = sourceSpace->dims;
+
+  //build the key and look it up in the cache
+  copyPlanCacheEntry_t* entry = NULL;
+  int64_t key[COPY_PLAN_KEY_SIZE(COPY_PLAN_MAX_DIMS)], keySize = COPY_PLAN_KEY_SIZE(dimensions);
+  if(dimensions <= COPY_PLAN_MAX_DIMS) {
+    int64_t sourceStride[COPY_PLAN_MAX_DIMS], destStride[COPY_PLAN_MAX_DIMS];
+    esdm_dataspace_getEffectiveStride(sourceSpace, sourceStride);
+    esdm_dataspace_getEffectiveStride(destSpace, destStride);
+    key[0] = dimensions;
+    key[1] = (int64_t)(intptr_t)converter;
+    key[2] = esdm_sizeof(sourceSpace->type);
+    key[3] = esdm_sizeof(destSpace->type);
+    for(int64_t i = 0; i < dimensions; i++) {
+      int64_t* dimKey = &key[4 + 5*i];
+      dimKey[0] = sourceSpace->size[i];
+      dimKey[1] = destSpace->size[i];
+      dimKey[2] = destSpace->offset[i] - sourceSpace->offset[i];
+      dimKey[3] = sourceStride[i];
+      dimKey[4] = destStride[i];
+    }
+
+    uint64_t hash = 14695981039346656037u;  //FNV-1a over the words of the key
+    for(int64_t i = 0; i < keySize; i++) hash = (hash ^ (uint64_t)key[i])*1099511628211u;
+    entry = &copy_plan_cache()[(hash ^ hash >> 32) & (COPY_PLAN_CACHE_SIZE - 1)];
+
+    if(entry->keySize == keySize && !memcmp(entry->key, key, keySize*sizeof(*key))) {
+      //cache hit
+      int64_t instructionDims = entry->plan.instructionDims;
+      int64_t *size = out_plan->size, *relSourceStride = out_plan->relSourceStride, *relDestStride = out_plan->relDestStride;
+      *out_plan = entry->plan;
+      out_plan->size = size;
+      out_plan->relSourceStride = relSourceStride;
+      out_plan->relDestStride = relDestStride;
+      if(instructionDims > 0) {
+        memcpy(size, entry->size, instructionDims*sizeof(*size));
+        memcpy(relSourceStride, entry->relSourceStride, instructionDims*sizeof(*relSourceStride));
+        memcpy(relDestStride, entry->relDestStride, instructionDims*sizeof(*relDestStride));
+      }
+      return;
+    }
+  }
+
+  //cache miss, make a new plan
+  out_plan->converter = converter;
+  out_plan->sourceElementSize = esdm_sizeof(sourceSpace->type);
+  out_plan->destElementSize = esdm_sizeof(destSpace->type);
+  esdmI_dataspace_copy_instructions(sourceSpace, destSpace, &out_plan->instructionDims, &out_plan->chunkSize, &out_plan->sourceOffset, &out_plan->destOffset, out_plan->size, out_plan->relSourceStride, out_plan->relDestStride);
+  out_plan->kernel = copy_select_kernel(out_plan);
+
+  if(entry) {
+    entry->keySize = keySize;
+    memcpy(entry->key, key, keySize*sizeof(*key));
+    entry->plan = *out_plan;
+    entry->plan.size = entry->plan.relSourceStride = entry->plan.relDestStride = NULL;
+    if(out_plan->instructionDims > 0) {
+      memcpy(entry->size, out_plan->size, out_plan->instructionDims*sizeof(*entry->size));
+      memcpy(entry->relSourceStride, out_plan->relSourceStride, out_plan->instructionDims*sizeof(*entry->relSourceStride));
+      memcpy(entry->relDestStride, out_plan->relDestStride, out_plan->instructionDims*sizeof(*entry->relDestStride));
+    }
+  }
+}
+
+//Execute the plan, `outerSize` replaces `plan->size[0]`, so that only a part of the plan can be executed.
+static void copy_execute(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t outerSize) {
+  plan->kernel(plan, destData, sourceData, outerSize);
+}
+
+// Parallel copying ///////////////////////////////////////////////////////////
+//
+// Large copies are split into tiles along the outermost instruction dimension (or along the elements of the single chunk if there is no instruction dimension).
+// The tiles are claimed with an atomic counter by the calling thread and by helpers from a process wide thread pool.
+// The caller always works on the tiles itself, so a copy never depends on the availability of helpers,
+// and helpers that start late simply find no work left. The job object is reference counted for that reason.
+
+static int64_t gCopyThreads = ESDMI_COPY_THREADS_DEFAULT;  //0 == use all cores
+static int64_t gCopyMinBytesPerThread = ESDMI_COPY_MIN_BYTES_PER_THREAD_DEFAULT;
+static GMutex gCopyPoolMutex;
+static GThreadPool* gCopyPool = NULL;
+static int64_t gCopyPoolThreads = 0;
+
+typedef struct copyJob_t copyJob_t;
+struct copyJob_t {
+  atomic_int refCount;
+  atomic_llong nextTile;
+  atomic_llong finishedTiles;
+  GMutex mutex; //for the done condition
+  GCond done;
+
+  copyPlan_t plan;  //the arrays of the plan point into the `data` member
+  const char* sourceData;
+  char* destData;
+  int64_t tileCount, tileSize;  //tileSize is in slices of the outermost instruction dimension, or in elements if there are no instruction dimensions
+  int64_t sourceElementSize, destElementSize;
+  int64_t outerSourceStride, outerDestStride;  //absolute strides of the outermost instruction dimension
+  int64_t data[];
+};
+
+static void copyJob_release(copyJob_t* job) {
+  if(atomic_fetch_sub(&job->refCount, 1) == 1) {
+    g_mutex_clear(&job->mutex);
+    g_cond_clear(&job->done);
+    free(job);
+  }
+}
+
+static void copyJob_work(copyJob_t* job) {
+  int64_t tile;
+  while((tile = atomic_fetch_add(&job->nextTile, 1)) < job->tileCount) {
+    int64_t start = tile*job->tileSize;
+    int64_t count = job->tileSize;
+    if(job->plan.instructionDims > 0) {
+      if(start + count > job->plan.size[0]) count = job->plan.size[0] - start;
+      copy_execute(&job->plan, job->destData + start*job->outerDestStride, job->sourceData + start*job->outerSourceStride, count);
+    } else {
+      int64_t elements = job->plan.chunkSize/job->sourceElementSize;
+      if(start + count > elements) count = elements - start;
+      job->plan.converter(job->destData + start*job->destElementSize, job->sourceData + start*job->sourceElementSize, count*job->sourceElementSize);
+    }
+    if(atomic_fetch_add(&job->finishedTiles, 1) + 1 == job->tileCount) {
+      g_mutex_lock(&job->mutex);
+      g_cond_signal(&job->done);
+      g_mutex_unlock(&job->mutex);
+    }
+  }
+}
+
+static void copy_helper(gpointer data, gpointer user_data) {
+  copyJob_t* job = data;
+  copyJob_work(job);
+  copyJob_release(job);
+}
+
+void esdmI_dataspace_setCopyParallelism(int64_t threadCount, int64_t minBytesPerThread) {
+  eassert(threadCount >= 0);
+  eassert(minBytesPerThread >= 0);
+  g_mutex_lock(&gCopyPoolMutex);
+  gCopyThreads = threadCount;
+  gCopyMinBytesPerThread = minBytesPerThread;
+  g_mutex_unlock(&gCopyPoolMutex);
+}
+
+//Returns the pool of helper threads (or NULL if parallel copying is disabled), and the number of threads that may work on a single copy, including the caller.
+static GThreadPool* copy_pool(int64_t* out_threads, int64_t* out_minBytesPerThread) {
+  g_mutex_lock(&gCopyPoolMutex);
+  int64_t threads = gCopyThreads ? gCopyThreads : g_get_num_processors();
+  *out_minBytesPerThread = gCopyMinBytesPerThread;
+  if(threads > 1 && gCopyPoolThreads != threads - 1) {
+    //The pool is never destroyed, other threads may still be pushing to it, so we only resize it.
+    GError* error = NULL;
+    if(gCopyPool) {
+      g_thread_pool_set_max_threads(gCopyPool, threads - 1, &error);
+    } else {
+      gCopyPool = g_thread_pool_new(copy_helper, NULL, threads - 1, FALSE, &error);
+    }
+    if(error) {
+      ESDM_WARN("cannot setup the thread pool for parallel copying, falling back to serial copying");
+      g_error_free(error);
+    }
+    if(!gCopyPool) threads = 1;
+    gCopyPoolThreads = threads - 1;
+  }
+  *out_threads = threads;
+  GThreadPool* result = threads > 1 ? gCopyPool : NULL;
+  g_mutex_unlock(&gCopyPoolMutex);
+  return result;
+}
+
+//Try to execute the copy in parallel, returns false if the copy is too small or parallel copying is disabled, the caller must perform the copy itself in that case.
+static bool copy_parallel(const copyPlan_t* plan, char* destData, const char* sourceData, int64_t sourceElementSize, int64_t destElementSize) {
+  //determine the amount of work and the number of tiles we can split it into
+  int64_t instructionDims = plan->instructionDims, chunkSize = plan->chunkSize;
+  const int64_t *size = plan->size, *relSourceStride = plan->relSourceStride, *relDestStride = plan->relDestStride;
+  int64_t slices = instructionDims > 0 ? size[0] : chunkSize/sourceElementSize;
+  int64_t totalBytes = chunkSize;
+  for(int64_t i = 0; i < instructionDims; i++) totalBytes *= size[i];
+  if(slices < 2) return false;
+
+  int64_t threads, minBytesPerThread;
+  GThreadPool* pool = copy_pool(&threads, &minBytesPerThread);
+  if(!pool) return false;
+  if(minBytesPerThread && threads > totalBytes/minBytesPerThread) threads = totalBytes/minBytesPerThread;
+  if(threads > slices) threads = slices;
+  if(threads < 2) return false;
+
+  //Use a few tiles per thread to balance the load when the helpers start at different times.
+  int64_t tileCount = 4*threads;
+  if(tileCount > slices) tileCount = slices;
+  int64_t tileSize = (slices + tileCount - 1)/tileCount;
+  tileCount = (slices + tileSize - 1)/tileSize;
+
+  int64_t arrayEntries = instructionDims > 0 ? instructionDims : 0;
+  copyJob_t* job = ea_checked_malloc(sizeof(*job) + 3*arrayEntries*sizeof(int64_t));
+  *job = (copyJob_t){
+    .plan = *plan,
+    .sourceData = sourceData,
+    .destData = destData,
+    .tileCount = tileCount,
+    .tileSize = tileSize,
+    .sourceElementSize = sourceElementSize,
+    .destElementSize = destElementSize
+  };
+  job->plan.size = job->data;
+  job->plan.relSourceStride = job->data + arrayEntries;
+  job->plan.relDestStride = job->data + 2*arrayEntries;
+  atomic_init(&job->refCount, 1);
+  atomic_init(&job->nextTile, 0);
+  atomic_init(&job->finishedTiles, 0);
+  g_mutex_init(&job->mutex);
+  g_cond_init(&job->done);
+  if(arrayEntries) {
+    memcpy(job->plan.size, size, arrayEntries*sizeof(int64_t));
+    memcpy(job->plan.relSourceStride, relSourceStride, arrayEntries*sizeof(int64_t));
+    memcpy(job->plan.relDestStride, relDestStride, arrayEntries*sizeof(int64_t));
+
+    //convert the relative strides back into absolute strides to be able to jump to the start of any tile
+    int64_t sourceStride = relSourceStride[instructionDims - 1], destStride = relDestStride[instructionDims - 1];
+    for(int64_t i = instructionDims - 1; i--; ) {
+      sourceStride = relSourceStride[i] + size[i + 1]*sourceStride;
+      destStride = relDestStride[i] + size[i + 1]*destStride;
+    }
+    job->outerSourceStride = sourceStride;
+    job->outerDestStride = destStride;
+  }
+
+  //recruit the helpers, then join the work ourselves
+  for(int64_t i = 1; i < threads; i++) {
+    atomic_fetch_add(&job->refCount, 1);
+    g_thread_pool_push(pool, job, NULL);
+  }
+  copyJob_work(job);
+
+  //wait for the tiles that the helpers are still working on
+  g_mutex_lock(&job->mutex);
+  while(atomic_load(&job->finishedTiles) < job->tileCount) g_cond_wait(&job->done, &job->mutex);
+  g_mutex_unlock(&job->mutex);
+
+  copyJob_release(job);
+  return true;
+}
+
+static esdm_status dataspace_copy_data(esdm_dataspace_t* sourceSpace, void *voidPtrSource, esdm_dataspace_t* destSpace, void *voidPtrDest, bool saturating) {
   eassert(sourceSpace->dims == destSpace->dims);
 
   timer myTimer;
@@ -313,28 +1230,83 @@ esdm_status esdm_dataspace_copy_data(esdm_dataspace_t* sourceSpace, void *voidPt
   char* sourceData = voidPtrSource;
   char* destData = voidPtrDest;
   uint64_t dimensions = sourceSpace->dims;
-  ea_datatype_converter converter = ea_converter_for_types(destSpace->type, sourceSpace->type);
+  ea_datatype_converter converter = saturating ? ea_saturating_converter_for_types(destSpace->type, sourceSpace->type) : ea_converter_for_types(destSpace->type, sourceSpace->type);
   if(!converter) {
     ESDM_WARN("unable to convert the given datatypes");
     return ESDM_ERROR;
   }
 
-  //get the instructions on how to copy the data
-  int64_t instructionDims, chunkSize, sourceOffset, destOffset, size[dimensions], relSourceStride[dimensions], relDestStride[dimensions];
-  esdmI_dataspace_copy_instructions(sourceSpace, destSpace, &instructionDims, &chunkSize, &sourceOffset, &destOffset, size, relSourceStride, relDestStride);
+  //get the plan on how to copy the data
+  int64_t size[dimensions], relSourceStride[dimensions], relDestStride[dimensions];
+  copyPlan_t plan = {
+    .size = size,
+    .relSourceStride = relSourceStride,
+    .relDestStride = relDestStride
+  };
+  copy_plan_make(sourceSpace, destSpace, converter, &plan);
 
   double workStartTime = ea_stop_timer(myTimer);
-  gCopyTimes.planning += workStartTime;
-  gCopyTimes.total += workStartTime;
+  esdm_copyTimes_t* copyTimes = &thread_stats()->copy;
+  copyTimes->planning += workStartTime;
+  copyTimes->total += workStartTime;
 
   //execute the instructions
-  if(instructionDims < 0) return ESDM_SUCCESS;  //nothing to do
-  sourceData += sourceOffset;
-  destData += destOffset;
-  int64_t counters[instructionDims];
+  if(plan.instructionDims < 0) return ESDM_SUCCESS;  //nothing to do
+  sourceData += plan.sourceOffset;
+  destData += plan.destOffset;
+  if(!copy_parallel(&plan, destData, sourceData, esdm_sizeof(sourceSpace->type), esdm_sizeof(destSpace->type))) {
+    copy_execute(&plan, destData, sourceData, plan.instructionDims > 0 ? plan.size[0] : 1);
+  }
+
+  double workEndTime = ea_stop_timer(myTimer);
+  copyTimes->execution += workEndTime - workStartTime;
+  copyTimes->total += workEndTime - workStartTime;
+
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdm_dataspace_copy_data(esdm_dataspace_t* sourceSpace, void *voidPtrSource, esdm_dataspace_t* destSpace, void *voidPtrDest) {
+  return dataspace_copy_data(sourceSpace, voidPtrSource, destSpace, voidPtrDest, false);
+}
+
+esdm_status esdmI_dataspace_copyDataSaturating(esdm_dataspace_t* sourceSpace, void *voidPtrSource, esdm_dataspace_t* destSpace, void *voidPtrDest) {
+  return dataspace_copy_data(sourceSpace, voidPtrSource, destSpace, voidPtrDest, true);
+}
+
+esdm_status esdmI_dataspace_makeIovecs(esdm_dataspace_t* space, void* buf, int64_t minChunkBytes, struct iovec** out_iov, int64_t* out_count) {
+  eassert(space);
+  eassert(out_iov);
+  eassert(out_count);
+  *out_iov = NULL;
+  *out_count = 0;
+
+  //the instructions for copying the serialized data into `buf` visit the chunks of `buf`
+  esdm_dataspace_t* contiguousSpace;
+  esdm_status ret = esdm_dataspace_makeContiguous(space, &contiguousSpace);
+  if(ret != ESDM_SUCCESS) return ret;
+  int64_t dimensions = space->dims;
+  int64_t instructionDims, chunkSize, sourceOffset, destOffset;
+  int64_t size[dimensions], relSourceStride[dimensions], relDestStride[dimensions];
+  esdmI_dataspace_copy_instructions(contiguousSpace, space, &instructionDims, &chunkSize, &sourceOffset, &destOffset, size, relSourceStride, relDestStride);
+  esdm_dataspace_destroy(contiguousSpace);
+  if(instructionDims < 0) return ESDM_SUCCESS;  //empty dataspace
+  if(chunkSize < minChunkBytes) return ESDM_ERROR;
+
+  int64_t count = 1;
+  for(int64_t i = 0; i < instructionDims; i++) count *= size[i];
+  struct iovec* iov = ea_checked_malloc(count*sizeof(*iov));
+
+  //walk the chunks like copy_nd() does, the serialized offsets must increase by one chunk at a time, otherwise the chunks are not visited in the order of the serialization
+  int64_t counters[instructionDims > 0 ? instructionDims : 1];
   memset(counters, 0, sizeof(counters));
-  while(true) {
-    converter(destData, sourceData, chunkSize);
+  int64_t sourceData = sourceOffset;
+  char* destData = (char*)buf + destOffset;
+  for(int64_t n = 0; ; n++) {
+    if(sourceData != n*chunkSize) {
+      free(iov);
+      return ESDM_ERROR;
+    }
+    iov[n] = (struct iovec){ .iov_base = destData, .iov_len = chunkSize };
 
     int64_t i;
     for(i = instructionDims; i--; ) {
@@ -346,10 +1318,55 @@ esdm_status esdm_dataspace_copy_data(esdm_dataspace_t* sourceSpace, void *voidPt
     if(i == -1) break;
   }
 
-  double workEndTime = ea_stop_timer(myTimer);
-  gCopyTimes.execution += workEndTime - workStartTime;
-  gCopyTimes.total += workEndTime - workStartTime;
+  *out_iov = iov;
+  *out_count = count;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdmI_dataspace_makeByteRanges(esdm_dataspace_t* fragmentSpace, esdm_dataspace_t* memspace, void* buf, esdmI_byteRange_t** out_ranges, int64_t* out_count) {
+  eassert(fragmentSpace);
+  eassert(memspace);
+  eassert(out_ranges);
+  eassert(out_count);
+  *out_ranges = NULL;
+  *out_count = 0;
+  if(fragmentSpace->type != memspace->type) return ESDM_ERROR;  //the ranges are copied verbatim, there's no room for a conversion
+
+  //the instructions for copying the serialized fragment data into `buf` visit exactly the needed chunks of the fragment
+  esdm_dataspace_t* contiguousSpace;
+  esdm_status ret = esdm_dataspace_makeContiguous(fragmentSpace, &contiguousSpace);
+  if(ret != ESDM_SUCCESS) return ret;
+  int64_t dimensions = fragmentSpace->dims;
+  int64_t instructionDims, chunkSize, sourceOffset, destOffset;
+  int64_t size[dimensions], relSourceStride[dimensions], relDestStride[dimensions];
+  esdmI_dataspace_copy_instructions(contiguousSpace, memspace, &instructionDims, &chunkSize, &sourceOffset, &destOffset, size, relSourceStride, relDestStride);
+  esdm_dataspace_destroy(contiguousSpace);
+  if(instructionDims < 0) return ESDM_SUCCESS;  //no overlap
+
+  int64_t count = 1;
+  for(int64_t i = 0; i < instructionDims; i++) count *= size[i];
+  esdmI_byteRange_t* ranges = ea_checked_malloc(count*sizeof(*ranges));
+
+  //walk the chunks like copy_nd() does
+  int64_t counters[instructionDims > 0 ? instructionDims : 1];
+  memset(counters, 0, sizeof(counters));
+  int64_t sourceData = sourceOffset;
+  char* destData = (char*)buf + destOffset;
+  for(int64_t n = 0; ; n++) {
+    ranges[n] = (esdmI_byteRange_t){ .offset = sourceData, .size = chunkSize, .dest = destData };
+
+    int64_t i;
+    for(i = instructionDims; i--; ) {
+      sourceData += relSourceStride[i];
+      destData += relDestStride[i];
+      if(++(counters[i]) < size[i]) break;
+      counters[i] = 0;
+    }
+    if(i == -1) break;
+  }
 
+  *out_ranges = ranges;
+  *out_count = count;
   return ESDM_SUCCESS;
 }
 
@@ -358,7 +1375,7 @@ static void read_copy_callback(io_work_t *work) {
     DEBUG("Error reading from fragment ", work->fragment);
     return;
   }
-  esdm_dataspace_copy_data(work->fragment->dataspace, work->fragment->buf, work->data.buf_space, work->data.mem_buf);
+  esdmI_dataspace_copyDataSaturating(work->fragment->dataspace, work->fragment->buf, work->data.buf_space, work->data.mem_buf);
 }
 
 static void buffer_cleanup_callback(io_work_t *work) {
@@ -369,6 +1386,35 @@ static void buffer_cleanup_callback(io_work_t *work) {
   work->return_code = esdm_fragment_unload(work->fragment); //get rid of the reference to user supplied data to avoid UB
 }
 
+static void region_cleanup_callback(io_work_t *work) {
+  if (work->return_code != ESDM_SUCCESS) {
+    DEBUG("Error reading from fragment ", work->fragment);
+  }
+  free(work->ranges);
+  work->ranges = NULL;
+}
+
+//Determine whether reading only the overlap of the fragment with `buf` is much cheaper than reading the whole fragment,
+//and return the byte ranges to read if so.
+static bool scheduler_try_region_read(esdm_fragment_t *f, void *buf, esdm_dataspace_t *da, esdmI_byteRange_t **out_ranges, int64_t *out_count) {
+  if(!f->backend->callbacks.fragment_retrieve_region) return false;
+  if(f->buf || f->status != ESDM_DATA_NOT_LOADED) return false; //the data is in memory already
+  if(f->actual_bytes != -1 || f->dataset->chints) return false; //the stored data is not a plain serialization of the dataspace
+
+  esdmI_byteRange_t *ranges;
+  int64_t count;
+  if(esdmI_dataspace_makeByteRanges(f->dataspace, da, buf, &ranges, &count) != ESDM_SUCCESS) return false;
+  int64_t cost = 0;
+  for(int64_t i = 0; i < count; i++) cost += ranges[i].size + ESDM_REGION_READ_RANGE_OVERHEAD;
+  if(!count || cost > esdm_dataspace_total_bytes(f->dataspace)/ESDM_REGION_READ_MAX_FRACTION) {
+    free(ranges);
+    return false;
+  }
+  *out_ranges = ranges;
+  *out_count = count;
+  return true;
+}
+
 bool esdmI_scheduler_try_direct_io(esdm_fragment_t *f, void * buf, esdm_dataspace_t * da){
   if(f->dataspace->type != da->type){
     return FALSE;
@@ -376,9 +1422,22 @@ bool esdmI_scheduler_try_direct_io(esdm_fragment_t *f, void * buf, esdm_dataspac
   eassert(f->dataspace->dims == da->dims);
 
   int64_t instructionDims, chunkSize, sourceOffset, destOffset;
-  esdmI_dataspace_copy_instructions(f->dataspace, da, &instructionDims, &chunkSize, &sourceOffset, &destOffset, NULL, NULL, NULL);
+  int64_t size[f->dataspace->dims];
+  esdmI_dataspace_copy_instructions(f->dataspace, da, &instructionDims, &chunkSize, &sourceOffset, &destOffset, size, NULL, NULL);
   if(instructionDims < 0) return true; //no overlap, nothing to do, we did it successfully
-  if(instructionDims > 0) return false; //copy cannot be reduced to a single memcpy() call, so direct I/O is impossible
+  if(instructionDims > 0) {
+    //The copy needs several memcpy() calls.
+    //If all of the fragment is needed in chunks that are large enough, the fragment can adopt the layout of the users' buffer,
+    //so that the backend can scatter the data straight into it (e.g. with preadv()) instead of reading it into a buffer of its own that we would have to copy from.
+    if(chunkSize < ESDM_IOVEC_MIN_CHUNK_BYTES || f->buf) return false;
+    int64_t overlapBytes = chunkSize;
+    for(int64_t i = 0; i < instructionDims; i++) overlapBytes *= size[i];
+    if(esdm_dataspace_total_bytes(f->dataspace) != overlapBytes) return false; //Only part of the data is used.
+    esdm_status ret = esdm_dataspace_copyDatalayout(f->dataspace, da);
+    eassert(ret == ESDM_SUCCESS);
+    f->buf = (char*)buf + esdm_dataspace_elementOffset(da, f->dataspace->offset);
+    return true;
+  }
 
   //Ok, only a single memcpy() would be needed to move the data.
   //Determine whether the entire fragment's data would be needed.
@@ -393,31 +1452,30 @@ bool esdmI_scheduler_try_direct_io(esdm_fragment_t *f, void * buf, esdm_dataspac
 }
 
 esdm_status esdm_scheduler_enqueue_read(esdm_instance_t *esdm, io_request_status_t *status, int frag_count, esdm_fragment_t **read_frag, void *buf, esdm_dataspace_t *buf_space) {
-  GError *error;
-
   atomic_fetch_add(&status->pending_ops, frag_count);
 
   for (int i = 0; i < frag_count; i++) {
     esdm_fragment_t *f = read_frag[i];
-    esdm_backend_t *backend_to_use = f->backend;
 
     io_work_t *task = ea_checked_malloc(sizeof(io_work_t));
     task->parent = status;
     task->op = ESDM_OP_READ;
     task->fragment = f;
+    task->ranges = NULL;
+    task->rangeCount = 0;
     if (esdmI_scheduler_try_direct_io(f, buf, buf_space)) {
       task->callback = buffer_cleanup_callback;
+    } else if (scheduler_try_region_read(f, buf, buf_space, &task->ranges, &task->rangeCount)) {
+      //Only a small part of the fragment is needed, so the backend reads just the needed bytes straight into `buf`.
+      task->op = ESDM_OP_READ_REGION;
+      task->callback = region_cleanup_callback;
     } else {
       //We cannot instruct the fragment to read the data directly into `buf` as we may only need a part of the fragment's data, and the overshoot may cause UB.
       task->callback = read_copy_callback;
       task->data.mem_buf = buf;
       task->data.buf_space = buf_space;
     }
-    if (backend_to_use->threads == 0) {
-      backend_thread(task, backend_to_use);
-    } else {
-      g_thread_pool_push(backend_to_use->threadPool, task, &error);
-    }
+    submit_work(esdm->scheduler, task);
   }
 
   return ESDM_SUCCESS;
@@ -468,9 +1526,9 @@ esdm_status esdmI_scheduler_readSingleFragmentBlocking(esdm_instance_t* esdm, es
   updateIoStats(&esdm->readStats, 1, requestBytes);
   updateRequestStats(&esdm->readStats, 1, requestBytes, false);
 
-  gReadTimes.enqueue += myTimes.enqueue;
-  gReadTimes.completion += myTimes.completion;
-  gReadTimes.total += ea_stop_timer(myTimer);
+  thread_stats()->read.enqueue += myTimes.enqueue;
+  thread_stats()->read.completion += myTimes.completion;
+  thread_stats()->read.total += ea_stop_timer(myTimer);
 
   return ret;
 }
@@ -519,8 +1577,25 @@ static esdm_status esdm_scheduler_enqueue_fill(esdm_instance_t* esdm, io_request
   return ESDM_SUCCESS;
 }
 
+//Returns the smallest number of slices of `sliceBytes` bytes each that add up to a multiple of `alignment`.
+static int64_t alignedSliceCount(int64_t sliceBytes, int64_t alignment) {
+  int64_t a = sliceBytes, b = alignment;
+  while(b) {
+    int64_t remainder = a%b;
+    a = b;
+    b = remainder;
+  }
+  return alignment/a;
+}
+
+//Returns the bound of the `index`-th of `slices` slices of a range of length `size`.
+//With a `thickness` of zero, the range is split evenly, otherwise all slices but the last are `thickness` thick.
+static int64_t sliceBound(int64_t index, int64_t slices, int64_t size, int64_t thickness) {
+  return thickness ? min_int64(index*thickness, size) : index*size/slices;
+}
+
 //Implementation of `esdm_scheduler_makeSplitRecommendation()` that tries to produce fragments that are about as wide as high/long/deep/... .
-static esdmI_hypercubeSet_t* makeSplitRecommendation_balancedDims(esdm_dataspace_t* space, int64_t maxFragmentSize) {
+static esdmI_hypercubeSet_t* makeSplitRecommendation_balancedDims(esdm_dataspace_t* space, int64_t maxFragmentSize, int64_t alignment) {
   eassert(space);
 
   esdmI_hypercubeSet_t* result = esdmI_hypercubeSet_make();
@@ -549,6 +1624,27 @@ static esdmI_hypercubeSet_t* makeSplitRecommendation_balancedDims(esdm_dataspace
     eassert(splitFactors[i] <= space->size[i]);
   }
 
+  //if the backend prefers aligned fragment sizes, give the slices of the outermost split dimension an aligned thickness,
+  //this is only possible if the other dimensions are split evenly
+  int64_t sliceThickness[space->dims];
+  memset(sliceThickness, 0, sizeof(sliceThickness));
+  int64_t alignDim = 0;
+  while(alignDim < space->dims && splitFactors[alignDim] == 1) alignDim++;
+  if(alignment > 0 && alignDim < space->dims) {
+    int64_t sliceBytes = esdm_sizeof(esdm_dataspace_get_type(space));
+    for(int64_t i = 0; i < space->dims; i++) {
+      if(i == alignDim) continue;
+      if(space->size[i] % splitFactors[i]) sliceBytes = 0;
+      sliceBytes *= space->size[i]/splitFactors[i];
+    }
+    int64_t maxThickness = (space->size[alignDim] + splitFactors[alignDim] - 1)/splitFactors[alignDim];
+    int64_t step = sliceBytes ? alignedSliceCount(sliceBytes, alignment) : 0;
+    if(step && step <= maxThickness) {
+      sliceThickness[alignDim] = maxThickness - maxThickness%step;
+      splitFactors[alignDim] = (space->size[alignDim] + sliceThickness[alignDim] - 1)/sliceThickness[alignDim];
+    }
+  }
+
   //create the split hypercubes
   int64_t splitCoords[space->dims];
   memset(splitCoords, 0, sizeof(splitCoords));
@@ -557,8 +1653,8 @@ static esdmI_hypercubeSet_t* makeSplitRecommendation_balancedDims(esdm_dataspace
     //set the current ranges
     for(int64_t i = 0; i < space->dims; i++) {
       curCube->ranges[i] = (esdmI_range_t){
-        .start = space->offset[i] + splitCoords[i]*space->size[i]/splitFactors[i],
-        .end = space->offset[i] + (splitCoords[i] + 1)*space->size[i]/splitFactors[i]
+        .start = space->offset[i] + sliceBound(splitCoords[i], splitFactors[i], space->size[i], sliceThickness[i]),
+        .end = space->offset[i] + sliceBound(splitCoords[i] + 1, splitFactors[i], space->size[i], sliceThickness[i])
       };
     }
 
@@ -589,7 +1685,7 @@ static int compare_dimInfo(const void* a, const void* b) {
 }
 
 //Implementation of `esdm_scheduler_makeSplitRecommendation()` that splits only the dimensions with the largest strides.
-static esdmI_hypercubeSet_t* makeSplitRecommendation_contiguousFragments(esdm_dataspace_t* space, int64_t maxFragmentSize) {
+static esdmI_hypercubeSet_t* makeSplitRecommendation_contiguousFragments(esdm_dataspace_t* space, int64_t maxFragmentSize, int64_t alignment) {
   eassert(space);
 
   esdmI_hypercubeSet_t* result = esdmI_hypercubeSet_make();
@@ -629,14 +1725,22 @@ static esdmI_hypercubeSet_t* makeSplitRecommendation_contiguousFragments(esdm_da
     int64_t maxSliceThickness = maxFragmentSize/fragmentSize;
     int64_t splitSlices = (size[dimInfo[splitDim].dimension] + maxSliceThickness - 1)/maxSliceThickness;
 
+    //if the backend prefers aligned fragment sizes, cut slices of an aligned thickness, only the last slice may be thinner
+    int64_t sliceThickness = 0;
+    int64_t step = alignment > 0 ? alignedSliceCount(fragmentSize, alignment) : 0;
+    if(step && step <= maxSliceThickness) {
+      sliceThickness = maxSliceThickness - maxSliceThickness%step;
+      splitSlices = (size[dimInfo[splitDim].dimension] + sliceThickness - 1)/sliceThickness;
+    }
+
     //create the hypercubes for the fragments
     int64_t fragmentCoords[dimensions];
     memset(fragmentCoords, 0, sizeof(fragmentCoords));
     while(fragmentCoords[splitDim] < splitSlices) {
       //compute the cubes' ranges from its fragment coordinates
       extends->ranges[dimInfo[splitDim].dimension] = (esdmI_range_t){
-        .start = offset[dimInfo[splitDim].dimension] + fragmentCoords[splitDim]*size[dimInfo[splitDim].dimension]/splitSlices,
-        .end = offset[dimInfo[splitDim].dimension] + (fragmentCoords[splitDim] + 1)*size[dimInfo[splitDim].dimension]/splitSlices
+        .start = offset[dimInfo[splitDim].dimension] + sliceBound(fragmentCoords[splitDim], splitSlices, size[dimInfo[splitDim].dimension], sliceThickness),
+        .end = offset[dimInfo[splitDim].dimension] + sliceBound(fragmentCoords[splitDim] + 1, splitSlices, size[dimInfo[splitDim].dimension], sliceThickness)
       };
       for(int64_t i = splitDim + 1; i < dimensions; i++) {
         extends->ranges[dimInfo[i].dimension] = (esdmI_range_t){
@@ -667,9 +1771,9 @@ static esdmI_hypercubeSet_t* makeSplitRecommendation_contiguousFragments(esdm_da
 esdmI_hypercubeSet_t* esdm_scheduler_makeSplitRecommendation(esdm_dataspace_t* space, esdm_backend_t* backend) {
   switch(backend->config->fragmentation_method) {
     case ESDMI_FRAGMENTATION_METHOD_EQUALIZED:
-      return makeSplitRecommendation_balancedDims(space, backend->config->max_fragment_size);
+      return makeSplitRecommendation_balancedDims(space, backend->config->max_fragment_size, backend->alignment);
     case ESDMI_FRAGMENTATION_METHOD_CONTIGUOUS:
-      return makeSplitRecommendation_contiguousFragments(space, backend->config->max_fragment_size);
+      return makeSplitRecommendation_contiguousFragments(space, backend->config->max_fragment_size, backend->alignment);
   }
   fprintf(stderr, "fatal error: memory corruption detected: backend->config->fragmentation contains broken data\n");
   abort();
@@ -727,7 +1831,7 @@ static void splitToBackends(esdm_dataspace_t* space, int64_t backendCount, esdm_
     for(int64_t i = 0; i < backendCount; i++) {
       eassert(bounds[i] <= bounds[i+1]);
       if(bounds[i] == bounds[i+1]) {
-        out_backendExtends = NULL;
+        out_backendExtends[i] = NULL;
       } else {
         esdmI_hypercube_t* curCube = esdmI_hypercube_makeCopy(totalExtends);
         curCube->ranges[bestDim] = (esdmI_range_t){
@@ -776,7 +1880,7 @@ esdm_status esdm_scheduler_enqueue_write(esdm_instance_t *esdm, io_request_statu
   eassert(backends);
   esdmI_hypercube_t** backendExtends = ea_checked_malloc(backendCount*sizeof(*backendExtends));
   splitToBackends(space, backendCount, backends, backendExtends);
-  gWriteTimes.backendDistribution += startTime = ea_stop_timer(myTimer);
+  thread_stats()->write.backendDistribution += startTime = ea_stop_timer(myTimer);
   for(int64_t backendIndex = 0; backendIndex < backendCount; backendIndex++) {
     esdmI_hypercube_t* curExtends = backendExtends[backendIndex];
     if(! curExtends) {
@@ -816,7 +1920,7 @@ esdm_status esdm_scheduler_enqueue_write(esdm_instance_t *esdm, io_request_statu
     esdmI_hypercubeSet_destroy(cubes);
     esdmI_hypercube_destroy(curExtends);
   }
-  gWriteTimes.backendDispatch += ea_stop_timer(myTimer) - startTime;
+  thread_stats()->write.backendDispatch += ea_stop_timer(myTimer) - startTime;
 
   //cleanup
   free(backendExtends);
@@ -829,7 +1933,6 @@ void esdmI_scheduler_writeFragmentNonblocking(esdm_instance_t* esdm, esdm_fragme
   ea_start_timer(&myTimer);
 
   if(!fragment->backend) fragment->backend = esdm_modules_fastestBackend(esdm_get_modules());
-  esdm_backend_t* backend = fragment->backend;
   io_work_t* task = ea_checked_malloc(sizeof(*task));
   *task = (io_work_t){
     .fragment = fragment,
@@ -841,20 +1944,15 @@ void esdmI_scheduler_writeFragmentNonblocking(esdm_instance_t* esdm, esdm_fragme
   };
 
   atomic_fetch_add(&status->pending_ops, 1);
-  if (backend->threads == 0) {
-    backend_thread(task, backend);
-  } else {
-    GError *error;
-    g_thread_pool_push(backend->threadPool, task, &error);
-  }
+  submit_work(esdm->scheduler, task);
 
   int64_t byteCount = esdm_dataspace_total_bytes(fragment->dataspace);
   updateIoStats(&esdm->writeStats, 1, byteCount);
   updateRequestStats(&esdm->writeStats, 1, byteCount, requestIsInternal);
 
   double endTime = ea_stop_timer(myTimer);
-  gWriteTimes.backendDispatch += endTime;
-  gWriteTimes.total += endTime;
+  thread_stats()->write.backendDispatch += endTime;
+  thread_stats()->write.total += endTime;
 }
 
 esdm_status esdmI_scheduler_writeFragmentBlocking(esdm_instance_t* esdm, esdm_fragment_t* fragment, bool requestIsInternal) {
@@ -876,8 +1974,8 @@ esdm_status esdmI_scheduler_writeFragmentBlocking(esdm_instance_t* esdm, esdm_fr
   eassert(ret == ESDM_SUCCESS);
 
   double endTime = ea_stop_timer(myTimer);
-  gWriteTimes.completion += endTime;
-  gWriteTimes.total += endTime;
+  thread_stats()->write.completion += endTime;
+  thread_stats()->write.total += endTime;
 
   return status.return_code;
 }
@@ -886,7 +1984,7 @@ esdm_status esdm_scheduler_status_init(io_request_status_t *status) {
   g_mutex_init(&status->mutex);
   g_cond_init(&status->done_condition);
   atomic_init(&status->pending_ops, 0);
-  status->return_code = ESDM_SUCCESS;
+  atomic_init(&status->return_code, ESDM_SUCCESS);
   return ESDM_SUCCESS;
 }
 
@@ -897,146 +1995,201 @@ esdm_status esdm_scheduler_status_finalize(io_request_status_t *status) {
 }
 
 esdm_status esdm_scheduler_wait(io_request_status_t *status) {
+#ifdef ESDM_HAVE_FUTEX
+  int pendings;
+  while ((pendings = atomic_load(&status->pending_ops))) {
+    syscall(SYS_futex, &status->pending_ops, FUTEX_WAIT_PRIVATE, pendings, NULL, NULL, 0);  //returns immediately if the count has changed in the meantime
+  }
+#else
   g_mutex_lock(&status->mutex);
   while (atomic_load(&status->pending_ops)) {
     g_cond_wait(&status->done_condition, &status->mutex);
   }
   g_mutex_unlock(&status->mutex);
+#endif
   return ESDM_SUCCESS;
 }
 
-esdm_status esdm_scheduler_write_blocking(esdm_instance_t *esdm, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, bool requestIsInternal) {
+static void request_init(esdm_request_t *request, esdm_instance_t *esdm, io_operation_t op, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *space, bool allowWriteback, bool requestIsInternal) {
+  *request = (esdm_request_t){
+    .esdm = esdm,
+    .op = op,
+    .dataset = dataset,
+    .buf = buf,
+    .space = space,
+    .ret = ESDM_SUCCESS,
+    .allowWriteback = allowWriteback,
+    .requestIsInternal = requestIsInternal,
+    .dataIsComplete = true
+  };
+  esdm_status ret = esdm_scheduler_status_init(&request->status);
+  eassert(ret == ESDM_SUCCESS);
+}
+
+esdm_status esdmI_scheduler_writeNonblocking(esdm_instance_t *esdm, esdm_request_t *request, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, bool requestIsInternal) {
   ESDM_DEBUG(__func__);
 
   timer myTimer;
   ea_start_timer(&myTimer);
 
-  io_request_status_t status;
-  esdm_status ret = esdm_scheduler_status_init(&status);
-  eassert(ret == ESDM_SUCCESS);
-
-  ret = esdm_scheduler_enqueue_write(esdm, &status, dataset, buf, subspace, requestIsInternal); //This function does its own internal time measurements.
-  if( ret != ESDM_SUCCESS){
-    return ret;
-  }
-  double syncStartTime = ea_stop_timer(myTimer);
+  request_init(request, esdm, ESDM_OP_WRITE, dataset, buf, subspace, false, requestIsInternal);
+  request->ret = esdm_scheduler_enqueue_write(esdm, &request->status, dataset, buf, subspace, requestIsInternal); //This function does its own internal time measurements.
 
-  ret = esdm_scheduler_wait(&status);
-  eassert(ret == ESDM_SUCCESS);
-
-  ret = esdm_scheduler_status_finalize(&status);
-  eassert(ret == ESDM_SUCCESS);
-  double endTime = ea_stop_timer(myTimer);
-
-  gWriteTimes.completion += endTime - syncStartTime;
-  gWriteTimes.total += endTime;
-
-  return status.return_code;
+  request->submitTime = ea_stop_timer(myTimer);
+  return request->ret;
 }
 
-
-esdm_status esdm_scheduler_read_blocking(esdm_instance_t *esdm, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, esdmI_hypercubeSet_t** out_fillRegion, bool allowWriteback, bool requestIsInternal) {
+esdm_status esdmI_scheduler_readNonblocking(esdm_instance_t *esdm, esdm_request_t *request, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, bool allowWriteback, bool requestIsInternal) {
   ESDM_DEBUG(__func__);
 
   timer myTimer;
   ea_start_timer(&myTimer);
-  esdm_readTimes_t myTimes = {0};
   double startTime; //reused for the different individual measurements
 
-  io_request_status_t status;
-  esdm_status ret = esdm_scheduler_status_init(&status);
-  eassert(ret == ESDM_SUCCESS);
+  request_init(request, esdm, ESDM_OP_READ, dataset, buf, subspace, allowWriteback, requestIsInternal);
 
   startTime = ea_stop_timer(myTimer);
-  int64_t frag_count;
-  esdm_fragment_t** read_frag;
-  esdmI_hypercubeSet_t* uncovered;
-  bool dataIsComplete;
+  esdm_status ret;
   {
     esdmI_hypercube_t* readExtends;
     esdmI_dataspace_getExtends(subspace, &readExtends);
-    esdmI_dataset_fragmentsCoveringRegion(dataset, readExtends, &frag_count, &read_frag, &uncovered, &dataIsComplete);
+    ret = esdmI_dataset_fragmentsCoveringRegion(dataset, readExtends, &request->fragmentCount, &request->fragments, &request->uncovered, &request->dataIsComplete);
     esdmI_hypercube_destroy(readExtends);
-    DEBUG("fragments to read: %d", frag_count);
+    DEBUG("fragments to read: %d", request->fragmentCount);
+  }
+  thread_stats()->read.makeSet += ea_stop_timer(myTimer) - startTime;
+  if(ret != ESDM_SUCCESS) {
+    //the fragment metadata could not be loaded, so we do not know what to read
+    ESDM_WARN("failed to select the fragments for reading");
+    request->ret = ret;
+    request->submitTime = ea_stop_timer(myTimer);
+    return ret;
   }
-  myTimes.makeSet = ea_stop_timer(myTimer) - startTime;
 
   //check whether we have all the requested data
   startTime = ea_stop_timer(myTimer);
-  if(!dataIsComplete) {
-    esdm_type_t type = esdm_dataspace_get_type(subspace);
-    eassert(type == esdm_dataset_get_type(dataset));  //TODO handle the case that the two types don't match
-    char fillValue[esdm_sizeof(type)];
-    ret = esdm_dataset_get_fill_value(dataset, fillValue);
+  if(!request->dataIsComplete) {
+    //the fill value is stored with the dataset's type, so it may need conversion to the type of the memory buffer
+    esdm_type_t type = esdm_dataspace_get_type(subspace), datasetType = esdm_dataset_get_type(dataset);
+    char datasetFillValue[esdm_sizeof(datasetType)], fillValue[esdm_sizeof(type)];
+    ret = esdm_dataset_get_fill_value(dataset, datasetFillValue);
     if(ret == ESDM_SUCCESS) {
       //we have a fill value, so we continue to read, fill the uncovered parts with the fill value, and signal back to the user how much uncovered data we filled
-      ret = esdm_scheduler_enqueue_fill(esdm, &status, fillValue, buf, subspace, esdmI_hypercubeSet_list(uncovered));
+      ea_datatype_converter converter = ea_saturating_converter_for_types(type, datasetType);
+      if(converter) {
+        converter(fillValue, datasetFillValue, sizeof(datasetFillValue));
+        ret = esdm_scheduler_enqueue_fill(esdm, &request->status, fillValue, buf, subspace, esdmI_hypercubeSet_list(request->uncovered));
+      } else {
+        ESDM_WARN("unable to convert the fill value to the datatype of the memory buffer");
+        ret = ESDM_ERROR;
+      }
     } else {
       ret = ESDM_INCOMPLETE_DATA; //no fill value set, so we error out
     }
   }
-  myTimes.coverageCheck = ea_stop_timer(myTimer) - startTime;
+  thread_stats()->read.coverageCheck += ea_stop_timer(myTimer) - startTime;
 
-  int64_t requestBytes = 0, ioBytes = 0;
   if(ret == ESDM_SUCCESS) {
     //all preliminaries successful, commit to reading
     startTime = ea_stop_timer(myTimer);
-    ret = esdm_scheduler_enqueue_read(esdm, &status, frag_count, read_frag, buf, subspace);
+    ret = esdm_scheduler_enqueue_read(esdm, &request->status, request->fragmentCount, request->fragments, buf, subspace);
     eassert(ret == ESDM_SUCCESS);
-    myTimes.enqueue = ea_stop_timer(myTimer) - startTime;
+    thread_stats()->read.enqueue += ea_stop_timer(myTimer) - startTime;
+  }
+  request->ret = ret;
 
-    startTime = ea_stop_timer(myTimer);
-    ret = esdm_scheduler_wait(&status);
-    eassert(ret == ESDM_SUCCESS);
+  request->submitTime = ea_stop_timer(myTimer);
+  return ret;
+}
 
-    ret = esdm_scheduler_status_finalize(&status);
-    eassert(ret == ESDM_SUCCESS);
-    myTimes.completion = ea_stop_timer(myTimer) - startTime;
+bool esdmI_scheduler_requestTest(esdm_request_t *request) {
+#ifdef ESDM_HAVE_FUTEX
+  return !atomic_load(&request->status.pending_ops);
+#else
+  //Without futexes, the workers decrement `pending_ops` while holding the mutex, and touch the status object until they release it.
+  //So we must take the mutex as well, otherwise the caller might destroy the request while a worker is still using it.
+  g_mutex_lock(&request->status.mutex);
+  bool done = !atomic_load(&request->status.pending_ops);
+  g_mutex_unlock(&request->status.mutex);
+  return done;
+#endif
+}
+
+esdm_status esdmI_scheduler_requestComplete(esdm_request_t *request, esdmI_hypercubeSet_t** out_fillRegion) {
+  ESDM_DEBUG(__func__);
+
+  timer myTimer;
+  ea_start_timer(&myTimer);
+  double startTime; //reused for the different individual measurements
+
+  //the status must be waited for even if the request failed, some I/O may have been enqueued before the failure was detected
+  startTime = ea_stop_timer(myTimer);
+  esdm_status ret = esdm_scheduler_wait(&request->status);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_scheduler_status_finalize(&request->status);
+  eassert(ret == ESDM_SUCCESS);
+  double completionTime = ea_stop_timer(myTimer) - startTime;
 
-    ret = status.return_code;
+  ret = request->ret != ESDM_SUCCESS ? request->ret : request->status.return_code;
 
+  if(request->op == ESDM_OP_WRITE) {
+    double endTime = ea_stop_timer(myTimer);
+    thread_stats()->write.completion += completionTime;
+    thread_stats()->write.total += request->submitTime + endTime;
+    return ret;
+  }
+
+  esdm_instance_t *esdm = request->esdm;
+  int64_t requestBytes = 0, ioBytes = 0;
+  if(request->ret == ESDM_SUCCESS) {
     //update the statistics
-    requestBytes = esdm_dataspace_total_bytes(subspace);
-    ioBytes = 0;
-    for(int64_t i = 0; i < frag_count; i++) {
-      ioBytes += esdm_dataspace_total_bytes(read_frag[i]->dataspace);
+    requestBytes = esdm_dataspace_total_bytes(request->space);
+    for(int64_t i = 0; i < request->fragmentCount; i++) {
+      ioBytes += esdm_dataspace_total_bytes(request->fragments[i]->dataspace);
     }
-    updateIoStats(&esdm->readStats, frag_count, ioBytes);
-    updateRequestStats(&esdm->readStats, 1, requestBytes, requestIsInternal);
+    updateIoStats(&esdm->readStats, request->fragmentCount, ioBytes);
+    updateRequestStats(&esdm->readStats, 1, requestBytes, request->requestIsInternal);
   }
 
   //reading is done, check whether we want to store the resulting fragment for faster access in the future
-  if(allowWriteback && ret == ESDM_SUCCESS && dataIsComplete) { //don't perform write-back of data that contains fill values, we do not want to transform data holes into stored data!
+  double writebackTime = 0;
+  if(request->allowWriteback && ret == ESDM_SUCCESS && request->dataIsComplete) { //don't perform write-back of data that contains fill values, we do not want to transform data holes into stored data!
     if(ioBytes/(double)requestBytes >= 8) { //TODO Turn this magic number into a proper configuration constant!
       startTime = ea_stop_timer(myTimer);
-      esdm_scheduler_write_blocking(esdm, dataset, buf, subspace, true);  //Ignore return code because this is just an optimization that writes a redundant data copy to disk.
-      myTimes.writeback = ea_stop_timer(myTimer) - startTime;
+      esdm_scheduler_write_blocking(esdm, request->dataset, request->buf, request->space, true);  //Ignore return code because this is just an optimization that writes a redundant data copy to disk.
+      writebackTime = ea_stop_timer(myTimer) - startTime;
     }
   }
 
   //cleanup, must not happen before we wait for the background processes to finish their tasks
   if(out_fillRegion) {  //either return the fill region to the user or destroy it
-    *out_fillRegion = uncovered;
-  } else {
-    esdmI_hypercubeSet_destroy(uncovered);
+    *out_fillRegion = request->uncovered;
+  } else if(request->uncovered) {
+    esdmI_hypercubeSet_destroy(request->uncovered);
   }
-  free(read_frag);
-  myTimes.total = ea_stop_timer(myTimer);
+  request->uncovered = NULL;
+  free(request->fragments);
+  request->fragments = NULL;
 
-  gReadTimes.makeSet += myTimes.makeSet;
-  gReadTimes.coverageCheck += myTimes.coverageCheck;
-  gReadTimes.enqueue += myTimes.enqueue;
-  gReadTimes.completion += myTimes.completion;
-  gReadTimes.writeback += myTimes.writeback;
-  gReadTimes.total += myTimes.total;
+  thread_stats()->read.completion += completionTime;
+  thread_stats()->read.writeback += writebackTime;
+  thread_stats()->read.total += request->submitTime + ea_stop_timer(myTimer);
 
   return ret;
 }
 
-esdm_readTimes_t esdmI_performance_read() {
-  return gReadTimes;
+esdm_status esdm_scheduler_write_blocking(esdm_instance_t *esdm, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, bool requestIsInternal) {
+  ESDM_DEBUG(__func__);
+
+  esdm_request_t request;
+  esdmI_scheduler_writeNonblocking(esdm, &request, dataset, buf, subspace, requestIsInternal);
+  return esdmI_scheduler_requestComplete(&request, NULL);
 }
 
-esdm_writeTimes_t esdmI_performance_write() {
-  return gWriteTimes;
+esdm_status esdm_scheduler_read_blocking(esdm_instance_t *esdm, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, esdmI_hypercubeSet_t** out_fillRegion, bool allowWriteback, bool requestIsInternal) {
+  ESDM_DEBUG(__func__);
+
+  esdm_request_t request;
+  esdmI_scheduler_readNonblocking(esdm, &request, dataset, buf, subspace, allowWriteback, requestIsInternal);
+  return esdmI_scheduler_requestComplete(&request, out_fillRegion);
 }
@@ -200,6 +200,105 @@ esdm_status esdm_read(esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *spac
   return esdmI_readWithFillRegion(dataset, buf, space, NULL);
 }
 
+//Returns a heap allocated request object with its own copy of the dataspace and a reference to the dataset, or NULL if that cannot be done.
+static esdm_request_t* request_make(esdm_dataset_t *dataset, esdm_dataspace_t *space, esdm_dataspace_t** out_spaceCopy) {
+  esdm_status ret = esdm_dataspace_copy(space, out_spaceCopy);
+  if(ret != ESDM_SUCCESS) return NULL;
+  ret = esdm_dataset_ref(dataset);
+  if(ret != ESDM_SUCCESS) {
+    esdm_dataspace_destroy(*out_spaceCopy);
+    return NULL;
+  }
+  return ea_checked_malloc(sizeof(esdm_request_t));
+}
+
+//Completes the request, and releases everything that `request_make()` acquired.
+static esdm_status request_complete(esdm_request_t *request) {
+  esdm_status ret = esdmI_scheduler_requestComplete(request, NULL);
+  esdm_dataspace_destroy(request->space);
+  esdm_dataset_close(request->dataset);
+  free(request);
+  return ret;
+}
+
+esdm_status esdm_iwrite(esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *space, esdm_request_t **out_request) {
+  ESDM_DEBUG(__func__);
+  eassert(dataset);
+  eassert(buf);
+  eassert(space);
+  eassert(out_request);
+
+  *out_request = NULL;
+  esdm_dataspace_t* spaceCopy;
+  esdm_request_t* request = request_make(dataset, space, &spaceCopy);
+  if(!request) return ESDM_ERROR;
+
+  esdm_status ret = esdmI_scheduler_writeNonblocking(esdmI_esdm(), request, dataset, buf, spaceCopy, false);
+  if(ret != ESDM_SUCCESS) {
+    request_complete(request);
+    return ret;
+  }
+  *out_request = request;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdm_iread(esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *space, esdm_request_t **out_request) {
+  ESDM_DEBUG(__func__);
+  eassert(dataset);
+  eassert(buf);
+  eassert(space);
+  eassert(out_request);
+
+  *out_request = NULL;
+  esdm_dataspace_t* spaceCopy;
+  esdm_request_t* request = request_make(dataset, space, &spaceCopy);
+  if(!request) return ESDM_ERROR;
+
+  esdm_status ret = esdmI_scheduler_readNonblocking(esdmI_esdm(), request, dataset, buf, spaceCopy, true, false);
+  if(ret != ESDM_SUCCESS) {
+    request_complete(request);
+    return ret;
+  }
+  *out_request = request;
+  return ESDM_SUCCESS;
+}
+
+esdm_status esdm_wait(esdm_request_t **request) {
+  ESDM_DEBUG(__func__);
+  eassert(request);
+
+  if(!*request) return ESDM_SUCCESS;
+  esdm_status ret = request_complete(*request);
+  *request = NULL;
+  return ret;
+}
+
+esdm_status esdm_test(esdm_request_t **request, int *out_done) {
+  eassert(request);
+  eassert(out_done);
+
+  if(!*request) {
+    *out_done = 1;
+    return ESDM_SUCCESS;
+  }
+  *out_done = esdmI_scheduler_requestTest(*request);
+  if(!*out_done) return ESDM_SUCCESS;
+  return esdm_wait(request);
+}
+
+esdm_status esdm_waitall(int64_t count, esdm_request_t **requests) {
+  ESDM_DEBUG(__func__);
+  eassert(count >= 0);
+  eassert(requests || !count);
+
+  esdm_status result = ESDM_SUCCESS;
+  for(int64_t i = 0; i < count; i++) {
+    esdm_status ret = esdm_wait(&requests[i]);
+    if(result == ESDM_SUCCESS) result = ret;
+  }
+  return result;
+}
+
 esdm_status esdm_sync() {
   ESDM_DEBUG(__func__);
   return ESDM_SUCCESS;
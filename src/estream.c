@@ -47,16 +47,24 @@ SCIL_Datatype_t ea_esdm_datatype_to_scil(smd_basic_type_t type){
 }
 #endif
 
+// staging buffers honor the alignment preference of the backend, so that it can transfer them without further copies
+static void * estream_malloc(esdm_fragment_t *f, size_t size){
+  if(f->backend && f->backend->alignment){
+    return ea_checked_memalign(f->backend->alignment, size);
+  }
+  return ea_checked_malloc(size);
+}
+
 bool estream_mem_unpack_fragment_param(esdm_fragment_t *f, void ** out_buf, size_t * out_size){
   if(f->actual_bytes != -1){
     *out_size = f->actual_bytes;
-    *out_buf = ea_checked_malloc(f->actual_bytes);
+    *out_buf = estream_malloc(f, f->actual_bytes);
     return TRUE;
   }else{
     *out_size = f->bytes;
   }
   if(f->dataspace->stride) {
-    *out_buf = ea_checked_malloc(f->bytes);
+    *out_buf = estream_malloc(f, f->bytes);
     return TRUE;
   }
   *out_buf = f->buf;
@@ -108,6 +116,18 @@ int estream_mem_unpack_fragment(esdm_fragment_t *f, void * rbuff, size_t size){
 }
 
 
+bool estream_mem_iovec_fragment(esdm_fragment_t *f, int64_t minChunkBytes, struct iovec ** out_iov, int64_t * out_count){
+  if(! f->dataspace->stride || ! f->buf || f->actual_bytes != -1){
+    return FALSE;
+  }
+#ifdef HAVE_SCIL
+  if(f->dataset->chints && f->dataspace->dims <= 5){
+    return FALSE;
+  }
+#endif
+  return esdmI_dataspace_makeIovecs(f->dataspace, f->buf, minChunkBytes, out_iov, out_count) == ESDM_SUCCESS && *out_iov;
+}
+
 int estream_mem_pack_fragment(esdm_fragment_t *f, void ** in_out_buff, size_t * out_size){
   int last_phase = 0;
 
@@ -143,7 +163,7 @@ int estream_mem_pack_fragment(esdm_fragment_t *f, void ** in_out_buff, size_t *
     if(*in_out_buff != NULL && last_phase == 1){
       outBuff = *in_out_buff; // output buffer
     }else{
-      outBuff = ea_checked_malloc(f->bytes);
+      outBuff = estream_malloc(f, f->bytes);
       allocBuff = outBuff;
     }
     esdm_dataspace_t* contiguousSpace;
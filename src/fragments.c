@@ -32,9 +32,80 @@ static void esdmI_fragments_deallocateValue(gpointer valueArg) {
 
 void esdmI_fragments_construct(esdm_fragments_t* me) {
   me->table = g_hash_table_new_full(esdmI_fragments_hashKey, esdmI_fragments_equalKeys, esdmI_fragments_deallocateKey, esdmI_fragments_deallocateValue);
+  g_mutex_init(&me->indexMutex);
+  me->index = NULL;
+  me->pendingKeys = NULL;
+  me->pendingFragments = NULL;
+  me->pendingCount = me->pendingAllocatedCount = 0;
+  me->uncommitted = NULL;
+  me->uncommittedCount = me->uncommittedAllocatedCount = 0;
 }
 
-esdm_status esdmI_fragments_add(esdm_fragments_t* me, esdm_fragment_t* fragment) {
+// The spatial index //////////////////////////////////////////////////////////
+//
+// Fragments are only queued for the index when they are added, the index itself is brought up to date by the next region query.
+// That way, loading the metadata of a dataset with many fragments results in a single bulk load of the index instead of many individual insertions.
+
+//Throw the index away, it will be rebuilt from the table by the next query. Used when all fragments are removed from the table.
+static void esdmI_fragments_invalidateIndex(esdm_fragments_t* me) {
+  g_mutex_lock(&me->indexMutex);
+  if(me->index) esdmI_hypercubeRTree_destroy(me->index);
+  me->index = NULL;
+  me->pendingCount = 0;
+  g_mutex_unlock(&me->indexMutex);
+}
+
+static void esdmI_fragments_queueForIndex(esdm_fragments_t* me, esdmI_hypercube_t* key, esdm_fragment_t* fragment) {
+  g_mutex_lock(&me->indexMutex);
+  if(me->index) { //without an index, the entire table will be bulk loaded anyway
+    if(me->pendingCount == me->pendingAllocatedCount) {
+      me->pendingAllocatedCount = me->pendingAllocatedCount ? 2*me->pendingAllocatedCount : 64;
+      me->pendingKeys = ea_checked_realloc(me->pendingKeys, me->pendingAllocatedCount*sizeof(*me->pendingKeys));
+      me->pendingFragments = ea_checked_realloc(me->pendingFragments, me->pendingAllocatedCount*sizeof(*me->pendingFragments));
+    }
+    me->pendingKeys[me->pendingCount] = key;
+    me->pendingFragments[me->pendingCount++] = fragment;
+  }
+  g_mutex_unlock(&me->indexMutex);
+}
+
+static void esdmI_fragments_bulkLoadIndex(esdm_fragments_t* me, int64_t dims) {
+  int64_t count = g_hash_table_size(me->table);
+  esdmI_hypercube_t** keys = ea_checked_malloc((count ? count : 1)*sizeof(*keys));
+  void** fragments = ea_checked_malloc((count ? count : 1)*sizeof(*fragments));
+  GHashTableIter iter;
+  gpointer key, value;
+  int64_t i = 0;
+  g_hash_table_iter_init(&iter, me->table);
+  while(g_hash_table_iter_next(&iter, &key, &value)) {
+    keys[i] = key;
+    fragments[i++] = value;
+  }
+  eassert(i == count);
+
+  me->index = esdmI_hypercubeRTree_make(dims);
+  esdmI_hypercubeRTree_bulkLoad(me->index, count, keys, fragments);
+  free(keys);
+  free(fragments);
+}
+
+//Bring the index up to date. Must be called with the indexMutex held.
+static void esdmI_fragments_updateIndex(esdm_fragments_t* me, int64_t dims) {
+  //A lot of pending fragments are better handled by rebuilding the index from scratch, the bulk loaded tree is also of better quality.
+  if(me->index && me->pendingCount > esdmI_hypercubeRTree_count(me->index)) {
+    esdmI_hypercubeRTree_destroy(me->index);
+    me->index = NULL;
+  }
+
+  if(!me->index) {
+    esdmI_fragments_bulkLoadIndex(me, dims);
+  } else {
+    for(int64_t i = 0; i < me->pendingCount; i++) esdmI_hypercubeRTree_insert(me->index, me->pendingKeys[i], me->pendingFragments[i]);
+  }
+  me->pendingCount = 0;
+}
+
+static esdm_status esdmI_fragments_insert(esdm_fragments_t* me, esdm_fragment_t* fragment, bool isCommitted) {
   eassert(me);
   eassert(me->table);
   eassert(fragment);
@@ -46,9 +117,18 @@ esdm_status esdmI_fragments_add(esdm_fragments_t* me, esdm_fragment_t* fragment)
   esdm_status result = esdmI_dataspace_getExtends(fragment->dataspace, &key);
   eassert(result == ESDM_SUCCESS);
   if(g_hash_table_contains(me->table, key)) {
+    esdmI_hypercube_destroy(key);
     result = ESDM_INVALID_STATE_ERROR;
   } else {
     g_hash_table_insert(me->table, key, fragment);
+    esdmI_fragments_queueForIndex(me, key, fragment);
+  }
+  if(result == ESDM_SUCCESS && !isCommitted) {
+    if(me->uncommittedCount == me->uncommittedAllocatedCount) {
+      me->uncommittedAllocatedCount = me->uncommittedAllocatedCount ? 2*me->uncommittedAllocatedCount : 64;
+      me->uncommitted = ea_checked_realloc(me->uncommitted, me->uncommittedAllocatedCount*sizeof(*me->uncommitted));
+    }
+    me->uncommitted[me->uncommittedCount++] = fragment;
   }
 
   gStats.fragmentAddCalls++;
@@ -57,6 +137,14 @@ esdm_status esdmI_fragments_add(esdm_fragments_t* me, esdm_fragment_t* fragment)
   return result;
 }
 
+esdm_status esdmI_fragments_add(esdm_fragments_t* me, esdm_fragment_t* fragment) {
+  return esdmI_fragments_insert(me, fragment, false);
+}
+
+esdm_status esdmI_fragments_addLoaded(esdm_fragments_t* me, esdm_fragment_t* fragment) {
+  return esdmI_fragments_insert(me, fragment, true);
+}
+
 esdm_fragment_t* esdmI_fragments_lookupForShape(esdm_fragments_t* me, esdmI_hypercube_t* shape) {
   timer myTimer;
   ea_start_timer(&myTimer);
@@ -71,6 +159,7 @@ esdm_fragment_t* esdmI_fragments_lookupForShape(esdm_fragments_t* me, esdmI_hype
 
 typedef struct deleteFragmentsFromBackendState {
   esdm_status result;
+  esdm_fragments_t* fragments;
 } deleteFragmentsFromBackendState;
 
 static gboolean esdmI_fragments_deleteFragmentsFromBackend(gpointer keyArg, gpointer valueArg, gpointer stateArg) {
@@ -80,33 +169,161 @@ static gboolean esdmI_fragments_deleteFragmentsFromBackend(gpointer keyArg, gpoi
 
   esdm_status result = esdmI_backend_fragment_delete(value->backend, value);
   if(state->result == ESDM_SUCCESS) state->result = result;
-  return result == ESDM_SUCCESS ? TRUE : FALSE;
+  if(result != ESDM_SUCCESS) return FALSE;
+  if(state->fragments->index) {
+    bool found = esdmI_hypercubeRTree_remove(state->fragments->index, key, value);
+    eassert(found);
+  }
+  return TRUE;
 }
 
 esdm_status esdmI_fragments_deleteAll(esdm_fragments_t* me) {
-  deleteFragmentsFromBackendState state = { .result = ESDM_SUCCESS };
+  deleteFragmentsFromBackendState state = { .result = ESDM_SUCCESS, .fragments = me };
+  //The fragments that cannot be deleted stay in the table, so they are removed from the index one by one instead of discarding it.
+  g_mutex_lock(&me->indexMutex);
+  if(me->index && me->pendingCount) esdmI_fragments_updateIndex(me, me->index->dims);
   g_hash_table_foreach_remove(me->table, esdmI_fragments_deleteFragmentsFromBackend, &state);
+  g_mutex_unlock(&me->indexMutex);
+  me->uncommittedCount = 0;
   return state.result;
 }
 
-typedef struct selectFragmentsInRegionState {
-  esdmI_hypercube_t* region;
-  esdm_fragment_t** fragments;
-  int64_t fragmentCount, bufferSize;
-} selectFragmentsInRegionState;
+// Fragment selection ////////////////////////////////////////////////////////
+//
+// The selection must be deterministic: given the same fragments and costs, every process has to arrive at the same set,
+// collective reads rely on that. So the fragments are put into a canonical order first, and all ties are broken by that order.
+
+//Number of candidate subsets that are generated and compared by cost.
+#define ESDMI_FRAGMENT_SELECTION_CANDIDATES 8
+//Above this count of mutually overlapping fragments, the redundancy analysis is skipped and all fragments are read.
+//The analysis needs O(n^2) intersections, and O(n) coverage checks against up to n cubes for each candidate subset,
+//with n = 64 that is in the order of a millisecond, which is small compared to the I/O of that many fragments.
+#define ESDMI_FRAGMENT_SELECTION_MAX_COUNT 64
+//Fixed cost of issuing one more read request, expressed in bytes, so that fewer fragments win when the byte counts are equal.
+#define ESDMI_FRAGMENT_REQUEST_OVERHEAD (64*1024)
+//Throughput that is assumed for backends that cannot estimate their own, the same default as the generic performance model.
+#define ESDMI_FRAGMENT_DEFAULT_THROUGHPUT (100.0*1024*1024)
+
+//Estimated cost of reading the given fragment in full, in seconds.
+//Unless only a small part of them is needed, fragments are read as a whole, so any overshoot beyond the requested region is paid for just like the useful bytes.
+//Fragments that are already in memory are essentially free.
+static double esdmI_fragments_readCost(esdm_fragment_t* fragment) {
+  if(fragment->buf && fragment->status != ESDM_DATA_NOT_LOADED) return 0;
+
+  double bytes = (fragment->actual_bytes != (size_t)-1 ? fragment->actual_bytes : fragment->bytes) + ESDMI_FRAGMENT_REQUEST_OVERHEAD;
+  double throughput = 0;
+  if(fragment->backend && fragment->backend->callbacks.estimate_throughput) throughput = esdmI_backend_estimate_throughput(fragment->backend);
+  if(!(throughput > 0)) throughput = ESDMI_FRAGMENT_DEFAULT_THROUGHPUT;
+  return bytes/throughput;
+}
 
-static void esdmI_fragments_selectFragmentsInRegion(gpointer keyArg, gpointer valueArg, gpointer stateArg) {
-  esdmI_hypercube_t* key = keyArg;
-  esdm_fragment_t* value = valueArg;
-  selectFragmentsInRegionState* state = stateArg;
+//Canonical order of the fragments: the fragments of a dataset have distinct shapes, so ordering them by offset and size is total.
+static int esdmI_fragments_compareShapes(const void* aArg, const void* bArg) {
+  const esdm_dataspace_t* a = (*(esdm_fragment_t* const*)aArg)->dataspace;
+  const esdm_dataspace_t* b = (*(esdm_fragment_t* const*)bArg)->dataspace;
+  eassert(a->dims == b->dims);
+  for(int64_t i = 0; i < a->dims; i++) {
+    if(a->offset[i] != b->offset[i]) return a->offset[i] < b->offset[i] ? -1 : 1;
+  }
+  for(int64_t i = 0; i < a->dims; i++) {
+    if(a->size[i] != b->size[i]) return a->size[i] < b->size[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+static int esdmI_fragments_compareStarts(const void* aArg, const void* bArg, void* cubesArg) {
+  esdmI_hypercube_t** cubes = cubesArg;
+  int64_t a = cubes[*(const int64_t*)aArg]->ranges[0].start;
+  int64_t b = cubes[*(const int64_t*)bArg]->ranges[0].start;
+  return a < b ? -1 : a > b ? 1 : 0;
+}
 
-  if(esdmI_hypercube_overlap(key, state->region)) {
-    if(state->fragmentCount == state->bufferSize) {
-      state->fragments = ea_checked_realloc(state->fragments, (state->bufferSize *= 2)*sizeof*state->fragments);
+//Mark the cubes that intersect at least one other cube, with a sweep along the first dimension.
+//Returns the number of marked cubes.
+static int64_t esdmI_fragments_findOverlaps(esdmI_hypercubeList_t* list, bool* out_overlapping) {
+  int64_t count = list->count;
+  memset(out_overlapping, 0, count*sizeof(*out_overlapping));
+  if(count && !list->cubes[0]->dims) { //zero dimensional cubes all occupy the same single point
+    for(int64_t i = 0; i < count; i++) out_overlapping[i] = count > 1;
+    return count > 1 ? count : 0;
+  }
+
+  int64_t* order = ea_checked_malloc(count*sizeof(*order));
+  for(int64_t i = 0; i < count; i++) order[i] = i;
+  g_qsort_with_data(order, count, sizeof(*order), esdmI_fragments_compareStarts, list->cubes);
+  int64_t result = 0;
+  for(int64_t a = 0; a < count; a++) {
+    esdmI_hypercube_t* cube = list->cubes[order[a]];
+    for(int64_t b = a + 1; b < count && list->cubes[order[b]]->ranges[0].start < cube->ranges[0].end; b++) {
+      if(!esdmI_hypercube_doesIntersect(cube, list->cubes[order[b]])) continue;
+      result += !out_overlapping[order[a]] + !out_overlapping[order[b]];
+      out_overlapping[order[a]] = out_overlapping[order[b]] = true;
+    }
+  }
+  free(order);
+  return result;
+}
+
+//Removes fragments from the set that are not needed to cover the parts of `bounds` that are covered by the set.
+//Among the nonredundant subsets, the one with the lowest estimated read cost is chosen.
+//Fragments that do not overlap any other fragment within `bounds` are always needed, so only the overlapping ones are analyzed.
+static void esdmI_fragments_dropRedundant(esdmI_hypercube_t* bounds, esdm_fragment_t** fragments, int64_t* inout_fragmentCount) {
+  int64_t count = *inout_fragmentCount;
+  if(count < 2) return;
+  qsort(fragments, count, sizeof(*fragments), esdmI_fragments_compareShapes);
+
+  double* costs = ea_checked_malloc(count*sizeof(*costs));
+  for(int64_t i = 0; i < count; i++) costs[i] = esdmI_fragments_readCost(fragments[i]);
+
+  //fast path: a single fragment that covers the entire region
+  int64_t boundsSize = esdmI_hypercube_size(bounds);
+  int64_t best = -1;
+  esdmI_hypercubeList_t list = { .cubes = ea_checked_malloc(count*sizeof(*list.cubes)), .count = count };
+  for(int64_t i = 0; i < count; i++) {
+    esdmI_hypercube_t* extends;
+    esdm_status status = esdmI_dataspace_getExtends(fragments[i]->dataspace, &extends);
+    eassert(status == ESDM_SUCCESS);
+    list.cubes[i] = esdmI_hypercube_makeIntersection(extends, bounds);
+    eassert(list.cubes[i]);  //the index only returns fragments that intersect the region
+    esdmI_hypercube_destroy(extends);
+    if(esdmI_hypercube_size(list.cubes[i]) == boundsSize && (best < 0 || costs[i] < costs[best])) best = i;
+  }
+
+  bool* overlapping = ea_checked_malloc(count*sizeof(*overlapping));
+  int64_t overlapCount = best >= 0 ? 0 : esdmI_fragments_findOverlaps(&list, overlapping);
+  if(best >= 0) {
+    fragments[0] = fragments[best];
+    *inout_fragmentCount = 1;
+  } else if(overlapCount && overlapCount <= ESDMI_FRAGMENT_SELECTION_MAX_COUNT) {
+    //general case: generate a few minimal subsets of the overlapping fragments and pick the cheapest one
+    esdmI_hypercubeList_t overlapList = { .cubes = ea_checked_malloc(overlapCount*sizeof(*overlapList.cubes)), .count = 0 };
+    for(int64_t i = 0; i < count; i++) if(overlapping[i]) overlapList.cubes[overlapList.count++] = list.cubes[i];
+    int64_t setCount = ESDMI_FRAGMENT_SELECTION_CANDIDATES;
+    uint8_t (*subsets)[overlapCount] = ea_checked_malloc(setCount*sizeof(*subsets));
+    esdmI_hypercubeList_nonredundantSubsets(&overlapList, &setCount, subsets);
+
+    double bestCost = 0;
+    for(int64_t set = 0; set < setCount; set++) {
+      double cost = 0;
+      for(int64_t i = 0, j = 0; i < count; i++) if(overlapping[i] && subsets[set][j++]) cost += costs[i];
+      if(best < 0 || cost < bestCost) best = set, bestCost = cost;
+    }
+
+    if(best >= 0) {
+      int64_t selectedCount = 0;
+      for(int64_t i = 0, j = 0; i < count; i++) {
+        if(!overlapping[i] || subsets[best][j++]) fragments[selectedCount++] = fragments[i];
+      }
+      *inout_fragmentCount = selectedCount;
     }
-    eassert(state->fragmentCount < state->bufferSize);
-    state->fragments[state->fragmentCount++] = value;
+    free(subsets);
+    free(overlapList.cubes);
   }
+
+  for(int64_t i = 0; i < count; i++) esdmI_hypercube_destroy(list.cubes[i]);
+  free(overlapping);
+  free(list.cubes);
+  free(costs);
 }
 
 esdm_fragment_t** esdmI_fragments_makeSetCoveringRegion(esdm_fragments_t* me, esdmI_hypercube_t* bounds, int64_t* out_fragmentCount) {
@@ -124,19 +341,13 @@ esdm_fragment_t** esdmI_fragments_makeSetCoveringRegion(esdm_fragments_t* me, es
     *out_fragmentCount = 1;
     result = ea_memdup(&singleFragment, sizeof(singleFragment));
   } else {
-    //search the hash table for matching fragments
-    selectFragmentsInRegionState state = {
-      .region = bounds,
-      .fragmentCount = 0,
-      .bufferSize = 8,
-      .fragments = malloc(8*sizeof*state.fragments)
-    };
-    g_hash_table_foreach(me->table, esdmI_fragments_selectFragmentsInRegion, &state);
-
-    //TODO: kick out any fragments that happen to be redundant
-
-    *out_fragmentCount = state.fragmentCount;
-    result = state.fragments;
+    //search the spatial index for matching fragments
+    g_mutex_lock(&me->indexMutex);
+    if(!me->index || me->pendingCount) esdmI_fragments_updateIndex(me, bounds->dims);
+    result = (esdm_fragment_t**)esdmI_hypercubeRTree_query(me->index, bounds, out_fragmentCount);
+    g_mutex_unlock(&me->indexMutex);
+
+    esdmI_fragments_dropRedundant(bounds, result, out_fragmentCount);
   }
 
   gStats.setCreationCalls++;
@@ -175,11 +386,48 @@ void esdmI_fragments_metadata_create(esdm_fragments_t* me, smd_string_stream_t*
   gStats.metadataCreation += ea_stop_timer(myTimer);;
 }
 
+void esdmI_fragments_metadata_createUncommitted(esdm_fragments_t* me, smd_string_stream_t* stream) {
+  timer myTimer;
+  ea_start_timer(&myTimer);
+
+  smd_string_stream_printf(stream, "[");
+  createFragmentMetadataState state = {
+    .stream = stream,
+    .needComma = false
+  };
+  for(int64_t i = 0; i < me->uncommittedCount; i++) esdmI_fragments_createFragmentMetadata(NULL, me->uncommitted[i], &state);
+  smd_string_stream_printf(stream, "]");
+
+  gStats.metadataCreationCalls++;
+  gStats.metadataCreation += ea_stop_timer(myTimer);;
+}
+
+void esdmI_fragments_markCommitted(esdm_fragments_t* me) {
+  me->uncommittedCount = 0;
+}
+
+void esdmI_fragments_snapshotCommitted(esdm_fragments_t* me) {
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init(&iter, me->table);
+  while(g_hash_table_iter_next(&iter, &key, &value)) {
+    esdm_fragment_t* fragment = value;
+    if(fragment->backend && fragment->backend->callbacks.fragment_metadata_committed) esdmI_backend_fragment_metadata_committed(fragment->backend, fragment);
+  }
+}
+
 void esdmI_fragments_purge(esdm_fragments_t* me) {
   g_hash_table_remove_all(me->table);
+  esdmI_fragments_invalidateIndex(me);
+  me->uncommittedCount = 0;
 }
 
 esdm_status esdmI_fragments_destruct(esdm_fragments_t* me) {
   g_hash_table_destroy(me->table);
+  if(me->index) esdmI_hypercubeRTree_destroy(me->index);
+  free(me->pendingKeys);
+  free(me->pendingFragments);
+  free(me->uncommitted);
+  g_mutex_clear(&me->indexMutex);
   return ESDM_SUCCESS;
 }
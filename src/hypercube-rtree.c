@@ -0,0 +1,510 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * @brief This file implements an R-tree over hypercubes, a spatial index that finds all the hypercubes overlapping a given region
+ * without looking at the ones that are far away.
+ *
+ * Incremental insertion and removal follow Guttman's original algorithms with the quadratic split.
+ * Bulk loading uses Sort-Tile-Recursive (STR) packing, which produces nearly full nodes with little overlap between them.
+ */
+
+#include <esdm-internal.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Nodes have one more slot than they may use permanently, so that an overflowing node can be filled up before it is split.
+struct esdmI_rtreeNode_t {
+  int64_t count;
+  bool isLeaf;
+  void* entries[ESDMI_RTREE_MAX_ENTRIES + 1];  //the child nodes of an inner node, or the values of a leaf
+  esdmI_range_t bounds[];  //(ESDMI_RTREE_MAX_ENTRIES + 1)*dims ranges, the bounding boxes of the entries
+};
+
+static esdmI_range_t* rtree_bounds(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, int64_t entry) {
+  return &node->bounds[entry*me->dims];
+}
+
+static esdmI_rtreeNode_t* rtree_makeNode(esdmI_hypercubeRTree_t* me, bool isLeaf) {
+  esdmI_rtreeNode_t* result = ea_checked_malloc(sizeof(*result) + (ESDMI_RTREE_MAX_ENTRIES + 1)*me->dims*sizeof(*result->bounds));
+  result->count = 0;
+  result->isLeaf = isLeaf;
+  return result;
+}
+
+static void rtree_destroyNode(esdmI_rtreeNode_t* node) {
+  if(!node->isLeaf) {
+    for(int64_t i = 0; i < node->count; i++) rtree_destroyNode(node->entries[i]);
+  }
+  free(node);
+}
+
+// Box arithmetic //////////////////////////////////////////////////////////////
+//
+// Volumes are computed as doubles, the products of the edge lengths of realistic datasets easily exceed the range of int64_t.
+
+static double box_volume(int64_t dims, const esdmI_range_t* box) {
+  double result = 1;
+  for(int64_t i = 0; i < dims; i++) result *= (double)esdmI_range_size(box[i]);
+  return result;
+}
+
+static double box_unionVolume(int64_t dims, const esdmI_range_t* a, const esdmI_range_t* b) {
+  double result = 1;
+  for(int64_t i = 0; i < dims; i++) {
+    int64_t start = a[i].start < b[i].start ? a[i].start : b[i].start;
+    int64_t end = a[i].end > b[i].end ? a[i].end : b[i].end;
+    result *= (double)(end - start);
+  }
+  return result;
+}
+
+static void box_extend(int64_t dims, esdmI_range_t* inout_box, const esdmI_range_t* other) {
+  for(int64_t i = 0; i < dims; i++) {
+    if(other[i].start < inout_box[i].start) inout_box[i].start = other[i].start;
+    if(other[i].end > inout_box[i].end) inout_box[i].end = other[i].end;
+  }
+}
+
+static bool box_contains(int64_t dims, const esdmI_range_t* outer, const esdmI_range_t* inner) {
+  for(int64_t i = 0; i < dims; i++) {
+    if(inner[i].start < outer[i].start || inner[i].end > outer[i].end) return false;
+  }
+  return true;
+}
+
+static bool box_equal(int64_t dims, const esdmI_range_t* a, const esdmI_range_t* b) {
+  for(int64_t i = 0; i < dims; i++) {
+    if(a[i].start != b[i].start || a[i].end != b[i].end) return false;
+  }
+  return true;
+}
+
+//same semantics as esdmI_hypercube_overlap(): the intersection must be non-empty
+static bool box_overlaps(int64_t dims, const esdmI_range_t* a, const esdmI_range_t* b) {
+  for(int64_t i = 0; i < dims; i++) {
+    if(a[i].start >= b[i].end || b[i].start >= a[i].end) return false;
+    if(a[i].start >= a[i].end || b[i].start >= b[i].end) return false;
+  }
+  return true;
+}
+
+static void rtree_nodeBounds(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, esdmI_range_t* out_box) {
+  eassert(node->count > 0);
+  memcpy(out_box, rtree_bounds(me, node, 0), me->dims*sizeof(*out_box));
+  for(int64_t i = 1; i < node->count; i++) box_extend(me->dims, out_box, rtree_bounds(me, node, i));
+}
+
+static void rtree_appendEntry(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, const esdmI_range_t* box, void* entry) {
+  eassert(node->count <= ESDMI_RTREE_MAX_ENTRIES);
+  memcpy(rtree_bounds(me, node, node->count), box, me->dims*sizeof(*box));
+  node->entries[node->count++] = entry;
+}
+
+//The order of the entries within a node is irrelevant, so the last entry simply takes the place of the removed one.
+static void rtree_removeEntry(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, int64_t entry) {
+  eassert(entry < node->count);
+  node->count--;
+  if(entry < node->count) {
+    memcpy(rtree_bounds(me, node, entry), rtree_bounds(me, node, node->count), me->dims*sizeof(esdmI_range_t));
+    node->entries[entry] = node->entries[node->count];
+  }
+}
+
+// Incremental insertion ///////////////////////////////////////////////////////
+
+//Distribute the entries of an overflowing node between the node itself and a new sibling, which is returned.
+static esdmI_rtreeNode_t* rtree_split(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node) {
+  const int64_t dims = me->dims, count = node->count;
+  eassert(count == ESDMI_RTREE_MAX_ENTRIES + 1);
+
+  //save the entries, they are redistributed from scratch
+  void* entries[ESDMI_RTREE_MAX_ENTRIES + 1];
+  esdmI_range_t boxes[(ESDMI_RTREE_MAX_ENTRIES + 1)*(dims ? dims : 1)];
+  memcpy(entries, node->entries, count*sizeof(*entries));
+  memcpy(boxes, node->bounds, count*dims*sizeof(*boxes));
+  #define entryBox(i) (&boxes[(i)*dims])
+
+  //pick the two entries that would waste the most space if they were put into the same node
+  int64_t seedA = 0, seedB = 1;
+  double worstWaste = -1;
+  for(int64_t i = 0; i < count; i++) {
+    for(int64_t j = i + 1; j < count; j++) {
+      double waste = box_unionVolume(dims, entryBox(i), entryBox(j)) - box_volume(dims, entryBox(i)) - box_volume(dims, entryBox(j));
+      if(waste > worstWaste) {
+        worstWaste = waste;
+        seedA = i;
+        seedB = j;
+      }
+    }
+  }
+
+  esdmI_rtreeNode_t* sibling = rtree_makeNode(me, node->isLeaf);
+  node->count = 0;
+  rtree_appendEntry(me, node, entryBox(seedA), entries[seedA]);
+  rtree_appendEntry(me, sibling, entryBox(seedB), entries[seedB]);
+  esdmI_range_t boxA[dims ? dims : 1], boxB[dims ? dims : 1];
+  memcpy(boxA, entryBox(seedA), dims*sizeof(*boxA));
+  memcpy(boxB, entryBox(seedB), dims*sizeof(*boxB));
+  bool assigned[ESDMI_RTREE_MAX_ENTRIES + 1] = {false};
+  assigned[seedA] = assigned[seedB] = true;
+
+  for(int64_t remaining = count - 2; remaining > 0; remaining--) {
+    //if one of the nodes needs all the remaining entries to reach the minimum fill, give them to it
+    esdmI_rtreeNode_t* forcedNode = NULL;
+    if(node->count + remaining <= ESDMI_RTREE_MIN_ENTRIES) forcedNode = node;
+    if(sibling->count + remaining <= ESDMI_RTREE_MIN_ENTRIES) forcedNode = sibling;
+
+    //otherwise pick the entry with the strongest preference for one of the nodes
+    int64_t next = -1;
+    double nextGrowthA = 0, nextGrowthB = 0, strongestPreference = -1;
+    for(int64_t i = 0; i < count; i++) {
+      if(assigned[i]) continue;
+      double growthA = box_unionVolume(dims, boxA, entryBox(i)) - box_volume(dims, boxA);
+      double growthB = box_unionVolume(dims, boxB, entryBox(i)) - box_volume(dims, boxB);
+      double preference = growthA > growthB ? growthA - growthB : growthB - growthA;
+      if(preference > strongestPreference) {
+        strongestPreference = preference;
+        next = i;
+        nextGrowthA = growthA;
+        nextGrowthB = growthB;
+      }
+      if(forcedNode) break;
+    }
+    eassert(next >= 0);
+    assigned[next] = true;
+
+    bool toA;
+    if(forcedNode) {
+      toA = forcedNode == node;
+    } else if(nextGrowthA < nextGrowthB) {
+      toA = true;
+    } else if(nextGrowthB < nextGrowthA) {
+      toA = false;
+    } else {
+      toA = node->count <= sibling->count;
+    }
+    rtree_appendEntry(me, toA ? node : sibling, entryBox(next), entries[next]);
+    box_extend(dims, toA ? boxA : boxB, entryBox(next));
+  }
+  #undef entryBox
+
+  return sibling;
+}
+
+//Insert the entry into the subtree, returns a new sibling of `node` if `node` had to be split.
+static esdmI_rtreeNode_t* rtree_insertRecursive(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, const esdmI_range_t* box, void* value) {
+  const int64_t dims = me->dims;
+  if(node->isLeaf) {
+    rtree_appendEntry(me, node, box, value);
+  } else {
+    //descend into the child whose bounding box grows the least, prefer the smaller one in case of a tie
+    int64_t bestChild = -1;
+    double bestGrowth = 0, bestVolume = 0;
+    for(int64_t i = 0; i < node->count; i++) {
+      double volume = box_volume(dims, rtree_bounds(me, node, i));
+      double growth = box_unionVolume(dims, rtree_bounds(me, node, i), box) - volume;
+      if(bestChild < 0 || growth < bestGrowth || (growth <= bestGrowth && volume < bestVolume)) {
+        bestChild = i;
+        bestGrowth = growth;
+        bestVolume = volume;
+      }
+    }
+    eassert(bestChild >= 0);
+
+    esdmI_rtreeNode_t* child = node->entries[bestChild];
+    esdmI_rtreeNode_t* childSibling = rtree_insertRecursive(me, child, box, value);
+    rtree_nodeBounds(me, child, rtree_bounds(me, node, bestChild));
+    if(childSibling) {
+      esdmI_range_t siblingBox[dims ? dims : 1];
+      rtree_nodeBounds(me, childSibling, siblingBox);
+      rtree_appendEntry(me, node, siblingBox, childSibling);
+    }
+  }
+
+  return node->count > ESDMI_RTREE_MAX_ENTRIES ? rtree_split(me, node) : NULL;
+}
+
+//Insert the entry at the leaf level, growing the tree by one level if the root has to be split.
+//Does not update the entry count of the tree.
+static void rtree_insertBox(esdmI_hypercubeRTree_t* me, const esdmI_range_t* box, void* value) {
+  if(!me->root) me->root = rtree_makeNode(me, true);
+  esdmI_rtreeNode_t* sibling = rtree_insertRecursive(me, me->root, box, value);
+  if(sibling) {
+    //the root was split, grow the tree by one level
+    esdmI_rtreeNode_t* newRoot = rtree_makeNode(me, false);
+    esdmI_range_t rootBox[me->dims ? me->dims : 1];
+    rtree_nodeBounds(me, me->root, rootBox);
+    rtree_appendEntry(me, newRoot, rootBox, me->root);
+    rtree_nodeBounds(me, sibling, rootBox);
+    rtree_appendEntry(me, newRoot, rootBox, sibling);
+    me->root = newRoot;
+  }
+}
+
+// Removal /////////////////////////////////////////////////////////////////////
+//
+// Follows Guttman's CondenseTree: nodes that drop below the minimum fill are dissolved, and their entries are inserted again.
+
+typedef struct rtreeOrphans_t {
+  int64_t count, allocatedCount;
+  esdmI_range_t* boxes;
+  void** values;
+} rtreeOrphans_t;
+
+//Move all values of the subtree into the orphan list, and free the nodes of the subtree.
+static void rtree_orphanSubtree(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, rtreeOrphans_t* orphans) {
+  for(int64_t i = 0; i < node->count; i++) {
+    if(node->isLeaf) {
+      if(orphans->count == orphans->allocatedCount) {
+        orphans->allocatedCount = orphans->allocatedCount ? 2*orphans->allocatedCount : ESDMI_RTREE_MAX_ENTRIES;
+        orphans->boxes = ea_checked_realloc(orphans->boxes, (orphans->allocatedCount*me->dims > 0 ? orphans->allocatedCount*me->dims : 1)*sizeof(*orphans->boxes));
+        orphans->values = ea_checked_realloc(orphans->values, orphans->allocatedCount*sizeof(*orphans->values));
+      }
+      memcpy(&orphans->boxes[orphans->count*me->dims], rtree_bounds(me, node, i), me->dims*sizeof(*orphans->boxes));
+      orphans->values[orphans->count++] = node->entries[i];
+    } else {
+      rtree_orphanSubtree(me, node->entries[i], orphans);
+    }
+  }
+  free(node);
+}
+
+//Remove the entry from the subtree, returns whether it was found.
+//Children that become underfull are removed from `node` and their values are added to the orphans, the bounds of the other children on the path are tightened.
+static bool rtree_removeRecursive(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, const esdmI_range_t* box, void* value, rtreeOrphans_t* orphans) {
+  const int64_t dims = me->dims;
+  for(int64_t i = 0; i < node->count; i++) {
+    if(node->isLeaf) {
+      if(node->entries[i] == value && box_equal(dims, rtree_bounds(me, node, i), box)) {
+        rtree_removeEntry(me, node, i);
+        return true;
+      }
+    } else if(box_contains(dims, rtree_bounds(me, node, i), box)) {
+      esdmI_rtreeNode_t* child = node->entries[i];
+      if(rtree_removeRecursive(me, child, box, value, orphans)) {
+        if(child->count < ESDMI_RTREE_MIN_ENTRIES) {
+          rtree_removeEntry(me, node, i);
+          rtree_orphanSubtree(me, child, orphans);
+        } else {
+          rtree_nodeBounds(me, child, rtree_bounds(me, node, i));
+        }
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Bulk loading ////////////////////////////////////////////////////////////////
+
+typedef struct rtreeSortItem_t {
+  int64_t key;  //twice the center of the box in the current sort dimension
+  int64_t index;
+} rtreeSortItem_t;
+
+static int rtree_compareSortItems(const void* aArg, const void* bArg) {
+  const rtreeSortItem_t* a = aArg;
+  const rtreeSortItem_t* b = bArg;
+  return a->key < b->key ? -1 : a->key > b->key ? 1 : 0;
+}
+
+//Sort the items by the center of their boxes in the given dimension.
+static void rtree_sortItems(int64_t dims, const esdmI_range_t* boxes, int64_t* indices, int64_t count, int64_t dim) {
+  rtreeSortItem_t* items = ea_checked_malloc(count*sizeof(*items));
+  for(int64_t i = 0; i < count; i++) {
+    const esdmI_range_t* range = &boxes[indices[i]*dims + dim];
+    items[i] = (rtreeSortItem_t){ .key = range->start + range->end, .index = indices[i] };
+  }
+  qsort(items, count, sizeof(*items), rtree_compareSortItems);
+  for(int64_t i = 0; i < count; i++) indices[i] = items[i].index;
+  free(items);
+}
+
+//Order the items recursively in slabs along each dimension, so that consecutive runs of ESDMI_RTREE_MAX_ENTRIES items are spatially compact.
+static void rtree_strOrder(int64_t dims, const esdmI_range_t* boxes, int64_t* indices, int64_t count, int64_t dim) {
+  if(dim >= dims || count <= ESDMI_RTREE_MAX_ENTRIES) return;
+  rtree_sortItems(dims, boxes, indices, count, dim);
+
+  //cut the sorted items into ceil(P^(1/k)) slabs, where P is the number of nodes that are needed, and k the number of dimensions that are left
+  //(computed as the smallest slab count whose k-th power covers P)
+  int64_t nodeCount = (count + ESDMI_RTREE_MAX_ENTRIES - 1)/ESDMI_RTREE_MAX_ENTRIES, slabCount = 1;
+  while(true) {
+    int64_t coveredNodes = 1;
+    for(int64_t i = dim; i < dims && coveredNodes < nodeCount; i++) coveredNodes *= slabCount;
+    if(coveredNodes >= nodeCount) break;
+    slabCount++;
+  }
+  int64_t slabSize = (count + slabCount - 1)/slabCount;
+  slabSize = (slabSize + ESDMI_RTREE_MAX_ENTRIES - 1)/ESDMI_RTREE_MAX_ENTRIES*ESDMI_RTREE_MAX_ENTRIES; //full nodes only, except for the last one
+  for(int64_t start = 0; start < count; start += slabSize) {
+    rtree_strOrder(dims, boxes, indices + start, (start + slabSize < count ? slabSize : count - start), dim + 1);
+  }
+}
+
+//Pack the given entries into nodes of the given kind, in the given order.
+//Returns the number of nodes created, the nodes and their bounding boxes are returned in `out_nodes` and `out_boxes`.
+static int64_t rtree_packLevel(esdmI_hypercubeRTree_t* me, bool isLeaf, void** entries, const esdmI_range_t* boxes, const int64_t* order, int64_t count, void** out_nodes, esdmI_range_t* out_boxes) {
+  const int64_t dims = me->dims;
+  int64_t nodeCount = 0;
+  for(int64_t start = 0; start < count; start += ESDMI_RTREE_MAX_ENTRIES) {
+    esdmI_rtreeNode_t* node = rtree_makeNode(me, isLeaf);
+    for(int64_t i = start; i < count && i < start + ESDMI_RTREE_MAX_ENTRIES; i++) {
+      int64_t index = order ? order[i] : i;
+      rtree_appendEntry(me, node, &boxes[index*dims], entries[index]);
+    }
+    rtree_nodeBounds(me, node, &out_boxes[nodeCount*dims]);
+    out_nodes[nodeCount++] = node;
+  }
+  return nodeCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// esdmI_hypercubeRTree_t /////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+esdmI_hypercubeRTree_t* esdmI_hypercubeRTree_make(int64_t dimensions) {
+  eassert(dimensions >= 0);
+  esdmI_hypercubeRTree_t* result = ea_checked_malloc(sizeof(*result));
+  *result = (esdmI_hypercubeRTree_t){
+    .dims = dimensions,
+    .count = 0,
+    .root = NULL
+  };
+  return result;
+}
+
+int64_t esdmI_hypercubeRTree_count(esdmI_hypercubeRTree_t* me) {
+  eassert(me);
+  return me->count;
+}
+
+void esdmI_hypercubeRTree_insert(esdmI_hypercubeRTree_t* me, esdmI_hypercube_t* cube, void* value) {
+  eassert(me);
+  eassert(cube);
+  eassert(cube->dims == me->dims);
+
+  rtree_insertBox(me, cube->ranges, value);
+  me->count++;
+}
+
+bool esdmI_hypercubeRTree_remove(esdmI_hypercubeRTree_t* me, esdmI_hypercube_t* cube, void* value) {
+  eassert(me);
+  eassert(cube);
+  eassert(cube->dims == me->dims);
+
+  rtreeOrphans_t orphans = {0};
+  if(!me->root || !rtree_removeRecursive(me, me->root, cube->ranges, value, &orphans)) return false;
+  me->count--;
+
+  //shorten the tree while the root has only a single child left, and drop an empty root
+  while(me->root && !me->root->isLeaf && me->root->count == 1) {
+    esdmI_rtreeNode_t* child = me->root->entries[0];
+    free(me->root);
+    me->root = child;
+  }
+  if(me->root && !me->root->count) {
+    free(me->root);
+    me->root = NULL;
+  }
+
+  for(int64_t i = 0; i < orphans.count; i++) rtree_insertBox(me, &orphans.boxes[i*me->dims], orphans.values[i]);
+  free(orphans.boxes);
+  free(orphans.values);
+  return true;
+}
+
+void esdmI_hypercubeRTree_bulkLoad(esdmI_hypercubeRTree_t* me, int64_t count, esdmI_hypercube_t** cubes, void** values) {
+  eassert(me);
+  eassert(count >= 0);
+  if(!count) return;
+  eassert(cubes);
+  eassert(values);
+
+  //a bulk load can only build a tree from scratch, so existing trees simply receive the new entries one by one
+  if(me->root) {
+    for(int64_t i = 0; i < count; i++) esdmI_hypercubeRTree_insert(me, cubes[i], values[i]);
+    return;
+  }
+
+  const int64_t dims = me->dims;
+  esdmI_range_t* boxes = ea_checked_malloc((count*dims > 0 ? count*dims : 1)*sizeof(*boxes));
+  int64_t* order = ea_checked_malloc(count*sizeof(*order));
+  for(int64_t i = 0; i < count; i++) {
+    eassert(cubes[i]->dims == dims);
+    memcpy(&boxes[i*dims], cubes[i]->ranges, dims*sizeof(*boxes));
+    order[i] = i;
+  }
+  rtree_strOrder(dims, boxes, order, count, 0);
+
+  //build the leaves, then the inner levels on top of them until only the root is left
+  //The nodes of each level are already ordered spatially, so each level can be packed in sequence.
+  int64_t levelCount = (count + ESDMI_RTREE_MAX_ENTRIES - 1)/ESDMI_RTREE_MAX_ENTRIES;
+  void** nodes = ea_checked_malloc(levelCount*sizeof(*nodes));
+  esdmI_range_t* nodeBoxes = ea_checked_malloc((levelCount*dims > 0 ? levelCount*dims : 1)*sizeof(*nodeBoxes));
+  levelCount = rtree_packLevel(me, true, values, boxes, order, count, nodes, nodeBoxes);
+  while(levelCount > 1) {
+    //the packing of a level never produces more nodes than it consumes, so it can work in place
+    levelCount = rtree_packLevel(me, false, nodes, nodeBoxes, NULL, levelCount, nodes, nodeBoxes);
+  }
+  me->root = nodes[0];
+  me->count = count;
+
+  free(nodeBoxes);
+  free(nodes);
+  free(order);
+  free(boxes);
+}
+
+static void rtree_queryRecursive(esdmI_hypercubeRTree_t* me, esdmI_rtreeNode_t* node, const esdmI_range_t* region, void*** inout_results, int64_t* inout_count, int64_t* inout_allocatedCount) {
+  for(int64_t i = 0; i < node->count; i++) {
+    if(!box_overlaps(me->dims, rtree_bounds(me, node, i), region)) continue;
+    if(node->isLeaf) {
+      if(*inout_count == *inout_allocatedCount) *inout_results = ea_checked_realloc(*inout_results, (*inout_allocatedCount *= 2)*sizeof(**inout_results));
+      (*inout_results)[(*inout_count)++] = node->entries[i];
+    } else {
+      rtree_queryRecursive(me, node->entries[i], region, inout_results, inout_count, inout_allocatedCount);
+    }
+  }
+}
+
+void** esdmI_hypercubeRTree_query(esdmI_hypercubeRTree_t* me, esdmI_hypercube_t* region, int64_t* out_count) {
+  eassert(me);
+  eassert(region);
+  eassert(region->dims == me->dims);
+  eassert(out_count);
+
+  int64_t allocatedCount = 8;
+  void** result = ea_checked_malloc(allocatedCount*sizeof(*result));
+  *out_count = 0;
+  if(me->root) rtree_queryRecursive(me, me->root, region->ranges, &result, out_count, &allocatedCount);
+  return result;
+}
+
+void esdmI_hypercubeRTree_clear(esdmI_hypercubeRTree_t* me) {
+  eassert(me);
+  if(me->root) rtree_destroyNode(me->root);
+  me->root = NULL;
+  me->count = 0;
+}
+
+void esdmI_hypercubeRTree_destroy(esdmI_hypercubeRTree_t* me) {
+  esdmI_hypercubeRTree_clear(me);
+  free(me);
+}
@@ -354,6 +354,121 @@ void esdmI_hypercubeSet_subtract(esdmI_hypercubeSet_t* me, esdmI_hypercube_t* su
   }
 }
 
+//The sweep behind esdmI_hypercubeSet_subtractList():
+//The region is cut into slabs along dimension `dim` at all the start/end coordinates of the covering cubes,
+//and each slab is processed recursively along the next dimension with only those cubes that span the slab.
+//A slab without any spanning cube is uncovered, consecutive uncovered slabs are merged into a single cube.
+//A slab that is spanned by a cube in all remaining dimensions is covered, and needs no further splitting.
+//The covering cubes are all required to intersect the region, and to span the region in all dimensions before `dim`.
+typedef struct sweepEvent_t {
+  int64_t start;
+  esdmI_hypercube_t* cube;
+} sweepEvent_t;
+
+static int sweepEvent_compare(const void* aArg, const void* bArg) {
+  const sweepEvent_t* a = aArg;
+  const sweepEvent_t* b = bArg;
+  return (a->start > b->start) - (a->start < b->start);
+}
+
+static int int64_compare(const void* aArg, const void* bArg) {
+  int64_t a = *(const int64_t*)aArg, b = *(const int64_t*)bArg;
+  return (a > b) - (a < b);
+}
+
+static void sweepUncovered(esdmI_hypercubeSet_t* out, esdmI_hypercube_t* region, int64_t dim, int64_t count, esdmI_hypercube_t** cubes) {
+  if(!count) {
+    esdmI_hypercubeSet_add(out, region);
+    return;
+  }
+
+  //fast path: a single cube that spans the entire region
+  for(int64_t i = 0; i < count; i++) {
+    bool spans = true;
+    for(int64_t d = dim; spans && d < region->dims; d++) {
+      spans = cubes[i]->ranges[d].start <= region->ranges[d].start && cubes[i]->ranges[d].end >= region->ranges[d].end;
+    }
+    if(spans) return;
+  }
+  eassert(dim < region->dims);  //if all dimensions are swept, any remaining cube spans the region
+
+  //collect the slab boundaries and sort the cubes by their start
+  esdmI_range_t range = region->ranges[dim];
+  int64_t* bounds = ea_checked_malloc((2*count + 2)*sizeof(*bounds));
+  sweepEvent_t* events = ea_checked_malloc(count*sizeof(*events));
+  int64_t boundCount = 0;
+  bounds[boundCount++] = range.start;
+  bounds[boundCount++] = range.end;
+  for(int64_t i = 0; i < count; i++) {
+    esdmI_range_t clipped = esdmI_range_intersection(cubes[i]->ranges[dim], range);
+    bounds[boundCount++] = clipped.start;
+    bounds[boundCount++] = clipped.end;
+    events[i] = (sweepEvent_t){ .start = clipped.start, .cube = cubes[i] };
+  }
+  qsort(bounds, boundCount, sizeof(*bounds), int64_compare);
+  qsort(events, count, sizeof(*events), sweepEvent_compare);
+  int64_t uniqueCount = 1;
+  for(int64_t i = 1; i < boundCount; i++) if(bounds[i] != bounds[uniqueCount - 1]) bounds[uniqueCount++] = bounds[i];
+
+  //sweep over the slabs, maintaining the set of cubes that span the current slab
+  esdmI_hypercube_t** active = ea_checked_malloc(count*sizeof(*active));
+  int64_t activeCount = 0, nextEvent = 0;
+  esdmI_hypercube_t* slab = esdmI_hypercube_makeCopy(region);
+  int64_t uncoveredStart = range.start;
+  for(int64_t i = 0; i + 1 < uniqueCount; i++) {
+    int64_t slabStart = bounds[i], slabEnd = bounds[i + 1];
+    int64_t keptCount = 0;
+    for(int64_t j = 0; j < activeCount; j++) if(active[j]->ranges[dim].end > slabStart) active[keptCount++] = active[j];
+    activeCount = keptCount;
+    for(; nextEvent < count && events[nextEvent].start <= slabStart; nextEvent++) active[activeCount++] = events[nextEvent].cube;
+
+    if(activeCount) {
+      //flush the preceding run of uncovered slabs
+      if(uncoveredStart < slabStart) {
+        slab->ranges[dim] = (esdmI_range_t){ .start = uncoveredStart, .end = slabStart };
+        esdmI_hypercubeSet_add(out, slab);
+      }
+      uncoveredStart = slabEnd;
+
+      slab->ranges[dim] = (esdmI_range_t){ .start = slabStart, .end = slabEnd };
+      sweepUncovered(out, slab, dim + 1, activeCount, active);
+    }
+  }
+  if(uncoveredStart < range.end) {
+    slab->ranges[dim] = (esdmI_range_t){ .start = uncoveredStart, .end = range.end };
+    esdmI_hypercubeSet_add(out, slab);
+  }
+
+  //cleanup
+  esdmI_hypercube_destroy(slab);
+  free(active);
+  free(events);
+  free(bounds);
+}
+
+void esdmI_hypercubeSet_subtractList(esdmI_hypercubeSet_t* me, esdmI_hypercubeList_t* subtrahends) {
+  eassert(me);
+  eassert(subtrahends);
+
+  esdmI_hypercubeList_t minuends = me->list;
+  esdmI_hypercubeSet_construct(me);
+  esdmI_hypercube_t** intersecting = ea_checked_malloc((subtrahends->count ? subtrahends->count : 1)*sizeof(*intersecting));
+  for(int64_t i = 0; i < minuends.count; i++) {
+    esdmI_hypercube_t* minuend = minuends.cubes[i];
+    int64_t intersectingCount = 0;
+    for(int64_t j = 0; j < subtrahends->count; j++) {
+      esdmI_hypercube_t* subtrahend = subtrahends->cubes[j];
+      if(subtrahend && esdmI_hypercube_doesIntersect(minuend, subtrahend)) intersecting[intersectingCount++] = subtrahend;
+    }
+    if(!esdmI_hypercube_isEmpty(minuend)) sweepUncovered(me, minuend, 0, intersectingCount, intersecting);
+    esdmI_hypercube_destroy(minuend);
+  }
+
+  //cleanup
+  free(intersecting);
+  free(minuends.cubes);
+}
+
 bool esdmI_hypercubeList_doesIntersect(esdmI_hypercubeList_t* list, esdmI_hypercube_t* cube) {
   for(int64_t i = 0; i < list->count; i++) {
     if(esdmI_hypercube_doesIntersect(list->cubes[i], cube)) return true;
@@ -414,23 +529,18 @@ static bool hypercubeIsFullyCovered(esdmI_hypercube_t* coveredCube, int64_t cove
   esdmI_hypercubeSet_construct(&restSet);
   esdmI_hypercubeSet_add(&restSet, coveredCube);
 
-  for(int64_t i = 0; i < coveringCubesCount; i++) {
-    if(coveringCubes[i]) {
-      esdmI_hypercubeSet_subtract(&restSet, coveringCubes[i]);
-      if(!restSet.list.count) break; //fast exit once the restSet becomes empty, this line is not necessary, but it might speed up some cases a bit
-    }
-  }
+  esdmI_hypercubeSet_subtractList(&restSet, &(esdmI_hypercubeList_t){ .cubes = coveringCubes, .count = coveringCubesCount });
   bool result = !restSet.list.count;
   esdmI_hypercubeSet_destruct(&restSet);
   return result;
 }
 
-//Probabilistically find a single minimal subset of cubes that covers the entire space.
-#define findMinimalSubset(list, requiredCubes, intersectionMatrix, out_selectedCubes) do {\
+//Find a single minimal subset of cubes that covers the entire space, checking the cubes in a pseudo-random order that is determined by `inout_seed`.
+#define findMinimalSubset(list, requiredCubes, intersectionMatrix, inout_seed, out_selectedCubes) do {\
   esdmI_hypercubeList_t* l = list;\
-  findMinimalSubset_internal(l->count, l->cubes, requiredCubes, intersectionMatrix, out_selectedCubes);\
+  findMinimalSubset_internal(l->count, l->cubes, requiredCubes, intersectionMatrix, inout_seed, out_selectedCubes);\
 } while(false)
-static void findMinimalSubset_internal(int64_t count, esdmI_hypercube_t** cubes, uint8_t* requiredCubes, esdmI_hypercube_t* (*intersectionMatrix)[count], uint8_t* out_selectedCubes) {
+static void findMinimalSubset_internal(int64_t count, esdmI_hypercube_t** cubes, uint8_t* requiredCubes, esdmI_hypercube_t* (*intersectionMatrix)[count], unsigned int* inout_seed, uint8_t* out_selectedCubes) {
   eassert(cubes);
   eassert(requiredCubes);
   eassert(intersectionMatrix);
@@ -446,8 +556,7 @@ static void findMinimalSubset_internal(int64_t count, esdmI_hypercube_t** cubes,
 
   for(; uncheckedCubeCount; uncheckedCubeCount--) {
     //randomly select a yet unchecked cube for checking
-    static unsigned int seed = 42;
-    uint64_t randomValue = rand_r(&seed);
+    uint64_t randomValue = rand_r(inout_seed);
     uint64_t cubeSelector = randomValue*uncheckedCubeCount/((uint64_t)RAND_MAX + 1);  //this is an index into the cubes for which the checkedCubes[] bit is not set
     int64_t checkIndex = 0;
     for(; ; checkIndex++) if(!checkedCubes[checkIndex] && !cubeSelector--) break;  //turn the cubeSelector into a real index
@@ -488,9 +597,11 @@ void esdmI_hypercubeList_nonredundantSubsets_internal(esdmI_hypercubeList_t* lis
   }
 
   //Probabilistically create a number of minimal sets.
+  //The seed is local, so that the result only depends on the list, which keeps the selection reproducible and free of shared state.
+  unsigned int seed = 42;
   int64_t setCount = 0;
   for(; setCount < *inout_setCount; setCount++) {
-    findMinimalSubset(list, requiredCubes, intersectionMatrix, out_subsets[setCount]);
+    findMinimalSubset(list, requiredCubes, intersectionMatrix, &seed, out_subsets[setCount]);
     //FIXME: Remove duplicate sets.
   }
 
@@ -49,9 +49,25 @@ struct esdm_container_t {
 };
 
 typedef struct esdmI_hypercubeNeighbourManager_t esdmI_hypercubeNeighbourManager_t;
+typedef struct esdmI_hypercubeRTree_t esdmI_hypercubeRTree_t;
+typedef struct esdmI_hypercube_t esdmI_hypercube_t;
+typedef struct esdmI_hypercubeSet_t esdmI_hypercubeSet_t;
+typedef struct esdmI_metadataCache_t esdmI_metadataCache_t;  //defined in esdm-metadata-cache.c
+typedef struct esdmI_fragmentPages_t esdmI_fragmentPages_t;  //defined in esdm-metadata-binary.c
 
 struct esdm_fragments_t {
   GHashTable* table;
+
+  //spatial index over the keys of the table, it is brought up to date lazily when a region query needs it
+  GMutex indexMutex;
+  esdmI_hypercubeRTree_t* index;  //NULL until the first query
+  esdmI_hypercube_t** pendingKeys;  //the keys of the fragments that have been added to the table but not to the index yet
+  esdm_fragment_t** pendingFragments;
+  int64_t pendingCount, pendingAllocatedCount;
+
+  //the fragments that have been added since the last commit of the dataset metadata, these are all that a journal entry needs to contain
+  esdm_fragment_t** uncommitted;
+  int64_t uncommittedCount, uncommittedAllocatedCount;
 };
 
 typedef struct esdm_fragments_t esdm_fragments_t;
@@ -66,9 +82,15 @@ struct esdm_dataset_t {
   smd_attr_t *attr;
   int64_t *actual_size; // used for unlimited dimensions
   esdm_fragments_t fragments;
+  esdmI_fragmentPages_t* fragmentPages;  //fragment metadata that has not been decoded yet, NULL if all fragments are in `fragments`
+  esdmI_hypercubeSet_t* indexedRegions;  //the regions for which the fragments have been retrieved from the fragment index of the metadata backend, NULL if there is nothing (left) to retrieve
+  GRecMutex loadMutex; //serializes the decoding of `fragmentPages` and the retrieval of indexed fragments into `fragments`, recursive because decoding a fragment looks up its shape
   int64_t gridCount, incompleteGridCount, gridSlotCount;
   esdm_grid_t** grids; //This array first contains the complete grids, then the grids that still lack some subgrids/fragments, and finally some pointers that are allocated but not used.
                       //When a grid is completed, it is swapped with the first incomplete grid and the grid counts are adjusted accordingly. This should be more efficient than managing two separate arrays.
+  int64_t committedGridCount; //the complete grids at indices below this have been written to the metadata backend already
+  int64_t journalEntries; //number of journal entries written/replayed since the last snapshot of the metadata, -1 if there is no snapshot yet
+  uint64_t snapshotId; //identifies the last snapshot of the metadata, journal entries are only valid for the snapshot with this ID
   int refcount;
   esdm_data_status_e status;
   int mode_flags; // set via esdm_mode_flags_e
@@ -105,6 +127,13 @@ typedef enum esdm_module_type_t {
   ESDM_MODULE_METADATA
 } esdm_module_type_t;
 
+//A piece of a fragment's serialized data, and the memory that receives it.
+typedef struct esdmI_byteRange_t {
+  int64_t offset;
+  int64_t size;
+  char *dest;
+} esdmI_byteRange_t;
+
 // Callbacks
 /**
  *
@@ -132,10 +161,43 @@ struct esdm_backend_t_callbacks_t {
   int (*fragment_update)  (esdm_backend_t * b, esdm_fragment_t *fragment);
   int (*fragment_delete)  (esdm_backend_t * b, esdm_fragment_t *fragment);
 
-  int (*fragment_metadata_create)(esdm_backend_t * b, esdm_fragment_t *fragment, smd_string_stream_t* stream);
+  /**
+   * Optional: Retrieve or update several fragments with a single call, so that the backend can keep all their I/O operations in flight at once.
+   *
+   * @param[in] b the backend object
+   * @param[in] count the number of fragments, at most the `batchSize` of the backend
+   * @param[inout] fragments the fragments, each is handled like by a call to `fragment_retrieve()` or `fragment_update()`, respectively
+   * @param[out] out_rets receives the status of each of the fragments
+   *
+   * These are used by the scheduler if the backend sets its `batchSize` to more than one.
+   */
+  void (*fragments_retrieve)(esdm_backend_t * b, int64_t count, esdm_fragment_t **fragments, int *out_rets);
+  void (*fragments_update)  (esdm_backend_t * b, int64_t count, esdm_fragment_t **fragments, int *out_rets);
+
+  /**
+   * Optional: Read only some byte ranges of a stored fragment, without loading the fragment itself.
+   *
+   * @param[in] b the backend object
+   * @param[in] fragment the fragment, its data is stored uncompressed in the contiguous C order of its dataspace
+   * @param[in] count the number of ranges
+   * @param[in] ranges the byte ranges within the serialized fragment data, each is read into its `dest` pointer
+   *
+   * The fragment's `buf` and status are left alone.
+   * This is used by the scheduler for reads that need only a small part of a large fragment.
+   */
+  int (*fragment_retrieve_region)(esdm_backend_t * b, esdm_fragment_t *fragment, int64_t count, esdmI_byteRange_t *ranges);
+
+  int (*fragment_metadata_create)(esdm_backend_t * b, esdm_fragment_t *fragment, smd_string_stream_t* stream); //writes a JSON value, or nothing if the fragment does not need any backend specific metadata
   void* (*fragment_metadata_load)(esdm_backend_t * b, esdm_fragment_t *fragment, json_t *metadata);
   int (*fragment_metadata_free) (esdm_backend_t * b, void * options);
 
+  /**
+   * Optional: Called after a snapshot of the dataset metadata has been committed, which references the current location of the fragment.
+   *
+   * A backend that moves fragments may only reclaim their old locations from here, before that the committed metadata may still reference them.
+   */
+  void (*fragment_metadata_committed)(esdm_backend_t * b, esdm_fragment_t *fragment);
+
   int (*mkfs)(esdm_backend_t * b, int format_flags);
   int (*fsck)(esdm_backend_t * b);
 
@@ -178,6 +240,24 @@ struct esdm_md_backend_callbacks_t {
   int (*dataset_destroy)(esdm_md_backend_t *, esdm_dataset_t *dataset);
   int (*dataset_remove)(esdm_md_backend_t *, esdm_dataset_t *dataset);
 
+  // Optional journal support, see esdm-metadata-journal.c.
+  // `dataset_journal_append()` appends the record to the journal of the dataset, `dataset_commit()` must discard the journal after writing the new snapshot.
+  // `dataset_journal_retrieve()` returns the concatenated records, or a NULL buffer if there is no journal.
+  int (*dataset_journal_append)(esdm_md_backend_t *, esdm_dataset_t *dataset, char * record, int record_size);
+  int (*dataset_journal_retrieve)(esdm_md_backend_t *, esdm_dataset_t *dataset, char ** out_journal, int * out_size);
+
+  // Optional fragment index, takes precedence over the journal if provided.
+  // The dataset level metadata is passed as JSON without fragments, the fragments are kept by the backend and are only retrieved for the regions that are accessed.
+  // `dataset_commit_fragments()` replaces the dataset level metadata and adds the given fragments to the index in one transaction.
+  // `dataset_fragments_retrieve()` returns a JSON array with the metadata of the indexed fragments that may intersect `region`, or of all fragments if `region` is NULL.
+  int (*dataset_commit_fragments)(esdm_md_backend_t *, esdm_dataset_t *dataset, char * json, int md_size, int64_t fragment_count, esdm_fragment_t ** fragments);
+  int (*dataset_fragments_retrieve)(esdm_md_backend_t *, esdm_dataset_t *dataset, esdmI_hypercube_t *region, char ** out_json, int * out_size);
+
+  // Optional, used by the metadata cache to detect changes made by other processes.
+  // Returns a value that changes whenever the stored metadata changes, e.g. derived from the modification time of the files.
+  int (*container_version)(esdm_md_backend_t *, esdm_container_t *container, uint64_t * out_version);
+  int (*dataset_version)(esdm_md_backend_t *, esdm_dataset_t *dataset, uint64_t * out_version);
+
   int (*mkfs)(esdm_md_backend_t *, int format_flags);
   int (*fsck)(esdm_md_backend_t*);
 };
@@ -200,10 +280,14 @@ struct esdm_backend_t {
   esdm_module_type_t type;
   char *version; // 0.0.0
   void *data;    /* backend-specific data. */
-  //uint32_t blocksize; /* any io must be multiple of 'blocksize' and aligned. */
+  int64_t alignment; //the alignment in bytes that this backend prefers for fragment buffers and fragment sizes (e.g. for O_DIRECT), 0 if it does not care
   esdm_backend_t_callbacks_t callbacks;
-  int threads;
-  GThreadPool *threadPool;
+  int threads;  //the maximum number of concurrent I/O operations on this backend, 0 means that the I/O is performed synchronously by the calling thread
+  int batchSize;  //the maximum number of I/O operations a worker passes to one `fragments_retrieve()`/`fragments_update()` call, values below 2 disable batching
+
+  //state used by the scheduler, protected by the scheduler's mutex
+  int activeThreads;  //the number of workers that are currently performing I/O on this backend
+  struct io_work_t *pendingHead, *pendingTail; //FIFO of I/O operations that wait for a free slot on this backend
 };
 
 struct esdm_md_backend_t {
@@ -216,14 +300,15 @@ struct esdm_md_backend_t {
 
 typedef enum io_operation_t {
   ESDM_OP_WRITE = 0,
-  ESDM_OP_READ
+  ESDM_OP_READ,
+  ESDM_OP_READ_REGION //reads the needed byte ranges of a fragment straight into the user buffer via `fragment_retrieve_region()`
 } io_operation_t;
 
 typedef struct io_request_status_t {
   atomic_int pending_ops;
-  GMutex mutex;
-  GCond done_condition;
-  int return_code;
+  GMutex mutex; //only used on systems without futexes
+  GCond done_condition; //only used on systems without futexes
+  atomic_int return_code;
 } io_request_status_t;
 
 typedef struct {
@@ -240,6 +325,31 @@ struct io_work_t {
   io_request_status_t *parent;
   void (*callback)(io_work_t *work);
   io_work_callback_data_t data;
+  esdmI_byteRange_t *ranges;  //only used by ESDM_OP_READ_REGION, owned by the work item
+  int64_t rangeCount;
+  io_work_t *next;  //used by the scheduler to queue the work item
+  double ioTime;  //the time spent in the I/O stage, measured by the scheduler
+};
+
+//The state of a read or write request between its submission to the scheduler and its completion.
+//Used both for the user visible `esdm_request_t` handles of `esdm_iread()`/`esdm_iwrite()`, and for the blocking calls which simply keep it on the stack.
+struct esdm_request_t {
+  io_request_status_t status;
+  struct esdm_instance_t *esdm;
+  io_operation_t op;
+  esdm_dataset_t *dataset;
+  void *buf;
+  esdm_dataspace_t *space;  //must stay alive until the request is completed, the background threads copy into/out of this space
+  esdm_status ret;  //errors detected before the I/O was enqueued, the I/O errors themselves are reported via `status.return_code`
+  bool allowWriteback, requestIsInternal;
+
+  //read specific state
+  int64_t fragmentCount;
+  esdm_fragment_t **fragments;
+  struct esdmI_hypercubeSet_t *uncovered;
+  bool dataIsComplete;
+
+  double submitTime;  //the time spent in the submitting call, needed to account the total time of the request correctly
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -248,6 +358,17 @@ struct io_work_t {
 
 // Organisation structures of core components /////////////////////////////////
 
+typedef enum esdmI_metadata_format_t {
+  ESDMI_METADATA_FORMAT_JSON, //human readable, the default
+  ESDMI_METADATA_FORMAT_BINARY  //compact and fast to decode, see esdm-metadata-binary.c
+} esdmI_metadata_format_t;
+
+typedef enum esdmI_metadata_durability_t {
+  ESDMI_METADATA_DURABILITY_NONE,  //metadata files are overwritten in place without syncing, the default
+  ESDMI_METADATA_DURABILITY_FSYNC, //every commit atomically replaces the file and syncs it before returning
+  ESDMI_METADATA_DURABILITY_GROUP  //concurrent commits are made durable together in batches by a background thread, each commit waits for its batch
+} esdmI_metadata_durability_t;
+
 // Configuration
 struct esdm_config_backend_t {
   const char *type;
@@ -260,6 +381,13 @@ struct esdm_config_backend_t {
   esdmI_fragmentation_method_t fragmentation_method;
   data_accessibility_t data_accessibility;
   uint32_t write_stream_blocksize; /* size in bytes for enabling write streaming, 0 if disabled */
+  esdmI_metadata_format_t metadata_format; //only used by metadata backends
+  int64_t journal_max_entries; //only used by metadata backends, number of journal entries after which the next commit writes a new snapshot, 0 disables the journal
+  esdmI_metadata_durability_t metadata_durability; //only used by metadata backends
+  int64_t group_commit_delay; //only used by metadata backends, maximum time in milliseconds that a group commit waits for more updates
+  int64_t metadata_cache_size; //only used by metadata backends, memory budget of the metadata cache in bytes, 0 disables the cache
+  bool metadata_cache_validate; //only used by metadata backends, whether cached metadata is checked against the version in the backend before it is reused
+  bool metadata_mpi_shared; //only used by metadata backends, whether `esdm_mpi_dataset_ref()` places binary metadata in node-local shared memory
 
   json_t *performance_model;
   json_t *esdm;
@@ -297,12 +425,14 @@ enum {
 typedef struct esdm_config_t {
   void *json;
   uint8_t boundListImplementation;  //one of the BOUND_LIST_IMPLEMENTATION_* constants
+  int64_t copyThreads, copyMinBytesPerThread;  //see esdmI_dataspace_setCopyParallelism()
 } esdm_config_t;
 
 typedef struct esdm_modules_t {
   int data_backend_count;
   esdm_backend_t **data_backends;
   esdm_md_backend_t *metadata_backend;
+  esdmI_metadataCache_t *metadata_cache;  //NULL if the cache is disabled
   //esdm_modules_t** modules;
 } esdm_modules_t;
 
@@ -310,11 +440,32 @@ typedef struct esdm_layout_t {
   int info;
 } esdm_layout_t;
 
+//A double ended queue of work items that have finished their I/O stage and wait for their CPU stage (the callback) to be executed.
+//The owning worker pushes and pops at the back, other workers steal from the front.
+typedef struct esdmI_workDeque_t {
+  GMutex mutex;
+  io_work_t **items;  //ring buffer
+  int64_t first, count, allocatedCount;
+} esdmI_workDeque_t;
+
+typedef struct esdmI_worker_t esdmI_worker_t;
+
 typedef struct esdm_scheduler_t {
   int info;
-  GThreadPool *thread_pool;
   GAsyncQueue *read_queue;
   GAsyncQueue *write_queue;
+
+  //The executor that is shared by all backends.
+  //Each worker either performs the I/O stage of a work item on a backend that has a free slot, or it executes CPU stages, stealing them from other workers when its own deque runs empty.
+  GMutex mutex; //protects the backends' pending queues and active thread counts, and all the fields below except for the deques
+  GCond workAvailable;
+  int64_t workerCount;
+  esdmI_worker_t *workers;
+  esdm_backend_t **backends;
+  int64_t backendCount, nextBackend; //`nextBackend` is where the round-robin search for I/O work starts
+  int64_t idleWorkers;
+  atomic_int pendingCpuTasks;
+  bool shutdown;
 } esdm_scheduler_t;
 
 typedef struct esdm_performance_t {
@@ -350,7 +501,6 @@ struct esdmI_range_t {
   int64_t start, end; //start is inclusive, end is exclusive, i.e. the range includes all `x` with `start <= x < end`
 };
 
-typedef struct esdmI_hypercube_t esdmI_hypercube_t;
 struct esdmI_hypercube_t {
   int64_t dims;
   esdmI_range_t ranges[];
@@ -452,6 +602,17 @@ struct esdmI_hypercubeNeighbourManager_t {
   esdmI_boundList_t* boundLists[];  //one esdmI_boundList_t per dimension
 };
 
+//An R-tree that maps hypercubes to arbitrary values, and finds all values whose hypercubes overlap a given region.
+//Used by esdm_fragments_t to avoid scanning all fragments of a dataset for each read.
+#define ESDMI_RTREE_MAX_ENTRIES 16
+#define ESDMI_RTREE_MIN_ENTRIES 6 //enforced by node splits and removals, bulk loading may leave the last node of each level with fewer entries
+typedef struct esdmI_rtreeNode_t esdmI_rtreeNode_t;
+struct esdmI_hypercubeRTree_t {
+  int64_t dims; //all hypercubes in the tree must be of the same rank
+  int64_t count;
+  esdmI_rtreeNode_t* root;  //NULL if the tree is empty
+};
+
 typedef struct esdm_readTimes_t esdm_readTimes_t;
 struct esdm_readTimes_t {
   double makeSet; //the time to determine the sets of fragments than need to be fetched from disk
@@ -488,9 +649,13 @@ struct esdm_backendTimes_t {
   double fragment_retrieve;
   double fragment_update;
   double fragment_delete;
+  double fragments_retrieve;
+  double fragments_update;
+  double fragment_retrieve_region;
   double fragment_metadata_create;
   double fragment_metadata_load;
   double fragment_metadata_free;
+  double fragment_metadata_committed;
   double mkfs;
   double fsck;
   double fragment_write_stream_blocksize;
@@ -76,6 +76,7 @@ typedef struct esdm_grid_t esdm_grid_t;
 typedef struct esdm_gridIterator_t esdm_gridIterator_t;
 typedef struct esdm_md_backend_callbacks_t esdm_md_backend_callbacks_t;
 typedef struct esdm_md_backend_t esdm_md_backend_t;
+typedef struct esdm_request_t esdm_request_t;
 
 //This needs to be public to allow creating simple dataspaces.
 struct esdm_dataspace_t {
@@ -10,6 +10,7 @@
 #include <jansson.h>
 #include <glib.h>
 #include <inttypes.h>
+#include <sys/uio.h>
 
 #include <esdm-datatypes-internal.h>
 #include <esdm-stream.h>
@@ -120,6 +121,28 @@ esdm_status esdm_scheduler_read_blocking(esdm_instance_t *esdm, esdm_dataset_t *
 
 esdm_status esdm_scheduler_write_blocking(esdm_instance_t *esdm, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *memspace, bool requestIsInternal);
 
+/**
+ * Submit a read/write request without waiting for the I/O to complete.
+ * The request object is initialized by these calls, and must be passed to `esdmI_scheduler_requestComplete()` exactly once, even if the submission failed.
+ * The buffer, the dataspace, and the dataset must be kept alive until the request is completed.
+ *
+ * @return the status of the submission, I/O errors are reported by `esdmI_scheduler_requestComplete()`
+ */
+esdm_status esdmI_scheduler_readNonblocking(esdm_instance_t *esdm, esdm_request_t *request, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *memspace, bool allowWriteback, bool requestIsInternal);
+esdm_status esdmI_scheduler_writeNonblocking(esdm_instance_t *esdm, esdm_request_t *request, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *memspace, bool requestIsInternal);
+
+/**
+ * Check whether all the background I/O of a request has finished, never blocks.
+ */
+bool esdmI_scheduler_requestTest(esdm_request_t *request);
+
+/**
+ * Wait for the request's I/O to complete, account its statistics, and release the resources held by the request object (but not the object itself).
+ *
+ * @param[out] out_fillRegion see `esdm_scheduler_read_blocking()`, must be NULL for write requests
+ */
+esdm_status esdmI_scheduler_requestComplete(esdm_request_t *request, esdmI_hypercubeSet_t** out_fillRegion);
+
 esdm_status esdmI_scheduler_writeFragmentBlocking(esdm_instance_t* esdm, esdm_fragment_t* fragment, bool requestIsInternal);
 void esdmI_scheduler_writeFragmentNonblocking(esdm_instance_t* esdm, esdm_fragment_t* fragment, bool requestIsInternal, io_request_status_t* status);
 
@@ -195,9 +218,13 @@ int esdmI_backend_fragment_create (esdm_backend_t * b, esdm_fragment_t *fragment
 int esdmI_backend_fragment_retrieve(esdm_backend_t * b, esdm_fragment_t *fragment);
 int esdmI_backend_fragment_update (esdm_backend_t * b, esdm_fragment_t *fragment);
 int esdmI_backend_fragment_delete (esdm_backend_t * b, esdm_fragment_t *fragment);
+void esdmI_backend_fragments_retrieve(esdm_backend_t * b, int64_t count, esdm_fragment_t **fragments, int *out_rets);
+void esdmI_backend_fragments_update(esdm_backend_t * b, int64_t count, esdm_fragment_t **fragments, int *out_rets);
+int esdmI_backend_fragment_retrieve_region(esdm_backend_t * b, esdm_fragment_t *fragment, int64_t count, esdmI_byteRange_t *ranges);
 int esdmI_backend_fragment_metadata_create(esdm_backend_t * b, esdm_fragment_t *fragment, smd_string_stream_t* stream);
 void* esdmI_backend_fragment_metadata_load(esdm_backend_t * b, esdm_fragment_t *fragment, json_t *metadata);
 int esdmI_backend_fragment_metadata_free (esdm_backend_t * b, void * options);
+void esdmI_backend_fragment_metadata_committed(esdm_backend_t * b, esdm_fragment_t *fragment);
 int esdmI_backend_mkfs(esdm_backend_t * b, int format_flags);
 int esdmI_backend_fsck(esdm_backend_t * b);
 int esdmI_backend_fragment_write_stream_blocksize(esdm_backend_t * b, estream_write_t * state, void * cur_buf, size_t cur_offset, uint32_t cur_size);
@@ -234,7 +261,65 @@ esdm_status esdmI_container_destroy(esdm_container_t *container);
 void esdm_dataset_init(esdm_container_t *container, const char *name, esdm_dataspace_t *dataspace, esdm_dataset_t **out_dataset);
 
 esdm_status esdm_dataset_open_md_load(esdm_dataset_t *dset, char ** out_md, int * out_size);
-esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size);
+esdm_status esdm_dataset_open_md_parse(esdm_dataset_t *d, char * md, int size);  //accepts both the JSON and the binary metadata format, with or without a journal
+esdm_status esdmI_dataset_metadata_parse(esdm_dataset_t *d, char *md, int size, bool journalEntry);  //parses a single snapshot or journal entry in either format, modifies `md`
+
+// Building blocks of the dataset metadata, shared by the JSON and the binary format.
+// The header is the opening part of the JSON object (attributes, type, shape, dimension names), the grids close the object.
+void esdmI_dataset_metadata_createHeader(esdm_dataset_t *d, smd_string_stream_t *s);
+void esdmI_dataset_metadata_createGrids(esdm_dataset_t *d, int64_t firstGrid, smd_string_stream_t *s);  //the complete grids starting at index `firstGrid`
+void esdmI_dataset_metadata_create(esdm_dataset_t *d, smd_string_stream_t *s);  //the complete JSON metadata
+void esdmI_dataset_metadata_createJournalEntry(esdm_dataset_t *d, smd_string_stream_t *s);  //JSON metadata with only the fragments and grids that were added since the last commit
+esdm_status esdmI_dataset_metadata_parseHeader(esdm_dataset_t *d, char *md, int size, json_t **out_root);  //modifies `md`, the caller must `json_decref()` the returned root object
+esdm_status esdmI_dataset_metadata_parseGrids(esdm_dataset_t *d, json_t *root, bool append);  //`append` adds the grids of a journal entry to the existing ones instead of replacing them
+esdm_status esdmI_dataset_addLoadedFragment(esdm_dataset_t *d, esdm_fragment_t *fragment);  //takes possession of the fragment, duplicates of known fragments are destroyed
+esdm_status esdmI_dataset_addFragment(esdm_dataset_t *d, esdm_fragment_t *fragment);  //like `esdmI_dataset_addLoadedFragment()`, but the fragment still needs to be committed
+void esdmI_dataset_extendActualSize(esdm_dataset_t *d, const int64_t *offset, const int64_t *size);  //grows the unlimited dimensions to include the given box
+void esdmI_dataset_unload(esdm_dataset_t *d);  //drops everything that has been loaded from the metadata backend, leaves the dataset in the state ESDM_DATA_NOT_LOADED
+esdm_status esdmI_dataset_loadFragments(esdm_dataset_t *d, esdmI_hypercube_t *region);  //makes sure that all fragments that may intersect `region` (all fragments if `region` is NULL) are in `d->fragments`, decoding pending binary pages and querying the fragment index of the metadata backend as needed
+
+// Binary metadata format (esdm-metadata-binary.c) //
+//
+// A versioned, position independent encoding of the dataset metadata that can be used directly from a memory mapped file.
+// It consists of a fixed header, a table of interned backend IDs, a table of fixed width fragment records, a string pool, and the JSON header/grid description.
+char* esdmI_dataset_metadata_createBinary(esdm_dataset_t *d, bool journalEntry, size_t *out_size);  //returns a `malloc()`ed buffer
+bool esdmI_metadata_isBinary(const char *md, size_t size);  //checks for the magic number of the binary format
+esdm_status esdmI_dataset_metadata_parseBinary(esdm_dataset_t *d, const char *md, size_t size, bool journalEntry);  //does not modify `md`, the fragments of a snapshot are only decoded by `esdmI_dataset_loadFragmentPages()`
+esdm_status esdmI_dataset_loadFragmentPages(esdm_dataset_t *d, esdmI_hypercube_t *region);  //decodes the pending fragments that may intersect `region`, or all pending fragments if `region` is NULL, concurrent callers wait until the decoding is done
+void esdmI_fragmentPages_destroy(esdmI_fragmentPages_t *pages);  //accepts NULL
+int64_t esdmI_fragmentPages_memorySize(esdmI_fragmentPages_t *pages);  //approximate number of bytes held by the pending pages, accepts NULL
+char* esdmI_dataset_metadata_createBinaryFragmentList(esdm_dataset_t *d, size_t *out_size);  //encodes only the uncommitted fragments, returns a `malloc()`ed buffer whose size is a multiple of 8 bytes
+esdm_status esdmI_dataset_metadata_parseBinaryFragmentList(esdm_dataset_t *d, const char *md, size_t size);  //adds the fragments of the list to `d` as uncommitted fragments, `md` must be 8 byte aligned
+esdm_status esdmI_dataset_metadata_parseShared(esdm_dataset_t *d, const char *md, int size, int64_t *users);  //like `esdm_dataset_open_md_parse()`, but the fragment pages of a binary snapshot reference `md` instead of copying it, `*users` counts those references, `md` must remain valid and unchanged while it is nonzero, a binary snapshot is parsed in place
+
+// Metadata journal (esdm-metadata-journal.c) //
+//
+// A commit may append only the changes since the last commit to the journal of a dataset instead of rewriting the snapshot.
+// The journal is a sequence of framed records, each of which holds a journal entry in either metadata format.
+// To load a dataset, the snapshot is wrapped into a record as well and prepended to the journal, the result is parsed by replaying the records in order.
+uint64_t esdmI_metadata_journal_snapshotId(const char *snapshot, size_t size);  //the ID that links the journal entries to the snapshot they were appended to
+char* esdmI_metadata_journal_createRecord(const char *md, size_t size, uint64_t snapshotId, size_t *out_size);  //returns a `malloc()`ed buffer
+char* esdmI_metadata_journal_bundle(const char *snapshot, size_t snapshotSize, const char *journal, size_t journalSize, size_t *out_size);  //returns a `malloc()`ed buffer
+bool esdmI_metadata_isJournal(const char *md, size_t size);  //checks for the magic number of a journal record
+esdm_status esdmI_dataset_metadata_replayJournal(esdm_dataset_t *d, char *md, size_t size);  //modifies `md`
+
+// Metadata cache (esdm-metadata-cache.c) //
+//
+// A process wide LRU cache with a memory budget (`/esdm/metadata/cache-size`), all functions accept a NULL cache, which disables caching.
+// It holds the metadata buffers as they were retrieved from the metadata backend, and datasets that have been closed but are kept parsed.
+// Entries are validated with the `container_version()`/`dataset_version()` callbacks of the metadata backend, if it provides them and validation is enabled.
+typedef esdm_status (*esdmI_metadataCache_loadContainer_func_t)(esdm_container_t *c, char **out_md, int *out_size);
+typedef esdm_status (*esdmI_metadataCache_loadDataset_func_t)(esdm_dataset_t *d, char **out_md, int *out_size);
+esdmI_metadataCache_t* esdmI_metadataCache_create(esdm_md_backend_t *backend);  //returns NULL if the cache is disabled in the configuration
+void esdmI_metadataCache_destroy(esdmI_metadataCache_t *cache);  //forgets the retained datasets without unloading them, they are destroyed along with their containers
+esdm_status esdmI_metadataCache_loadContainer(esdmI_metadataCache_t *cache, esdm_container_t *c, esdmI_metadataCache_loadContainer_func_t load, char **out_md, int *out_size);  //returns a `malloc()`ed copy of the cached buffer, or calls `load()` and caches its result
+esdm_status esdmI_metadataCache_loadDataset(esdmI_metadataCache_t *cache, esdm_dataset_t *d, esdmI_metadataCache_loadDataset_func_t load, char **out_md, int *out_size);  //returns a `malloc()`ed copy of the cached buffer, or calls `load()` and caches its result
+void esdmI_metadataCache_invalidateContainer(esdmI_metadataCache_t *cache, esdm_container_t *c);  //must be called when the metadata of the container is committed or removed
+void esdmI_metadataCache_invalidateDataset(esdmI_metadataCache_t *cache, esdm_dataset_t *d);  //must be called when the metadata of the dataset is committed or removed
+bool esdmI_metadataCache_retainDataset(esdmI_metadataCache_t *cache, esdm_dataset_t *d);  //keeps a dataset with a refcount of zero loaded, returns false if the caller needs to unload it itself
+void esdmI_metadataCache_releaseDataset(esdmI_metadataCache_t *cache, esdm_dataset_t *d, bool unload);  //takes a retained dataset out of the cache before it is referenced again, unloads it if `unload` is set or if it has been changed by another process
+void esdmI_metadataCache_forgetDataset(esdmI_metadataCache_t *cache, esdm_dataset_t *d);  //removes the dataset from the cache without unloading it, must be called before it is destroyed
+int64_t esdmI_metadataCache_usedBytes(esdmI_metadataCache_t *cache);
 
 esdm_status esdmI_dataset_fragmentsCoveringRegion(esdm_dataset_t* dataset, esdmI_hypercube_t* region, int64_t* out_count, esdm_fragment_t*** out_fragments, esdmI_hypercubeSet_t** out_uncovered, bool* out_fullyCovered);
 
@@ -302,6 +387,56 @@ esdm_status esdmI_dataspace_getExtends(esdm_dataspace_t* space, esdmI_hypercube_
  */
 esdm_status esdmI_dataspace_setExtends(esdm_dataspace_t* space, esdmI_hypercube_t* extends);
 
+/**
+ * Configure the parallelization of `esdm_dataspace_copy_data()`.
+ * Large copies are split into tiles which are processed by the calling thread and a process wide pool of helper threads.
+ *
+ * @param [in] threadCount the maximum number of threads that work on a single copy, including the calling thread; 1 disables parallel copying, 0 selects the number of available cores (the default)
+ * @param [in] minBytesPerThread copies are only parallelized as far as each thread gets at least this many bytes to move, smaller copies are performed serially
+ *
+ * `esdm_init()` calls this with the values of the "copy-threads" and "copy-min-bytes-per-thread" configuration parameters.
+ */
+void esdmI_dataspace_setCopyParallelism(int64_t threadCount, int64_t minBytesPerThread);
+
+//Like `esdm_dataspace_copy_data()`, but integer conversions that narrow the range clamp the values to the range of the destination type instead of wrapping around.
+//Used to copy the data of a read into the user's buffer.
+esdm_status esdmI_dataspace_copyDataSaturating(esdm_dataspace_t* sourceSpace, void *sourceData, esdm_dataspace_t* destSpace, void *destData);
+
+#define ESDMI_COPY_THREADS_DEFAULT 0
+#define ESDMI_COPY_MIN_BYTES_PER_THREAD_DEFAULT (4*1024*1024)
+
+#define ESDM_IOVEC_MIN_CHUNK_BYTES 4096 //strided data with smaller contiguous chunks is staged in a contiguous buffer instead of being transferred with vectored I/O
+
+/**
+ * Describe the memory of a dataspace as a list of contiguous chunks, in the order in which they appear in the serialized (contiguous C order) data.
+ * This allows a backend to transfer strided data with `preadv()`/`pwritev()` without staging it in a contiguous buffer.
+ *
+ * @param [in] space the dataspace that describes the layout of `buf`
+ * @param [in] buf the memory buffer
+ * @param [in] minChunkBytes the minimal size of a chunk
+ * @param [out] out_iov returns a `malloc()`'ed array of the chunks, which must be free'd by the caller, NULL if the dataspace is empty or on error
+ * @param [out] out_count returns the number of chunks
+ *
+ * @return ESDM_SUCCESS, or ESDM_ERROR if the chunks are smaller than `minChunkBytes` or cannot be visited in the serialization order (e.g. for transposed layouts)
+ */
+esdm_status esdmI_dataspace_makeIovecs(esdm_dataspace_t* space, void* buf, int64_t minChunkBytes, struct iovec** out_iov, int64_t* out_count);
+
+#define ESDM_REGION_READ_RANGE_OVERHEAD 4096 //the cost of reading one more byte range of a fragment, expressed in bytes (at least a page comes from the storage for each range)
+#define ESDM_REGION_READ_MAX_FRACTION 2 //a fragment is read in ranges only if that costs at most this fraction (1/n) of reading it in full
+
+/**
+ * Determine which byte ranges of a fragment's serialized data are needed to fill the overlap of the fragment with a memory buffer.
+ *
+ * @param [in] fragmentSpace the dataspace of the fragment, its data is serialized in contiguous C order
+ * @param [in] memspace the dataspace that describes the layout of `buf`
+ * @param [in] buf the memory buffer that receives the data
+ * @param [out] out_ranges returns a `malloc()`'ed array of the ranges in the order of the serialization, which must be free'd by the caller, NULL if there is no overlap or on error
+ * @param [out] out_count returns the number of ranges
+ *
+ * @return ESDM_SUCCESS, or ESDM_ERROR if the data types of the two dataspaces differ
+ */
+esdm_status esdmI_dataspace_makeByteRanges(esdm_dataspace_t* fragmentSpace, esdm_dataspace_t* memspace, void* buf, esdmI_byteRange_t** out_ranges, int64_t* out_count);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Fragment ///////////////////////////////////////////////////////////////////
@@ -309,15 +444,26 @@ esdm_status esdmI_dataspace_setExtends(esdm_dataspace_t* space, esdmI_hypercube_
 
 void esdmI_fragments_construct(esdm_fragments_t* me);
 esdm_status esdmI_fragments_add(esdm_fragments_t* me, esdm_fragment_t* fragment) __attribute__((warn_unused_result));  //takes possession of the fragment, eventually calling `esdm_fragment_destroy()` on it when the `esdm_fragments_t` object is destructed
+esdm_status esdmI_fragments_addLoaded(esdm_fragments_t* me, esdm_fragment_t* fragment) __attribute__((warn_unused_result));  //like `esdmI_fragments_add()`, but for fragments that are already part of the persistent metadata
 esdm_fragment_t* esdmI_fragments_lookupForShape(esdm_fragments_t* me, esdmI_hypercube_t* shape);
 esdm_status esdmI_fragments_deleteAll(esdm_fragments_t* me);  //calls `esdmI_backend_fragment_delete()` and `esdmI_fragment_destroy()` on all fragments, leaving the fragment list empty on success
 esdm_fragment_t** esdmI_fragments_makeSetCoveringRegion(esdm_fragments_t* me, esdmI_hypercube_t* region, int64_t* out_fragmentCount);  //caller is responsible to free the returned array
 void esdmI_fragments_metadata_create(esdm_fragments_t* me, smd_string_stream_t* s);
+void esdmI_fragments_metadata_createUncommitted(esdm_fragments_t* me, smd_string_stream_t* s);  //only the fragments that were added since the last `esdmI_fragments_markCommitted()`
+void esdmI_fragments_markCommitted(esdm_fragments_t* me);
+void esdmI_fragments_snapshotCommitted(esdm_fragments_t* me);  //calls the `fragment_metadata_committed()` callback of the backends for all fragments, after a snapshot with their current locations has been committed
 void esdmI_fragments_purge(esdm_fragments_t* me); //this will `esdm_fragment_destroy()` all currently stored fragments
 esdm_status esdmI_fragments_destruct(esdm_fragments_t* me);  //calls `esdm_fragment_destroy()` on its members, but does not invoke the `fragment_delete()` callback of the backend
 
+//Like `esdm_fragment_load()`/`esdm_fragment_commit()` for each of the fragments, which must all reside on the same backend.
+//The backend's `fragments_retrieve()`/`fragments_update()` callback is used to handle them together if it has one.
+void esdmI_fragment_loadBatch(int64_t count, esdm_fragment_t **fragments, esdm_status *out_rets);
+void esdmI_fragment_commitBatch(int64_t count, esdm_fragment_t **fragments, esdm_status *out_rets);
+
 void esdm_fragment_metadata_create(esdm_fragment_t *f, smd_string_stream_t * stream);
 esdm_status esdmI_create_fragment_from_metadata(esdm_dataset_t *dset, json_t * json, esdm_fragment_t ** out);
+//Takes possession of `space`. Returns the existing fragment if the dataset already has one with the same shape.
+esdm_status esdmI_fragment_createFromParts(esdm_dataset_t *dset, const char *id, esdm_backend_t *backend, int64_t actualBytes, esdm_dataspace_t *space, json_t *backendMetadata, esdm_fragment_t **out_fragment);
 
 /**
  * Create a new fragment.
@@ -433,6 +579,12 @@ void* ea_checked_malloc(size_t size) __attribute__((alloc_size(1), malloc));
  */
 void* ea_checked_calloc(size_t nmemb, size_t size) __attribute__((alloc_size(1, 2), malloc));
 
+/**
+ * Wrapper for posix_memalign() that aborts on failure.
+ * The result must be free'd with free().
+ */
+void* ea_checked_memalign(size_t alignment, size_t size) __attribute__((alloc_size(2), malloc));
+
 /**
  * Wrapper for realloc() that checks the result for a null-pointer.
  */
@@ -488,6 +640,13 @@ typedef void* (*ea_datatype_converter)(void* dest, const void* source, size_t so
  */
 ea_datatype_converter ea_converter_for_types(esdm_type_t destType, esdm_type_t sourceType);
 
+/**
+ * Like `ea_converter_for_types()`, but values that cannot be represented in destType are clamped to the nearest representable value instead of wrapping around.
+ * NaNs are converted to zero when the destination is an integer type, and conversions to `float` or `double` behave exactly like the C cast.
+ * This avoids the UB of the out-of-range float/double to integer conversions.
+ */
+ea_datatype_converter ea_saturating_converter_for_types(esdm_type_t destType, esdm_type_t sourceType);
+
 ///////////////////////////////////////////////////////////////////////////////
 // esdmI_range_t //////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -586,6 +745,7 @@ bool esdmI_hypercubeList_doesCoverFully(esdmI_hypercubeList_t* list, esdmI_hyper
  * The returned value may be lower than the given value because a subset may be found several times.
  *
  * The probabilistic algorithm is written in such a way that it will find small minimal subsets more easily than subsets that contain more cubes.
+ * The pseudo-random sequence is seeded anew for each call, so the same list always yields the same subsets.
  *
  * The complexity of the algorithm is `O(*inout_setCount * list->count^2)`.
  *
@@ -622,6 +782,11 @@ void esdmI_hypercubeSet_add(esdmI_hypercubeSet_t* me, esdmI_hypercube_t* cube);
 
 void esdmI_hypercubeSet_subtract(esdmI_hypercubeSet_t* me, esdmI_hypercube_t* cube);
 
+//Same result as calling esdmI_hypercubeSet_subtract() for each cube in the list, but computed in a single sweep per cube in the set.
+//This scales much better for many subtrahends, as the set does not need to be split and rescanned for every one of them.
+//NULL entries in the list are ignored.
+void esdmI_hypercubeSet_subtractList(esdmI_hypercubeSet_t* me, esdmI_hypercubeList_t* subtrahends);
+
 void esdmI_hypercubeSet_destruct(esdmI_hypercubeSet_t* me); //counterpart to esdmI_hypercubeSet_construct()
 void esdmI_hypercubeSet_destroy(esdmI_hypercubeSet_t* me);  //counterpart to esdmI_hypercubeSet_make()
 
@@ -643,6 +808,31 @@ int64_t* esdmI_hypercubeNeighbourManager_getNeighbours(esdmI_hypercubeNeighbourM
 
 void esdmI_hypercubeNeighbourManager_destroy(esdmI_hypercubeNeighbourManager_t* me);
 
+///////////////////////////////////////////////////////////////////////////////
+// esdmI_hypercubeRTree_t /////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+esdmI_hypercubeRTree_t* esdmI_hypercubeRTree_make(int64_t dimensions);  //all hypercubes added to this tree need to have the same rank
+
+int64_t esdmI_hypercubeRTree_count(esdmI_hypercubeRTree_t* me);
+
+//The tree does not take possession of the cube, it only copies its bounds. The value is returned by the queries that match the cube.
+void esdmI_hypercubeRTree_insert(esdmI_hypercubeRTree_t* me, esdmI_hypercube_t* cube, void* value);
+
+//Same as calling esdmI_hypercubeRTree_insert() for each cube/value pair,
+//but builds a much better tree in O(n*log(n)) when the tree is still empty.
+void esdmI_hypercubeRTree_bulkLoad(esdmI_hypercubeRTree_t* me, int64_t count, esdmI_hypercube_t** cubes, void** values);
+
+//Removes the entry with the given value and bounds, returns false if the tree has no such entry.
+bool esdmI_hypercubeRTree_remove(esdmI_hypercubeRTree_t* me, esdmI_hypercube_t* cube, void* value);
+
+//Returns a newly allocated array with the values of all cubes that overlap the region, in no particular order.
+//The caller is responsible to free the array.
+void** esdmI_hypercubeRTree_query(esdmI_hypercubeRTree_t* me, esdmI_hypercube_t* region, int64_t* out_count);
+
+void esdmI_hypercubeRTree_clear(esdmI_hypercubeRTree_t* me); //removes all entries
+void esdmI_hypercubeRTree_destroy(esdmI_hypercubeRTree_t* me);
+
 #ifdef HAVE_SCIL
 SCIL_Datatype_t ea_esdm_datatype_to_scil(smd_basic_type_t type);
 #endif
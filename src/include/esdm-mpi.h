@@ -34,6 +34,44 @@ esdm_status esdm_mpi_dataset_open(MPI_Comm com, esdm_container_t *container, con
 esdm_status esdm_mpi_dataset_ref(MPI_Comm com, esdm_dataset_t * d);
 esdm_status esdm_mpi_dataset_commit(MPI_Comm com, esdm_dataset_t *dataset);
 
+/**
+ * esdm_mpi_write_all()
+ *
+ * Collectively write one hyperslab per process, aggregating the hyperslabs of each node into large fragments.
+ *
+ * The first process on each node gathers the data of the other processes on its node, merges neighbouring hyperslabs into larger boxes, and writes those.
+ * This avoids the many small fragments and metadata entries that result from every process writing its own small subdomain with `esdm_write()`.
+ * If the hyperslabs of a node overlap, or their data exceeds 2 GiB, each process writes its own hyperslab instead.
+ * The fragments only become persistent with a subsequent `esdm_mpi_dataset_commit()`.
+ *
+ * @param com the MPI communicator that defines the process set, all processes must use the same datatype in `memspace`
+ * @param dataset the dataset that is to be written, these must be the results of a single collective `esdm_mpi_dataset_create()` or `esdm_mpi_dataset_open()` call
+ * @param buf the data of this process, may be NULL if `memspace` is empty
+ * @param memspace the hyperslab of this process and the layout of `buf`, as for `esdm_write()`
+ *
+ * @return a status code, an error is returned on all processes if any of the writes failed
+ */
+esdm_status esdm_mpi_write_all(MPI_Comm com, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *memspace);
+
+/**
+ * esdm_mpi_read_all()
+ *
+ * Collectively read one hyperslab per process, reading each required fragment only once.
+ *
+ * Rank 0 selects the fragments that cover the requested regions, so that all processes agree on them even if they have different fragments in memory.
+ * These fragments are distributed among the processes that need them.
+ * Each fragment is read by its owner, which sends the relevant parts to all processes that requested them.
+ * If the requested data contains holes, each process reads its own hyperslab with `esdm_read()` instead, so that the fill value is applied.
+ *
+ * @param com the MPI communicator that defines the process set, all processes must use the same datatype in `memspace`
+ * @param dataset the dataset that is to be read, these must be the results of a single collective `esdm_mpi_dataset_open()` call
+ * @param buf the buffer of this process, may be NULL if `memspace` is empty
+ * @param memspace the hyperslab of this process and the layout of `buf`, as for `esdm_read()`
+ *
+ * @return a status code, an error is returned on all processes if any of the reads failed
+ */
+esdm_status esdm_mpi_read_all(MPI_Comm com, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *memspace);
+
 /**
  * esdm_mpi_grid_bcast()
  *
@@ -8,6 +8,7 @@
 extern "C" {
 #endif
 
+struct iovec;
 typedef struct esdm_wstream_metadata_t esdm_wstream_metadata_t;
 
 #define defineStreamType(streamType, elementType) typedef struct streamType { \
@@ -175,6 +176,14 @@ bool estream_mem_unpack_fragment_param(esdm_fragment_t *f, void ** out_buf, size
  */
 int estream_mem_unpack_fragment(esdm_fragment_t *f, void * rbuff, size_t size);
 
+/*
+ * Avoid packing/unpacking a strided fragment by transferring it with vectored I/O
+ *
+ * Returns true if the serialized data of the fragment is just its uncompressed elements, and `*out_iov` receives a malloc'ed list of the chunks of f->buf in serialization order, which the backend can transfer with preadv()/pwritev() instead.
+ * Returns false if the fragment is contiguous, compressed, or has chunks smaller than minChunkBytes.
+ */
+bool estream_mem_iovec_fragment(esdm_fragment_t *f, int64_t minChunkBytes, struct iovec ** out_iov, int64_t * out_count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -113,6 +113,72 @@ esdm_status esdm_read(esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subs
  */
 //esdm_status esdm_read_so(esdm_dataset_t *dataset, void *buf, int64_t *size, int64_t *offset);
 
+/**
+ * Start writing data without waiting for the write to complete.
+ *
+ * The contents of `buf` must not be modified, and `dataset` must not be closed before the request has been completed with `esdm_wait()`, `esdm_waitall()`, or `esdm_test()`.
+ * The dataspace is copied, it may be destroyed right after this call returns.
+ *
+ * @param [in] dataset the dataset to write to
+ * @param [in] buf the pointer to a contiguous memory region that shall be written to permanent storage
+ * @param [in] subspace an existing dataspace that describes the shape and location of the hypercube that is to be written
+ * @param [out] out_request returns a request handle that must be completed by the caller, set to NULL if the request could not be started
+ *
+ * @return status
+ */
+
+esdm_status esdm_iwrite(esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, esdm_request_t **out_request);
+
+/**
+ * Start reading data without waiting for the read to complete.
+ *
+ * The contents of `buf` are undefined until the request has been completed with `esdm_wait()`, `esdm_waitall()`, or `esdm_test()`,
+ * and `dataset` must not be closed before that.
+ * The dataspace is copied, it may be destroyed right after this call returns.
+ *
+ * @param [in] dataset the dataset to read from
+ * @param [out] buf a contiguous memory region that shall be filled with the data from permanent storage
+ * @param [in] subspace an existing dataspace that describes the shape and location of the hypercube that is to be read
+ * @param [out] out_request returns a request handle that must be completed by the caller, set to NULL if the request could not be started
+ *
+ * @return status, errors that are detected before any I/O is started (like `ESDM_INCOMPLETE_DATA`) are returned directly
+ */
+
+esdm_status esdm_iread(esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *subspace, esdm_request_t **out_request);
+
+/**
+ * Wait for a request started by `esdm_iwrite()` or `esdm_iread()` to complete, and release it.
+ *
+ * @param [in,out] request the request to complete, set to NULL on return; passing a pointer to NULL is a no-op
+ *
+ * @return the status of the I/O operation
+ */
+
+esdm_status esdm_wait(esdm_request_t **request);
+
+/**
+ * Check whether a request has completed without blocking.
+ * If it has, the request is released as with `esdm_wait()`.
+ *
+ * @param [in,out] request the request to check, set to NULL if it has completed
+ * @param [out] out_done returns 1 if the request has completed, 0 otherwise
+ *
+ * @return the status of the I/O operation if it has completed, ESDM_SUCCESS otherwise
+ */
+
+esdm_status esdm_test(esdm_request_t **request, int *out_done);
+
+/**
+ * Wait for all the given requests to complete, and release them.
+ *
+ * @param [in] count the number of entries in `requests`
+ * @param [in,out] requests an array of requests, entries may be NULL, all entries are set to NULL on return
+ *
+ * @return ESDM_SUCCESS if all requests succeeded, otherwise the status of the first request that failed
+ */
+
+esdm_status esdm_waitall(int64_t count, esdm_request_t **requests);
+
 
 /**
  * This function performs the operation on the data while is streamed in.
@@ -417,6 +483,16 @@ esdm_status esdm_dataset_ref(esdm_dataset_t *dataset);
  */
 esdm_status esdm_dataset_commit(esdm_dataset_t *dataset);
 
+/**
+ * Write a new snapshot of the dataset metadata, replacing the snapshot and the journal that have been written so far.
+ * This is only useful when the metadata backend is configured to use a journal, other commits always write a snapshot.
+ *
+ * @param [in] dataset pointer to an existing, open dataset
+ *
+ * @return status
+ */
+esdm_status esdm_dataset_compact(esdm_dataset_t *dataset);
+
 /**
  * Close a dataset object, if it isn't used anymore, it's metadata will be unloaded
  *
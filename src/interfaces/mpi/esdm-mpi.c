@@ -5,6 +5,12 @@
 #include <esdm-internal.h>
 
 
+__attribute__((noreturn))
+void panic(const char* operation) {
+  fprintf(stderr, "failed %s, aborting...\n", operation);
+  abort();
+}
+
 static void check_hash_abort(MPI_Comm com, int hash, int rank){
   int ret;
   int vals[] = {hash, -hash};
@@ -23,11 +29,16 @@ static void check_hash_abort(MPI_Comm com, int hash, int rank){
   }
 }
 
-int esdm_mpi_get_tasks_per_node() {
+//Returns a communicator with the processes of `com` that run on the same node as this process, the caller must `MPI_Comm_free()` it.
+static MPI_Comm node_comm(MPI_Comm com) {
   MPI_Comm shared_comm;
-  int count = 1;
+  if(MPI_SUCCESS != MPI_Comm_split_type(com, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &shared_comm)) panic("MPI_Comm_split_type");
+  return shared_comm;
+}
 
-  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &shared_comm);
+int esdm_mpi_get_tasks_per_node() {
+  MPI_Comm shared_comm = node_comm(MPI_COMM_WORLD);
+  int count = 1;
   MPI_Comm_size(shared_comm, &count);
   MPI_Comm_free(&shared_comm);
 
@@ -91,8 +102,11 @@ esdm_status esdm_mpi_init() {
 
 
 
+static void shared_metadata_free_all();
+
 void esdm_mpi_finalize(){
   esdm_finalize();
+  shared_metadata_free_all();
 }
 
 
@@ -230,14 +244,113 @@ esdm_status esdm_mpi_dataset_create(MPI_Comm com, esdm_container_t *c, const cha
   }
 }
 
+// Shared metadata //////////////////////////////////////////////////////////////
+//
+// With the "mpi-shared" option of the metadata backend, the metadata of a dataset is only broadcast to one process per node, which places it in a shared memory window.
+// All processes of the node parse it from there. Since the fragment pages of the binary format reference the window instead of copying it,
+// and fragments are only decoded when they are accessed, the node holds a single copy of the fragment table instead of one per process.
+// A window is freed once no process of its node references it anymore, which is checked collectively by the next load over the same communicator, and by `esdm_mpi_finalize()`.
+
+typedef struct sharedMetadata_t {
+  struct sharedMetadata_t* next;
+  MPI_Comm com;  //the communicator of the `esdm_mpi_dataset_ref()` call that created the window
+  MPI_Comm node;
+  MPI_Win win;
+  int64_t users;  //fragment pages of this process that reference the window
+} sharedMetadata_t;
+
+static sharedMetadata_t* gSharedMetadata = NULL;  //all processes create and free the windows in the same order
+
+static void shared_metadata_free(sharedMetadata_t** link) {
+  sharedMetadata_t* entry = *link;
+  *link = entry->next;
+  if(MPI_SUCCESS != MPI_Win_free(&entry->win)) panic("MPI_Win_free");
+  MPI_Comm_free(&entry->node);
+  free(entry);
+}
+
+//Frees the windows of `com` that are not referenced by any process of their node anymore, must be called collectively.
+static void shared_metadata_sweep(MPI_Comm com) {
+  for(sharedMetadata_t** link = &gSharedMetadata; *link; ) {
+    if((*link)->com != com) {
+      link = &(*link)->next;
+      continue;
+    }
+    int unused = !(*link)->users, allUnused;
+    if(MPI_SUCCESS != MPI_Allreduce(&unused, &allUnused, 1, MPI_INT, MPI_MIN, (*link)->node)) panic("MPI_Allreduce");
+    if(allUnused) {
+      shared_metadata_free(link);
+    } else {
+      link = &(*link)->next;
+    }
+  }
+}
+
+//Called after `esdm_finalize()`, when no dataset references the windows anymore.
+static void shared_metadata_free_all() {
+  while(gSharedMetadata) shared_metadata_free(&gSharedMetadata);
+}
+
+static esdm_status dataset_ref_shared(MPI_Comm com, esdm_dataset_t * d){
+  shared_metadata_sweep(com);
+
+  int rank, nodeRank;
+  if(MPI_SUCCESS != MPI_Comm_rank(com, &rank)) panic("MPI_Comm_rank");
+  MPI_Comm node = node_comm(com);
+  if(MPI_SUCCESS != MPI_Comm_rank(node, &nodeRank)) panic("MPI_Comm_rank");
+  MPI_Comm leaders;
+  if(MPI_SUCCESS != MPI_Comm_split(com, nodeRank ? MPI_UNDEFINED : 0, rank, &leaders)) panic("MPI_Comm_split");
+
+  // rank 0 loads the metadata, the broadcasted size tells everybody whether that worked
+  char * buff = NULL;
+  int size = 0;
+  if(!rank && esdm_dataset_open_md_load(d, &buff, &size) != ESDM_SUCCESS) size = -1;
+  if(MPI_SUCCESS != MPI_Bcast(&size, 1, MPI_INT, 0, com)) panic("MPI_Bcast");
+  if(size < 0){
+    if(leaders != MPI_COMM_NULL) MPI_Comm_free(&leaders);
+    MPI_Comm_free(&node);
+    return ESDM_ERROR;
+  }
+
+  // the leaders receive the metadata, including the string terminator, directly into the shared memory of their node
+  sharedMetadata_t* entry = ea_checked_calloc(1, sizeof(*entry));
+  entry->com = com;
+  entry->node = node;
+  char * shared;
+  if(MPI_SUCCESS != MPI_Win_allocate_shared(nodeRank ? 0 : size + 1, 1, MPI_INFO_NULL, node, &shared, &entry->win)) panic("MPI_Win_allocate_shared");
+  if(nodeRank){
+    MPI_Aint sharedSize;
+    int dispUnit;
+    if(MPI_SUCCESS != MPI_Win_shared_query(entry->win, 0, &sharedSize, &dispUnit, &shared)) panic("MPI_Win_shared_query");
+  }else{
+    if(!rank) memcpy(shared, buff, size + 1);
+    if(MPI_SUCCESS != MPI_Bcast(shared, size + 1, MPI_CHAR, 0, leaders)) panic("MPI_Bcast");
+    MPI_Comm_free(&leaders);
+  }
+  free(buff);
+  if(MPI_SUCCESS != MPI_Win_fence(0, entry->win)) panic("MPI_Win_fence");  //makes the data of the leader visible to the other processes of the node
+  entry->next = gSharedMetadata;
+  gSharedMetadata = entry;
+
+  return esdmI_dataset_metadata_parseShared(d, shared, size, &entry->users);
+}
+
 esdm_status esdm_mpi_dataset_ref(MPI_Comm com, esdm_dataset_t * d){
   ESDM_DEBUG(__func__);
   assert(d);
+  //the ranks may disagree on whether a retained dataset is still current, so it is always reloaded collectively
+  if(d->status != ESDM_DATA_NOT_LOADED && !d->refcount) esdmI_metadataCache_releaseDataset(esdm_get_modules()->metadata_cache, d, true);
   if(d->status != ESDM_DATA_NOT_LOADED){
     d->refcount++;
     return ESDM_SUCCESS;
   }
 
+  if(esdm_get_modules()->metadata_backend->config->metadata_mpi_shared){
+    esdm_status ret = dataset_ref_shared(com, d);
+    if(ret == ESDM_SUCCESS) d->refcount++;
+    return ret;
+  }
+
   char * buff;
   int size;
   int rank;
@@ -271,7 +384,7 @@ esdm_status esdm_mpi_dataset_ref(MPI_Comm com, esdm_dataset_t * d){
     ret = MPI_Bcast(buff, size, MPI_CHAR, 0, com);
     eassert(ret == MPI_SUCCESS);
   }
-  ret = esdm_dataset_open_md_parse(d, buff, size);
+  ret = esdm_dataset_open_md_parse(d, buff, size - 1); //the terminator is not part of the metadata
   if(ret != ESDM_SUCCESS){
     return ret;
   }
@@ -297,74 +410,511 @@ esdm_status esdm_mpi_dataset_open(MPI_Comm com, esdm_container_t *c, const char
   return ESDM_ERROR;
 }
 
+// Collective dataset commit ///////////////////////////////////////////////////
+//
+// The uncommitted fragments of all processes are collected at rank 0 along a binomial tree:
+// Each process receives the batches of its children, appends them to its own fragment list, and forwards the result to its parent.
+// So, rank 0 only receives log2(procCount) messages, and no process waits for more than log2(procCount) others.
+// A batch is a sequence of 8 byte aligned entries, each of which is a uint64_t size followed by a binary fragment list of that size.
+
+enum { kCommitTag = 4711 };
+
+typedef struct fragmentBatch_t {
+  char* data;
+  uint64_t size, allocatedSize;
+} fragmentBatch_t;
+
+static void fragmentBatch_append(fragmentBatch_t* me, const void* data, uint64_t size) {
+  if(me->size + size > me->allocatedSize) {
+    me->allocatedSize = 2*(me->size + size);
+    me->data = ea_checked_realloc(me->data, me->allocatedSize);
+  }
+  memcpy(me->data + me->size, data, size);
+  me->size += size;
+}
+
+//MPI counts are `int`, so the size is sent first, and large buffers are split into several messages.
+static int sendBuffer(MPI_Comm com, int dest, const char* buff, uint64_t size) {
+  int ret = MPI_Send(&size, 1, MPI_UINT64_T, dest, kCommitTag, com);
+  for(uint64_t done = 0; ret == MPI_SUCCESS && done < size; ) {
+    int count = size - done > INT_MAX ? INT_MAX : size - done;
+    ret = MPI_Send(buff + done, count, MPI_BYTE, dest, kCommitTag, com);
+    done += count;
+  }
+  return ret;
+}
+
+static int recvBuffer(MPI_Comm com, int source, char** out_buff, uint64_t* out_size) {
+  uint64_t size;
+  int ret = MPI_Recv(&size, 1, MPI_UINT64_T, source, kCommitTag, com, MPI_STATUS_IGNORE);
+  if(ret != MPI_SUCCESS) return ret;
+  char* buff = ea_checked_malloc(size ? size : 1);
+  for(uint64_t done = 0; ret == MPI_SUCCESS && done < size; ) {
+    int count = size - done > INT_MAX ? INT_MAX : size - done;
+    ret = MPI_Recv(buff + done, count, MPI_BYTE, source, kCommitTag, com, MPI_STATUS_IGNORE);
+    done += count;
+  }
+  *out_buff = buff;
+  *out_size = size;
+  return ret;
+}
+
+//Adds the fragments of all entries of a batch to the dataset.
+static esdm_status parseBatch(esdm_dataset_t *d, const char* batch, uint64_t size) {
+  uint64_t position = 0;
+  while(position < size) {
+    uint64_t entrySize;
+    if(size - position < sizeof(entrySize)) return ESDM_INVALID_DATA_ERROR;
+    memcpy(&entrySize, batch + position, sizeof(entrySize));
+    position += sizeof(entrySize);
+    if(entrySize > size - position || entrySize & 7) return ESDM_INVALID_DATA_ERROR;
+    esdm_status ret = esdmI_dataset_metadata_parseBinaryFragmentList(d, batch + position, entrySize);
+    if(ret != ESDM_SUCCESS) return ret;
+    position += entrySize;
+  }
+  return ESDM_SUCCESS;
+}
+
 esdm_status esdm_mpi_dataset_commit(MPI_Comm com, esdm_dataset_t *d){
-  esdm_status ret;
-  int rank;
-  ret = MPI_Comm_rank(com, & rank);
+  esdm_status ret = ESDM_SUCCESS;
+  int rank, procCount;
+  if(MPI_SUCCESS != MPI_Comm_rank(com, &rank)) return ESDM_ERROR;
+  if(MPI_SUCCESS != MPI_Comm_size(com, &procCount)) return ESDM_ERROR;
 
-  // retrieve for all fragments the metadata and attach it to the metadata
-  if(rank == 0){
-    int procCount;
-    ret = MPI_Comm_size(com, & procCount);
-    int max_len = 10000000;
-    char * buff = ea_checked_malloc(max_len);
-    for(int p = 1 ; p < procCount; p++){
-      int size = max_len;
-      MPI_Status mstatus;
-      ret = MPI_Recv(buff, size, MPI_CHAR, MPI_ANY_SOURCE, 4711, com, & mstatus);
-      eassert(ret == MPI_SUCCESS);
-      int recvd_bytes = 0;
-      ret = MPI_Get_count(& mstatus, MPI_CHAR, & recvd_bytes);
-      eassert(ret == MPI_SUCCESS);
-      if (buff[0] != '[' || buff[recvd_bytes-2] != ']' || buff[recvd_bytes -1] != 0){
-        ESDM_ERROR_FMT("Buffer appears to be corrupted (%d bytes) \"%s\"\n", recvd_bytes, buff);
+  // the fragments of earlier commits are already known to rank 0, so only the uncommitted ones are sent
+  fragmentBatch_t batch = {0};
+  if(rank){
+    size_t size;
+    char* list = esdmI_dataset_metadata_createBinaryFragmentList(d, &size);
+    uint64_t entrySize = size;
+    fragmentBatch_append(&batch, &entrySize, sizeof(entrySize));
+    fragmentBatch_append(&batch, list, size);
+    free(list);
+  }
+
+  // receive from the children in the binomial tree, then forward everything to the parent
+  int mask = 1;
+  for(; mask < procCount && !(rank & mask); mask <<= 1){
+    if(rank + mask >= procCount) continue;
+    char* childBatch;
+    uint64_t childSize;
+    if(MPI_SUCCESS != recvBuffer(com, rank + mask, &childBatch, &childSize)) panic("MPI_Recv");
+    if(rank){
+      fragmentBatch_append(&batch, childBatch, childSize);
+    }else if(ret == ESDM_SUCCESS){
+      // rank 0 merges the fragments right away, so that it never holds more than one batch
+      ret = parseBatch(d, childBatch, childSize);
+      if(ret != ESDM_SUCCESS) ESDM_LOG_FMT(ESDM_LOGLEVEL_ERROR, "received invalid fragment metadata from rank %d", rank + mask);
+    }
+    free(childBatch);
+  }
+  if(rank){
+    if(MPI_SUCCESS != sendBuffer(com, rank - mask, batch.data, batch.size)) panic("MPI_Send");
+  }else if(ret == ESDM_SUCCESS){
+    ret = esdm_dataset_commit(d);
+  }
+  free(batch.data);
+
+  // the fragments only count as committed once rank 0 has reported that its commit succeeded, otherwise they are sent again with the next commit
+  if(MPI_SUCCESS != MPI_Bcast(&ret, 1, MPI_INT, 0, com)) panic("MPI_Bcast");
+  if(rank && ret == ESDM_SUCCESS) esdmI_fragments_markCommitted(&d->fragments);
+  return ret;
+}
+
+
+// Collective write /////////////////////////////////////////////////////////////
+//
+// Many small hyperslabs are written as a few large ones:
+// The first process on each node acts as the aggregator, it gathers the hyperslabs of the other processes on its node,
+// merges neighbouring hyperslabs into larger boxes, and writes each box with a single `esdm_write()`, which splits it into fragments of the configured `max_fragment_size`.
+// The shape of a hyperslab is exchanged as `dims` offsets, `dims` sizes, and the size of the data in bytes.
+
+//Checks whether two boxes share any element.
+static bool boxes_intersect(int64_t dims, const int64_t* a, const int64_t* b) {
+  for(int64_t i = 0; i < dims; i++) {
+    if(a[i] >= b[i] + b[dims + i] || b[i] >= a[i] + a[dims + i]) return false;
+  }
+  return true;
+}
+
+//Two boxes can be merged into one if they have the same extent in all dimensions but one, and touch in the remaining dimension.
+static bool boxes_merge(int64_t dims, int64_t* a, const int64_t* b) {
+  int64_t mergeDim = -1;
+  for(int64_t i = 0; i < dims; i++) {
+    if(a[i] == b[i] && a[dims + i] == b[dims + i]) continue;
+    if(mergeDim >= 0) return false;
+    if(a[i] + a[dims + i] != b[i] && b[i] + b[dims + i] != a[i]) return false;
+    mergeDim = i;
+  }
+  if(mergeDim < 0) return false;  //identical boxes overlap, they are never merged
+  int64_t end = a[mergeDim] + a[dims + mergeDim] > b[mergeDim] + b[dims + mergeDim] ? a[mergeDim] + a[dims + mergeDim] : b[mergeDim] + b[dims + mergeDim];
+  if(b[mergeDim] < a[mergeDim]) a[mergeDim] = b[mergeDim];
+  a[dims + mergeDim] = end - a[mergeDim];
+  return true;
+}
+
+//Merges the non-empty pieces into as few boxes as possible, which must not overlap.
+//Each piece ends up in exactly one region, `regionOf` receives the index of that region or -1 for empty pieces.
+//Returns the number of regions, which are stored at the start of the `regions` array.
+static int merge_regions(int64_t dims, int pieceCount, const int64_t* pieces, int64_t* regions, int* regionOf) {
+  int64_t shapeLen = 2*dims + 1;
+  bool* alive = ea_checked_calloc(pieceCount ? pieceCount : 1, sizeof(*alive));
+  for(int i = 0; i < pieceCount; i++) {
+    memcpy(regions + i*2*dims, pieces + i*shapeLen, 2*dims*sizeof(*regions));
+    alive[i] = pieces[i*shapeLen + 2*dims] > 0;
+    regionOf[i] = alive[i] ? i : -1;
+  }
+  for(bool changed = true; changed; ) {
+    changed = false;
+    for(int i = 0; i < pieceCount; i++) {
+      if(!alive[i]) continue;
+      for(int j = i + 1; j < pieceCount; j++) {
+        if(!alive[j] || !boxes_merge(dims, regions + i*2*dims, regions + j*2*dims)) continue;
+        alive[j] = false;
+        for(int k = 0; k < pieceCount; k++) if(regionOf[k] == j) regionOf[k] = i;
+        changed = true;
       }
+    }
+  }
 
-      json_t * elem = load_json(buff);
-      int json_frags = json_array_size(elem);
+  //compact the surviving regions
+  int regionCount = 0;
+  for(int i = 0; i < pieceCount; i++) {
+    if(!alive[i]) continue;
+    memmove(regions + regionCount*2*dims, regions + i*2*dims, 2*dims*sizeof(*regions));
+    for(int k = 0; k < pieceCount; k++) if(regionOf[k] == i) regionOf[k] = regionCount;
+    regionCount++;
+  }
+  free(alive);
+  return regionCount;
+}
 
-      for (int i = 0; i < json_frags; i++) {
-        esdm_fragment_t * fragment;
-        json_t * frag_elem = json_array_get(elem, i);
-        ret = esdmI_create_fragment_from_metadata(d, frag_elem, & fragment);
-        if (ret != ESDM_SUCCESS){
-          MPI_Abort(com, 1);
-        }
-        ret = esdmI_fragments_add(&d->fragments, fragment);
-        if(ret == ESDM_INVALID_STATE_ERROR) {
-          //this happens when there is already a fragment with the exact same shape -> we don't need this fragment at all
-          esdm_fragment_destroy(fragment);
-          ret = ESDM_SUCCESS;
-        }
-        eassert(ret == ESDM_SUCCESS);
+//Called at the aggregator, writes the gathered pieces as merged regions.
+static esdm_status write_regions(esdm_dataset_t *dataset, esdm_type_t type, int64_t dims, int pieceCount, const int64_t* pieces, char* data, const int* offsets) {
+  int64_t shapeLen = 2*dims + 1;
+  int64_t regionsLen = pieceCount*2*dims;
+  int64_t* regions = ea_checked_malloc((regionsLen > 0 ? regionsLen : 1)*sizeof(*regions));
+  int* regionOf = ea_checked_malloc((pieceCount ? pieceCount : 1)*sizeof(*regionOf));
+  int regionCount = merge_regions(dims, pieceCount, pieces, regions, regionOf);
+  ESDM_DEBUG_FMT("aggregating %d hyperslabs into %d regions", pieceCount, regionCount);
+
+  esdm_status ret = ESDM_SUCCESS;
+  for(int r = 0; r < regionCount && ret == ESDM_SUCCESS; r++) {
+    esdm_dataspace_t* regionSpace;
+    ret = esdm_dataspace_create_full(dims, regions + r*2*dims + dims, regions + r*2*dims, type, &regionSpace);
+    if(ret != ESDM_SUCCESS) break;
+    char* regionData = ea_checked_malloc(esdm_dataspace_total_bytes(regionSpace));
+    for(int p = 0; p < pieceCount && ret == ESDM_SUCCESS; p++) {
+      if(regionOf[p] != r) continue;
+      esdm_dataspace_t* pieceSpace;
+      ret = esdm_dataspace_create_full(dims, (int64_t*)pieces + p*shapeLen + dims, (int64_t*)pieces + p*shapeLen, type, &pieceSpace);
+      if(ret != ESDM_SUCCESS) break;
+      ret = esdm_dataspace_copy_data(pieceSpace, data + offsets[p], regionSpace, regionData);
+      esdm_dataspace_destroy(pieceSpace);
+    }
+    if(ret == ESDM_SUCCESS) ret = esdm_write(dataset, regionData, regionSpace);
+    free(regionData);
+    esdm_dataspace_destroy(regionSpace);
+  }
+
+  free(regionOf);
+  free(regions);
+  return ret;
+}
+
+esdm_status esdm_mpi_write_all(MPI_Comm com, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *memspace) {
+  eassert(dataset);
+  eassert(memspace);
+
+  MPI_Comm node = node_comm(com);
+  int nodeRank, nodeSize;
+  if(MPI_SUCCESS != MPI_Comm_rank(node, &nodeRank)) panic("MPI_Comm_rank");
+  if(MPI_SUCCESS != MPI_Comm_size(node, &nodeSize)) panic("MPI_Comm_size");
+
+  // collect the shapes of all hyperslabs of this node at the aggregator
+  int64_t dims = memspace->dims;
+  int64_t shapeLen = 2*dims + 1;
+  int64_t* shape = ea_checked_malloc(shapeLen*sizeof(*shape));
+  memcpy(shape, memspace->offset, dims*sizeof(*shape));
+  memcpy(shape + dims, memspace->size, dims*sizeof(*shape));
+  shape[2*dims] = esdm_dataspace_total_bytes(memspace);
+  int64_t* pieces = nodeRank ? NULL : ea_checked_malloc(nodeSize*shapeLen*sizeof(*pieces));
+  if(MPI_SUCCESS != MPI_Gather(shape, shapeLen, MPI_INT64_T, pieces, shapeLen, MPI_INT64_T, 0, node)) panic("MPI_Gather");
+
+  // aggregation requires that the hyperslabs do not overlap, and that the gathered data can be addressed with `int` displacements
+  int aggregate = nodeSize > 1;
+  int* counts = NULL, *offsets = NULL;
+  if(!nodeRank && aggregate) {
+    counts = ea_checked_malloc(nodeSize*sizeof(*counts));
+    offsets = ea_checked_malloc(nodeSize*sizeof(*offsets));
+    int64_t totalSize = 0;
+    for(int p = 0; p < nodeSize; p++) {
+      const int64_t* piece = pieces + p*shapeLen;
+      for(int q = 0; q < p && aggregate; q++) {
+        const int64_t* other = pieces + q*shapeLen;
+        if(piece[2*dims] && other[2*dims] && boxes_intersect(dims, piece, other)) aggregate = 0;
       }
-      json_decref(elem);
+      offsets[p] = totalSize;
+      counts[p] = piece[2*dims];
+      totalSize += piece[2*dims];
+      if(totalSize > INT_MAX) aggregate = 0;
     }
-    free(buff);
-    ret = esdm_dataset_commit(d);
+  }
+  if(MPI_SUCCESS != MPI_Bcast(&aggregate, 1, MPI_INT, 0, node)) panic("MPI_Bcast");
 
-    MPI_Bcast(& ret, 1, MPI_INT, 0, com);
-    return ret;
-  }else{
-    size_t size;
-    smd_string_stream_t * s = smd_string_stream_create();
-    esdmI_fragments_metadata_create(&d->fragments, s);
-    char * buff = smd_string_stream_close(s, & size);
+  esdm_status ret = ESDM_SUCCESS;
+  if(!aggregate) {
+    ret = esdm_write(dataset, buf, memspace);
+  } else {
+    // send the data in C order, the aggregator does not know about the strides of the other processes
+    esdm_dataspace_t* packedSpace;
+    ret = esdm_dataspace_makeContiguous(memspace, &packedSpace);
+    eassert(ret == ESDM_SUCCESS);
+    char* packed = ea_checked_malloc(shape[2*dims] ? shape[2*dims] : 1);
+    if(shape[2*dims]) ret = esdm_dataspace_copy_data(memspace, buf, packedSpace, packed);
+    esdm_dataspace_destroy(packedSpace);
+
+    char* data = nodeRank ? NULL : ea_checked_malloc(offsets[nodeSize - 1] + counts[nodeSize - 1] + 1);
+    if(MPI_SUCCESS != MPI_Gatherv(packed, shape[2*dims], MPI_BYTE, data, counts, offsets, MPI_BYTE, 0, node)) panic("MPI_Gatherv");
+    free(packed);
+
+    if(!nodeRank && ret == ESDM_SUCCESS) ret = write_regions(dataset, memspace->type, dims, nodeSize, pieces, data, offsets);
+    free(data);
+  }
 
-    ret = MPI_Send(buff, size + 1, MPI_CHAR, 0, 4711, com);
-    eassert(ret == MPI_SUCCESS);
-    free(buff);
+  free(offsets);
+  free(counts);
+  free(pieces);
+  free(shape);
+  MPI_Comm_free(&node);
 
-    MPI_Bcast(& ret, 1, MPI_INT, 0, com);
+  int result;
+  if(MPI_SUCCESS != MPI_Allreduce(&ret, &result, 1, MPI_INT, MPI_MAX, com)) panic("MPI_Allreduce");
+  return result;
+}
 
-    return ret;
+// Collective read //////////////////////////////////////////////////////////////
+//
+// Rank 0 selects the set of fragments that covers the bounding box of all requested regions, sorts it by fragment ID, and broadcasts the shapes of the fragments.
+// The other processes must not select on their own: the selection prefers fragments that are already loaded, which differs from process to process.
+// Each fragment that is needed by any process is assigned to one owner, preferably a process that needs the fragment itself,
+// the owner reads the fragment once, and sends the intersection with each requested region to the respective process with a single `MPI_Alltoallv()`.
+// Within each message, the intersections are packed in C order, in the order of the sorted fragments.
+
+static int compare_fragment_ids(const void* aArg, const void* bArg) {
+  const esdm_fragment_t* a = *(esdm_fragment_t* const*)aArg;
+  const esdm_fragment_t* b = *(esdm_fragment_t* const*)bArg;
+  return strcmp(a->id, b->id);
+}
+
+//Assigns each fragment that intersects any region to the least loaded process that needs it, `owners` receives -1 for fragments that nobody needs.
+static void assign_fragments(int64_t fragmentCount, esdmI_hypercube_t** fragmentCubes, int procCount, esdmI_hypercube_t** regions, int* owners) {
+  int64_t* load = ea_checked_calloc(procCount, sizeof(*load));
+  for(int64_t i = 0; i < fragmentCount; i++) {
+    owners[i] = -1;
+    for(int p = 0; p < procCount; p++) {
+      if(!regions[p] || !esdmI_hypercube_doesIntersect(fragmentCubes[i], regions[p])) continue;
+      if(owners[i] < 0 || load[p] < load[owners[i]]) owners[i] = p;
+    }
+    if(owners[i] >= 0) load[owners[i]] += esdmI_hypercube_size(fragmentCubes[i]);
   }
+  free(load);
 }
 
-__attribute__((noreturn))
-void panic(const char* operation) {
-  fprintf(stderr, "failed %s, aborting...\n", operation);
-  abort();
+//Checks whether the selected fragments contain all the data of the region, i.e. none of it is uncovered.
+static bool region_is_covered(esdmI_hypercube_t* region, esdmI_hypercubeSet_t* uncovered) {
+  if(!region) return true;
+  esdmI_hypercubeList_t* list = esdmI_hypercubeSet_list(uncovered);
+  for(int64_t i = 0; i < list->count; i++) {
+    if(esdmI_hypercube_doesIntersect(region, list->cubes[i])) return false;
+  }
+  return true;
+}
+
+esdm_status esdm_mpi_read_all(MPI_Comm com, esdm_dataset_t *dataset, void *buf, esdm_dataspace_t *memspace) {
+  eassert(dataset);
+  eassert(memspace);
+
+  int rank, procCount;
+  if(MPI_SUCCESS != MPI_Comm_rank(com, &rank)) return ESDM_ERROR;
+  if(MPI_SUCCESS != MPI_Comm_size(com, &procCount)) return ESDM_ERROR;
+
+  // collect the requested regions of all processes, and their bounding box
+  int64_t dims = memspace->dims;
+  int64_t* shapes = ea_checked_malloc(procCount*(2*dims + 1)*sizeof(*shapes));
+  int64_t* shape = ea_checked_malloc((2*dims + 1)*sizeof(*shape));
+  memcpy(shape, memspace->offset, dims*sizeof(*shape));
+  memcpy(shape + dims, memspace->size, dims*sizeof(*shape));
+  if(MPI_SUCCESS != MPI_Allgather(shape, 2*dims, MPI_INT64_T, shapes, 2*dims, MPI_INT64_T, com)) panic("MPI_Allgather");
+  free(shape);
+
+  esdmI_hypercube_t** regions = ea_checked_calloc(procCount, sizeof(*regions));
+  int64_t* boundsStart = ea_checked_malloc((2*dims + 1)*sizeof(*boundsStart)), *boundsEnd = boundsStart + dims;
+  bool haveBounds = false;
+  for(int p = 0; p < procCount; p++) {
+    int64_t* offset = shapes + p*2*dims, *size = offset + dims;
+    bool empty = false;
+    for(int64_t i = 0; i < dims; i++) empty = empty || !size[i];
+    if(empty) continue;
+    regions[p] = esdmI_hypercube_make(dims, offset, size);
+    for(int64_t i = 0; i < dims; i++) {
+      if(!haveBounds || offset[i] < boundsStart[i]) boundsStart[i] = offset[i];
+      if(!haveBounds || offset[i] + size[i] > boundsEnd[i]) boundsEnd[i] = offset[i] + size[i];
+    }
+    haveBounds = true;
+  }
+  free(shapes);
+
+  esdmI_hypercube_t* bounds = NULL;
+  if(haveBounds) {
+    for(int64_t i = 0; i < dims; i++) boundsEnd[i] -= boundsStart[i];
+    bounds = esdmI_hypercube_make(dims, boundsStart, boundsEnd);
+  }
+  free(boundsStart);
+
+  // rank 0 selects the fragments, the others receive the shapes of the selected fragments
+  esdm_status ret = ESDM_SUCCESS;
+  int64_t selection[2] = {0, 0};  //fallback flag, fragment count
+  int64_t* fragmentShapes = NULL;
+  if(!rank) {
+    int64_t count = 0;
+    esdm_fragment_t** selected = NULL;
+    esdmI_hypercubeSet_t* uncovered = NULL;
+    if(bounds) {
+      bool fullyCovered;
+      ret = esdmI_dataset_fragmentsCoveringRegion(dataset, bounds, &count, &selected, &uncovered, &fullyCovered);
+    }
+
+    // regions with holes are read individually, so that `esdm_read()` takes care of the fill value
+    bool fallback = ret != ESDM_SUCCESS;
+    for(int p = 0; p < procCount && uncovered && !fallback; p++) fallback = !region_is_covered(regions[p], uncovered);
+    if(!fallback) {
+      qsort(selected, count, sizeof(*selected), compare_fragment_ids);
+      fragmentShapes = ea_checked_malloc((count*2*dims + 1)*sizeof(*fragmentShapes));
+      for(int64_t i = 0; i < count; i++) {
+        eassert(selected[i]->dataspace->dims == dims);
+        memcpy(fragmentShapes + i*2*dims, selected[i]->dataspace->offset, dims*sizeof(*fragmentShapes));
+        memcpy(fragmentShapes + i*2*dims + dims, selected[i]->dataspace->size, dims*sizeof(*fragmentShapes));
+      }
+      selection[1] = count;
+    }
+    selection[0] = fallback;
+    free(selected);
+    if(uncovered) esdmI_hypercubeSet_destroy(uncovered);
+  }
+  if(MPI_SUCCESS != MPI_Bcast(selection, 2, MPI_INT64_T, 0, com)) panic("MPI_Bcast");
+  int fallback = selection[0], localFallback = 0;
+  int64_t fragmentCount = selection[1];
+  if(rank) fragmentShapes = ea_checked_malloc((fragmentCount*2*dims + 1)*sizeof(*fragmentShapes));
+  if(fragmentCount && MPI_SUCCESS != MPI_Bcast(fragmentShapes, fragmentCount*2*dims, MPI_INT64_T, 0, com)) panic("MPI_Bcast");
+
+  int64_t elementSize = esdm_sizeof(memspace->type);
+  esdm_fragment_t** fragments = ea_checked_calloc(fragmentCount ? fragmentCount : 1, sizeof(*fragments));
+  esdmI_hypercube_t** fragmentCubes = ea_checked_calloc(fragmentCount ? fragmentCount : 1, sizeof(*fragmentCubes));
+  int* owners = ea_checked_malloc((fragmentCount ? fragmentCount : 1)*sizeof(*owners));
+  int* sendCounts = ea_checked_calloc(procCount, sizeof(*sendCounts)), *sendOffsets = ea_checked_calloc(procCount, sizeof(*sendOffsets));
+  int* recvCounts = ea_checked_calloc(procCount, sizeof(*recvCounts)), *recvOffsets = ea_checked_calloc(procCount, sizeof(*recvOffsets));
+  if(!fallback) {
+    for(int64_t i = 0; i < fragmentCount; i++) fragmentCubes[i] = esdmI_hypercube_make(dims, fragmentShapes + i*2*dims, fragmentShapes + i*2*dims + dims);
+    assign_fragments(fragmentCount, fragmentCubes, procCount, regions, owners);
+
+    // each owner looks up the fragments it reads, a process with stale metadata makes all processes fall back
+    bool ownsFragments = false;
+    for(int64_t i = 0; i < fragmentCount; i++) ownsFragments = ownsFragments || owners[i] == rank;
+    if(ownsFragments && esdmI_dataset_loadFragments(dataset, bounds) != ESDM_SUCCESS) localFallback = 1;
+    for(int64_t i = 0; i < fragmentCount && !localFallback; i++) {
+      if(owners[i] != rank) continue;
+      fragments[i] = esdmI_fragments_lookupForShape(&dataset->fragments, fragmentCubes[i]);
+      if(!fragments[i]) localFallback = 1;
+    }
+
+    // compute the message sizes, falling back if they cannot be expressed as `int`
+    int64_t sendTotal = 0, recvTotal = 0;
+    for(int p = 0; p < procCount; p++) {
+      int64_t sendSize = 0, recvSize = 0;
+      for(int64_t i = 0; i < fragmentCount; i++) {
+        if(owners[i] == rank && regions[p]) sendSize += esdmI_hypercube_overlap(fragmentCubes[i], regions[p])*elementSize;
+        if(owners[i] == p && regions[rank]) recvSize += esdmI_hypercube_overlap(fragmentCubes[i], regions[rank])*elementSize;
+      }
+      sendOffsets[p] = sendTotal;
+      sendCounts[p] = sendSize;
+      recvOffsets[p] = recvTotal;
+      recvCounts[p] = recvSize;
+      sendTotal += sendSize;
+      recvTotal += recvSize;
+      if(sendTotal > INT_MAX || recvTotal > INT_MAX) localFallback = 1;
+    }
+    if(MPI_SUCCESS != MPI_Allreduce(&localFallback, &fallback, 1, MPI_INT, MPI_MAX, com)) panic("MPI_Allreduce");
+  }
+
+  if(fallback) {
+    ret = esdm_read(dataset, buf, memspace);
+  } else {
+    // read the owned fragments, and pack their intersections with the requested regions
+    char* sendBuf = ea_checked_malloc(sendOffsets[procCount - 1] + sendCounts[procCount - 1] + 1);
+    int* sendCursors = ea_memdup(sendOffsets, procCount*sizeof(*sendCursors));
+    for(int64_t i = 0; i < fragmentCount; i++) {
+      if(owners[i] != rank) continue;
+      bool wasLoaded = fragments[i]->status != ESDM_DATA_NOT_LOADED;
+      esdm_status fragmentRet = esdm_fragment_load(fragments[i]);
+      for(int p = 0; p < procCount && fragmentRet == ESDM_SUCCESS; p++) {
+        esdmI_hypercube_t* intersection = regions[p] ? esdmI_hypercube_makeIntersection(fragmentCubes[i], regions[p]) : NULL;
+        if(!intersection) continue;
+        esdm_dataspace_t* intersectionSpace;
+        fragmentRet = esdmI_dataspace_createFromHypercube(intersection, memspace->type, &intersectionSpace);
+        if(fragmentRet == ESDM_SUCCESS) {
+          fragmentRet = esdm_dataspace_copy_data(fragments[i]->dataspace, fragments[i]->buf, intersectionSpace, sendBuf + sendCursors[p]);
+          esdm_dataspace_destroy(intersectionSpace);
+        }
+        sendCursors[p] += esdmI_hypercube_size(intersection)*elementSize;
+        esdmI_hypercube_destroy(intersection);
+      }
+      if(!wasLoaded) esdm_fragment_unload(fragments[i]);  //don't keep the data of fragments that were only loaded for the other processes
+      if(ret == ESDM_SUCCESS) ret = fragmentRet;
+    }
+    free(sendCursors);
+
+    char* recvBuf = ea_checked_malloc(recvOffsets[procCount - 1] + recvCounts[procCount - 1] + 1);
+    if(MPI_SUCCESS != MPI_Alltoallv(sendBuf, sendCounts, sendOffsets, MPI_BYTE, recvBuf, recvCounts, recvOffsets, MPI_BYTE, com)) panic("MPI_Alltoallv");
+    free(sendBuf);
+
+    // unpack in the same order as the owners packed
+    int* recvCursors = ea_memdup(recvOffsets, procCount*sizeof(*recvCursors));
+    for(int64_t i = 0; i < fragmentCount && regions[rank]; i++) {
+      esdmI_hypercube_t* intersection = esdmI_hypercube_makeIntersection(fragmentCubes[i], regions[rank]);
+      if(!intersection) continue;
+      esdm_dataspace_t* intersectionSpace;
+      esdm_status copyRet = esdmI_dataspace_createFromHypercube(intersection, memspace->type, &intersectionSpace);
+      if(copyRet == ESDM_SUCCESS) {
+        copyRet = esdm_dataspace_copy_data(intersectionSpace, recvBuf + recvCursors[owners[i]], memspace, buf);
+        esdm_dataspace_destroy(intersectionSpace);
+      }
+      recvCursors[owners[i]] += esdmI_hypercube_size(intersection)*elementSize;
+      esdmI_hypercube_destroy(intersection);
+      if(ret == ESDM_SUCCESS) ret = copyRet;
+    }
+    free(recvCursors);
+    free(recvBuf);
+  }
+
+  // cleanup
+  for(int64_t i = 0; i < fragmentCount; i++) if(fragmentCubes[i]) esdmI_hypercube_destroy(fragmentCubes[i]);
+  for(int p = 0; p < procCount; p++) if(regions[p]) esdmI_hypercube_destroy(regions[p]);
+  free(recvOffsets);
+  free(recvCounts);
+  free(sendOffsets);
+  free(sendCounts);
+  free(owners);
+  free(fragmentCubes);
+  free(fragments);
+  free(fragmentShapes);
+  free(regions);
+  if(bounds) esdmI_hypercube_destroy(bounds);
+
+  // an error of any process, including an error in the data it sent, is an error of all processes
+  int result;
+  if(MPI_SUCCESS != MPI_Allreduce(&ret, &result, 1, MPI_INT, MPI_MAX, com)) panic("MPI_Allreduce");
+  return result;
 }
 
 esdm_status esdm_mpi_grid_bcast(MPI_Comm comm, esdm_dataset_t* dataset, esdm_grid_t** inout_grid) {
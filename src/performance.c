@@ -168,6 +168,28 @@ int esdmI_backend_fragment_update (esdm_backend_t * b, esdm_fragment_t *fragment
   return result;
 }
 
+void esdmI_backend_fragments_retrieve(esdm_backend_t * b, int64_t count, esdm_fragment_t **fragments, int *out_rets) {
+  timer clock;
+  ea_start_timer(&clock);
+  b->callbacks.fragments_retrieve(b, count, fragments, out_rets);
+  gBackendTimes.fragments_retrieve += ea_stop_timer(clock);
+}
+
+void esdmI_backend_fragments_update(esdm_backend_t * b, int64_t count, esdm_fragment_t **fragments, int *out_rets) {
+  timer clock;
+  ea_start_timer(&clock);
+  b->callbacks.fragments_update(b, count, fragments, out_rets);
+  gBackendTimes.fragments_update += ea_stop_timer(clock);
+}
+
+int esdmI_backend_fragment_retrieve_region(esdm_backend_t * b, esdm_fragment_t *fragment, int64_t count, esdmI_byteRange_t *ranges) {
+  timer clock;
+  ea_start_timer(&clock);
+  int result = b->callbacks.fragment_retrieve_region(b, fragment, count, ranges);
+  gBackendTimes.fragment_retrieve_region += ea_stop_timer(clock);
+  return result;
+}
+
 int esdmI_backend_fragment_delete (esdm_backend_t * b, esdm_fragment_t *fragment) {
   timer clock;
   ea_start_timer(&clock);
@@ -200,6 +222,13 @@ int esdmI_backend_fragment_metadata_free (esdm_backend_t * b, void * options) {
   return result;
 }
 
+void esdmI_backend_fragment_metadata_committed(esdm_backend_t * b, esdm_fragment_t *fragment) {
+  timer clock;
+  ea_start_timer(&clock);
+  b->callbacks.fragment_metadata_committed(b, fragment);
+  gBackendTimes.fragment_metadata_committed += ea_stop_timer(clock);
+}
+
 int esdmI_backend_mkfs(esdm_backend_t * b, int format_flags) {
   timer clock;
   ea_start_timer(&clock);
@@ -237,9 +266,13 @@ esdm_backendTimes_t esdmI_performance_backend_add(const esdm_backendTimes_t* a,
     .fragment_retrieve = a->fragment_retrieve + b->fragment_retrieve,
     .fragment_update = a->fragment_update + b->fragment_update,
     .fragment_delete = a->fragment_delete + b->fragment_delete,
+    .fragments_retrieve = a->fragments_retrieve + b->fragments_retrieve,
+    .fragments_update = a->fragments_update + b->fragments_update,
+    .fragment_retrieve_region = a->fragment_retrieve_region + b->fragment_retrieve_region,
     .fragment_metadata_create = a->fragment_metadata_create + b->fragment_metadata_create,
     .fragment_metadata_load = a->fragment_metadata_load + b->fragment_metadata_load,
     .fragment_metadata_free = a->fragment_metadata_free + b->fragment_metadata_free,
+    .fragment_metadata_committed = a->fragment_metadata_committed + b->fragment_metadata_committed,
     .mkfs = a->mkfs + b->mkfs,
     .fsck = a->fsck + b->fsck,
     .fragment_write_stream_blocksize = a->fragment_write_stream_blocksize + b->fragment_write_stream_blocksize,
@@ -255,9 +288,13 @@ esdm_backendTimes_t esdmI_performance_backend_sub(const esdm_backendTimes_t* min
     .fragment_retrieve = minuend->fragment_retrieve - subtrahend->fragment_retrieve,
     .fragment_update = minuend->fragment_update - subtrahend->fragment_update,
     .fragment_delete = minuend->fragment_delete - subtrahend->fragment_delete,
+    .fragments_retrieve = minuend->fragments_retrieve - subtrahend->fragments_retrieve,
+    .fragments_update = minuend->fragments_update - subtrahend->fragments_update,
+    .fragment_retrieve_region = minuend->fragment_retrieve_region - subtrahend->fragment_retrieve_region,
     .fragment_metadata_create = minuend->fragment_metadata_create - subtrahend->fragment_metadata_create,
     .fragment_metadata_load = minuend->fragment_metadata_load - subtrahend->fragment_metadata_load,
     .fragment_metadata_free = minuend->fragment_metadata_free - subtrahend->fragment_metadata_free,
+    .fragment_metadata_committed = minuend->fragment_metadata_committed - subtrahend->fragment_metadata_committed,
     .mkfs = minuend->mkfs - subtrahend->mkfs,
     .fsck = minuend->fsck - subtrahend->fsck,
     .fragment_write_stream_blocksize = minuend->fragment_write_stream_blocksize - subtrahend->fragment_write_stream_blocksize,
@@ -275,9 +312,13 @@ void esdmI_performance_backend_print(FILE* stream, const char* linePrefix, const
   printTime(stream, linePrefix, indentation, diff, fragment_retrieve);
   printTime(stream, linePrefix, indentation, diff, fragment_update);
   printTime(stream, linePrefix, indentation, diff, fragment_delete);
+  printTime(stream, linePrefix, indentation, diff, fragments_retrieve);
+  printTime(stream, linePrefix, indentation, diff, fragments_update);
+  printTime(stream, linePrefix, indentation, diff, fragment_retrieve_region);
   printTime(stream, linePrefix, indentation, diff, fragment_metadata_create);
   printTime(stream, linePrefix, indentation, diff, fragment_metadata_load);
   printTime(stream, linePrefix, indentation, diff, fragment_metadata_free);
+  printTime(stream, linePrefix, indentation, diff, fragment_metadata_committed);
   printTime(stream, linePrefix, indentation, diff, mkfs);
   printTime(stream, linePrefix, indentation, diff, fsck);
   printTime(stream, linePrefix, indentation, diff, fragment_write_stream_blocksize);
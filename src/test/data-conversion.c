@@ -1,5 +1,7 @@
 #include <esdm-internal.h>
+#include <math.h>
 #include <stdbool.h>
+#include <string.h>
 
 void testConvertersDirectly() {
   const int64_t ref_int64[] = {0, 1, 0x7f, 0xff, 0x7fff, 0xffff, 0x7fffffff, 0xffffffff, 0x7fffffffffffffff, -0x8000000000000000, -0x80000000, -0x8000, -0x80, -1};
@@ -66,6 +68,96 @@ void testConvertersDirectly() {
   }
 }
 
+//The converters use vectorized kernels for some type combinations, so this checks arrays that are long enough to trigger them, with a length that leaves a scalar tail.
+void testLongConversions() {
+  enum { kElementCount = 1021 };
+  int32_t sourceInt32[kElementCount];
+  float sourceFloat[kElementCount];
+  double sourceDouble[kElementCount];
+  for(int i = 0; i < kElementCount; i++) {
+    sourceInt32[i] = (i - kElementCount/2)*4194301;
+    sourceFloat[i] = (float)(i - kElementCount/2)*0.3f;
+    sourceDouble[i] = (i - kElementCount/2)*0.3;
+  }
+
+  #define checkLongConversion(source, sourceType, destType) { \
+    destType converted[kElementCount]; \
+    ea_datatype_converter converter = ea_converter_for_types(smd_c_to_smd_type((destType){0}), smd_c_to_smd_type((sourceType){0})); \
+    eassert(converter); \
+    converter(converted, source, sizeof(source)); \
+    for(int i = 0; i < kElementCount; i++) { \
+      destType expected = (destType)source[i]; \
+      if(memcmp(&converted[i], &expected, sizeof(expected))) { \
+        fprintf(stderr, "long conversion from "#sourceType" to "#destType" yields wrong value at index %d\n", i); \
+        abort(); \
+      } \
+    } \
+  }
+
+  checkLongConversion(sourceInt32, int32_t, float)
+  checkLongConversion(sourceInt32, int32_t, double)
+  checkLongConversion(sourceFloat, float, double)
+  checkLongConversion(sourceDouble, double, float)
+}
+
+void testSaturatingConverters() {
+  const int32_t sourceInt32[] = {0, 1, -1, 0x7f, 0x80, -0x81, 0x7fff, 0x8000, -0x8001, 0xffff, 0x10000, 0x7fffffff, -0x7fffffff - 1};
+  const uint64_t sourceUint64[] = {0, 1, 0x7f, 0x80, 0xffffffff, 0x100000000, 0xffffffffffffffff};
+  const double sourceDouble[] = {-1.0e300, -2147483649.0, -2147483648.0, -1, -0.5, 0.0, 0.5, 0x7fffffff, 0x80000000, 0xffffffff, 0x100000000, 1.0e300, NAN};
+
+  #define checkSaturation(source, sourceType, destType, ...) { \
+    const destType expected[] = {__VA_ARGS__}; \
+    size_t elementCount = sizeof(source)/sizeof*source; \
+    eassert(elementCount == sizeof(expected)/sizeof*expected); \
+    destType converted[elementCount]; \
+    ea_datatype_converter converter = ea_saturating_converter_for_types(smd_c_to_smd_type((destType){0}), smd_c_to_smd_type((sourceType){0})); \
+    if(!converter) fprintf(stderr, "no saturating converter found to convert `"#sourceType"` to `"#destType"`\n"), abort(); \
+    converter(converted, source, sizeof(source)); \
+    for(size_t i = 0; i < elementCount; i++) { \
+      if(converted[i] != expected[i]) { \
+        fprintf(stderr, "saturating conversion from "#sourceType" to "#destType" yields wrong value at index %zu\n", i); \
+        abort(); \
+      } \
+    } \
+  }
+
+  checkSaturation(sourceInt32, int32_t, int8_t, 0, 1, -1, 0x7f, 0x7f, -0x80, 0x7f, 0x7f, -0x80, 0x7f, 0x7f, 0x7f, -0x80)
+  checkSaturation(sourceInt32, int32_t, uint8_t, 0, 1, 0, 0x7f, 0x80, 0, 0xff, 0xff, 0, 0xff, 0xff, 0xff, 0)
+  checkSaturation(sourceInt32, int32_t, int16_t, 0, 1, -1, 0x7f, 0x80, -0x81, 0x7fff, 0x7fff, -0x8000, 0x7fff, 0x7fff, 0x7fff, -0x8000)
+  checkSaturation(sourceInt32, int32_t, uint16_t, 0, 1, 0, 0x7f, 0x80, 0, 0x7fff, 0x8000, 0, 0xffff, 0xffff, 0xffff, 0)
+  checkSaturation(sourceUint64, uint64_t, int8_t, 0, 1, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f)
+  checkSaturation(sourceUint64, uint64_t, uint32_t, 0, 1, 0x7f, 0x80, 0xffffffff, 0xffffffff, 0xffffffff)
+  checkSaturation(sourceUint64, uint64_t, int64_t, 0, 1, 0x7f, 0x80, 0xffffffff, 0x100000000, 0x7fffffffffffffff)
+  checkSaturation(sourceDouble, double, int32_t, -0x7fffffff - 1, -0x7fffffff - 1, -0x7fffffff - 1, -1, 0, 0, 0, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0)
+  checkSaturation(sourceDouble, double, uint32_t, 0, 0, 0, 0, 0, 0, 0, 0x7fffffff, 0x80000000, 0xffffffff, 0xffffffff, 0xffffffff, 0)
+  checkSaturation(sourceDouble, double, int64_t, -0x7fffffffffffffff - 1, -2147483649, -2147483648, -1, 0, 0, 0, 0x7fffffff, 0x80000000, 0xffffffff, 0x100000000, 0x7fffffffffffffff, 0)
+
+  //the vectorized saturating kernels only kick in for longer arrays
+  enum { kElementCount = 1021 };
+  int32_t longInt32[kElementCount];
+  int16_t longInt16[kElementCount];
+  for(int i = 0; i < kElementCount; i++) longInt32[i] = (i - kElementCount/2)*157, longInt16[i] = (int16_t)((i - kElementCount/2)*3);
+
+  #define checkLongSaturation(source, sourceType, destType, destMin, destMax) { \
+    destType converted[kElementCount]; \
+    ea_datatype_converter converter = ea_saturating_converter_for_types(smd_c_to_smd_type((destType){0}), smd_c_to_smd_type((sourceType){0})); \
+    eassert(converter); \
+    converter(converted, source, sizeof(source)); \
+    for(int i = 0; i < kElementCount; i++) { \
+      destType expected = source[i] < destMin ? destMin : source[i] > destMax ? destMax : (destType)source[i]; \
+      if(converted[i] != expected) { \
+        fprintf(stderr, "saturating conversion from "#sourceType" to "#destType" yields wrong value at index %d\n", i); \
+        abort(); \
+      } \
+    } \
+  }
+
+  checkLongSaturation(longInt32, int32_t, int16_t, INT16_MIN, INT16_MAX)
+  checkLongSaturation(longInt32, int32_t, uint16_t, 0, UINT16_MAX)
+  checkLongSaturation(longInt16, int16_t, int8_t, INT8_MIN, INT8_MAX)
+  checkLongSaturation(longInt16, int16_t, uint8_t, 0, UINT8_MAX)
+}
+
 void testDataCopy() {
   uint8_t source[2][3][4] = {
     {
@@ -145,9 +237,70 @@ void testDataCopy() {
   }
 }
 
+//Copies between C order and FORTRAN order (and with a reversed dimension) use a blocked transpose kernel, check it together with a type conversion.
+void testTransposedCopy() {
+  enum { kX = 37, kY = 23, kZ = 5 };
+  int32_t (*source)[kY][kX] = ea_checked_malloc(kZ*sizeof(*source));
+  double (*dest)[kY][kZ] = ea_checked_malloc(kX*sizeof(*dest));
+  for(int z = 0; z < kZ; z++) {
+    for(int y = 0; y < kY; y++) {
+      for(int x = 0; x < kX; x++) source[z][y][x] = (z*kY + y)*kX + x;
+    }
+  }
+
+  esdm_dataspace_t *sourceSpace, *destSpace;
+  esdm_status ret = esdm_dataspace_create(3, (int64_t[3]){kZ, kY, kX}, SMD_DTYPE_INT32, &sourceSpace);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataspace_create(3, (int64_t[3]){kZ, kY, kX}, SMD_DTYPE_DOUBLE, &destSpace);
+  eassert(ret == ESDM_SUCCESS);
+
+  //FORTRAN order
+  ret = esdm_dataspace_set_stride(destSpace, (int64_t[3]){1, kZ, kZ*kY});
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataspace_copy_data(sourceSpace, source, destSpace, dest);
+  eassert(ret == ESDM_SUCCESS);
+  for(int z = 0; z < kZ; z++) {
+    for(int y = 0; y < kY; y++) {
+      for(int x = 0; x < kX; x++) {
+        if(dest[x][y][z] < source[z][y][x] || dest[x][y][z] > source[z][y][x]) {
+          fprintf(stderr, "transposed copy yields wrong value at (%d, %d, %d)\n", z, y, x);
+          abort();
+        }
+      }
+    }
+  }
+
+  //reversed x dimension in the destination, the data pointer points to the logical element (0, 0, 0), which has the highest address within its row
+  double (*reversed)[kY][kX] = (double (*)[kY][kX])dest;
+  ret = esdm_dataspace_set_stride(destSpace, (int64_t[3]){kY*kX, kX, -1});
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataspace_copy_data(sourceSpace, source, destSpace, &reversed[0][0][kX - 1]);
+  eassert(ret == ESDM_SUCCESS);
+  for(int z = 0; z < kZ; z++) {
+    for(int y = 0; y < kY; y++) {
+      for(int x = 0; x < kX; x++) {
+        if(reversed[z][y][kX - 1 - x] < source[z][y][x] || reversed[z][y][kX - 1 - x] > source[z][y][x]) {
+          fprintf(stderr, "reversed copy yields wrong value at (%d, %d, %d)\n", z, y, x);
+          abort();
+        }
+      }
+    }
+  }
+
+  ret = esdm_dataspace_destroy(sourceSpace);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataspace_destroy(destSpace);
+  eassert(ret == ESDM_SUCCESS);
+  free(source);
+  free(dest);
+}
+
 int main() {
   testConvertersDirectly();
+  testLongConversions();
+  testSaturatingConverters();
   testDataCopy();
+  testTransposedCopy();
 
   printf("OK\n");
 }
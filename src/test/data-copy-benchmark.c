@@ -164,6 +164,85 @@ int main() {
   }
   printf("checking result: %.3fms\n", 1000*ea_stop_timer(myTimer));
 
+  //compare serial and parallel execution of the same copies
+  for(int64_t threads = 1; threads >= 0; threads--) {
+    esdmI_dataspace_setCopyParallelism(threads, 1024*1024);
+    const char* mode = threads ? "serial" : "parallel";
+
+    memset(data, 0, kDimSize*sizeof(*data));
+    ea_start_timer(&myTimer);
+    result = esdm_dataspace_copy_data(sourceSubspace, referenceData, sourceSubspace, data);
+    assert(result == ESDM_SUCCESS);
+    printf("%s contiguous copy: %.3fms\n", mode, 1000*ea_stop_timer(myTimer));
+    eassert(!memcmp(data, referenceData, kDimSize*sizeof(*data)));
+
+    result = esdm_dataspace_subspace(logicalSpace, 3, (int64_t[3]){kDimSize, kDimSize-1, kDimSize}, (int64_t[3]){0, 1, 0}, &destSubspace);
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_set_stride(destSubspace, (int64_t[3]){kDimSize*kDimSize, kDimSize, 1});
+    assert(result == ESDM_SUCCESS);
+    ea_start_timer(&myTimer);
+    result = esdm_dataspace_copy_data(sourceSubspace, referenceData, destSubspace, data);
+    assert(result == ESDM_SUCCESS);
+    printf("%s copy %d blocks: %.3fms\n", mode, kDimSize, 1000*ea_stop_timer(myTimer));
+    result = esdm_dataspace_destroy(destSubspace);
+    assert(result == ESDM_SUCCESS);
+    for(int64_t z = 0; z < kDimSize; z++) {
+      for(int64_t y = 0; y < kDimSize - 1; y++) {
+        for(int64_t x = 0; x < kDimSize; x++) {
+          eassert(data[z][y][x] == referenceData[z][y + 1][x]);
+        }
+      }
+    }
+
+    result = esdm_dataspace_subspace(logicalSpace, 3, (int64_t[3]){kDimSize, kDimSize, kDimSize}, (int64_t[3]){0, 0, 0}, &destSubspace);
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_set_stride(destSubspace, (int64_t[3]){kDimSize*kDimSize, 1, kDimSize});
+    assert(result == ESDM_SUCCESS);
+    ea_start_timer(&myTimer);
+    result = esdm_dataspace_copy_data(sourceSubspace, referenceData, destSubspace, data);
+    assert(result == ESDM_SUCCESS);
+    printf("%s transpose two inner dimensions: %.3fms\n", mode, 1000*ea_stop_timer(myTimer));
+    result = esdm_dataspace_destroy(destSubspace);
+    assert(result == ESDM_SUCCESS);
+    for(int64_t z = 0; z < kDimSize; z++) {
+      for(int64_t y = 0; y < kDimSize; y++) {
+        for(int64_t x = 0; x < kDimSize; x++) {
+          eassert(data[z][x][y] == referenceData[z][y][x]);
+        }
+      }
+    }
+  }
+
+  //many small copies with the same layout, like copying the timesteps of a small grid, these hit the copy plan cache after the first iteration
+  esdmI_dataspace_setCopyParallelism(0, 4*1024*1024);
+  memset(data, 0, kDimSize*sizeof(*data));
+  ea_start_timer(&myTimer);
+  for(int64_t z = 0; z < kDimSize; z++) {
+    esdm_dataspace_t *timestepSource, *timestepDest;
+    result = esdm_dataspace_subspace(logicalSpace, 3, (int64_t[3]){1, 16, 16}, (int64_t[3]){z, 8, 8}, &timestepSource);
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_subspace(logicalSpace, 3, (int64_t[3]){1, 16, 16}, (int64_t[3]){z, 8, 8}, &timestepDest);
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_set_stride(timestepSource, (int64_t[3]){kDimSize*kDimSize, kDimSize, 1});
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_set_stride(timestepDest, (int64_t[3]){kDimSize*kDimSize, kDimSize, 1});
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_copy_data(timestepSource, referenceData[z][8] + 8, timestepDest, data[z][8] + 8);
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_destroy(timestepSource);
+    assert(result == ESDM_SUCCESS);
+    result = esdm_dataspace_destroy(timestepDest);
+    assert(result == ESDM_SUCCESS);
+  }
+  printf("%d small copies of the same layout: %.3fms\n", kDimSize, 1000*ea_stop_timer(myTimer));
+  for(int64_t z = 0; z < kDimSize; z++) {
+    for(int64_t y = 8; y < 24; y++) {
+      for(int64_t x = 8; x < 24; x++) {
+        eassert(data[z][y][x] == referenceData[z][y][x]);
+      }
+    }
+  }
+
   result = esdm_dataspace_destroy(logicalSpace);
   assert(result == ESDM_SUCCESS);
   result = esdm_dataspace_destroy(sourceSubspace);
@@ -181,7 +181,6 @@ int main(int argc, char const *argv[]) {
   eassert(ret == ESDM_SUCCESS);
   after = esdm_read_stats();
   eassert(dataIsCorrect(dims, dimSizes, data));
-  free(data);
 
   printf("bytes requested to read = %"PRId64" (expected %"PRId64")\n", after.bytesUser - before.bytesUser, totalSize(dims, dimSizes));
   eassert(after.bytesUser - before.bytesUser == totalSize(dims, dimSizes));
@@ -192,6 +191,40 @@ int main(int argc, char const *argv[]) {
   printf("fragments read = %"PRId64" (expected %"PRId64")\n", after.fragments - before.fragments, edgeLength);
   eassert(after.fragments - before.fragments == edgeLength);
 
+  //Read the data again in many small pieces, this is dominated by finding the fragments that overlap each piece.
+  //Each piece is a single line along the last dimension, so it overlaps one slice of each of the other directions, and all slices of the last direction.
+  {
+    int64_t lineSize[dims], lineOffset[dims];
+    for(int64_t i = 0; i < dims; i++) lineSize[i] = 1, lineOffset[i] = 0;
+    lineSize[dims - 1] = edgeLength;
+    int64_t lineCount = totalElements(dims, dimSizes)/edgeLength;
+
+    clearData(dims, dimSizes, data);
+    esdm_fragmentsTimes_t fragmentTimesBefore = esdmI_performance_fragments();
+    timer myTimer;
+    ea_start_timer(&myTimer);
+    for(int64_t line = 0; line < lineCount; line++) {
+      for(int64_t i = dims - 1, remainder = line; i--; remainder /= edgeLength) lineOffset[i] = remainder%edgeLength;
+      esdm_dataspace_t* subspace;
+      ret = esdm_dataspace_subspace(dataspace, dims, lineSize, lineOffset, &subspace);
+      eassert(ret == ESDM_SUCCESS);
+      ret = esdm_dataspace_copyDatalayout(subspace, dataspace);
+      eassert(ret == ESDM_SUCCESS);
+      ret = esdm_read(dataset, (char*)data + esdm_dataspace_elementOffset(dataspace, lineOffset), subspace);
+      eassert(ret == ESDM_SUCCESS);
+      ret = esdm_dataspace_destroy(subspace);
+      eassert(ret == ESDM_SUCCESS);
+    }
+    double lineReadTime = ea_stop_timer(myTimer);
+    esdm_fragmentsTimes_t fragmentTimesAfter = esdmI_performance_fragments();
+    esdm_fragmentsTimes_t fragmentTimes = esdmI_performance_fragments_sub(&fragmentTimesAfter, &fragmentTimesBefore);
+    eassert(dataIsCorrect(dims, dimSizes, data));
+
+    printf("line reads = %"PRId64" in %.3fs\n", lineCount, lineReadTime);
+    printf("fragment set creation = %"PRId64" calls in %.3fs (%.3fus per call)\n", fragmentTimes.setCreationCalls, fragmentTimes.setCreation, 1e6*fragmentTimes.setCreation/(double)(fragmentTimes.setCreationCalls ? fragmentTimes.setCreationCalls : 1));
+  }
+  free(data);
+
   esdm_dataspace_destroy(dataspace);
   esdm_dataset_close(dataset);
   esdm_container_close(container);
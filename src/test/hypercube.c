@@ -24,6 +24,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define checkRange(a, min, max) do {\
   esdmI_range_t temp_a = (a);\
@@ -322,9 +323,217 @@ void checkTouch() {
   esdmI_hypercube_destroy(referenceCube);
 }
 
+//Check that esdmI_hypercubeSet_subtractList() yields the same region as subtracting the cubes one by one.
+void checkSubtractList() {
+  const int64_t cubeCount = 64;
+  esdmI_hypercubeList_t subtrahends = { .cubes = ea_checked_malloc(cubeCount*sizeof(*subtrahends.cubes)), .count = cubeCount };
+  unsigned int seed = 42;
+  for(int64_t i = 0; i < cubeCount; i++) {
+    int64_t offset[3], size[3];
+    for(int64_t d = 0; d < 3; d++) {
+      offset[d] = rand_r(&seed)%20;
+      size[d] = 1 + rand_r(&seed)%8;
+    }
+    subtrahends.cubes[i] = i%16 ? esdmI_hypercube_make(3, offset, size) : NULL;  //NULL entries must be ignored
+  }
+  esdmI_hypercube_t* region = esdmI_hypercube_make(3, (int64_t[3]){2, 3, 4}, (int64_t[3]){16, 15, 14});
+
+  esdmI_hypercubeSet_t* expected = esdmI_hypercubeSet_make();
+  esdmI_hypercubeSet_add(expected, region);
+  for(int64_t i = 0; i < cubeCount; i++) if(subtrahends.cubes[i]) esdmI_hypercubeSet_subtract(expected, subtrahends.cubes[i]);
+
+  esdmI_hypercubeSet_t* actual = esdmI_hypercubeSet_make();
+  esdmI_hypercubeSet_add(actual, region);
+  esdmI_hypercubeSet_subtractList(actual, &subtrahends);
+
+  //both sets consist of disjoint cubes, so equal sizes and mutual coverage means that they describe the same region
+  int64_t expectedSize = 0, actualSize = 0;
+  esdmI_hypercubeList_t* expectedList = esdmI_hypercubeSet_list(expected);
+  esdmI_hypercubeList_t* actualList = esdmI_hypercubeSet_list(actual);
+  for(int64_t i = 0; i < expectedList->count; i++) {
+    expectedSize += esdmI_hypercube_size(expectedList->cubes[i]);
+    eassert(esdmI_hypercubeList_doesCoverFully(actualList, expectedList->cubes[i]));
+  }
+  for(int64_t i = 0; i < actualList->count; i++) {
+    actualSize += esdmI_hypercube_size(actualList->cubes[i]);
+    eassert(esdmI_hypercubeList_doesCoverFully(expectedList, actualList->cubes[i]));
+    for(int64_t j = 0; j < cubeCount; j++) eassert(!subtrahends.cubes[j] || !esdmI_hypercube_doesIntersect(actualList->cubes[i], subtrahends.cubes[j]));
+  }
+  eassert(actualSize == expectedSize);
+  eassert(actualSize > 0);
+  printf("\nsubtracting %"PRId64" cubes at once leaves %"PRId64" cubes (%"PRId64" when subtracting one by one)\n", cubeCount, actualList->count, expectedList->count);
+
+  //subtracting the region itself must leave nothing
+  esdmI_hypercubeSet_subtractList(actual, &(esdmI_hypercubeList_t){ .cubes = &region, .count = 1 });
+  eassert(esdmI_hypercubeSet_isEmpty(actual));
+
+  esdmI_hypercubeSet_destroy(expected);
+  esdmI_hypercubeSet_destroy(actual);
+  esdmI_hypercube_destroy(region);
+  for(int64_t i = 0; i < cubeCount; i++) if(subtrahends.cubes[i]) esdmI_hypercube_destroy(subtrahends.cubes[i]);
+  free(subtrahends.cubes);
+}
+
+void checkNonredundantSubsets() {
+  //two tilings of the same area, the second one shifted by half a tile, so that there are many ways to cover the area
+  const int64_t side = 4, cubeCount = 2*side*side;
+  esdmI_hypercube_t* cubes[cubeCount];
+  int64_t n = 0;
+  for(int64_t tiling = 0; tiling < 2; tiling++) {
+    for(int64_t y = 0; y < side; y++) {
+      for(int64_t x = 0; x < side; x++) cubes[n++] = esdmI_hypercube_make(2, (int64_t[2]){y*16 + tiling*8, x*16 + tiling*8}, (int64_t[2]){16, 16});
+    }
+  }
+  esdmI_hypercubeList_t list = { .cubes = cubes, .count = cubeCount };
+
+  //the subsets only depend on the list, not on earlier calls
+  int64_t setCount = 8, repeatedSetCount = 8;
+  uint8_t (*subsets)[cubeCount] = ea_checked_malloc(setCount*sizeof(*subsets));
+  uint8_t (*repeatedSubsets)[cubeCount] = ea_checked_malloc(repeatedSetCount*sizeof(*repeatedSubsets));
+  esdmI_hypercubeList_nonredundantSubsets(&list, &setCount, subsets);
+  esdmI_hypercubeList_nonredundantSubsets(&list, &repeatedSetCount, repeatedSubsets);
+  eassert(setCount > 0);
+  eassert(setCount == repeatedSetCount);
+  eassert(!memcmp(subsets, repeatedSubsets, setCount*sizeof(*subsets)));
+
+  //each subset still covers every cube of the list
+  for(int64_t set = 0; set < setCount; set++) {
+    esdmI_hypercube_t* selected[cubeCount];
+    esdmI_hypercubeList_t selectedList = { .cubes = selected, .count = 0 };
+    for(int64_t i = 0; i < cubeCount; i++) if(subsets[set][i]) selected[selectedList.count++] = cubes[i];
+    eassert(selectedList.count < cubeCount);
+    for(int64_t i = 0; i < cubeCount; i++) eassert(esdmI_hypercubeList_doesCoverFully(&selectedList, cubes[i]));
+  }
+
+  free(subsets);
+  free(repeatedSubsets);
+  for(int64_t i = 0; i < cubeCount; i++) esdmI_hypercube_destroy(cubes[i]);
+}
+
+//Compare the result of an R-tree query against a brute force scan of the cubes that are currently in the tree.
+//The values are the indices of the cubes, offset by one to avoid NULL.
+static void checkRTreeQuery(esdmI_hypercubeRTree_t* tree, esdmI_hypercube_t** cubes, bool* inTree, int64_t cubeCount, esdmI_hypercube_t* region) {
+  int64_t resultCount;
+  void** result = esdmI_hypercubeRTree_query(tree, region, &resultCount);
+  bool* found = ea_checked_calloc(cubeCount, sizeof(*found));
+  for(int64_t i = 0; i < resultCount; i++) {
+    int64_t index = (intptr_t)result[i] - 1;
+    eassert(index >= 0 && index < cubeCount);
+    eassert(!found[index]); //no duplicates
+    found[index] = true;
+  }
+  int64_t expectedCount = 0;
+  for(int64_t i = 0; i < cubeCount; i++) {
+    bool expected = inTree[i] && esdmI_hypercube_doesIntersect(cubes[i], region);
+    eassert(found[i] == expected);
+    expectedCount += expected;
+  }
+  eassert(resultCount == expectedCount);
+  free(found);
+  free(result);
+}
+
+static void checkRTreeQueries(esdmI_hypercubeRTree_t* tree, esdmI_hypercube_t** cubes, bool* inTree, int64_t cubeCount, unsigned int* seed) {
+  int64_t expectedCount = 0;
+  for(int64_t i = 0; i < cubeCount; i++) expectedCount += inTree[i];
+  eassert(esdmI_hypercubeRTree_count(tree) == expectedCount);
+
+  for(int64_t i = 0; i < 16; i++) {
+    int64_t offset[2] = { rand_r(seed)%1000, rand_r(seed)%1000 }, size[2] = { 1 + rand_r(seed)%200, 1 + rand_r(seed)%200 };
+    esdmI_hypercube_t* region = esdmI_hypercube_make(2, offset, size);
+    checkRTreeQuery(tree, cubes, inTree, cubeCount, region);
+    esdmI_hypercube_destroy(region);
+  }
+
+  //regions that cannot match anything: far outside of all cubes, and empty
+  esdmI_hypercube_t* outside = esdmI_hypercube_make(2, (int64_t[2]){5000, 5000}, (int64_t[2]){100, 100});
+  esdmI_hypercube_t* empty = esdmI_hypercube_make(2, (int64_t[2]){500, 500}, (int64_t[2]){0, 10});
+  int64_t resultCount;
+  free(esdmI_hypercubeRTree_query(tree, outside, &resultCount));
+  eassert(resultCount == 0);
+  free(esdmI_hypercubeRTree_query(tree, empty, &resultCount));
+  eassert(resultCount == 0);
+  esdmI_hypercube_destroy(outside);
+  esdmI_hypercube_destroy(empty);
+}
+
+void checkRTree() {
+  const int64_t cubeCount = 600;  //enough for three levels of nodes with at most ESDMI_RTREE_MAX_ENTRIES entries each
+  unsigned int seed = 4711;
+  esdmI_hypercube_t* cubes[cubeCount];
+  void* values[cubeCount];
+  bool inTree[cubeCount];
+  for(int64_t i = 0; i < cubeCount; i++) {
+    int64_t offset[2] = { rand_r(&seed)%1000, rand_r(&seed)%1000 }, size[2] = { 1 + rand_r(&seed)%50, 1 + rand_r(&seed)%50 };
+    cubes[i] = esdmI_hypercube_make(2, offset, size);
+    values[i] = (void*)(intptr_t)(i + 1);
+    inTree[i] = false;
+  }
+
+  //incremental insertion, which splits nodes on all levels
+  esdmI_hypercubeRTree_t* tree = esdmI_hypercubeRTree_make(2);
+  checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+  for(int64_t i = 0; i < cubeCount; i++) {
+    esdmI_hypercubeRTree_insert(tree, cubes[i], values[i]);
+    inTree[i] = true;
+    if(i < 2*ESDMI_RTREE_MAX_ENTRIES || i%50 == 0) checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+  }
+  checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+
+  //removing entries that are not in the tree fails without changing it
+  eassert(!esdmI_hypercubeRTree_remove(tree, cubes[0], values[1]));
+  eassert(!esdmI_hypercubeRTree_remove(tree, cubes[1], values[0]));
+  eassert(esdmI_hypercubeRTree_count(tree) == cubeCount);
+
+  //remove the entries in a random order, which dissolves underfull nodes and shrinks the tree level by level until it is empty
+  int64_t order[cubeCount];
+  for(int64_t i = 0; i < cubeCount; i++) order[i] = i;
+  for(int64_t i = cubeCount - 1; i > 0; i--) {
+    int64_t j = rand_r(&seed)%(i + 1), temp = order[i];
+    order[i] = order[j];
+    order[j] = temp;
+  }
+  for(int64_t i = 0; i < cubeCount; i++) {
+    int64_t index = order[i];
+    eassert(esdmI_hypercubeRTree_remove(tree, cubes[index], values[index]));
+    inTree[index] = false;
+    eassert(!esdmI_hypercubeRTree_remove(tree, cubes[index], values[index]));
+    if(i%25 == 0 || cubeCount - i < 2*ESDMI_RTREE_MAX_ENTRIES) checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+  }
+  eassert(esdmI_hypercubeRTree_count(tree) == 0);
+  eassert(tree->root == NULL);
+
+  //a bulk loaded tree may contain underfull nodes, removals from it must work as well
+  esdmI_hypercubeRTree_bulkLoad(tree, cubeCount, cubes, values);
+  for(int64_t i = 0; i < cubeCount; i++) inTree[i] = true;
+  checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+  for(int64_t i = 0; i < cubeCount; i += 2) {
+    eassert(esdmI_hypercubeRTree_remove(tree, cubes[order[i]], values[order[i]]));
+    inTree[order[i]] = false;
+  }
+  checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+
+  //insertions after removals
+  for(int64_t i = 0; i < cubeCount; i += 2) {
+    esdmI_hypercubeRTree_insert(tree, cubes[order[i]], values[order[i]]);
+    inTree[order[i]] = true;
+  }
+  checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+
+  esdmI_hypercubeRTree_clear(tree);
+  for(int64_t i = 0; i < cubeCount; i++) inTree[i] = false;
+  checkRTreeQueries(tree, cubes, inTree, cubeCount, &seed);
+
+  esdmI_hypercubeRTree_destroy(tree);
+  for(int64_t i = 0; i < cubeCount; i++) esdmI_hypercube_destroy(cubes[i]);
+}
+
 int main() {
   checkRanges();
   checkHypercubes();
   checkTouch();
+  checkSubtractList();
+  checkNonredundantSubsets();
+  checkRTree();
   printf("\nOK\n");
 }
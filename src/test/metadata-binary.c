@@ -0,0 +1,145 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test writes a dataset with the binary metadata format, and reads it back after a restart with both metadata formats configured.
+ * It also checks that the fragment metadata is only decoded when it is accessed,
+ * and that a snapshot in shared memory is parsed without writing to that memory.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define HEIGHT 16
+#define WIDTH  100
+#define COUNT  10
+
+static void initWithFormat(const char* format) {
+  char config[1024];
+  snprintf(config, sizeof(config), "{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\" } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\", \"format\": \"%s\" } } }", format);
+  esdm_status ret = esdm_load_config_str(config);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void readAndCheck(const char* format, uint64_t* expected) {
+  initWithFormat(format);
+
+  esdm_container_t *container;
+  esdm_status ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  //the metadata on disk is binary, no matter which format is configured for writing
+  char* md;
+  int size;
+  ret = esdm_dataset_open_md_load(dataset, &md, &size);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(esdmI_metadata_isBinary(md, size));
+
+  //parse the snapshot again from read-only memory, as if it was shared with other processes, the fragment pages reference that memory
+  long pageSize = sysconf(_SC_PAGESIZE);
+  size_t sharedSize = (size + pageSize - 1) / pageSize * pageSize;
+  char* shared = mmap(NULL, sharedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  eassert(shared != MAP_FAILED);
+  memcpy(shared, md, size);
+  eassert(!mprotect(shared, sharedSize, PROT_READ));
+  free(md);
+  int64_t sharedUsers = 0;
+  ret = esdmI_dataset_metadata_parseShared(dataset, shared, size, &sharedUsers);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(sharedUsers == 1);
+
+  //the fragments of a binary snapshot are only decoded when they are accessed
+  eassert(dataset->fragmentPages);
+  eassert(g_hash_table_size(dataset->fragments.table) == 0);
+
+  uint64_t* buf = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  memset(buf, 0, COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_statistics_t before = esdm_read_stats();
+  ret = esdm_read(dataset, buf, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_statistics_t after = esdm_read_stats();
+  eassert(!memcmp(buf, expected, COUNT * HEIGHT * WIDTH * sizeof(uint64_t)));
+  printf("%s: fragments read = %"PRId64" (expected %d)\n", format, after.fragments - before.fragments, COUNT);
+  eassert(after.fragments - before.fragments == COUNT);
+  eassert(!dataset->fragmentPages);
+  eassert(g_hash_table_size(dataset->fragments.table) == COUNT);
+  eassert(sharedUsers == 0);
+  munmap(shared, sharedSize);
+  free(buf);
+
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < COUNT * HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  initWithFormat("binary");
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  // write one fragment per slice
+  for (int n = 0; n < COUNT; n++) {
+    esdm_simple_dspace_t subspace = esdm_dataspace_2do(n * HEIGHT, HEIGHT, 0, WIDTH, SMD_DTYPE_UINT64);
+    ret = esdm_write(dataset, buf_w + n * HEIGHT * WIDTH, subspace.ptr);
+    eassert(ret == ESDM_SUCCESS);
+  }
+
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  readAndCheck("binary", buf_w);
+  readAndCheck("json", buf_w);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
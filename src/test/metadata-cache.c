@@ -0,0 +1,179 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test opens a dataset repeatedly with the metadata cache enabled.
+ * It checks that a closed dataset stays parsed, that a change by another process is detected by the validation,
+ * that commits invalidate the cached metadata, and that cached metadata is served without touching the backend.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HEIGHT 16
+#define WIDTH  100
+#define COUNT  10
+
+static void init(const char* validate) {
+  char config[1024];
+  snprintf(config, sizeof(config), "{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\" } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\", \"format\": \"binary\", \"cache-size\": 10000000, \"cache-validate\": %s } } }", validate);
+  esdm_status ret = esdm_load_config_str(config);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void datasetPath(esdm_dataset_t *dataset, char *path) {
+  sprintf(path, "./_metadummy/datasets/%c%c/%s.md", dataset->id[0], dataset->id[1], dataset->id + 2);
+}
+
+static void readAndCheck(esdm_dataset_t *dataset, uint64_t *expected) {
+  uint64_t *buf = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  memset(buf, 0, COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_status ret = esdm_read(dataset, buf, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(!memcmp(buf, expected, COUNT * HEIGHT * WIDTH * sizeof(uint64_t)));
+  free(buf);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < COUNT * HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  init("true");
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  for (int n = 0; n < COUNT; n++) {
+    esdm_simple_dspace_t subspace = esdm_dataspace_2do(n * HEIGHT, HEIGHT, 0, WIDTH, SMD_DTYPE_UINT64);
+    ret = esdm_write(dataset, buf_w + n * HEIGHT * WIDTH, subspace.ptr);
+    eassert(ret == ESDM_SUCCESS);
+  }
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  // a closed dataset stays parsed, reopening it reuses the decoded fragments
+  init("true");
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset, buf_w);
+  eassert(g_hash_table_size(dataset->fragments.table) == COUNT);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(dataset->status == ESDM_DATA_PERSISTENT);
+  eassert(esdmI_metadataCache_usedBytes(esdm_get_modules()->metadata_cache) > 0);
+
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(!dataset->fragmentPages);
+  eassert(g_hash_table_size(dataset->fragments.table) == COUNT);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  // another process rewriting the metadata is detected, the dataset is parsed again
+  char path[PATH_MAX];
+  datasetPath(dataset, path);
+  struct stat statbuf;
+  ret = stat(path, &statbuf);
+  eassert(ret == 0);
+  ret = utimensat(AT_FDCWD, path, (struct timespec[]){ statbuf.st_atim, { statbuf.st_mtim.tv_sec + 10, statbuf.st_mtim.tv_nsec } }, 0);
+  eassert(ret == 0);
+
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(dataset->fragmentPages);
+  eassert(g_hash_table_size(dataset->fragments.table) == 0);
+  readAndCheck(dataset, buf_w);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  // without validation, a commit of this process still invalidates the cached container metadata
+  init("false");
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ | ESDM_MODE_FLAG_WRITE, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *second;
+  ret = esdm_dataset_create(container, "second", dataspace.ptr, &second);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(second);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(esdm_container_dataset_count(container) == 2);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  datasetPath(dataset, path);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+
+  // the cached metadata outlives the container objects, so reopening does not need the metadata backend
+  ret = unlink("./_metadummy/containers/mycontainer.md");
+  eassert(ret == 0);
+  ret = unlink(path);
+  eassert(ret == 0);
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset, buf_w);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
@@ -0,0 +1,125 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test commits a dataset repeatedly with each durability mode of the POSIX metadata backend.
+ * With every mode, the data must be found after a restart. With "fsync" and group commit, each commit must be on disk when it returns.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define HEIGHT 16
+#define WIDTH  100
+#define COUNT  10
+
+static void init(const char* durability) {
+  char config[1024];
+  snprintf(config, sizeof(config), "{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\" } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\", \"journal\": 4, \"durability\": \"%s\", \"group-commit-delay\": 20 } } }", durability);
+  esdm_status ret = esdm_load_config_str(config);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void readAndCheck(esdm_dataset_t *dataset, uint64_t *expected) {
+  uint64_t *buf = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  memset(buf, 0, COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_status ret = esdm_read(dataset, buf, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(!memcmp(buf, expected, COUNT * HEIGHT * WIDTH * sizeof(uint64_t)));
+  free(buf);
+}
+
+static void writeAndCheck(const char* durability, uint64_t *buf_w) {
+  init(durability);
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  struct stat statbuf;
+  if (strcmp(durability, "none")) eassert(stat("./_metadummy/containers/mycontainer.md", &statbuf) == 0);
+
+  // one commit per slice, which alternates between snapshots and journal entries
+  for (int n = 0; n < COUNT; n++) {
+    esdm_simple_dspace_t subspace = esdm_dataspace_2do(n * HEIGHT, HEIGHT, 0, WIDTH, SMD_DTYPE_UINT64);
+    ret = esdm_write(dataset, buf_w + n * HEIGHT * WIDTH, subspace.ptr);
+    eassert(ret == ESDM_SUCCESS);
+    ret = esdm_dataset_commit(dataset);
+    eassert(ret == ESDM_SUCCESS);
+  }
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset, buf_w);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+  eassert(stat("./_metadummy/containers/mycontainer.md", &statbuf) == 0);
+
+  // restart and read the data back
+  init("none");
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset, buf_w);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+  printf("%s: OK\n", durability);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < COUNT * HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  writeAndCheck("none", buf_w);
+  writeAndCheck("fsync", buf_w);
+  writeAndCheck("group", buf_w);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
@@ -0,0 +1,118 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test makes the fragment index query of the metadata backend fail, and checks that `esdm_read()` reports the error
+ * instead of returning success without filling the buffer.
+ * The query is injected into the metadummy backend, so that the test does not depend on a backend that has a fragment index.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 16
+#define WIDTH  16
+
+static int queryCount;
+static bool queryFails;
+
+static int fragments_retrieve(esdm_md_backend_t *backend, esdm_dataset_t *d, esdmI_hypercube_t *region, char **out_json, int *out_size) {
+  queryCount++;
+  if(queryFails) return ESDM_ERROR;
+
+  //the snapshot of the metadummy backend lists all fragments already, so there is nothing in the index
+  *out_json = ea_checked_strdup("[]");
+  *out_size = 2;
+  return ESDM_SUCCESS;
+}
+
+static void init() {
+  esdm_status ret = esdm_load_config_str("{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\" } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\" } } }");
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t));
+  uint64_t *buf_r = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < HEIGHT * WIDTH; i++) buf_w[i] = i + 1;
+
+  init();
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_write(dataset, buf_w, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  // restart with a fragment index, which must be in place before the dataset metadata is parsed
+  init();
+  esdm_md_backend_t *backend = esdm_get_modules()->metadata_backend;
+  backend->callbacks.dataset_fragments_retrieve = fragments_retrieve;
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  // a failing query must fail the read
+  queryFails = true;
+  memset(buf_r, 0, HEIGHT * WIDTH * sizeof(uint64_t));
+  ret = esdm_read(dataset, buf_r, dataspace.ptr);
+  eassert(ret != ESDM_SUCCESS);
+  eassert(queryCount == 1);
+
+  // the failed region is queried again, and the read succeeds once the query does
+  queryFails = false;
+  ret = esdm_read(dataset, buf_r, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(queryCount == 2);
+  eassert(!memcmp(buf_r, buf_w, HEIGHT * WIDTH * sizeof(uint64_t)));
+
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  free(buf_w);
+  free(buf_r);
+
+  printf("\nOK\n");
+  return 0;
+}
@@ -0,0 +1,177 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test commits a dataset after every write with the metadata journal enabled, and checks that the data is found after a restart, before and after compaction.
+ * It also puts the journal back after the compaction, as if the process had crashed before removing it, the stale entries must not be replayed.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 16
+#define WIDTH  100
+#define COUNT  10
+#define JOURNAL_ENTRIES 4
+
+static void initWithFormat(const char* format) {
+  char config[1024];
+  snprintf(config, sizeof(config), "{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\" } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\", \"format\": \"%s\", \"journal\": %d } } }", format, JOURNAL_ENTRIES);
+  esdm_status ret = esdm_load_config_str(config);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static bool metadataHasJournal(esdm_dataset_t* dataset) {
+  char* md;
+  int size;
+  esdm_status ret = esdm_dataset_open_md_load(dataset, &md, &size);
+  eassert(ret == ESDM_SUCCESS);
+  bool result = esdmI_metadata_isJournal(md, size);
+  free(md);
+  return result;
+}
+
+static void journalPath(char* path, const char* id) {
+  sprintf(path, "./_metadummy/datasets/%c%c/%s.journal", id[0], id[1], id + 2);
+}
+
+static char* readFile(const char* path, size_t* out_size) {
+  FILE* file = fopen(path, "rb");
+  eassert(file);
+  fseek(file, 0, SEEK_END);
+  *out_size = ftell(file);
+  rewind(file);
+  char* result = ea_checked_malloc(*out_size);
+  eassert(fread(result, 1, *out_size, file) == *out_size);
+  fclose(file);
+  return result;
+}
+
+static void writeFile(const char* path, const char* data, size_t size) {
+  FILE* file = fopen(path, "wb");
+  eassert(file);
+  eassert(fwrite(data, 1, size, file) == size);
+  fclose(file);
+}
+
+//Reads the dataset after a restart, optionally compacting it afterwards.
+//With `staleJournal`, there is a journal file, but none of its entries belong to the current snapshot.
+static void readAndCheck(const char* format, uint64_t* expected, int64_t expectedJournalEntries, bool compact, bool staleJournal) {
+  initWithFormat(format);
+
+  esdm_container_t *container;
+  esdm_status ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ | ESDM_MODE_FLAG_WRITE, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ | ESDM_MODE_FLAG_WRITE, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  printf("%s: journal entries = %"PRId64" (expected %"PRId64")\n", format, dataset->journalEntries, expectedJournalEntries);
+  eassert(dataset->journalEntries == expectedJournalEntries);
+  eassert(metadataHasJournal(dataset) == (expectedJournalEntries > 0 || staleJournal));
+
+  uint64_t* buf = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  memset(buf, 0, COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_statistics_t before = esdm_read_stats();
+  ret = esdm_read(dataset, buf, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_statistics_t after = esdm_read_stats();
+  eassert(!memcmp(buf, expected, COUNT * HEIGHT * WIDTH * sizeof(uint64_t)));
+  eassert(after.fragments - before.fragments == COUNT);
+  free(buf);
+
+  if(compact) {
+    ret = esdm_dataset_compact(dataset);
+    eassert(ret == ESDM_SUCCESS);
+    eassert(dataset->journalEntries == 0);
+    eassert(!metadataHasJournal(dataset));
+  }
+
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void runTest(const char* format, uint64_t* buf_w) {
+  initWithFormat(format);
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+
+  // write and commit one fragment at a time:
+  // the first commit writes a snapshot, then each snapshot is followed by JOURNAL_ENTRIES journal entries
+  for (int n = 0; n < COUNT; n++) {
+    esdm_simple_dspace_t subspace = esdm_dataspace_2do(n * HEIGHT, HEIGHT, 0, WIDTH, SMD_DTYPE_UINT64);
+    ret = esdm_write(dataset, buf_w + n * HEIGHT * WIDTH, subspace.ptr);
+    eassert(ret == ESDM_SUCCESS);
+    ret = esdm_dataset_commit(dataset);
+    eassert(ret == ESDM_SUCCESS);
+    eassert(dataset->journalEntries == n % (JOURNAL_ENTRIES + 1));
+    eassert(dataset->fragments.uncommittedCount == 0);
+  }
+
+  char path[PATH_MAX];
+  journalPath(path, dataset->id);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  size_t journalSize;
+  char* journal = readFile(path, &journalSize);
+  readAndCheck(format, buf_w, (COUNT - 1) % (JOURNAL_ENTRIES + 1), true, false);
+  readAndCheck(format, buf_w, 0, false, false);
+
+  // restore the journal that the compaction removed, its entries are already contained in the new snapshot
+  writeFile(path, journal, journalSize);
+  free(journal);
+  readAndCheck(format, buf_w, 0, false, true);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < COUNT * HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  runTest("json", buf_w);
+  runTest("binary", buf_w);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
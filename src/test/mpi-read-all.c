@@ -0,0 +1,141 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test reads a dataset with `esdm_mpi_read_all()` that is stored twice, once in row blocks and once in column blocks.
+ * Before the read, the even processes load the row blocks and the odd processes load the column blocks,
+ * so that a selection that prefers loaded fragments would pick different fragments on different processes.
+ * Each process must nevertheless receive the correct data for its band of rows.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <esdm-mpi.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 64
+#define WIDTH  64
+#define BLOCK  16
+
+static void init() {
+  esdm_mpi_init_manual();
+  esdm_status ret = esdm_load_config_str("{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\" } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\" } } }");
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+//Writes the data as row blocks and as column blocks, only called on rank 0.
+static void writeDataset(uint64_t *buf_w) {
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  for (int64_t n = 0; n < HEIGHT / BLOCK; n++) {
+    esdm_dataspace_t *subspace;
+    ret = esdm_dataspace_create_full(2, (int64_t[2]){BLOCK, WIDTH}, (int64_t[2]){n * BLOCK, 0}, SMD_DTYPE_UINT64, &subspace);
+    eassert(ret == ESDM_SUCCESS);
+    ret = esdm_write(dataset, buf_w + n * BLOCK * WIDTH, subspace);
+    eassert(ret == ESDM_SUCCESS);
+    esdm_dataspace_destroy(subspace);
+  }
+  for (int64_t n = 0; n < WIDTH / BLOCK; n++) {
+    esdm_dataspace_t *subspace;
+    ret = esdm_dataspace_create_full(2, (int64_t[2]){HEIGHT, BLOCK}, (int64_t[2]){0, n * BLOCK}, SMD_DTYPE_UINT64, &subspace);
+    eassert(ret == ESDM_SUCCESS);
+    ret = esdm_dataspace_set_stride(subspace, (int64_t[2]){WIDTH, 1});  //the column block is part of the full array
+    eassert(ret == ESDM_SUCCESS);
+    ret = esdm_write(dataset, buf_w + n * BLOCK, subspace);
+    eassert(ret == ESDM_SUCCESS);
+    esdm_dataspace_destroy(subspace);
+  }
+
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+}
+
+//Loads either the row blocks or the column blocks into memory.
+static void loadBlocks(esdm_dataset_t *dataset, bool rows) {
+  int64_t count = rows ? HEIGHT / BLOCK : WIDTH / BLOCK;
+  for (int64_t n = 0; n < count; n++) {
+    esdm_simple_dspace_t shape = rows ? esdm_dataspace_2do(n * BLOCK, BLOCK, 0, WIDTH, SMD_DTYPE_UINT64) : esdm_dataspace_2do(0, HEIGHT, n * BLOCK, BLOCK, SMD_DTYPE_UINT64);
+    esdm_fragment_t *fragment = esdmI_dataset_lookupFragmentForShape(dataset, shape.ptr);
+    eassert(fragment);
+    esdm_status ret = esdm_fragment_load(fragment);
+    eassert(ret == ESDM_SUCCESS);
+  }
+}
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+  int rank, procCount;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &procCount);
+
+  uint64_t *buf_w = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  init();
+  if (!rank) writeDataset(buf_w);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  esdm_container_t *container;
+  esdm_status ret = esdm_mpi_container_open(MPI_COMM_WORLD, "mycontainer", 0, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_mpi_dataset_open(MPI_COMM_WORLD, container, "mydataset", &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  loadBlocks(dataset, rank % 2 == 0);
+
+  // each process reads a band of rows
+  int64_t start = rank * HEIGHT / procCount, end = (rank + 1) * HEIGHT / procCount;
+  uint64_t *buf_r = ea_checked_malloc((end - start) * WIDTH * sizeof(uint64_t) + 1);
+  memset(buf_r, 0, (end - start) * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t region = esdm_dataspace_2do(start, end - start, 0, WIDTH, SMD_DTYPE_UINT64);
+  ret = esdm_mpi_read_all(MPI_COMM_WORLD, dataset, buf_r, region.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(!memcmp(buf_r, buf_w + start * WIDTH, (end - start) * WIDTH * sizeof(uint64_t)));
+  free(buf_r);
+
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_mpi_finalize();
+  free(buf_w);
+
+  if (!rank) printf("\nOK\n");
+  MPI_Finalize();
+  return 0;
+}
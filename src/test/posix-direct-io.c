@@ -0,0 +1,119 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test writes and reads a dataset with the O_DIRECT mode of the POSIX backend.
+ * It checks that the fragment sizes are rounded to the alignment, and that aligned and unaligned user buffers are transferred correctly.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 1000
+#define WIDTH  100
+#define ALIGNMENT 4096
+
+static void init() {
+  esdm_status ret = esdm_load_config_str("{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\", \"max-fragment-size\": 120000, \"direct-io\": true, \"direct-io-threshold\": 4096, \"direct-io-alignment\": 4096 } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\" } } }");
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void readAndCheck(esdm_dataset_t *dataset, uint64_t *expected, int64_t offset) {
+  //a buffer that is deliberately not aligned
+  char *raw = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t) + 8);
+  uint64_t *buf = (uint64_t*)(raw + offset);
+  memset(buf, 0, HEIGHT * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_status ret = esdm_read(dataset, buf, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(!memcmp(buf, expected, HEIGHT * WIDTH * sizeof(uint64_t)));
+  free(raw);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_memalign(ALIGNMENT, HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  init();
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  // the slices are 128 rows thick, so that all fragments but the last are multiples of the alignment
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_write(dataset, buf_w, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+
+  int64_t unalignedFragments = 0;
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, dataset->fragments.table);
+  while(g_hash_table_iter_next(&iter, NULL, &value)) {
+    esdm_fragment_t *fragment = value;
+    if(fragment->bytes % ALIGNMENT) unalignedFragments++;
+  }
+  printf("fragments written = %u, unaligned = %"PRId64"\n", g_hash_table_size(dataset->fragments.table), unalignedFragments);
+  eassert(g_hash_table_size(dataset->fragments.table) == 8);
+  eassert(unalignedFragments == 1);
+
+  // overwrite the first rows from an unaligned part of the buffer, this goes through the bounce buffers
+  esdm_simple_dspace_t subspace = esdm_dataspace_2do(1, HEIGHT - 1, 0, WIDTH, SMD_DTYPE_UINT64);
+  ret = esdm_write(dataset, buf_w + WIDTH, subspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset, buf_w, 0);
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  // restart and read the data back into an aligned and an unaligned buffer
+  init();
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset, buf_w, 0);
+  readAndCheck(dataset, buf_w, 8);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
@@ -0,0 +1,128 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test writes and reads a dataset from/to the middle columns of a wider buffer, so that the fragments are strided in memory.
+ * The rows are large enough for the POSIX backend to transfer them with pwritev()/preadv() straight from/to the user buffer.
+ * The data must be correct, and the memory between the rows must not be touched.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 64
+#define WIDTH  1024
+#define BUFFER_WIDTH (3*WIDTH)
+#define SENTINEL 0xdeadbeefdeadbeef
+
+static void init() {
+  esdm_status ret = esdm_load_config_str("{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\", \"max-fragment-size\": 131072 } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\" } } }");
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+//the dataset occupies the middle third of each row of the buffer
+static esdm_dataspace_t* makeStridedSpace() {
+  esdm_dataspace_t *space;
+  esdm_status ret = esdm_dataspace_create(2, (int64_t[2]){HEIGHT, WIDTH}, SMD_DTYPE_UINT64, &space);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataspace_set_stride(space, (int64_t[2]){BUFFER_WIDTH, 1});
+  eassert(ret == ESDM_SUCCESS);
+  return space;
+}
+
+static void readAndCheck(esdm_dataset_t *dataset) {
+  uint64_t *buf = ea_checked_malloc(HEIGHT * BUFFER_WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < HEIGHT * BUFFER_WIDTH; i++) buf[i] = SENTINEL;
+  esdm_dataspace_t *space = makeStridedSpace();
+  esdm_status ret = esdm_read(dataset, buf + WIDTH, space);
+  eassert(ret == ESDM_SUCCESS);
+  for (int64_t y = 0; y < HEIGHT; y++) {
+    for (int64_t x = 0; x < BUFFER_WIDTH; x++) {
+      uint64_t expected = x >= WIDTH && x < 2*WIDTH ? y * WIDTH + x - WIDTH : SENTINEL;
+      eassert(buf[y * BUFFER_WIDTH + x] == expected);
+    }
+  }
+  esdm_dataspace_destroy(space);
+  free(buf);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(HEIGHT * BUFFER_WIDTH * sizeof(uint64_t));
+  for (int64_t y = 0; y < HEIGHT; y++) {
+    for (int64_t x = 0; x < BUFFER_WIDTH; x++) buf_w[y * BUFFER_WIDTH + x] = x >= WIDTH && x < 2*WIDTH ? y * WIDTH + x - WIDTH : SENTINEL;
+  }
+
+  init();
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataspace_t *space = makeStridedSpace();
+  ret = esdm_write(dataset, buf_w + WIDTH, space);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataspace_destroy(space);
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  // restart and read the data back into a strided buffer, twice, to check that the fragments can be reused afterwards
+  init();
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset);
+  readAndCheck(dataset);
+
+  // a contiguous read of the same fragments still works
+  uint64_t *buf_r = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t));
+  ret = esdm_read(dataset, buf_r, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  for (int64_t i = 0; i < HEIGHT * WIDTH; i++) eassert(buf_r[i] == (uint64_t)i);
+  free(buf_r);
+
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
@@ -0,0 +1,124 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test writes many small fragments with the packed mode of the POSIX backend.
+ * It checks that they end up in a few extent files, that they can be read back after a restart with either metadata format,
+ * and that the compactor removes the extents once all their fragments have been deleted.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 256
+#define WIDTH  100
+
+static void init(const char* format) {
+  char config[1024];
+  snprintf(config, sizeof(config), "{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\", \"max-fragment-size\": 800, \"packed\": true, \"extent-size\": 65536 } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\", \"format\": \"%s\" } } }", format);
+  esdm_status ret = esdm_load_config_str(config);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static int countExtents() {
+  int result = 0;
+  DIR *dir = opendir("./_posix1/extents");
+  if(!dir) return 0;
+  for(struct dirent *entry; (entry = readdir(dir)); ) {
+    if(entry->d_name[0] != '.' && !strstr(entry->d_name, ".dead")) result++;
+  }
+  closedir(dir);
+  return result;
+}
+
+static void readAndCheck(esdm_dataset_t *dataset, uint64_t *expected) {
+  uint64_t *buf = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t));
+  memset(buf, 0, HEIGHT * WIDTH * sizeof(uint64_t));
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_status ret = esdm_read(dataset, buf, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  eassert(!memcmp(buf, expected, HEIGHT * WIDTH * sizeof(uint64_t)));
+  free(buf);
+}
+
+static void writeReadDelete(const char* format, uint64_t *buf_w) {
+  init(format);
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_write(dataset, buf_w, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  // 256 fragments of 800 bytes fit into a handful of extents per thread
+  int extents = countExtents();
+  printf("%s: extents = %d\n", format, extents);
+  eassert(extents > 0 && extents < 32);
+
+  // restart and read the data back from the extents
+  init(format);
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ | ESDM_MODE_FLAG_WRITE, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  readAndCheck(dataset, buf_w);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  // deleting all fragments makes the extents completely dead, they are gone after the compactor has finished
+  ret = esdm_container_delete(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+  eassert(countExtents() == 0);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  writeReadDelete("json", buf_w);
+  writeReadDelete("binary", buf_w);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
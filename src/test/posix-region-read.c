@@ -0,0 +1,119 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test reads small regions of a dataset that is stored in large fragments.
+ * These reads only fetch the needed byte ranges of the fragments via `fragment_retrieve_region()`, while a full read still loads the fragments.
+ * The data must be correct either way.
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 64
+#define WIDTH  8192
+
+static void init() {
+  esdm_status ret = esdm_load_config_str("{ \"esdm\": { \"backends\": [ { \"type\": \"POSIX\", \"id\": \"p1\", \"accessibility\": \"global\", \"target\": \"./_posix1\", \"max-fragment-size\": 1048576 } ], \"metadata\": { \"type\": \"metadummy\", \"id\": \"md\", \"target\": \"./_metadummy\" } } }");
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+}
+
+static void readRegionAndCheck(esdm_dataset_t *dataset, int64_t y, int64_t height, int64_t x, int64_t width) {
+  uint64_t *buf = ea_checked_malloc(height * width * sizeof(uint64_t));
+  memset(buf, 0, height * width * sizeof(uint64_t));
+  esdm_simple_dspace_t subspace = esdm_dataspace_2do(y, height, x, width, SMD_DTYPE_UINT64);
+  esdm_status ret = esdm_read(dataset, buf, subspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  for (int64_t i = 0; i < height; i++) {
+    for (int64_t j = 0; j < width; j++) eassert(buf[i * width + j] == (uint64_t)((y + i) * WIDTH + x + j));
+  }
+  free(buf);
+}
+
+int main(int argc, char const *argv[]) {
+  uint64_t *buf_w = ea_checked_malloc(HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  init();
+  esdm_status ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  esdm_container_t *container;
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  esdm_dataset_t *dataset;
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_write(dataset, buf_w, dataspace.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  // restart, so that none of the fragments is in memory
+  init();
+  ret = esdm_container_open("mycontainer", ESDM_MODE_FLAG_READ, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_open(container, "mydataset", ESDM_MODE_FLAG_READ, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  // a single element is read without loading its fragment
+  esdm_backendTimes_t before = esdmI_performance_backend();
+  readRegionAndCheck(dataset, 17, 1, 4711, 1);
+  esdm_backendTimes_t after = esdmI_performance_backend();
+  eassert(after.fragment_retrieve_region > before.fragment_retrieve_region);
+  eassert(after.fragment_retrieve == before.fragment_retrieve);
+
+  // a column and a small block, which need one range per row
+  readRegionAndCheck(dataset, 0, HEIGHT, 1234, 1);
+  readRegionAndCheck(dataset, 30, 8, WIDTH/2 - 50, 100);
+
+  // reading everything loads the fragments as a whole
+  before = esdmI_performance_backend();
+  readRegionAndCheck(dataset, 0, HEIGHT, 0, WIDTH);
+  after = esdmI_performance_backend();
+  eassert(after.fragment_retrieve + after.fragments_retrieve > before.fragment_retrieve + before.fragments_retrieve);
+
+  // the full read leaves the fragments unloaded, so this is a region read again
+  readRegionAndCheck(dataset, 17, 1, 4711, 1);
+
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  free(buf_w);
+
+  printf("\nOK\n");
+  return 0;
+}
@@ -128,6 +128,16 @@ int main(int argc, char const *argv[]) {
   }
   calc_bw("Total", HEIGHT * WIDTH * COUNT * 2 * 8, tv_origin);
 
+  // narrowing reads saturate: the values of the first block go up to HEIGHT*WIDTH - 1, which does not fit into an int8_t
+  int8_t *buf_i8 = ea_checked_malloc(HEIGHT * WIDTH * sizeof(int8_t));
+  esdm_simple_dspace_t subspace_i8 = esdm_dataspace_2do(0, HEIGHT, 0, WIDTH, SMD_DTYPE_INT8);
+  ret = esdm_read(dataset, buf_i8, subspace_i8.ptr);
+  eassert(ret == ESDM_SUCCESS);
+  for (int idx = 0; idx < HEIGHT * WIDTH; idx++) {
+    eassert(buf_i8[idx] == (idx < INT8_MAX ? idx : INT8_MAX));
+  }
+  free(buf_i8);
+
   ret = esdm_dataset_close(dataset);
   eassert(ret == ESDM_SUCCESS);
   ret = esdm_container_close(container);
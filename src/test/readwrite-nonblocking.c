@@ -0,0 +1,118 @@
+/* This file is part of ESDM.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ESDM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This test checks the non-blocking esdm_iwrite()/esdm_iread() API together with esdm_wait(), esdm_test(), and esdm_waitall().
+ */
+
+#include <esdm.h>
+#include <esdm-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEIGHT 32
+#define WIDTH  1024
+#define COUNT  8
+
+int main(int argc, char const *argv[]) {
+  esdm_status ret;
+  esdm_container_t *container = NULL;
+  esdm_dataset_t *dataset = NULL;
+
+  uint64_t *buf_w = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  uint64_t *buf_r = ea_checked_malloc(COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int64_t i = 0; i < COUNT * HEIGHT * WIDTH; i++) buf_w[i] = i;
+
+  ret = esdm_init();
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_GLOBAL);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_mkfs(ESDM_FORMAT_PURGE_RECREATE, ESDM_ACCESSIBILITY_NODELOCAL);
+  eassert(ret == ESDM_SUCCESS);
+
+  esdm_simple_dspace_t dataspace = esdm_dataspace_2d(COUNT * HEIGHT, WIDTH, SMD_DTYPE_UINT64);
+  eassert(dataspace.ptr);
+  ret = esdm_container_create("mycontainer", 1, &container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_dataset_create(container, "mydataset", dataspace.ptr, &dataset);
+  eassert(ret == ESDM_SUCCESS);
+
+  // start all writes at once, the dataspaces are destroyed right away to check that the requests hold their own copies
+  esdm_request_t *requests[COUNT];
+  for (int n = 0; n < COUNT; n++) {
+    esdm_dataspace_t *subspace;
+    ret = esdm_dataspace_create_full(2, (int64_t[2]){HEIGHT, WIDTH}, (int64_t[2]){n * HEIGHT, 0}, SMD_DTYPE_UINT64, &subspace);
+    eassert(ret == ESDM_SUCCESS);
+    ret = esdm_iwrite(dataset, buf_w + n * HEIGHT * WIDTH, subspace, &requests[n]);
+    eassert(ret == ESDM_SUCCESS);
+    eassert(requests[n]);
+    ret = esdm_dataspace_destroy(subspace);
+    eassert(ret == ESDM_SUCCESS);
+  }
+  ret = esdm_waitall(COUNT, requests);
+  eassert(ret == ESDM_SUCCESS);
+  for (int n = 0; n < COUNT; n++) eassert(!requests[n]);
+
+  ret = esdm_dataset_commit(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_commit(container);
+  eassert(ret == ESDM_SUCCESS);
+
+  // read the whole dataset back in one request, polling it with esdm_test()
+  memset(buf_r, 0, COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  esdm_request_t *request;
+  ret = esdm_iread(dataset, buf_r, dataspace.ptr, &request);
+  eassert(ret == ESDM_SUCCESS);
+  int done = 0;
+  while (!done) {
+    ret = esdm_test(&request, &done);
+    eassert(ret == ESDM_SUCCESS);
+  }
+  eassert(!request);
+  eassert(memcmp(buf_w, buf_r, COUNT * HEIGHT * WIDTH * sizeof(uint64_t)) == 0);
+
+  // read the slices individually, completing them one by one with esdm_wait()
+  memset(buf_r, 0, COUNT * HEIGHT * WIDTH * sizeof(uint64_t));
+  for (int n = 0; n < COUNT; n++) {
+    esdm_simple_dspace_t subspace = esdm_dataspace_2do(n * HEIGHT, HEIGHT, 0, WIDTH, SMD_DTYPE_UINT64);
+    ret = esdm_iread(dataset, buf_r + n * HEIGHT * WIDTH, subspace.ptr, &requests[n]);
+    eassert(ret == ESDM_SUCCESS);
+  }
+  for (int n = 0; n < COUNT; n++) {
+    ret = esdm_wait(&requests[n]);
+    eassert(ret == ESDM_SUCCESS);
+    eassert(!requests[n]);
+  }
+  eassert(memcmp(buf_w, buf_r, COUNT * HEIGHT * WIDTH * sizeof(uint64_t)) == 0);
+
+  // waiting for a completed request is a no-op
+  ret = esdm_wait(&requests[0]);
+  eassert(ret == ESDM_SUCCESS);
+
+  ret = esdm_dataset_close(dataset);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_container_close(container);
+  eassert(ret == ESDM_SUCCESS);
+  ret = esdm_finalize();
+  eassert(ret == ESDM_SUCCESS);
+
+  free(buf_w);
+  free(buf_r);
+
+  printf("\nOK\n");
+  return 0;
+}
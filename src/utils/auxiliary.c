@@ -27,7 +27,9 @@
 #include <fcntl.h>
 #include <glib.h>
 #include <limits.h>
+#include <math.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -330,6 +332,15 @@ void* ea_checked_calloc(size_t nmemb, size_t size) {
   return result;
 }
 
+void* ea_checked_memalign(size_t alignment, size_t size) {
+  void* result;
+  if(posix_memalign(&result, alignment, size ? size : 1)) {
+    fprintf(stderr, "out-of-memory error: could not allocate a block of %zd bytes with an alignment of %zd, aborting...\n", size, alignment);
+    abort();
+  }
+  return result;
+}
+
 void* ea_checked_realloc(void* ptr, size_t size) {
   void* result = realloc(ptr, size);
   if(!result && size) {
@@ -455,12 +466,217 @@ defineConvertersForSourceType(uint64_t)
 defineConvertersForSourceType(float)
 defineConvertersForSourceType(double)
 
-//define the selector function
-ea_datatype_converter ea_converter_for_types(esdm_type_t requestDestType, esdm_type_t requestSourceType) {
-  if(requestDestType == requestSourceType) return memcpy; //fast path for all noop conversions
+//define the saturating converter functions
+//The source value is widened to one of three classes (S == int64_t, U == uint64_t, F == double), and then clamped to the range of the destination class.
+//All the bounds that are compared against as doubles are powers of two, or zero, so they are exact.
+
+static inline int64_t saturate_S_to_S(int64_t value, int64_t min, int64_t max) { return value < min ? min : value > max ? max : value; }
+static inline uint64_t saturate_S_to_U(int64_t value, int64_t min, uint64_t max) { return value < 0 ? 0 : (uint64_t)value > max ? max : (uint64_t)value; }
+static inline int64_t saturate_U_to_S(uint64_t value, int64_t min, int64_t max) { return value > (uint64_t)max ? max : (int64_t)value; }
+static inline uint64_t saturate_U_to_U(uint64_t value, int64_t min, uint64_t max) { return value > max ? max : value; }
+static inline int64_t saturate_F_to_S(double value, int64_t min, int64_t max) {
+  if(isnan(value)) return 0;
+  if(value < (double)min) return min;
+  if(value >= -(double)min) return max;  //-min == max + 1
+  return (int64_t)value;
+}
+static inline uint64_t saturate_F_to_U(double value, int64_t min, uint64_t max) {
+  if(!(value > -1.0)) return 0;  //also catches NaN, values in (-1, 0) truncate to zero
+  if(value >= 2.0*(double)(max/2 + 1)) return max;  //2*(max/2 + 1) == max + 1, but without overflow
+  return (uint64_t)value;
+}
+//floating point destinations are not saturated, they behave exactly like the plain converters
+#define saturate_S_to_F(value, min, max) (value)
+#define saturate_U_to_F(value, min, max) (value)
+#define saturate_F_to_F(value, min, max) (value)
+
+#define saturate_widen_S(value) ((int64_t)(value))
+#define saturate_widen_U(value) ((uint64_t)(value))
+#define saturate_widen_F(value) ((double)(value))
+
+#define defineSaturatingConverter(destType, destClass, destMin, destMax, sourceType, sourceClass) \
+  static void* saturate_from_##sourceType##_to_##destType(void* vdest, const void* vsource, size_t sourceBytes) { \
+    sourceType const* source = vsource; \
+    destType* dest = vdest; \
+    size_t elementCount = sourceBytes/sizeof*source; \
+    eassert(elementCount*sizeof(sourceType) == sourceBytes); \
+    for(size_t i = 0; i < elementCount; i++) dest[i] = (destType)saturate_##sourceClass##_to_##destClass(saturate_widen_##sourceClass(source[i]), destMin, destMax); \
+    return dest; \
+  }
+
+#define defineSaturatingConvertersForSourceType(sourceType, sourceClass) \
+  defineSaturatingConverter(int8_t, S, INT8_MIN, INT8_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(int16_t, S, INT16_MIN, INT16_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(int32_t, S, INT32_MIN, INT32_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(int64_t, S, INT64_MIN, INT64_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(uint8_t, U, 0, UINT8_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(uint16_t, U, 0, UINT16_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(uint32_t, U, 0, UINT32_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(uint64_t, U, 0, UINT64_MAX, sourceType, sourceClass) \
+  defineSaturatingConverter(float, F, 0, 0, sourceType, sourceClass) \
+  defineSaturatingConverter(double, F, 0, 0, sourceType, sourceClass)
+
+defineSaturatingConvertersForSourceType(int8_t, S)
+defineSaturatingConvertersForSourceType(int16_t, S)
+defineSaturatingConvertersForSourceType(int32_t, S)
+defineSaturatingConvertersForSourceType(int64_t, S)
+defineSaturatingConvertersForSourceType(uint8_t, U)
+defineSaturatingConvertersForSourceType(uint16_t, U)
+defineSaturatingConvertersForSourceType(uint32_t, U)
+defineSaturatingConvertersForSourceType(uint64_t, U)
+defineSaturatingConvertersForSourceType(float, F)
+defineSaturatingConvertersForSourceType(double, F)
+
+//define vectorized versions of the most common conversions
+//Each kernel handles the bulk of the data with vector instructions, and leaves the remaining elements to the respective scalar converter.
+//The kernel body is passed as the variadic argument because it contains commas.
+//The vector instructions round exactly like the C casts, so the results are identical to those of the scalar converters.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define EA_HAVE_X86_SIMD 1
+#include <immintrin.h>
+
+#define defineSimdKernel(name, targetSpec, sourceType, destType, step, tailConverter, ...) \
+  __attribute__((target(targetSpec))) static void* name(void* vdest, const void* vsource, size_t sourceBytes) { \
+    sourceType const* source = vsource; \
+    destType* dest = vdest; \
+    size_t elementCount = sourceBytes/sizeof*source, i = 0; \
+    eassert(elementCount*sizeof(sourceType) == sourceBytes); \
+    for(; i + (step) <= elementCount; i += (step)) { __VA_ARGS__ } \
+    tailConverter(dest + i, source + i, (elementCount - i)*sizeof*source); \
+    return vdest; \
+  }
+
+//SSE2
+defineSimdKernel(sse2_float_to_double, "sse2", float, double, 4, convert_from_float_to_double,
+  _mm_storeu_pd(dest + i, _mm_cvtps_pd(_mm_loadu_ps(source + i)));
+  _mm_storeu_pd(dest + i + 2, _mm_cvtps_pd(_mm_movehl_ps(_mm_loadu_ps(source + i), _mm_loadu_ps(source + i))));
+)
+defineSimdKernel(sse2_double_to_float, "sse2", double, float, 4, convert_from_double_to_float,
+  _mm_storeu_ps(dest + i, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(source + i)), _mm_cvtpd_ps(_mm_loadu_pd(source + i + 2))));
+)
+defineSimdKernel(sse2_int32_t_to_float, "sse2", int32_t, float, 4, convert_from_int32_t_to_float,
+  _mm_storeu_ps(dest + i, _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(source + i))));
+)
+defineSimdKernel(sse2_int32_t_to_double, "sse2", int32_t, double, 4, convert_from_int32_t_to_double,
+  __m128i values = _mm_loadu_si128((const __m128i*)(source + i));
+  _mm_storeu_pd(dest + i, _mm_cvtepi32_pd(values));
+  _mm_storeu_pd(dest + i + 2, _mm_cvtepi32_pd(_mm_unpackhi_epi64(values, values)));
+)
+defineSimdKernel(sse2_saturate_int32_t_to_int16_t, "sse2", int32_t, int16_t, 8, saturate_from_int32_t_to_int16_t,
+  __m128i low = _mm_loadu_si128((const __m128i*)(source + i)), high = _mm_loadu_si128((const __m128i*)(source + i + 4));
+  _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(low, high));
+)
+defineSimdKernel(sse2_saturate_int16_t_to_int8_t, "sse2", int16_t, int8_t, 16, saturate_from_int16_t_to_int8_t,
+  __m128i low = _mm_loadu_si128((const __m128i*)(source + i)), high = _mm_loadu_si128((const __m128i*)(source + i + 8));
+  _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi16(low, high));
+)
+defineSimdKernel(sse2_saturate_int16_t_to_uint8_t, "sse2", int16_t, uint8_t, 16, saturate_from_int16_t_to_uint8_t,
+  __m128i low = _mm_loadu_si128((const __m128i*)(source + i)), high = _mm_loadu_si128((const __m128i*)(source + i + 8));
+  _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(low, high));
+)
+
+//AVX2
+//The 256 bit pack instructions work on the two 128 bit lanes separately, so their results need to be permuted into the right order.
+defineSimdKernel(avx2_float_to_double, "avx2", float, double, 8, convert_from_float_to_double,
+  _mm256_storeu_pd(dest + i, _mm256_cvtps_pd(_mm_loadu_ps(source + i)));
+  _mm256_storeu_pd(dest + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(source + i + 4)));
+)
+defineSimdKernel(avx2_double_to_float, "avx2", double, float, 8, convert_from_double_to_float,
+  _mm_storeu_ps(dest + i, _mm256_cvtpd_ps(_mm256_loadu_pd(source + i)));
+  _mm_storeu_ps(dest + i + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(source + i + 4)));
+)
+defineSimdKernel(avx2_int32_t_to_float, "avx2", int32_t, float, 8, convert_from_int32_t_to_float,
+  _mm256_storeu_ps(dest + i, _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(source + i))));
+)
+defineSimdKernel(avx2_int32_t_to_double, "avx2", int32_t, double, 8, convert_from_int32_t_to_double,
+  _mm256_storeu_pd(dest + i, _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(source + i))));
+  _mm256_storeu_pd(dest + i + 4, _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(source + i + 4))));
+)
+defineSimdKernel(avx2_saturate_int32_t_to_int16_t, "avx2", int32_t, int16_t, 16, saturate_from_int32_t_to_int16_t,
+  __m256i low = _mm256_loadu_si256((const __m256i*)(source + i)), high = _mm256_loadu_si256((const __m256i*)(source + i + 8));
+  _mm256_storeu_si256((__m256i*)(dest + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xd8));
+)
+defineSimdKernel(avx2_saturate_int32_t_to_uint16_t, "avx2", int32_t, uint16_t, 16, saturate_from_int32_t_to_uint16_t,
+  __m256i low = _mm256_loadu_si256((const __m256i*)(source + i)), high = _mm256_loadu_si256((const __m256i*)(source + i + 8));
+  _mm256_storeu_si256((__m256i*)(dest + i), _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xd8));
+)
+defineSimdKernel(avx2_saturate_int16_t_to_int8_t, "avx2", int16_t, int8_t, 32, saturate_from_int16_t_to_int8_t,
+  __m256i low = _mm256_loadu_si256((const __m256i*)(source + i)), high = _mm256_loadu_si256((const __m256i*)(source + i + 16));
+  _mm256_storeu_si256((__m256i*)(dest + i), _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xd8));
+)
+defineSimdKernel(avx2_saturate_int16_t_to_uint8_t, "avx2", int16_t, uint8_t, 32, saturate_from_int16_t_to_uint8_t,
+  __m256i low = _mm256_loadu_si256((const __m256i*)(source + i)), high = _mm256_loadu_si256((const __m256i*)(source + i + 16));
+  _mm256_storeu_si256((__m256i*)(dest + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xd8));
+)
+
+//AVX-512
+defineSimdKernel(avx512_float_to_double, "avx512f", float, double, 16, convert_from_float_to_double,
+  _mm512_storeu_pd(dest + i, _mm512_cvtps_pd(_mm256_loadu_ps(source + i)));
+  _mm512_storeu_pd(dest + i + 8, _mm512_cvtps_pd(_mm256_loadu_ps(source + i + 8)));
+)
+defineSimdKernel(avx512_double_to_float, "avx512f", double, float, 16, convert_from_double_to_float,
+  _mm256_storeu_ps(dest + i, _mm512_cvtpd_ps(_mm512_loadu_pd(source + i)));
+  _mm256_storeu_ps(dest + i + 8, _mm512_cvtpd_ps(_mm512_loadu_pd(source + i + 8)));
+)
+defineSimdKernel(avx512_int32_t_to_float, "avx512f", int32_t, float, 16, convert_from_int32_t_to_float,
+  _mm512_storeu_ps(dest + i, _mm512_cvtepi32_ps(_mm512_loadu_si512(source + i)));
+)
+defineSimdKernel(avx512_int32_t_to_double, "avx512f", int32_t, double, 16, convert_from_int32_t_to_double,
+  _mm512_storeu_pd(dest + i, _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(source + i))));
+  _mm512_storeu_pd(dest + i + 8, _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(source + i + 8))));
+)
+
+typedef enum { kSimdNone, kSimdSse2, kSimdAvx2, kSimdAvx512 } simdLevel_t;
+
+//The level is detected on the first call only, every converter lookup asks for it.
+static simdLevel_t simd_level() {
+  static atomic_int cachedLevel = -1;
+  int level = atomic_load_explicit(&cachedLevel, memory_order_relaxed);
+  if(level < 0) {
+    //racing threads detect the same level, so it does not matter which one stores it
+    __builtin_cpu_init();
+    level = __builtin_cpu_supports("avx512f") ? kSimdAvx512 : __builtin_cpu_supports("avx2") ? kSimdAvx2 : __builtin_cpu_supports("sse2") ? kSimdSse2 : kSimdNone;
+    atomic_store_explicit(&cachedLevel, level, memory_order_relaxed);
+  }
+  return level;
+}
+
+//Returns the fastest vectorized kernel that the CPU supports for the given conversion, or NULL if there is none.
+static ea_datatype_converter simd_converter_for_types(esdm_type_t destType, esdm_type_t sourceType, bool saturating) {
+  simdLevel_t level = simd_level();
+
+  #define selectSimdKernel(esdmSourceType, esdmDestType, avx512Kernel, avx2Kernel, sse2Kernel) \
+    if(sourceType == esdmSourceType && destType == esdmDestType) { \
+      ea_datatype_converter avx512 = avx512Kernel, avx2 = avx2Kernel, sse2 = sse2Kernel; \
+      if(level >= kSimdAvx512 && avx512) return avx512; \
+      if(level >= kSimdAvx2 && avx2) return avx2; \
+      if(level >= kSimdSse2 && sse2) return sse2; \
+      return NULL; \
+    }
+
+  selectSimdKernel(SMD_DTYPE_FLOAT, SMD_DTYPE_DOUBLE, avx512_float_to_double, avx2_float_to_double, sse2_float_to_double)
+  selectSimdKernel(SMD_DTYPE_DOUBLE, SMD_DTYPE_FLOAT, avx512_double_to_float, avx2_double_to_float, sse2_double_to_float)
+  selectSimdKernel(SMD_DTYPE_INT32, SMD_DTYPE_FLOAT, avx512_int32_t_to_float, avx2_int32_t_to_float, sse2_int32_t_to_float)
+  selectSimdKernel(SMD_DTYPE_INT32, SMD_DTYPE_DOUBLE, avx512_int32_t_to_double, avx2_int32_t_to_double, sse2_int32_t_to_double)
+  if(saturating) {
+    selectSimdKernel(SMD_DTYPE_INT32, SMD_DTYPE_INT16, NULL, avx2_saturate_int32_t_to_int16_t, sse2_saturate_int32_t_to_int16_t)
+    selectSimdKernel(SMD_DTYPE_INT32, SMD_DTYPE_UINT16, NULL, avx2_saturate_int32_t_to_uint16_t, NULL)
+    selectSimdKernel(SMD_DTYPE_INT16, SMD_DTYPE_INT8, NULL, avx2_saturate_int16_t_to_int8_t, sse2_saturate_int16_t_to_int8_t)
+    selectSimdKernel(SMD_DTYPE_INT16, SMD_DTYPE_UINT8, NULL, avx2_saturate_int16_t_to_uint8_t, sse2_saturate_int16_t_to_uint8_t)
+  }
+  return NULL;
+}
+
+#else
+
+static ea_datatype_converter simd_converter_for_types(esdm_type_t destType, esdm_type_t sourceType, bool saturating) { return NULL; }
 
+#endif
+
+//define the selector functions
+static ea_datatype_converter scalar_converter_for_types(esdm_type_t requestDestType, esdm_type_t requestSourceType, bool saturating) {
   #define selectConverterForDest(destType, esdmDestType, sourceType) \
-    if(esdmDestType == requestDestType) return convert_from_##sourceType##_to_##destType;
+    if(esdmDestType == requestDestType) return saturating ? saturate_from_##sourceType##_to_##destType : convert_from_##sourceType##_to_##destType;
 
   #define selectConvertersForSource(sourceType, esdmSourceType) \
     if(esdmSourceType == requestSourceType) { \
@@ -489,3 +705,17 @@ ea_datatype_converter ea_converter_for_types(esdm_type_t requestDestType, esdm_t
   selectConvertersForSource(double, SMD_DTYPE_DOUBLE)
   return NULL;
 }
+
+ea_datatype_converter ea_converter_for_types(esdm_type_t requestDestType, esdm_type_t requestSourceType) {
+  if(requestDestType == requestSourceType) return memcpy; //fast path for all noop conversions
+
+  ea_datatype_converter result = simd_converter_for_types(requestDestType, requestSourceType, false);
+  return result ? result : scalar_converter_for_types(requestDestType, requestSourceType, false);
+}
+
+ea_datatype_converter ea_saturating_converter_for_types(esdm_type_t requestDestType, esdm_type_t requestSourceType) {
+  if(requestDestType == requestSourceType) return memcpy; //fast path for all noop conversions
+
+  ea_datatype_converter result = simd_converter_for_types(requestDestType, requestSourceType, true);
+  return result ? result : scalar_converter_for_types(requestDestType, requestSourceType, true);
+}